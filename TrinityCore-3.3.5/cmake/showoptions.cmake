@@ -180,6 +180,24 @@ elseif (WITH_DETAILED_METRICS)
       WITH_DETAILED_METRICS)
 endif()
 
+if(WITH_PROFILER)
+  message("")
+  message(" *** WITH_PROFILER - WARNING!")
+  message(" *** Please note that this will build the zone profiler into the core (.debug profile)")
+  target_compile_definitions(trinity-compile-option-interface
+    INTERFACE
+      WITH_PROFILER)
+endif()
+
+if(WITH_ALLOCATION_COUNTER)
+  message("")
+  message(" *** WITH_ALLOCATION_COUNTER - WARNING!")
+  message(" *** Please note that this will replace the global operator new to count allocations per thread")
+  target_compile_definitions(trinity-compile-option-interface
+    INTERFACE
+      WITH_ALLOCATION_COUNTER)
+endif()
+
 if(BUILD_SHARED_LIBS)
   message("")
   message(" *** WITH_DYNAMIC_LINKING - INFO!")
@@ -0,0 +1,7 @@
+-- 
+DELETE FROM `command` WHERE `name`='debug profile';
+INSERT INTO `command` (`name`,`permission`,`help`) VALUES
+('debug profile',300,'Syntax: .debug profile [#seconds]
+Records profiler zones for #seconds (10 if not specified) and writes them to the logs directory as a Chrome trace and as folded stacks for flame graphs. Use 0 to stop the running capture right away.
+Requires a core built with -DWITH_PROFILER=1
+');
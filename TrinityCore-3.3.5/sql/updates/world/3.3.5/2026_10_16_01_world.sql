@@ -0,0 +1,10 @@
+-- 
+DELETE FROM `command` WHERE `name` IN ('debug opcodestats','debug opcodestats reset');
+INSERT INTO `command` (`name`,`permission`,`help`) VALUES
+('debug opcodestats',300,'Syntax: .debug opcodestats [#count]
+Shows the #count (10 if not specified) client packet handlers that took the most time since the last reset, with their calls, total, average and maximum time and average packet size.
+Allocations per call are only counted by a core built with -DWITH_ALLOCATION_COUNTER=1
+'),
+('debug opcodestats reset',300,'Syntax: .debug opcodestats reset
+Clears the client packet handler statistics.
+');
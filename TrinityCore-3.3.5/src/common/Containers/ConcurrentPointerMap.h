@@ -0,0 +1,199 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITYCORE_CONCURRENT_POINTER_MAP_H
+#define TRINITYCORE_CONCURRENT_POINTER_MAP_H
+
+#include "Define.h"
+#include "EpochReclaimer.h"
+#include "Errors.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace Trinity::Containers
+{
+/**
+ * uint64 key -> pointer map with lock-free lookups, for indexes read from many threads but rarely modified
+ *
+ * Open addressing with linear probing, removed keys stay in their slot with a null value and are reused when the key comes back.
+ * Writers are serialized internally, when the table fills up it is rebuilt without the removed keys and the old one is
+ * handed to the EpochReclaimer so lookups running concurrently can finish on it.
+ * Key 0 is reserved for empty slots.
+ */
+template <class T>
+class ConcurrentPointerMap
+{
+    struct Slot
+    {
+        std::atomic<uint64> Key = 0;
+        std::atomic<T*> Value = nullptr;
+    };
+
+    struct Table
+    {
+        explicit Table(std::size_t capacity) : Mask(capacity - 1), Slots(std::make_unique<Slot[]>(capacity)) { }
+
+        std::size_t Mask;
+        std::unique_ptr<Slot[]> Slots;
+        std::size_t UsedSlots = 0;
+    };
+
+public:
+    static constexpr std::size_t MinCapacity = 16;
+
+    ConcurrentPointerMap() : _table(new Table(MinCapacity)), _size(0) { }
+
+    ~ConcurrentPointerMap()
+    {
+        delete _table.load(std::memory_order_relaxed);
+    }
+
+    ConcurrentPointerMap(ConcurrentPointerMap const&) = delete;
+    ConcurrentPointerMap(ConcurrentPointerMap&&) = delete;
+    ConcurrentPointerMap& operator=(ConcurrentPointerMap const&) = delete;
+    ConcurrentPointerMap& operator=(ConcurrentPointerMap&&) = delete;
+
+    T* Find(uint64 key) const
+    {
+        EpochReclaimer::ReadGuard guard;
+        Table const* table = _table.load(std::memory_order_acquire);
+        for (std::size_t i = Hash(key) & table->Mask; ; i = (i + 1) & table->Mask)
+        {
+            uint64 slotKey = table->Slots[i].Key.load(std::memory_order_acquire);
+            if (slotKey == key)
+                return table->Slots[i].Value.load(std::memory_order_acquire);
+
+            if (!slotKey)
+                return nullptr;
+        }
+    }
+
+    void Insert(uint64 key, T* value)
+    {
+        ASSERT(key, "ConcurrentPointerMap key 0 is reserved");
+        ASSERT(value);
+
+        std::lock_guard<std::mutex> lock(_writeLock);
+        Table* table = _table.load(std::memory_order_relaxed);
+        if (Slot* slot = FindSlot(*table, key))
+        {
+            if (!slot->Value.load(std::memory_order_relaxed))
+                ++_size;
+
+            slot->Value.store(value, std::memory_order_release);
+            return;
+        }
+
+        // keep the load factor (removed keys included) below 3/4 so probe sequences stay short and always end
+        if ((table->UsedSlots + 1) * 4 > (table->Mask + 1) * 3)
+            table = Rebuild();
+
+        Slot& slot = FindFreeSlot(*table, key);
+        slot.Value.store(value, std::memory_order_relaxed);
+        slot.Key.store(key, std::memory_order_release);
+        ++table->UsedSlots;
+        ++_size;
+    }
+
+    void Remove(uint64 key)
+    {
+        std::lock_guard<std::mutex> lock(_writeLock);
+        if (Slot* slot = FindSlot(*_table.load(std::memory_order_relaxed), key))
+            if (slot->Value.exchange(nullptr, std::memory_order_release))
+                --_size;
+    }
+
+    std::size_t Size() const
+    {
+        std::lock_guard<std::mutex> lock(_writeLock);
+        return _size;
+    }
+
+    std::size_t Capacity() const
+    {
+        std::lock_guard<std::mutex> lock(_writeLock);
+        return _table.load(std::memory_order_relaxed)->Mask + 1;
+    }
+
+private:
+    static std::size_t Hash(uint64 key)
+    {
+        // guids differ mostly in their low bits, mix them over the whole word (murmur3 finalizer)
+        key ^= key >> 33;
+        key *= 0xFF51AFD7ED558CCDULL;
+        key ^= key >> 33;
+        key *= 0xC4CEB9FE1A85EC53ULL;
+        key ^= key >> 33;
+        return std::size_t(key);
+    }
+
+    static Slot* FindSlot(Table& table, uint64 key)
+    {
+        for (std::size_t i = Hash(key) & table.Mask; ; i = (i + 1) & table.Mask)
+        {
+            uint64 slotKey = table.Slots[i].Key.load(std::memory_order_relaxed);
+            if (slotKey == key)
+                return &table.Slots[i];
+
+            if (!slotKey)
+                return nullptr;
+        }
+    }
+
+    static Slot& FindFreeSlot(Table& table, uint64 key)
+    {
+        std::size_t i = Hash(key) & table.Mask;
+        while (table.Slots[i].Key.load(std::memory_order_relaxed))
+            i = (i + 1) & table.Mask;
+
+        return table.Slots[i];
+    }
+
+    Table* Rebuild()
+    {
+        Table* oldTable = _table.load(std::memory_order_relaxed);
+
+        // size for at most 1/2 load after dropping removed keys
+        std::size_t capacity = MinCapacity;
+        while (capacity < (_size + 1) * 2)
+            capacity *= 2;
+
+        Table* newTable = new Table(capacity);
+        for (std::size_t i = 0; i <= oldTable->Mask; ++i)
+        {
+            if (T* value = oldTable->Slots[i].Value.load(std::memory_order_relaxed))
+            {
+                Slot& slot = FindFreeSlot(*newTable, oldTable->Slots[i].Key.load(std::memory_order_relaxed));
+                slot.Key.store(oldTable->Slots[i].Key.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                slot.Value.store(value, std::memory_order_relaxed);
+                ++newTable->UsedSlots;
+            }
+        }
+
+        _table.store(newTable, std::memory_order_release);
+        sEpochReclaimer->Retire(oldTable);
+        return newTable;
+    }
+
+    std::atomic<Table*> _table;
+    std::size_t _size;
+    mutable std::mutex _writeLock;
+};
+}
+
+#endif // TRINITYCORE_CONCURRENT_POINTER_MAP_H
@@ -0,0 +1,106 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TRINITYCORE_DENSE_INDEX_H
+#define TRINITYCORE_DENSE_INDEX_H
+
+#include "Define.h"
+#include <vector>
+
+namespace Trinity::Containers
+{
+/**
+ * Direct key -> element lookup table for stores keyed by small, mostly contiguous ids (db template entries)
+ * Elements stay owned by the backing store which must keep their addresses stable (node based containers)
+ * The index disables itself when the keys are too sparse for a flat table, callers then fall back to the store
+ */
+template <class T, std::size_t MaxSlotsPerElement = 16>
+class DenseIndex
+{
+public:
+    bool IsEnabled() const { return _enabled; }
+    std::size_t Capacity() const { return _slots.size(); }
+
+    T* Find(uint32 key) const
+    {
+        return key < _slots.size() ? _slots[key] : nullptr;
+    }
+
+    template <class Store, class Projection>
+    void Build(Store& store, Projection projection)
+    {
+        Clear();
+
+        uint32 maxKey = 0;
+        for (auto&& pair : store)
+            if (pair.first > maxKey)
+                maxKey = pair.first;
+
+        if (!store.empty() && !IsDenseEnough(maxKey, store.size()))
+            return;
+
+        _slots.resize(store.empty() ? 0 : std::size_t(maxKey) + 1, nullptr);
+        for (auto&& pair : store)
+            _slots[pair.first] = projection(pair.second);
+
+        _elements = store.size();
+        _enabled = true;
+    }
+
+    // keeps an already built index in sync with single element loads (reload commands)
+    void Insert(uint32 key, T* value)
+    {
+        if (!_enabled)
+            return;
+
+        if (key >= _slots.size())
+        {
+            if (!IsDenseEnough(key, _elements + 1))
+            {
+                Clear();
+                return;
+            }
+
+            _slots.resize(std::size_t(key) + 1, nullptr);
+        }
+
+        if (!_slots[key])
+            ++_elements;
+
+        _slots[key] = value;
+    }
+
+    void Clear()
+    {
+        _slots.clear();
+        _slots.shrink_to_fit();
+        _elements = 0;
+        _enabled = false;
+    }
+
+private:
+    static bool IsDenseEnough(uint32 maxKey, std::size_t elements)
+    {
+        return std::size_t(maxKey) < (elements + 1) * MaxSlotsPerElement;
+    }
+
+    std::vector<T*> _slots;
+    std::size_t _elements = 0;
+    bool _enabled = false;
+};
+}
+
+#endif // TRINITYCORE_DENSE_INDEX_H
@@ -27,7 +27,8 @@ AppenderFile::AppenderFile(uint8 id, std::string const& name, LogLevel level, Ap
     logfile(nullptr),
     _logDir(sLog->GetLogsDir()),
     _maxFileSize(0),
-    _fileSize(0)
+    _fileSize(0),
+    _flushSize(sLog->GetAsyncFlushSize())
 {
     if (args.size() < 4)
         throw InvalidAppenderArgsException(Trinity::StringFormat("Log::CreateAppenderFromConfig: Missing file name for appender {}", name));
@@ -85,15 +86,36 @@ void AppenderFile::_write(LogMessage const* message)
         fclose(file);
         return;
     }
-    else if (exceedMaxSize)
+
+    std::lock_guard<std::mutex> lock(_bufferLock);
+    if (exceedMaxSize)
         logfile = OpenFile(_fileName, "w", true);
 
     if (!logfile)
         return;
 
-    fprintf(logfile, "%s%s\n", message->prefix.c_str(), message->text.c_str());
-    fflush(logfile);
+    // written out in batches, either when enough piled up or when the log flushes its appenders
+    _buffer.append(message->prefix).append(message->text).push_back('\n');
     _fileSize += uint64(message->Size());
+    if (_buffer.size() >= _flushSize)
+        FlushBuffer();
+}
+
+void AppenderFile::flush()
+{
+    std::lock_guard<std::mutex> lock(_bufferLock);
+    FlushBuffer();
+}
+
+void AppenderFile::FlushBuffer()
+{
+    if (logfile && !_buffer.empty())
+    {
+        fwrite(_buffer.data(), 1, _buffer.size(), logfile);
+        fflush(logfile);
+    }
+
+    _buffer.clear();
 }
 
 FILE* AppenderFile::OpenFile(std::string const& filename, std::string const& mode, bool backup)
@@ -122,6 +144,7 @@ void AppenderFile::CloseFile()
 {
     if (logfile)
     {
+        FlushBuffer();
         fclose(logfile);
         logfile = nullptr;
     }
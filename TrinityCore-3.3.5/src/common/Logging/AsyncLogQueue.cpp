@@ -0,0 +1,249 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AsyncLogQueue.h"
+#include "LogMessage.h"
+#include "LogRingBuffer.h"
+#include "fmt/format.h"
+#include <algorithm>
+#include <limits>
+
+namespace Trinity::Logging
+{
+namespace
+{
+std::atomic<uint64> NextQueueId = 1;
+
+struct ThreadRing
+{
+    uint64 QueueId = 0;
+    std::shared_ptr<LogRingBuffer> Ring;
+};
+
+thread_local ThreadRing CurrentThreadRing;
+thread_local uint32 ConsumerDepth = 0;
+}
+
+AsyncLogQueue::AsyncLogQueue(AsyncLogOptions const& options, WriteFn write, FlushFn flush) : _id(NextQueueId++), _options(options),
+    _write(std::move(write)), _flush(std::move(flush)), _dropped(0), _reportedDrops(0), _stopping(false)
+{
+    _thread = std::thread(&AsyncLogQueue::Run, this);
+}
+
+AsyncLogQueue::~AsyncLogQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(_wakeupLock);
+        _stopping = true;
+    }
+
+    _wakeup.notify_one();
+    _thread.join();
+
+    // anything enqueued after the logger thread made its last pass
+    Flush();
+}
+
+AsyncLogQueue::ConsumerScope::ConsumerScope()
+{
+    ++ConsumerDepth;
+}
+
+AsyncLogQueue::ConsumerScope::~ConsumerScope()
+{
+    --ConsumerDepth;
+}
+
+bool AsyncLogQueue::IsConsumerThread()
+{
+    return ConsumerDepth != 0;
+}
+
+LogRingBuffer* AsyncLogQueue::GetThreadRing()
+{
+    if (CurrentThreadRing.QueueId == _id)
+        return CurrentThreadRing.Ring.get();
+
+    // the ring is shared with the thread so messages left in it when the thread exits are still written
+    std::shared_ptr<LogRingBuffer> ring = std::make_shared<LogRingBuffer>(_options.QueueSize);
+    {
+        std::lock_guard<std::mutex> lock(_ringsLock);
+        _rings.push_back(ring);
+    }
+
+    CurrentThreadRing.QueueId = _id;
+    CurrentThreadRing.Ring = std::move(ring);
+    return CurrentThreadRing.Ring.get();
+}
+
+bool AsyncLogQueue::FitsInRecord(LogRingBuffer const& ring, std::string_view filter, std::size_t dataSize)
+{
+    return filter.length() <= std::numeric_limits<uint16>::max() && sizeof(LogRecord) + filter.length() + dataSize <= ring.GetMaxRecordSize();
+}
+
+LogRecord* AsyncLogQueue::BeginRecord(LogRingBuffer& ring, LogRecordType type, std::string_view filter, LogLevel level, std::size_t dataSize)
+{
+    std::size_t size = sizeof(LogRecord) + filter.length() + dataSize;
+    void* memory = ring.Reserve(size);
+    while (!memory)
+    {
+        if (_options.DropPolicy == LogDropPolicy::DropNewest)
+        {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        _wakeup.notify_one();
+        std::this_thread::yield();
+        memory = ring.Reserve(size);
+    }
+
+    LogRecord* record = new (memory) LogRecord();
+    record->Type = type;
+    record->Level = level;
+    record->FilterLength = uint16(filter.length());
+    record->DataLength = uint32(dataSize);
+    record->Time = time(nullptr);
+    record->Format = nullptr;
+    record->FormatString = nullptr;
+    record->FormatLength = 0;
+    record->Message = nullptr;
+    std::memcpy(reinterpret_cast<char*>(record + 1), filter.data(), filter.length());
+    return record;
+}
+
+void AsyncLogQueue::EndRecord(LogRingBuffer& ring, LogLevel level)
+{
+    // wake the logger thread early instead of waiting for the flush interval when the ring is filling up
+    // or when the process may be about to die
+    if (ring.Commit() || level >= LOG_LEVEL_FATAL)
+        _wakeup.notify_one();
+}
+
+bool AsyncLogQueue::EnqueueFormatted(std::string_view filter, LogLevel level, FormatStringView format, FormatArgs args)
+{
+    if (IsConsumerThread())
+        return false;
+
+    thread_local fmt::memory_buffer buffer;
+    buffer.clear();
+    StringVFormatTo(std::back_inserter(buffer), format, args);
+
+    LogRingBuffer* ring = GetThreadRing();
+    if (!FitsInRecord(*ring, filter, buffer.size()))
+    {
+        std::unique_ptr<LogMessage> message = std::make_unique<LogMessage>(level, filter, std::string(buffer.data(), buffer.size()));
+        return EnqueueMessage(message);
+    }
+
+    LogRecord* record = BeginRecord(*ring, LogRecordType::Text, filter, level, buffer.size());
+    if (!record)
+        return true;
+
+    std::memcpy(record->GetData(), buffer.data(), buffer.size());
+    EndRecord(*ring, level);
+    return true;
+}
+
+bool AsyncLogQueue::EnqueueMessage(std::unique_ptr<LogMessage>& message)
+{
+    if (IsConsumerThread())
+        return false;
+
+    LogRingBuffer* ring = GetThreadRing();
+    LogRecord* record = BeginRecord(*ring, LogRecordType::Message, {}, message->level, 0);
+    if (!record)
+    {
+        message.reset();
+        return true;
+    }
+
+    record->Message = message.release();
+    EndRecord(*ring, record->Level);
+    return true;
+}
+
+void AsyncLogQueue::Flush()
+{
+    std::lock_guard<std::mutex> lock(_consumerLock);
+    ConsumerScope scope;
+    DrainLocked();
+}
+
+void AsyncLogQueue::Run()
+{
+    std::unique_lock<std::mutex> wakeupLock(_wakeupLock);
+    while (!_stopping)
+    {
+        _wakeup.wait_for(wakeupLock, _options.FlushInterval);
+
+        wakeupLock.unlock();
+        Flush();
+        wakeupLock.lock();
+    }
+}
+
+void AsyncLogQueue::DrainLocked()
+{
+    {
+        std::lock_guard<std::mutex> lock(_ringsLock);
+        _drainList = _rings;
+    }
+
+    for (std::shared_ptr<LogRingBuffer> const& ring : _drainList)
+        ring->Consume([this](void* record) { Process(*static_cast<LogRecord*>(record)); });
+
+    _drainList.clear();
+
+    uint64 dropped = _dropped.load(std::memory_order_relaxed);
+    if (dropped != _reportedDrops)
+    {
+        LogMessage message(LOG_LEVEL_WARN, "server", StringFormat("Log queue full, dropped {} messages ({} since startup)", dropped - _reportedDrops, dropped));
+        _write(&message);
+        _reportedDrops = dropped;
+    }
+
+    _flush();
+
+    // rings of exited threads are only referenced by us anymore, forget them once written out
+    std::lock_guard<std::mutex> lock(_ringsLock);
+    _rings.erase(std::remove_if(_rings.begin(), _rings.end(), [](std::shared_ptr<LogRingBuffer> const& ring)
+    {
+        return ring.use_count() == 1 && ring->IsEmpty();
+    }), _rings.end());
+}
+
+void AsyncLogQueue::Process(LogRecord const& record)
+{
+    if (record.Type == LogRecordType::Message)
+    {
+        std::unique_ptr<LogMessage> message(record.Message);
+        _write(message.get());
+        return;
+    }
+
+    std::string text;
+    if (record.Type == LogRecordType::Deferred)
+        text = record.Format({ record.FormatString, record.FormatLength }, record.GetData());
+    else
+        text.assign(reinterpret_cast<char const*>(record.GetData()), record.DataLength);
+
+    LogMessage message(record.Level, { record.GetFilter(), record.FilterLength }, std::move(text));
+    message.mtime = record.Time;
+    _write(&message);
+}
+}
@@ -0,0 +1,287 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITYCORE_ASYNC_LOG_QUEUE_H
+#define TRINITYCORE_ASYNC_LOG_QUEUE_H
+
+#include "Define.h"
+#include "Duration.h"
+#include "LogCommon.h"
+#include "StringFormat.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+struct LogMessage;
+
+namespace Trinity::Logging
+{
+class LogRingBuffer;
+
+enum class LogDropPolicy : uint8
+{
+    Block       = 0,    // producers wait for the logger thread to make room
+    DropNewest  = 1     // messages that do not fit are counted and discarded
+};
+
+struct AsyncLogOptions
+{
+    std::size_t QueueSize = 256 * 1024;
+    LogDropPolicy DropPolicy = LogDropPolicy::Block;
+    Milliseconds FlushInterval = 100ms;
+};
+
+/**
+ * Encoding of a format argument into a log record, so formatting can happen on the logger thread
+ *
+ * Only types that can be copied without keeping references into the caller are supported,
+ * everything else is formatted on the calling thread.
+ */
+template <typename T, typename = void>
+struct DeferredArg
+{
+    static constexpr bool Supported = false;
+};
+
+template <typename T>
+struct DeferredArg<T, std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>>>
+{
+    static constexpr bool Supported = true;
+    using Decoded = T;
+
+    static bool IsValid(T const& /*value*/) { return true; }
+    static std::size_t GetSize(T const& /*value*/) { return sizeof(T); }
+
+    static uint8* Encode(uint8* out, T const& value)
+    {
+        std::memcpy(out, &value, sizeof(T));
+        return out + sizeof(T);
+    }
+
+    static T Decode(uint8 const*& in)
+    {
+        T value;
+        std::memcpy(&value, in, sizeof(T));
+        in += sizeof(T);
+        return value;
+    }
+};
+
+struct DeferredStringArg
+{
+    static constexpr bool Supported = true;
+    using Decoded = std::string_view;
+
+    static std::size_t GetSize(std::string_view value) { return sizeof(uint32) + value.length(); }
+
+    static uint8* Encode(uint8* out, std::string_view value)
+    {
+        uint32 length = uint32(value.length());
+        std::memcpy(out, &length, sizeof(length));
+        std::memcpy(out + sizeof(length), value.data(), length);
+        return out + sizeof(length) + length;
+    }
+
+    static std::string_view Decode(uint8 const*& in)
+    {
+        uint32 length;
+        std::memcpy(&length, in, sizeof(length));
+        std::string_view value(reinterpret_cast<char const*>(in + sizeof(length)), length);
+        in += sizeof(length) + length;
+        return value;
+    }
+};
+
+template <>
+struct DeferredArg<std::string> : DeferredStringArg
+{
+    static bool IsValid(std::string const& /*value*/) { return true; }
+};
+
+template <>
+struct DeferredArg<std::string_view> : DeferredStringArg
+{
+    static bool IsValid(std::string_view /*value*/) { return true; }
+};
+
+template <>
+struct DeferredArg<char const*> : DeferredStringArg
+{
+    // fmt rejects null strings, let the calling thread produce that error
+    static bool IsValid(char const* value) { return value != nullptr; }
+};
+
+template <>
+struct DeferredArg<char*> : DeferredArg<char const*> { };
+
+template <std::size_t N>
+struct DeferredArg<char[N]> : DeferredArg<char const*> { };
+
+template <typename... Args>
+inline constexpr bool AreArgsDeferrable = (DeferredArg<std::remove_cvref_t<Args>>::Supported && ...);
+
+using DeferredFormatFn = std::string(*)(FormatStringView format, uint8 const* args);
+
+template <typename... Args>
+std::string FormatDeferred(FormatStringView format, [[maybe_unused]] uint8 const* args)
+{
+    // braced initialization decodes the arguments left to right, in the order they were encoded
+    std::tuple<typename DeferredArg<Args>::Decoded...> values{ DeferredArg<Args>::Decode(args)... };
+    return std::apply([format](auto const&... value) { return StringVFormat(format, MakeFormatArgs(value...)); }, values);
+}
+
+enum class LogRecordType : uint8
+{
+    Deferred,   // format string and encoded arguments
+    Text,       // formatted on the calling thread
+    Message     // owned LogMessage, for messages with extra parameters or too large for the ring
+};
+
+struct LogRecord
+{
+    LogRecordType Type;
+    LogLevel Level;
+    uint16 FilterLength;
+    uint32 DataLength;
+    time_t Time;
+    DeferredFormatFn Format;
+    char const* FormatString;
+    std::size_t FormatLength;
+    LogMessage* Message;
+
+    char const* GetFilter() const { return reinterpret_cast<char const*>(this + 1); }
+    uint8* GetData() { return reinterpret_cast<uint8*>(this + 1) + FilterLength; }
+    uint8 const* GetData() const { return reinterpret_cast<uint8 const*>(this + 1) + FilterLength; }
+};
+
+/**
+ * Moves log messages off the logging threads
+ *
+ * Every thread writes into its own lock-free ring, a dedicated logger thread drains all rings
+ * every flush interval (or sooner when one of them fills up), formats deferred messages, hands them
+ * to the write callback and then calls the flush callback once for the whole batch.
+ */
+class TC_COMMON_API AsyncLogQueue
+{
+public:
+    using WriteFn = std::function<void(LogMessage* message)>;
+    using FlushFn = std::function<void()>;
+
+    AsyncLogQueue(AsyncLogOptions const& options, WriteFn write, FlushFn flush);
+    ~AsyncLogQueue();
+
+    AsyncLogQueue(AsyncLogQueue const&) = delete;
+    AsyncLogQueue(AsyncLogQueue&&) = delete;
+    AsyncLogQueue& operator=(AsyncLogQueue const&) = delete;
+    AsyncLogQueue& operator=(AsyncLogQueue&&) = delete;
+
+    /// Returns false when the message must be written by the caller (arguments that cannot be deferred, or called from the logger thread)
+    template <typename... Args>
+    bool EnqueueDeferred(std::string_view filter, LogLevel level, FormatStringView format, Args const&... args)
+    {
+        if (IsConsumerThread() || !(DeferredArg<std::remove_cvref_t<Args>>::IsValid(args) && ...))
+            return false;
+
+        std::size_t dataSize = (std::size_t(0) + ... + DeferredArg<std::remove_cvref_t<Args>>::GetSize(args));
+        LogRingBuffer* ring = GetThreadRing();
+        if (!FitsInRecord(*ring, filter, dataSize))
+            return false;
+
+        LogRecord* record = BeginRecord(*ring, LogRecordType::Deferred, filter, level, dataSize);
+        if (!record)
+            return true;
+
+        [[maybe_unused]] uint8* data = record->GetData();
+        ((data = DeferredArg<std::remove_cvref_t<Args>>::Encode(data, args)), ...);
+        record->Format = &FormatDeferred<std::remove_cvref_t<Args>...>;
+        record->FormatString = format.data();
+        record->FormatLength = format.size();
+        EndRecord(*ring, level);
+        return true;
+    }
+
+    /// Formats on the calling thread, returns false when called from the logger thread
+    bool EnqueueFormatted(std::string_view filter, LogLevel level, FormatStringView format, FormatArgs args);
+
+    /// Takes ownership of message unless it returns false (called from the logger thread)
+    bool EnqueueMessage(std::unique_ptr<LogMessage>& message);
+
+    /// Writes and flushes everything enqueued so far on the calling thread
+    void Flush();
+
+    /// Flushes, then calls fn while the logger thread is held off
+    template <typename Fn>
+    void Synchronize(Fn&& fn)
+    {
+        std::lock_guard<std::mutex> lock(_consumerLock);
+        ConsumerScope scope;
+        DrainLocked();
+        fn();
+    }
+
+    uint64 GetDroppedCount() const { return _dropped.load(std::memory_order_relaxed); }
+
+    /// True on the logger thread and inside Flush/Synchronize, messages logged there are written directly
+    static bool IsConsumerThread();
+
+private:
+    struct ConsumerScope
+    {
+        ConsumerScope();
+        ~ConsumerScope();
+    };
+
+    LogRingBuffer* GetThreadRing();
+    static bool FitsInRecord(LogRingBuffer const& ring, std::string_view filter, std::size_t dataSize);
+    LogRecord* BeginRecord(LogRingBuffer& ring, LogRecordType type, std::string_view filter, LogLevel level, std::size_t dataSize);
+    void EndRecord(LogRingBuffer& ring, LogLevel level);
+
+    void Run();
+    void DrainLocked();
+    void Process(LogRecord const& record);
+
+    uint64 const _id;
+    AsyncLogOptions const _options;
+    WriteFn _write;
+    FlushFn _flush;
+
+    std::mutex _ringsLock;
+    std::vector<std::shared_ptr<LogRingBuffer>> _rings;
+    std::vector<std::shared_ptr<LogRingBuffer>> _drainList;
+
+    std::atomic<uint64> _dropped;
+    uint64 _reportedDrops;
+
+    std::mutex _consumerLock;
+    std::mutex _wakeupLock;
+    std::condition_variable _wakeup;
+    bool _stopping;
+    std::thread _thread;
+};
+}
+
+#endif // TRINITYCORE_ASYNC_LOG_QUEUE_H
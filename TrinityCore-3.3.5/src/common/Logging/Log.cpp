@@ -24,13 +24,12 @@
 #include "Errors.h"
 #include "Logger.h"
 #include "LogMessage.h"
-#include "LogOperation.h"
-#include "Strand.h"
 #include "StringConvert.h"
 #include "Util.h"
+#include <algorithm>
 #include <sstream>
 
-Log::Log() : AppenderId(0), lowestLogLevel(LOG_LEVEL_FATAL), _ioContext(nullptr), _strand(nullptr)
+Log::Log() : AppenderId(0), lowestLogLevel(LOG_LEVEL_FATAL), _asyncFlushSize(0)
 {
     m_logsTimestamp = "_" + GetTimestampStr();
     RegisterAppender<AppenderConsole>();
@@ -39,7 +38,7 @@ Log::Log() : AppenderId(0), lowestLogLevel(LOG_LEVEL_FATAL), _ioContext(nullptr)
 
 Log::~Log()
 {
-    delete _strand;
+    _asyncQueue.reset();
     Close();
 }
 
@@ -216,6 +215,9 @@ void Log::RegisterAppender(uint8 index, AppenderCreatorFn appenderCreateFn)
 
 void Log::OutMessageImpl(std::string_view filter, LogLevel level, Trinity::FormatStringView messageFormat, Trinity::FormatArgs messageFormatArgs)
 {
+    if (_asyncQueue && _asyncQueue->EnqueueFormatted(filter, level, messageFormat, messageFormatArgs))
+        return;
+
     write(std::make_unique<LogMessage>(level, filter, Trinity::StringVFormat(messageFormat, messageFormatArgs)));
 }
 
@@ -225,16 +227,24 @@ void Log::OutCommandImpl(uint32 account, Trinity::FormatStringView messageFormat
 }
 
 void Log::write(std::unique_ptr<LogMessage> msg) const
+{
+    if (_asyncQueue && _asyncQueue->EnqueueMessage(msg))
+        return;
+
+    writeSynchronous(msg.get());
+}
+
+void Log::writeSynchronous(LogMessage* msg) const
 {
     Logger const* logger = GetLoggerByType(msg->type);
+    if (!logger)
+        return;
 
-    if (_ioContext)
-    {
-        std::shared_ptr<LogOperation> logOperation = std::make_shared<LogOperation>(logger, std::move(msg));
-        Trinity::Asio::post(*_ioContext, Trinity::Asio::bind_executor(*_strand, [logOperation]() { logOperation->call(); }));
-    }
-    else
-        logger->write(msg.get());
+    logger->write(msg);
+
+    // the logger thread flushes once per batch
+    if (!_asyncQueue)
+        logger->flush();
 }
 
 Logger const* Log::GetLoggerByType(std::string const& type) const
@@ -291,6 +301,9 @@ bool Log::SetLogLevel(std::string const& name, int32 newLeveli, bool isLogger /*
 
         if (newLevel != LOG_LEVEL_DISABLED && newLevel < lowestLogLevel)
             lowestLogLevel = newLevel;
+
+        // call sites check the cached level only, let them see the change right away
+        UpdateCategories();
     }
     else
     {
@@ -334,22 +347,62 @@ void Log::Close()
     appenders.clear();
 }
 
-bool Log::ShouldLog(std::string const& type, LogLevel level) const
+bool Log::ShouldLog(std::string_view type, LogLevel level)
 {
-    // TODO: Use cache to store "Type.sub1.sub2": "Type" equivalence, should
-    // Speed up in cases where requesting "Type.sub1.sub2" but only configured
-    // Logger "Type"
-
     // Don't even look for a logger if the LogLevel is lower than lowest log levels across all loggers
     if (level < lowestLogLevel)
         return false;
 
-    Logger const* logger = GetLoggerByType(type);
-    if (!logger)
-        return false;
+    return GetCategory(type)->IsEnabled(level);
+}
+
+Trinity::Logging::LogCategory* Log::GetCategory(std::string_view name)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(_categoriesLock);
+        auto itr = _categories.find(name);
+        if (itr != _categories.end())
+            return itr->second.get();
+    }
+
+    std::unique_lock<std::shared_mutex> lock(_categoriesLock);
+    auto itr = _categories.find(name);
+    if (itr != _categories.end())
+        return itr->second.get();
+
+    // the key views the name owned by the category
+    std::unique_ptr<Trinity::Logging::LogCategory> category = std::make_unique<Trinity::Logging::LogCategory>(name);
+    category->Threshold.store(GetCategoryThreshold(category->Name), std::memory_order_relaxed);
+    std::string_view key = category->Name;
+    return _categories.emplace(key, std::move(category)).first->second.get();
+}
+
+uint8 Log::GetCategoryThreshold(std::string const& name) const
+{
+    Logger const* logger = GetLoggerByType(name);
+    if (!logger || logger->getLogLevel() == LOG_LEVEL_DISABLED)
+        return Trinity::Logging::LogCategory::DisabledThreshold;
 
-    LogLevel logLevel = logger->getLogLevel();
-    return logLevel != LOG_LEVEL_DISABLED && logLevel <= level;
+    return logger->getLogLevel();
+}
+
+void Log::UpdateCategories()
+{
+    std::unique_lock<std::shared_mutex> lock(_categoriesLock);
+    for (auto const& [name, category] : _categories)
+        category->Threshold.store(GetCategoryThreshold(category->Name), std::memory_order_relaxed);
+}
+
+std::atomic<uint8> const* Trinity::Logging::LogCallSite::Resolve(std::string_view filter)
+{
+    std::atomic<uint8> const* threshold = &sLog->GetCategory(filter)->Threshold;
+    _threshold.store(threshold, std::memory_order_release);
+    return threshold;
+}
+
+bool Trinity::Logging::LogCallSite::ShouldLogUncached(std::string_view filter, LogLevel level)
+{
+    return sLog->ShouldLog(filter, level);
 }
 
 Log* Log::instance()
@@ -358,12 +411,23 @@ Log* Log::instance()
     return &instance;
 }
 
-void Log::Initialize(Trinity::Asio::IoContext* ioContext)
+void Log::Initialize(bool async)
 {
-    if (ioContext)
+    if (async)
     {
-        _ioContext = ioContext;
-        _strand = new Trinity::Asio::Strand(*ioContext);
+        Trinity::Logging::AsyncLogOptions options;
+        options.QueueSize = std::max(sConfigMgr->GetIntDefault("Log.Async.QueueSize", 262144), 0);
+        options.DropPolicy = sConfigMgr->GetIntDefault("Log.Async.DropPolicy", 0) == 1 ? Trinity::Logging::LogDropPolicy::DropNewest : Trinity::Logging::LogDropPolicy::Block;
+        options.FlushInterval = Milliseconds(std::max(sConfigMgr->GetIntDefault("Log.Async.FlushInterval", 100), 1));
+        _asyncFlushSize = std::max(sConfigMgr->GetIntDefault("Log.Async.FlushSize", 65536), 0);
+
+        _asyncQueue = std::make_unique<Trinity::Logging::AsyncLogQueue>(options,
+            [this](LogMessage* msg) { writeSynchronous(msg); },
+            [this]()
+            {
+                for (std::pair<uint8 const, std::unique_ptr<Appender>>& appender : appenders)
+                    appender.second->flush();
+            });
     }
 
     LoadFromConfig();
@@ -371,12 +435,23 @@ void Log::Initialize(Trinity::Asio::IoContext* ioContext)
 
 void Log::SetSynchronous()
 {
-    delete _strand;
-    _strand = nullptr;
-    _ioContext = nullptr;
+    // writes out everything still queued
+    _asyncQueue.reset();
+
+    for (std::pair<uint8 const, std::unique_ptr<Appender>>& appender : appenders)
+        appender.second->flush();
 }
 
 void Log::LoadFromConfig()
+{
+    // loggers and appenders are about to be replaced, keep the logger thread away from them
+    if (_asyncQueue)
+        _asyncQueue->Synchronize([this] { ReadConfig(); });
+    else
+        ReadConfig();
+}
+
+void Log::ReadConfig()
 {
     Close();
 
@@ -389,4 +464,5 @@ void Log::LoadFromConfig()
 
     ReadAppendersFromConfig();
     ReadLoggersFromConfig();
+    UpdateCategories();
 }
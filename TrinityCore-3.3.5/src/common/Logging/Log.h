@@ -19,11 +19,13 @@
 #define TRINITYCORE_LOG_H
 
 #include "Define.h"
-#include "AsioHacksFwd.h"
+#include "AsyncLogQueue.h"
+#include "LogCategory.h"
 #include "LogCommon.h"
 #include "StringFormat.h"
 
 #include <memory>
+#include <shared_mutex>
 #include <unordered_map>
 #include <vector>
 
@@ -31,14 +33,6 @@ class Appender;
 class Logger;
 struct LogMessage;
 
-namespace Trinity
-{
-    namespace Asio
-    {
-        class IoContext;
-    }
-}
-
 #define LOGGER_ROOT "root"
 
 typedef Appender*(*AppenderCreatorFn)(uint8 id, std::string const& name, LogLevel level, AppenderFlags flags, std::vector<std::string_view> const& extraArgs);
@@ -64,16 +58,24 @@ class TC_COMMON_API Log
     public:
         static Log* instance();
 
-        void Initialize(Trinity::Asio::IoContext* ioContext);
+        void Initialize(bool async);
         void SetSynchronous();  // Not threadsafe - should only be called from main() after all threads are joined
         void LoadFromConfig();
         void Close();
-        bool ShouldLog(std::string const& type, LogLevel level) const;
+        bool ShouldLog(std::string_view type, LogLevel level);
         bool SetLogLevel(std::string const& name, int32 level, bool isLogger = true);
 
+        /// Returns the interned category for a logger name, categories live as long as the Log
+        Trinity::Logging::LogCategory* GetCategory(std::string_view name);
+
         template<typename... Args>
         void OutMessage(std::string_view filter, LogLevel const level, Trinity::FormatString<Args...> fmt, Args&&... args)
         {
+            // format strings are literals, only the arguments need to be copied for the logger thread
+            if constexpr (Trinity::Logging::AreArgsDeferrable<Args...>)
+                if (_asyncQueue && _asyncQueue->EnqueueDeferred(filter, level, fmt, args...))
+                    return;
+
             this->OutMessageImpl(filter, level, fmt, Trinity::MakeFormatArgs(args...));
         }
 
@@ -98,10 +100,16 @@ class TC_COMMON_API Log
 
         std::string const& GetLogsDir() const { return m_logsDir; }
         std::string const& GetLogsTimestamp() const { return m_logsTimestamp; }
+        std::size_t GetAsyncFlushSize() const { return _asyncFlushSize; }
+        uint64 GetDroppedMessageCount() const { return _asyncQueue ? _asyncQueue->GetDroppedCount() : 0; }
 
     private:
         static std::string GetTimestampStr();
         void write(std::unique_ptr<LogMessage> msg) const;
+        void writeSynchronous(LogMessage* msg) const;
+        void ReadConfig();
+        uint8 GetCategoryThreshold(std::string const& name) const;
+        void UpdateCategories();
 
         Logger const* GetLoggerByType(std::string const& type) const;
         Appender* GetAppenderByName(std::string_view name);
@@ -123,8 +131,11 @@ class TC_COMMON_API Log
         std::string m_logsDir;
         std::string m_logsTimestamp;
 
-        Trinity::Asio::IoContext* _ioContext;
-        Trinity::Asio::Strand* _strand;
+        std::unordered_map<std::string_view, std::unique_ptr<Trinity::Logging::LogCategory>> _categories;
+        std::shared_mutex _categoriesLock;
+
+        std::unique_ptr<Trinity::Logging::AsyncLogQueue> _asyncQueue;
+        std::size_t _asyncFlushSize;
 };
 
 #define sLog Log::instance()
@@ -136,7 +147,8 @@ class TC_COMMON_API Log
 // This will catch format errors on build time
 #define TC_LOG_MESSAGE_BODY(filterType__, level__, ...)                 \
         do {                                                            \
-            if (sLog->ShouldLog(filterType__, level__))                 \
+            static Trinity::Logging::LogCallSite callSite__;            \
+            if (callSite__.ShouldLog(filterType__, level__))            \
                 sLog->OutMessage(filterType__, level__, __VA_ARGS__);   \
         } while (0)
 #else
@@ -144,7 +156,8 @@ class TC_COMMON_API Log
         __pragma(warning(push))                                         \
         __pragma(warning(disable:4127))                                 \
         do {                                                            \
-            if (sLog->ShouldLog(filterType__, level__))                 \
+            static Trinity::Logging::LogCallSite callSite__;            \
+            if (callSite__.ShouldLog(filterType__, level__))            \
                 sLog->OutMessage(filterType__, level__, __VA_ARGS__);   \
         } while (0)                                                     \
         __pragma(warning(pop))
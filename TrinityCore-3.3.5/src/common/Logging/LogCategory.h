@@ -0,0 +1,89 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITYCORE_LOG_CATEGORY_H
+#define TRINITYCORE_LOG_CATEGORY_H
+
+#include "Define.h"
+#include "LogCommon.h"
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace Trinity::Logging
+{
+/**
+ * Interned logger name
+ *
+ * Threshold holds the level of the logger the name resolves to (walking dotted parents),
+ * it is updated in place whenever loggers are reconfigured so cached pointers to it never go stale.
+ */
+struct LogCategory
+{
+    static constexpr uint8 DisabledThreshold = LOG_LEVEL_INVALID;
+
+    explicit LogCategory(std::string_view name) : Name(name), Threshold(DisabledThreshold) { }
+
+    bool IsEnabled(LogLevel level) const { return uint8(level) >= Threshold.load(std::memory_order_relaxed); }
+
+    std::string const Name;
+    std::atomic<uint8> Threshold;
+};
+
+/**
+ * Per call site cache used by the TC_LOG_* macros
+ *
+ * Literal logger names are resolved once, after that checking the level costs two loads and a compare.
+ * Names that are not literals take the uncached path every time.
+ */
+class TC_COMMON_API LogCallSite
+{
+public:
+    constexpr LogCallSite() : _threshold(nullptr) { }
+
+    template <std::size_t N>
+    bool ShouldLog(char const (&filter)[N], LogLevel level)
+    {
+        std::atomic<uint8> const* threshold = _threshold.load(std::memory_order_acquire);
+        if (!threshold) [[unlikely]]
+            threshold = Resolve(filter);
+
+        return uint8(level) >= threshold->load(std::memory_order_relaxed);
+    }
+
+    // mutable buffers may change their contents between calls
+    template <std::size_t N>
+    bool ShouldLog(char (&filter)[N], LogLevel level)
+    {
+        return ShouldLogUncached(filter, level);
+    }
+
+    bool ShouldLog(std::string_view filter, LogLevel level)
+    {
+        return ShouldLogUncached(filter, level);
+    }
+
+private:
+    std::atomic<uint8> const* Resolve(std::string_view filter);
+    static bool ShouldLogUncached(std::string_view filter, LogLevel level);
+
+    std::atomic<std::atomic<uint8> const*> _threshold;
+};
+}
+
+#endif // TRINITYCORE_LOG_CATEGORY_H
@@ -0,0 +1,154 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITYCORE_LOG_RING_BUFFER_H
+#define TRINITYCORE_LOG_RING_BUFFER_H
+
+#include "Define.h"
+#include <atomic>
+#include <memory>
+
+namespace Trinity::Logging
+{
+/**
+ * Single producer single consumer ring of variable sized records
+ *
+ * The producer reserves space for a record, fills it in place and commits it, the consumer only ever sees whole records.
+ * Records never wrap around, the unused end of the buffer is skipped with a padding record instead.
+ */
+class LogRingBuffer
+{
+    struct RecordHeader
+    {
+        uint32 Size;
+        bool Padding;
+    };
+
+public:
+    static constexpr std::size_t RecordAlignment = 8;
+    static constexpr std::size_t MinCapacity = 4096;
+
+    explicit LogRingBuffer(std::size_t capacity) : _capacity(RoundUpCapacity(capacity)), _storage(std::make_unique<uint64[]>(_capacity / sizeof(uint64))),
+        _buffer(reinterpret_cast<uint8*>(_storage.get())), _head(0), _pendingHead(0), _cachedTail(0), _tail(0)
+    {
+        static_assert(sizeof(RecordHeader) == RecordAlignment && alignof(uint64) == RecordAlignment);
+    }
+
+    LogRingBuffer(LogRingBuffer const&) = delete;
+    LogRingBuffer(LogRingBuffer&&) = delete;
+    LogRingBuffer& operator=(LogRingBuffer const&) = delete;
+    LogRingBuffer& operator=(LogRingBuffer&&) = delete;
+
+    /// Largest payload Reserve can ever succeed for
+    std::size_t GetMaxRecordSize() const { return _capacity / 4 - sizeof(RecordHeader); }
+
+    /// Producer only, returns nullptr when the ring does not have room for the record right now
+    void* Reserve(std::size_t size)
+    {
+        std::size_t total = (sizeof(RecordHeader) + size + RecordAlignment - 1) & ~(RecordAlignment - 1);
+        if (size > GetMaxRecordSize())
+            return nullptr;
+
+        std::size_t head = _head.load(std::memory_order_relaxed);
+        std::size_t offset = head & (_capacity - 1);
+        std::size_t padding = offset + total > _capacity ? _capacity - offset : 0;
+        if (head + padding + total - _cachedTail > _capacity)
+        {
+            _cachedTail = _tail.load(std::memory_order_acquire);
+            if (head + padding + total - _cachedTail > _capacity)
+                return nullptr;
+        }
+
+        if (padding)
+        {
+            *reinterpret_cast<RecordHeader*>(_buffer + offset) = { uint32(padding), true };
+            head += padding;
+            offset = 0;
+        }
+
+        RecordHeader* header = reinterpret_cast<RecordHeader*>(_buffer + offset);
+        *header = { uint32(total), false };
+        _pendingHead = head + total;
+        return header + 1;
+    }
+
+    /// Producer only, publishes the record returned by the last Reserve. Returns true when the ring is more than half full.
+    bool Commit()
+    {
+        _head.store(_pendingHead, std::memory_order_release);
+        if ((_pendingHead - _cachedTail) * 2 <= _capacity)
+            return false;
+
+        _cachedTail = _tail.load(std::memory_order_acquire);
+        return (_pendingHead - _cachedTail) * 2 > _capacity;
+    }
+
+    /// Consumer only, calls fn(void* payload) for every committed record and frees their space
+    template <class Fn>
+    std::size_t Consume(Fn&& fn)
+    {
+        std::size_t count = 0;
+        std::size_t tail = _tail.load(std::memory_order_relaxed);
+        std::size_t head = _head.load(std::memory_order_acquire);
+        while (tail != head)
+        {
+            RecordHeader* header = reinterpret_cast<RecordHeader*>(_buffer + (tail & (_capacity - 1)));
+            if (!header->Padding)
+            {
+                fn(static_cast<void*>(header + 1));
+                ++count;
+            }
+
+            tail += header->Size;
+            _tail.store(tail, std::memory_order_release);
+        }
+
+        return count;
+    }
+
+    bool IsEmpty() const
+    {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+    std::size_t GetCapacity() const { return _capacity; }
+
+private:
+    static std::size_t RoundUpCapacity(std::size_t capacity)
+    {
+        std::size_t result = MinCapacity;
+        while (result < capacity)
+            result *= 2;
+
+        return result;
+    }
+
+    std::size_t const _capacity;
+    std::unique_ptr<uint64[]> _storage;
+    uint8* const _buffer;
+
+    // producer side
+    alignas(64) std::atomic<std::size_t> _head;
+    std::size_t _pendingHead;
+    std::size_t _cachedTail;
+
+    // consumer side
+    alignas(64) std::atomic<std::size_t> _tail;
+};
+}
+
+#endif // TRINITYCORE_LOG_RING_BUFFER_H
@@ -58,3 +58,10 @@ void Logger::write(LogMessage* message) const
         if (appender.second)
             appender.second->write(message);
 }
+
+void Logger::flush() const
+{
+    for (std::pair<uint8 const, Appender*> const& appender : appenders)
+        if (appender.second)
+            appender.second->flush();
+}
@@ -38,6 +38,7 @@ class TC_COMMON_API Logger
         LogLevel getLogLevel() const;
         void setLogLevel(LogLevel level);
         void write(LogMessage* message) const;
+        void flush() const;
 
     private:
         std::string name;
@@ -0,0 +1,75 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AllocationCounter.h"
+
+#ifdef WITH_ALLOCATION_COUNTER
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+thread_local uint64 ThreadAllocationCount = 0;
+}
+
+// Replaces the global allocation functions for the whole program, they are pulled in by the first
+// caller of GetThreadAllocationCount. Array and nothrow forms forward to these by default.
+// Builds with BUILD_SHARED_LIBS only count allocations made from within the common library on Windows.
+void* operator new(std::size_t size)
+{
+    ++ThreadAllocationCount;
+
+    if (!size)
+        size = 1;
+
+    for (;;)
+    {
+        if (void* memory = std::malloc(size))
+            return memory;
+
+        std::new_handler handler = std::get_new_handler();
+        if (!handler)
+            throw std::bad_alloc();
+
+        handler();
+    }
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t /*size*/) noexcept
+{
+    std::free(memory);
+}
+
+uint64 Trinity::GetThreadAllocationCount()
+{
+    return ThreadAllocationCount;
+}
+
+#else
+
+uint64 Trinity::GetThreadAllocationCount()
+{
+    return 0;
+}
+
+#endif
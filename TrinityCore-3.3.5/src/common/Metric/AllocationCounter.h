@@ -15,27 +15,25 @@
  * with this program. If not, see <http://www.gnu.org/licenses/>.
  */
 
-#ifndef LOGOPERATION_H
-#define LOGOPERATION_H
+#ifndef TRINITYCORE_ALLOCATION_COUNTER_H
+#define TRINITYCORE_ALLOCATION_COUNTER_H
 
 #include "Define.h"
-#include <memory>
 
-class Logger;
-struct LogMessage;
-
-class TC_COMMON_API LogOperation
+namespace Trinity
 {
-    public:
-        LogOperation(Logger const* _logger, std::unique_ptr<LogMessage>&& _msg);
-
-        ~LogOperation();
-
-        int call();
+    /// True when built with WITH_ALLOCATION_COUNTER, global operator new then counts every allocation per thread
+    constexpr bool IsAllocationCounterEnabled()
+    {
+#ifdef WITH_ALLOCATION_COUNTER
+        return true;
+#else
+        return false;
+#endif
+    }
 
-    protected:
-        Logger const* logger;
-        std::unique_ptr<LogMessage> msg;
-};
+    /// Number of operator new calls made by the calling thread so far, always 0 without WITH_ALLOCATION_COUNTER
+    TC_COMMON_API uint64 GetThreadAllocationCount();
+}
 
-#endif
+#endif // TRINITYCORE_ALLOCATION_COUNTER_H
@@ -20,10 +20,80 @@
 #include "Config.h"
 #include "DeadlineTimer.h"
 #include "Log.h"
+#include "MetricHttpEndpoint.h"
 #include "Strand.h"
+#include "StringFormat.h"
 #include "Util.h"
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+
+struct Metric::LocalSeries
+{
+    std::string Name;
+    std::string Labels;
+    bool IsDuration = false;
+    MetricHistogram Histogram;
+
+    // Prometheus expects _sum and _count to only ever grow, only touched by TakeLocalSnapshot
+    uint64 TotalCount = 0;
+    uint64 TotalSum = 0;
+};
+
+namespace
+{
+std::string FormatPrometheusName(std::string_view name)
+{
+    std::string formatted(name);
+    for (char& c : formatted)
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '_' && c != ':')
+            c = '_';
+
+    if (formatted.empty() || isdigit(static_cast<unsigned char>(formatted[0])))
+        formatted.insert(formatted.begin(), '_');
+
+    return formatted;
+}
+
+void AppendPrometheusLabel(std::string& labels, std::string_view name, std::string_view value)
+{
+    if (!labels.empty())
+        labels += ',';
+
+    labels += FormatPrometheusName(name);
+    labels += "=\"";
+    for (char c : value)
+    {
+        if (c == '\\' || c == '"')
+            labels += '\\';
+        else if (c == '\n')
+        {
+            labels += "\\n";
+            continue;
+        }
+
+        labels += c;
+    }
+
+    labels += '"';
+}
+
+std::string FormatPrometheusLabels(std::string const& labels)
+{
+    return labels.empty() ? std::string() : '{' + labels + '}';
+}
+
+std::string FormatPrometheusValue(double value)
+{
+    if (std::isnan(value))
+        return "NaN";
+
+    return Trinity::StringFormat("{}", value);
+}
+}
 
 void Metric::Initialize(std::string const& realmName, Trinity::Asio::IoContext& ioContext, std::function<void()> overallStatusLogger)
 {
@@ -32,7 +102,21 @@ void Metric::Initialize(std::string const& realmName, Trinity::Asio::IoContext&
     _batchTimer = std::make_unique<Trinity::Asio::DeadlineTimer>(ioContext);
     _overallStatusTimer = std::make_unique<Trinity::Asio::DeadlineTimer>(ioContext);
     _overallStatusLogger = overallStatusLogger;
+    _ioContext = &ioContext;
+    _localSnapshotTimer = std::make_unique<Trinity::Asio::DeadlineTimer>(ioContext);
+    AppendPrometheusLabel(_localRealmLabel, "realm", realmName);
     LoadFromConfigs();
+
+    // the endpoint is only set up once, changing where it listens needs a restart
+    if (_localEnabled)
+    {
+        if (uint16 port = uint16(sConfigMgr->GetIntDefault("Metric.Local.Port", 0)))
+        {
+            _localHttpEndpoint = std::make_unique<MetricHttpEndpoint>(ioContext, sConfigMgr->GetStringDefault("Metric.Local.BindIP", "127.0.0.1"), port,
+                [this] { return GetLocalSnapshot(); });
+            _localHttpEndpoint->Start();
+        }
+    }
 }
 
 bool Metric::Connect()
@@ -54,6 +138,8 @@ bool Metric::Connect()
 void Metric::LoadFromConfigs()
 {
     bool previousValue = _enabled;
+    bool previousAnyEnabled = IsEnabled();
+    LoadLocalConfigs();
     _enabled = sConfigMgr->GetBoolDefault("Metric.Enable", false);
     _updateInterval = sConfigMgr->GetIntDefault("Metric.Interval", 1);
     if (_updateInterval < 1)
@@ -102,8 +188,29 @@ void Metric::LoadFromConfigs()
         Connect();
 
         ScheduleSend();
+    }
+
+    if (IsEnabled() && !previousAnyEnabled)
         ScheduleOverallStatusLog();
+}
+
+void Metric::LoadLocalConfigs()
+{
+    bool previousValue = _localEnabled;
+    _localEnabled = sConfigMgr->GetBoolDefault("Metric.Local.Enable", false);
+    _localInterval = sConfigMgr->GetIntDefault("Metric.Local.Interval", 10);
+    if (_localInterval < 1)
+    {
+        TC_LOG_ERROR("metric", "'Metric.Local.Interval' config set to {}, overriding to 1.", _localInterval);
+        _localInterval = 1;
     }
+
+    _localMaxSeries = uint32(std::max(sConfigMgr->GetIntDefault("Metric.Local.MaxSeries", 2000), 1));
+    _localFile = sConfigMgr->GetStringDefault("Metric.Local.File", "");
+    _localFileMaxSize = uint64(std::max(sConfigMgr->GetIntDefault("Metric.Local.FileMaxSize", 10 * 1024 * 1024), 0));
+
+    if (_localEnabled && !previousValue)
+        ScheduleLocalSnapshot();
 }
 
 void Metric::Update()
@@ -127,6 +234,10 @@ void Metric::LogEvent(std::string category, std::string title, std::string descr
 {
     using namespace std::chrono;
 
+    // events are not aggregated locally
+    if (!_enabled)
+        return;
+
     MetricData* data = new MetricData;
     data->Category = std::move(category);
     data->Timestamp = system_clock::now();
@@ -242,13 +353,181 @@ void Metric::Unload()
         SendBatch();
     }
 
+    // last snapshot covers whatever happened since the previous one
+    if (_localEnabled && Trinity::Asio::get_io_context(*_localSnapshotTimer).stopped())
+    {
+        _localEnabled = false;
+        TakeLocalSnapshot();
+    }
+
     _batchTimer->cancel();
     _overallStatusTimer->cancel();
+    _localSnapshotTimer->cancel();
+    if (_localHttpEndpoint)
+        _localHttpEndpoint->Close();
+}
+
+MetricHistogram* Metric::GetHistogram(std::string const& category, MetricTagsVector const& tags, bool isDuration)
+{
+    std::string key = category;
+    for (MetricTag const& tag : tags)
+    {
+        key += '\n';
+        key += tag.first;
+        key += '=';
+        key += tag.second;
+    }
+
+    {
+        std::shared_lock<std::shared_mutex> lock(_localSeriesLock);
+        auto itr = _localSeries.find(key);
+        if (itr != _localSeries.end())
+            return &itr->second->Histogram;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(_localSeriesLock);
+    auto itr = _localSeries.find(key);
+    if (itr != _localSeries.end())
+        return &itr->second->Histogram;
+
+    // tags like account ids could create a series for every player, call sites without tags are always tracked
+    if (!tags.empty() && _localSeries.size() >= _localMaxSeries)
+    {
+        if (!_localSeriesLimitReported)
+        {
+            _localSeriesLimitReported = true;
+            TC_LOG_ERROR("metric", "Local metrics reached 'Metric.Local.MaxSeries' ({}) with '{}', new tagged series are ignored.", _localMaxSeries, category);
+        }
+
+        return nullptr;
+    }
+
+    std::unique_ptr<LocalSeries>& series = _localSeries[std::move(key)];
+    series = std::make_unique<LocalSeries>();
+    series->Name = FormatPrometheusName(category);
+    series->Labels = _localRealmLabel;
+    for (MetricTag const& tag : tags)
+        AppendPrometheusLabel(series->Labels, tag.first, tag.second);
+
+    series->IsDuration = isDuration;
+    return &series->Histogram;
+}
+
+std::shared_ptr<std::string const> Metric::GetLocalSnapshot()
+{
+    std::lock_guard<std::mutex> lock(_localSnapshotLock);
+    return _localSnapshot;
+}
+
+std::string Metric::BuildLocalSnapshot()
+{
+    static constexpr double Quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+    std::vector<std::pair<LocalSeries*, MetricHistogramSnapshot>> collected;
+    {
+        std::shared_lock<std::shared_mutex> lock(_localSeriesLock);
+        collected.reserve(_localSeries.size());
+        for (auto const& [key, series] : _localSeries)
+            collected.emplace_back(series.get(), series->Histogram.Collect());
+    }
+
+    // every line of a metric family has to be next to each other
+    std::sort(collected.begin(), collected.end(), [](auto const& left, auto const& right)
+    {
+        return std::tie(left.first->Name, left.first->Labels) < std::tie(right.first->Name, right.first->Labels);
+    });
+
+    std::string text;
+    for (auto familyBegin = collected.begin(); familyBegin != collected.end();)
+    {
+        auto familyEnd = std::find_if(familyBegin, collected.end(), [&](auto const& series) { return series.first->Name != familyBegin->first->Name; });
+
+        // durations are recorded in microseconds, Prometheus wants seconds
+        bool isDuration = familyBegin->first->IsDuration;
+        std::string name = familyBegin->first->Name + (isDuration ? "_seconds" : "");
+        double divisor = isDuration ? 1e6 : 1.0;
+
+        text += Trinity::StringFormat("# TYPE {} summary\n", name);
+        for (auto itr = familyBegin; itr != familyEnd; ++itr)
+        {
+            LocalSeries* series = itr->first;
+            MetricHistogramSnapshot const& values = itr->second;
+            series->TotalCount += values.Count;
+            series->TotalSum += values.Sum;
+
+            for (double quantile : Quantiles)
+            {
+                std::string labels = series->Labels;
+                AppendPrometheusLabel(labels, "quantile", Trinity::StringFormat("{}", quantile));
+                double value = values.Count ? double(values.GetValueAtPercentile(quantile * 100.0)) / divisor : std::nan("");
+                text += Trinity::StringFormat("{}{{{}}} {}\n", name, labels, FormatPrometheusValue(value));
+            }
+
+            text += Trinity::StringFormat("{}_sum{} {}\n", name, FormatPrometheusLabels(series->Labels), FormatPrometheusValue(double(series->TotalSum) / divisor));
+            text += Trinity::StringFormat("{}_count{} {}\n", name, FormatPrometheusLabels(series->Labels), series->TotalCount);
+        }
+
+        text += Trinity::StringFormat("# TYPE {}_max gauge\n", name);
+        for (auto itr = familyBegin; itr != familyEnd; ++itr)
+            text += Trinity::StringFormat("{}_max{} {}\n", name, FormatPrometheusLabels(itr->first->Labels), FormatPrometheusValue(double(itr->second.Max) / divisor));
+
+        familyBegin = familyEnd;
+    }
+
+    return text;
+}
+
+void Metric::ScheduleLocalSnapshot()
+{
+    if (!_localEnabled)
+        return;
+
+    _localSnapshotTimer->expires_after(std::chrono::seconds(_localInterval));
+    _localSnapshotTimer->async_wait([this](boost::system::error_code const& error)
+    {
+        if (error)
+            return;
+
+        TakeLocalSnapshot();
+        ScheduleLocalSnapshot();
+    });
+}
+
+void Metric::TakeLocalSnapshot()
+{
+    std::shared_ptr<std::string const> snapshot = std::make_shared<std::string const>(BuildLocalSnapshot());
+    {
+        std::lock_guard<std::mutex> lock(_localSnapshotLock);
+        _localSnapshot = snapshot;
+    }
+
+    if (!_localFile.empty())
+        WriteLocalSnapshot(*snapshot);
+}
+
+void Metric::WriteLocalSnapshot(std::string const& snapshot) const
+{
+    std::string path = sLog->GetLogsDir() + _localFile;
+
+    // rotate into a single .1 file, snapshots never take more than twice Metric.Local.FileMaxSize
+    boost::system::error_code error;
+    uintmax_t size = boost::filesystem::file_size(path, error);
+    if (!error && _localFileMaxSize && size + snapshot.size() > _localFileMaxSize)
+        boost::filesystem::rename(path, path + ".1", error);
+
+    std::ofstream file(path, std::ios::app);
+    if (!file)
+    {
+        TC_LOG_ERROR("metric", "Could not open '{}' to write local metrics.", path);
+        return;
+    }
+
+    file << "# " << TimeToTimestampStr(time(nullptr)) << '\n' << snapshot << '\n';
 }
 
 void Metric::ScheduleOverallStatusLog()
 {
-    if (_enabled)
+    if (IsEnabled())
     {
         _overallStatusTimer->expires_after(std::chrono::seconds(_overallStatusTimerInterval));
         _overallStatusTimer->async_wait([this](const boost::system::error_code&)
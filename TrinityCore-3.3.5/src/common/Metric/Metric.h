@@ -20,13 +20,18 @@
 
 #include "Define.h"
 #include "Duration.h"
+#include "MetricHistogram.h"
 #include "MPSCQueue.h"
 #include "Optional.h"
+#include <algorithm>
 #include <vector>
 #include <functional>
 #include <iosfwd>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 
@@ -66,9 +71,13 @@ struct MetricData
     std::atomic<MetricData*> QueueLink;
 };
 
+class MetricHttpEndpoint;
+
 class TC_COMMON_API Metric
 {
 private:
+    struct LocalSeries;
+
     std::iostream& GetDataStream() { return *_dataStream; }
     std::unique_ptr<std::iostream> _dataStream;
     MPSCQueue<MetricData, &MetricData::QueueLink> _queuedData;
@@ -85,10 +94,45 @@ private:
     std::string _realmName;
     std::unordered_map<std::string, int64> _thresholds;
 
+    // local aggregation, works without the metric database
+    Trinity::Asio::IoContext* _ioContext = nullptr;
+    std::unordered_map<std::string, std::unique_ptr<LocalSeries>> _localSeries;
+    std::shared_mutex _localSeriesLock;
+    std::unique_ptr<Trinity::Asio::DeadlineTimer> _localSnapshotTimer;
+    std::unique_ptr<MetricHttpEndpoint> _localHttpEndpoint;
+    std::shared_ptr<std::string const> _localSnapshot;
+    std::mutex _localSnapshotLock;
+    bool _localEnabled = false;
+    bool _localSeriesLimitReported = false;
+    int32 _localInterval = 0;
+    uint32 _localMaxSeries = 0;
+    std::string _localFile;
+    uint64 _localFileMaxSize = 0;
+    std::string _localRealmLabel;
+
     bool Connect();
     void SendBatch();
     void ScheduleSend();
     void ScheduleOverallStatusLog();
+    void LoadLocalConfigs();
+    void ScheduleLocalSnapshot();
+    void TakeLocalSnapshot();
+    void WriteLocalSnapshot(std::string const& snapshot) const;
+
+    template <class T>
+    void RecordLocalValue(std::string const& category, MetricTagsVector const& tags, T value)
+    {
+        if constexpr (std::is_arithmetic_v<T> && !std::is_same_v<T, bool>)
+            if (MetricHistogram* histogram = GetHistogram(category, tags, false))
+                histogram->Record(value > T(0) ? uint64(value) : 0);
+    }
+
+    template <class Rep, class Period>
+    void RecordLocalValue(std::string const& category, MetricTagsVector const& tags, std::chrono::duration<Rep, Period> value)
+    {
+        if (MetricHistogram* histogram = GetHistogram(category, tags, true))
+            histogram->Record(std::max<int64>(std::chrono::duration_cast<std::chrono::microseconds>(value).count(), 0));
+    }
 
     static std::string FormatInfluxDBValue(bool value);
     template <class T>
@@ -113,26 +157,46 @@ public:
     void Update();
     bool ShouldLog(std::string const& category, int64 value) const;
 
-    template<class T, class... Tags>
-    void LogValue(std::string category, T value, Tags&&... tags)
+    template<class T, class... TagTypes>
+    void LogValue(std::string category, T value, TagTypes&&... tags)
     {
         using namespace std::chrono;
 
+        MetricTagsVector tagsVector;
+        if constexpr (sizeof...(tags) > 0)
+            (tagsVector.emplace_back(std::move(tags)), ...);
+
+        if (_localEnabled)
+            RecordLocalValue(category, tagsVector, value);
+
+        if (!_enabled)
+            return;
+
         MetricData* data = new MetricData;
         data->Category = std::move(category);
         data->Timestamp = system_clock::now();
         data->Type = METRIC_DATA_VALUE;
         data->ValueOrEventText = FormatInfluxDBValue(value);
-        if constexpr (sizeof...(tags) > 0)
-            (data->Tags.emplace_back(std::move(tags)), ...);
+        data->Tags = std::move(tagsVector);
 
         _queuedData.Enqueue(data);
     }
 
     void LogEvent(std::string category, std::string title, std::string description);
 
+    /// Histogram aggregating a metric locally, the pointer stays valid until shutdown.
+    /// Returns nullptr for tagged series once Metric.Local.MaxSeries is reached.
+    MetricHistogram* GetHistogram(std::string const& category, MetricTagsVector const& tags, bool isDuration);
+
+    /// Latest snapshot of the local histograms in Prometheus text format, empty until the first one is taken
+    std::shared_ptr<std::string const> GetLocalSnapshot();
+
+    /// Collects every local histogram, percentiles cover the values recorded since the previous call
+    std::string BuildLocalSnapshot();
+
     void Unload();
-    bool IsEnabled() const { return _enabled; }
+    bool IsEnabled() const { return _enabled || _localEnabled; }
+    bool IsLocalEnabled() const { return _localEnabled; }
 };
 
 #define sMetric Metric::instance()
@@ -166,6 +230,29 @@ Optional<MetricStopWatch<LoggerType>> MakeMetricStopWatch(LoggerType&& loggerFun
     return Optional<MetricStopWatch<LoggerType>>(std::in_place, std::forward<LoggerType>(loggerFunc));
 }
 
+class MetricHistogramStopWatch
+{
+public:
+    explicit MetricHistogramStopWatch(MetricHistogram* histogram) : _histogram(histogram)
+    {
+        if (_histogram)
+            _startTime = std::chrono::steady_clock::now();
+    }
+
+    ~MetricHistogramStopWatch()
+    {
+        if (_histogram)
+            _histogram->Record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _startTime).count());
+    }
+
+    MetricHistogramStopWatch(MetricHistogramStopWatch const&) = delete;
+    MetricHistogramStopWatch& operator=(MetricHistogramStopWatch const&) = delete;
+
+private:
+    MetricHistogram* _histogram;
+    TimePoint _startTime;
+};
+
 #define TC_METRIC_TAG(name, value) MetricTag(name, value)
 
 #define TC_METRIC_DO_CONCAT(a, b) a ## b
@@ -179,6 +266,7 @@ Optional<MetricStopWatch<LoggerType>> MakeMetricStopWatch(LoggerType&& loggerFun
 #define TC_METRIC_DETAILED_EVENT(category, title, description) ((void)0)
 #define TC_METRIC_DETAILED_TIMER(category, ...) ((void)0)
 #define TC_METRIC_DETAILED_NO_THRESHOLD_TIMER(category, ...) ((void)0)
+#define TC_METRIC_HISTOGRAM_TIMER(category) ((void)0)
 #else
 #  if TRINITY_PLATFORM != TRINITY_PLATFORM_WINDOWS
 #define TC_METRIC_EVENT(category, title, description)                  \
@@ -214,6 +302,10 @@ Optional<MetricStopWatch<LoggerType>> MakeMetricStopWatch(LoggerType&& loggerFun
         {                                                                                                        \
             sMetric->LogValue(category, std::chrono::steady_clock::now() - start, ##__VA_ARGS__);                \
         });
+// only aggregated locally, for call sites too hot to send every sample to the metric database
+#define TC_METRIC_HISTOGRAM_TIMER(category)                                                                      \
+        static MetricHistogram* const TC_METRIC_UNIQUE_NAME(__tc_metric_histogram) = sMetric->GetHistogram(category, {}, true); \
+        MetricHistogramStopWatch TC_METRIC_UNIQUE_NAME(__tc_metric_histogram_stop_watch)(sMetric->IsLocalEnabled() ? TC_METRIC_UNIQUE_NAME(__tc_metric_histogram) : nullptr);
 #  if defined WITH_DETAILED_METRICS
 #define TC_METRIC_DETAILED_TIMER(category, ...)                                                                  \
         auto TC_METRIC_UNIQUE_NAME(__tc_metric_stop_watch) = MakeMetricStopWatch([&](TimePoint start)            \
@@ -0,0 +1,64 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MetricHistogram.h"
+#include <algorithm>
+#include <cmath>
+
+uint64 MetricHistogramSnapshot::GetValueAtPercentile(double percentile) const
+{
+    if (!Count)
+        return 0;
+
+    // rank of the value we are looking for, 1 based
+    uint64 rank = std::max<uint64>(uint64(std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * double(Count))), 1);
+    uint64 seen = 0;
+    for (uint32 i = 0; i < Counts.size(); ++i)
+    {
+        seen += Counts[i];
+        if (seen >= rank)
+            return std::min(MetricHistogram::GetBucketHighestValue(i), Max);
+    }
+
+    return Max;
+}
+
+MetricHistogram::MetricHistogram() : _sum(0), _max(0)
+{
+    for (std::atomic<uint64>& count : _counts)
+        count.store(0, std::memory_order_relaxed);
+}
+
+MetricHistogramSnapshot MetricHistogram::Collect()
+{
+    MetricHistogramSnapshot snapshot;
+    snapshot.Counts.resize(BucketCount);
+
+    // the count is summed from the buckets so percentiles always see a consistent total
+    for (uint32 i = 0; i < BucketCount; ++i)
+    {
+        if (!_counts[i].load(std::memory_order_relaxed))
+            continue;
+
+        snapshot.Counts[i] = _counts[i].exchange(0, std::memory_order_relaxed);
+        snapshot.Count += snapshot.Counts[i];
+    }
+
+    snapshot.Sum = _sum.exchange(0, std::memory_order_relaxed);
+    snapshot.Max = _max.exchange(0, std::memory_order_relaxed);
+    return snapshot;
+}
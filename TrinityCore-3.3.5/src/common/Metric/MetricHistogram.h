@@ -0,0 +1,97 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITYCORE_METRIC_HISTOGRAM_H
+#define TRINITYCORE_METRIC_HISTOGRAM_H
+
+#include "Define.h"
+#include <array>
+#include <atomic>
+#include <bit>
+#include <vector>
+
+/// Values recorded by a MetricHistogram since the previous snapshot
+struct TC_COMMON_API MetricHistogramSnapshot
+{
+    std::vector<uint64> Counts;
+    uint64 Count = 0;
+    uint64 Sum = 0;
+    uint64 Max = 0;
+
+    /// Highest value equivalent to the one found at percentile (0-100), 0 when nothing was recorded
+    uint64 GetValueAtPercentile(double percentile) const;
+};
+
+/**
+ * Log-linear histogram in the spirit of HdrHistogram
+ *
+ * Values below 2 * SubBucketCount are counted exactly, larger ones share SubBucketCount buckets per power of two,
+ * which keeps the relative error of every percentile under 1 / SubBucketCount.
+ * Recording takes a few relaxed atomic operations and never blocks, snapshots can be taken from any thread.
+ */
+class TC_COMMON_API MetricHistogram
+{
+public:
+    static constexpr uint32 SubBucketBits = 5;
+    static constexpr uint32 SubBucketCount = 1 << SubBucketBits;
+    static constexpr uint32 MaxValueBits = 40;
+    static constexpr uint64 MaxValue = (uint64(1) << MaxValueBits) - 1;
+    static constexpr uint32 BucketCount = (MaxValueBits - SubBucketBits + 1) * SubBucketCount;
+
+    MetricHistogram();
+
+    MetricHistogram(MetricHistogram const&) = delete;
+    MetricHistogram& operator=(MetricHistogram const&) = delete;
+
+    /// Values above MaxValue are counted as MaxValue
+    void Record(uint64 value)
+    {
+        if (value > MaxValue)
+            value = MaxValue;
+
+        _counts[GetBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(value, std::memory_order_relaxed);
+
+        uint64 max = _max.load(std::memory_order_relaxed);
+        while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+            ;
+    }
+
+    /// Moves everything recorded so far into the snapshot, values recorded meanwhile land in this one or the next
+    MetricHistogramSnapshot Collect();
+
+    static constexpr uint32 GetBucketIndex(uint64 value)
+    {
+        uint32 width = uint32(std::bit_width(value));
+        uint32 shift = width > SubBucketBits + 1 ? width - SubBucketBits - 1 : 0;
+        return shift * SubBucketCount + uint32(value >> shift);
+    }
+
+    static constexpr uint64 GetBucketHighestValue(uint32 index)
+    {
+        uint32 shift = index >= 2 * SubBucketCount ? (index >> SubBucketBits) - 1 : 0;
+        uint64 mantissa = index - shift * SubBucketCount;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+private:
+    std::array<std::atomic<uint64>, BucketCount> _counts;
+    std::atomic<uint64> _sum;
+    std::atomic<uint64> _max;
+};
+
+#endif // TRINITYCORE_METRIC_HISTOGRAM_H
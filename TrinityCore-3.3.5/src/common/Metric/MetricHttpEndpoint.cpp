@@ -0,0 +1,186 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MetricHttpEndpoint.h"
+#include "DeadlineTimer.h"
+#include "IpAddress.h"
+#include "Log.h"
+#include "StringFormat.h"
+#include <boost/asio/bind_executor.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/read_until.hpp>
+#include <boost/asio/streambuf.hpp>
+#include <boost/asio/write.hpp>
+#include <array>
+#include <istream>
+
+using boost::asio::ip::tcp;
+
+namespace
+{
+class MetricHttpConnection : public std::enable_shared_from_this<MetricHttpConnection>
+{
+public:
+    // the socket lives on its own strand, the timeout and completion handlers are bound to it so they never overlap
+    using Socket = boost::asio::basic_stream_socket<tcp, MetricHttpEndpoint::Strand>;
+
+    static constexpr std::size_t MaxRequestSize = 8 * 1024;
+    static constexpr Seconds RequestTimeout = 5s;
+
+    MetricHttpConnection(Trinity::Asio::IoContext& ioContext, Socket&& socket, std::shared_ptr<std::string const> snapshot) :
+        _socket(std::move(socket)), _timeout(ioContext), _request(MaxRequestSize), _body(std::move(snapshot))
+    {
+    }
+
+    void Start()
+    {
+        // scrapers send their request right away, do not let idle connections pile up
+        _timeout.expires_after(RequestTimeout);
+        _timeout.async_wait(boost::asio::bind_executor(_socket.get_executor(), [self = shared_from_this()](boost::system::error_code const& error)
+        {
+            if (!error)
+                self->Close();
+        }));
+
+        boost::asio::async_read_until(_socket, _request, "\r\n\r\n", boost::asio::bind_executor(_socket.get_executor(), [self = shared_from_this()](boost::system::error_code const& error, std::size_t /*length*/)
+        {
+            self->HandleRequest(error);
+        }));
+    }
+
+private:
+    void HandleRequest(boost::system::error_code const& error)
+    {
+        _timeout.cancel();
+
+        // also rejects requests larger than MaxRequestSize
+        if (error)
+            return Close();
+
+        std::istream request(&_request);
+        std::string method, target;
+        request >> method >> target;
+
+        if (method != "GET")
+            SetResponse("405 Method Not Allowed", nullptr);
+        else if (target != "/metrics")
+            SetResponse("404 Not Found", nullptr);
+        else
+            SetResponse("200 OK", _body);
+
+        std::array<boost::asio::const_buffer, 2> buffers = { boost::asio::buffer(_header), boost::asio::buffer(*_body) };
+        boost::asio::async_write(_socket, buffers, boost::asio::bind_executor(_socket.get_executor(), [self = shared_from_this()](boost::system::error_code const& /*error*/, std::size_t /*length*/)
+        {
+            self->Close();
+        }));
+    }
+
+    void SetResponse(std::string_view status, std::shared_ptr<std::string const> body)
+    {
+        static std::shared_ptr<std::string const> const EmptyBody = std::make_shared<std::string const>();
+
+        _body = body ? std::move(body) : EmptyBody;
+        _header = Trinity::StringFormat("HTTP/1.1 {}\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: {}\r\nConnection: close\r\n\r\n",
+            status, _body->size());
+    }
+
+    void Close()
+    {
+        boost::system::error_code ignored;
+        _socket.shutdown(tcp::socket::shutdown_both, ignored);
+        _socket.close(ignored);
+    }
+
+    Socket _socket;
+    Trinity::Asio::DeadlineTimer _timeout;
+    boost::asio::streambuf _request;
+    std::string _header;
+    std::shared_ptr<std::string const> _body;
+};
+}
+
+MetricHttpEndpoint::MetricHttpEndpoint(Trinity::Asio::IoContext& ioContext, std::string const& bindIp, uint16 port, SnapshotFn getSnapshot) :
+    _ioContext(ioContext), _acceptor(boost::asio::make_strand(ioContext.get_executor())), _bindIp(bindIp), _port(port), _getSnapshot(std::move(getSnapshot)), _closed(false)
+{
+}
+
+MetricHttpEndpoint::~MetricHttpEndpoint()
+{
+    Close();
+}
+
+bool MetricHttpEndpoint::Start()
+{
+    boost::system::error_code error;
+    tcp::endpoint endpoint(Trinity::Net::make_address(_bindIp, error), _port);
+    if (error)
+    {
+        TC_LOG_ERROR("metric", "Invalid 'Metric.Local.BindIP' {}: {}", _bindIp, error.message());
+        return false;
+    }
+
+    _acceptor.open(endpoint.protocol(), error);
+    if (!error)
+        _acceptor.set_option(tcp::acceptor::reuse_address(true), error);
+    if (!error)
+        _acceptor.bind(endpoint, error);
+    if (!error)
+        _acceptor.listen(boost::asio::socket_base::max_listen_connections, error);
+
+    if (error)
+    {
+        TC_LOG_ERROR("metric", "Could not serve metrics on {}:{}: {}", _bindIp, _port, error.message());
+        return false;
+    }
+
+    TC_LOG_INFO("metric", "Serving local metrics on http://{}:{}/metrics", _bindIp, _port);
+    AsyncAccept();
+    return true;
+}
+
+void MetricHttpEndpoint::Close()
+{
+    if (_closed.exchange(true))
+        return;
+
+    auto closeAcceptor = [this]
+    {
+        boost::system::error_code ignored;
+        _acceptor.close(ignored);
+    };
+
+    // on shutdown the io_context is already stopped and nothing runs on the strand anymore
+    if (static_cast<boost::asio::io_context&>(_ioContext).stopped())
+        closeAcceptor();
+    else
+        boost::asio::post(_acceptor.get_executor(), closeAcceptor);
+}
+
+void MetricHttpEndpoint::AsyncAccept()
+{
+    // the accept handler runs on the acceptor strand, each accepted socket gets a strand of its own
+    _acceptor.async_accept(boost::asio::make_strand(_ioContext.get_executor()), [this](boost::system::error_code const& error, MetricHttpConnection::Socket socket)
+    {
+        if (_closed)
+            return;
+
+        if (!error)
+            std::make_shared<MetricHttpConnection>(_ioContext, std::move(socket), _getSnapshot())->Start();
+
+        AsyncAccept();
+    });
+}
@@ -0,0 +1,61 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITYCORE_METRIC_HTTP_ENDPOINT_H
+#define TRINITYCORE_METRIC_HTTP_ENDPOINT_H
+
+#include "Define.h"
+#include "IoContext.h"
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/strand.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+
+/**
+ * Minimal HTTP listener answering GET /metrics with the latest local metric snapshot,
+ * meant to be scraped by Prometheus. Runs on the io_context it is given, every connection is closed after one response.
+ * The acceptor and every connection run their handlers on a strand of their own, the io_context is shared by several threads.
+ */
+class TC_COMMON_API MetricHttpEndpoint
+{
+public:
+    using SnapshotFn = std::function<std::shared_ptr<std::string const>()>;
+    using Strand = boost::asio::strand<boost::asio::io_context::executor_type>;
+
+    MetricHttpEndpoint(Trinity::Asio::IoContext& ioContext, std::string const& bindIp, uint16 port, SnapshotFn getSnapshot);
+    ~MetricHttpEndpoint();
+
+    bool Start();
+    void Close();
+
+    std::string const& GetBindIp() const { return _bindIp; }
+    uint16 GetPort() const { return _port; }
+
+private:
+    void AsyncAccept();
+
+    Trinity::Asio::IoContext& _ioContext;
+    boost::asio::basic_socket_acceptor<boost::asio::ip::tcp, Strand> _acceptor;
+    std::string _bindIp;
+    uint16 _port;
+    SnapshotFn _getSnapshot;
+    std::atomic<bool> _closed;
+};
+
+#endif // TRINITYCORE_METRIC_HTTP_ENDPOINT_H
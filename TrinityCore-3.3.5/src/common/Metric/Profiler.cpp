@@ -0,0 +1,393 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Profiler.h"
+#include "Log.h"
+#include "StringFormat.h"
+#include "Util.h"
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <map>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#  ifdef _MSC_VER
+#    include <intrin.h>
+#  else
+#    include <x86intrin.h>
+#  endif
+#  define TRINITY_PROFILER_RDTSC
+#endif
+
+namespace Trinity
+{
+struct Profiler::ThreadBuffer
+{
+    uint32 Id = 0;
+    std::atomic<bool> InUse = false;
+
+    // written by the owning thread only, Stop reads the first Count events
+    std::atomic<uint64> Session = 0;
+    std::array<std::unique_ptr<ProfilerCapture::Event[]>, MaxEventsPerThread / EventsPerChunk> Chunks;
+    std::atomic<uint32> Count = 0;
+    std::atomic<uint32> Dropped = 0;
+};
+
+namespace
+{
+struct ThreadBufferOwner
+{
+    std::atomic<bool>* InUse = nullptr;
+    void* Buffer = nullptr;
+
+    ~ThreadBufferOwner()
+    {
+        if (InUse)
+            InUse->store(false, std::memory_order_release);
+    }
+};
+
+thread_local ThreadBufferOwner CurrentThreadBuffer;
+thread_local uint32 ZoneDepth = 0;
+
+// keeps zone names readable inside JSON strings and folded stack frames
+void AppendEscaped(std::string& out, char const* text, bool folded)
+{
+    for (; *text; ++text)
+    {
+        char c = *text;
+        if (folded && c == ';')
+            c = '_';
+        else if (!folded && (c == '"' || c == '\\'))
+            out += '\\';
+
+        out += c;
+    }
+}
+}
+
+std::atomic<bool> Profiler::Recording = false;
+
+Profiler::Profiler() : _session(0), _startTicks(0), _stopWriter(false)
+{
+}
+
+Profiler::~Profiler()
+{
+    // captures still queued at shutdown are written before the process exits
+    {
+        std::lock_guard<std::mutex> lock(_writeLock);
+        _stopWriter = true;
+    }
+    _writeCondition.notify_one();
+
+    if (_writer.joinable())
+        _writer.join();
+}
+
+Profiler* Profiler::instance()
+{
+    static Profiler instance;
+    return &instance;
+}
+
+uint64 Profiler::GetTicks()
+{
+#ifdef TRINITY_PROFILER_RDTSC
+    return __rdtsc();
+#else
+    return uint64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+    if (CurrentThreadBuffer.Buffer)
+        return static_cast<ThreadBuffer*>(CurrentThreadBuffer.Buffer);
+
+    std::lock_guard<std::mutex> lock(_lock);
+
+    // reuse the buffer of an exited thread, map and network threads are long lived but others come and go
+    ThreadBuffer* buffer = nullptr;
+    for (std::unique_ptr<ThreadBuffer> const& thread : _threads)
+    {
+        bool expected = false;
+        if (thread->InUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+        {
+            buffer = thread.get();
+            break;
+        }
+    }
+
+    if (!buffer)
+    {
+        buffer = _threads.emplace_back(std::make_unique<ThreadBuffer>()).get();
+        buffer->Id = uint32(_threads.size());
+        buffer->InUse.store(true, std::memory_order_relaxed);
+    }
+
+    CurrentThreadBuffer.InUse = &buffer->InUse;
+    CurrentThreadBuffer.Buffer = buffer;
+    return buffer;
+}
+
+void Profiler::Zone::Begin()
+{
+    ++ZoneDepth;
+    _start = GetTicks();
+}
+
+void Profiler::Zone::End()
+{
+    uint64 end = GetTicks();
+    --ZoneDepth;
+
+    ThreadBuffer* buffer = sProfiler->GetThreadBuffer();
+    uint64 session = sProfiler->_session.load(std::memory_order_acquire);
+    if (buffer->Session.load(std::memory_order_relaxed) != session)
+    {
+        // Stop is done reading this buffer before the next session can begin
+        buffer->Session.store(session, std::memory_order_relaxed);
+        buffer->Count.store(0, std::memory_order_relaxed);
+        buffer->Dropped.store(0, std::memory_order_relaxed);
+    }
+
+    uint32 count = buffer->Count.load(std::memory_order_relaxed);
+    if (count >= MaxEventsPerThread)
+    {
+        buffer->Dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // memory is only committed for threads that actually record zones, and kept for the next capture
+    std::unique_ptr<ProfilerCapture::Event[]>& chunk = buffer->Chunks[count / EventsPerChunk];
+    if (!chunk)
+        chunk = std::make_unique<ProfilerCapture::Event[]>(EventsPerChunk);
+
+    chunk[count % EventsPerChunk] = { _name, _start, end, ZoneDepth };
+    buffer->Count.store(count + 1, std::memory_order_release);
+}
+
+bool Profiler::Start(Milliseconds duration)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    if (Recording.load(std::memory_order_relaxed))
+        return false;
+
+    _startTicks = GetTicks();
+    _startTime = std::chrono::steady_clock::now();
+    _endTime = _startTime + duration;
+    _session.fetch_add(1, std::memory_order_release);
+    Recording.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+std::unique_ptr<ProfilerCapture> Profiler::Stop()
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    if (!Recording.exchange(false, std::memory_order_relaxed))
+        return nullptr;
+
+    uint64 endTicks = GetTicks();
+    TimePoint endTime = std::chrono::steady_clock::now();
+    uint64 session = _session.load(std::memory_order_relaxed);
+
+    std::unique_ptr<ProfilerCapture> capture = std::make_unique<ProfilerCapture>();
+    capture->StartTicks = _startTicks;
+
+    // calibrate the tick source against the steady clock over the whole capture
+    double elapsedMicroseconds = double(std::chrono::duration_cast<std::chrono::microseconds>(endTime - _startTime).count());
+    capture->TicksPerMicrosecond = elapsedMicroseconds > 0.0 ? double(endTicks - _startTicks) / elapsedMicroseconds : 1.0;
+
+    for (std::unique_ptr<ThreadBuffer> const& buffer : _threads)
+    {
+        uint32 count = buffer->Count.load(std::memory_order_acquire);
+        if (buffer->Session.load(std::memory_order_relaxed) != session || !count)
+            continue;
+
+        ProfilerCapture::Thread& thread = capture->Threads.emplace_back();
+        thread.Id = buffer->Id;
+        thread.Events.reserve(count);
+        for (uint32 i = 0; i < count; i += EventsPerChunk)
+        {
+            ProfilerCapture::Event const* chunk = buffer->Chunks[i / EventsPerChunk].get();
+            thread.Events.insert(thread.Events.end(), chunk, chunk + std::min(count - i, EventsPerChunk));
+        }
+
+        thread.Dropped = buffer->Dropped.load(std::memory_order_relaxed);
+    }
+
+    return capture;
+}
+
+void Profiler::Write(std::unique_ptr<ProfilerCapture> capture)
+{
+    if (!capture)
+        return;
+
+    std::string fileName = sLog->GetLogsDir() + "profile_" + TimeToTimestampStr(time(nullptr));
+    std::replace(fileName.begin(), fileName.end(), ':', '-');
+
+    // files can get large, the world thread only queues them and never waits for an earlier capture
+    {
+        std::lock_guard<std::mutex> lock(_writeLock);
+        if (!_writer.joinable())
+            _writer = std::thread(&Profiler::WriterThread, this);
+
+        _writeQueue.emplace(std::move(fileName), std::move(capture));
+    }
+    _writeCondition.notify_one();
+}
+
+void Profiler::WriterThread()
+{
+    std::unique_lock<std::mutex> lock(_writeLock);
+    while (true)
+    {
+        _writeCondition.wait(lock, [this] { return _stopWriter || !_writeQueue.empty(); });
+        if (_writeQueue.empty())
+            return;
+
+        std::string fileName = std::move(_writeQueue.front().first);
+        std::unique_ptr<ProfilerCapture> capture = std::move(_writeQueue.front().second);
+        _writeQueue.pop();
+
+        lock.unlock();
+        std::ofstream(fileName + ".json", std::ios::trunc) << capture->ToChromeTrace();
+        std::ofstream(fileName + ".folded", std::ios::trunc) << capture->ToFoldedStacks();
+        TC_LOG_INFO("server.profiler", "Profile with {} zones ({} dropped) written to {}.json and {}.folded",
+            capture->GetEventCount(), capture->GetDroppedCount(), fileName, fileName);
+        lock.lock();
+    }
+}
+
+void Profiler::Update()
+{
+    if (!Recording.load(std::memory_order_relaxed))
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        if (std::chrono::steady_clock::now() < _endTime)
+            return;
+    }
+
+    Write(Stop());
+}
+
+uint64 ProfilerCapture::GetEventCount() const
+{
+    uint64 count = 0;
+    for (Thread const& thread : Threads)
+        count += thread.Events.size();
+
+    return count;
+}
+
+uint64 ProfilerCapture::GetDroppedCount() const
+{
+    uint64 count = 0;
+    for (Thread const& thread : Threads)
+        count += thread.Dropped;
+
+    return count;
+}
+
+std::string ProfilerCapture::ToChromeTrace() const
+{
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    for (Thread const& thread : Threads)
+    {
+        if (!first)
+            json += ',';
+
+        first = false;
+        json += Trinity::StringFormat(R"({{"name":"thread_name","ph":"M","pid":1,"tid":{},"args":{{"name":"Thread {}"}}}})", thread.Id, thread.Id);
+        for (Event const& event : thread.Events)
+        {
+            json += R"(,{"name":")";
+            AppendEscaped(json, event.Zone, false);
+            json += Trinity::StringFormat(R"(","ph":"X","pid":1,"tid":{},"ts":{:.3f},"dur":{:.3f}}})", thread.Id,
+                double(event.Start - StartTicks) / TicksPerMicrosecond, double(event.End - event.Start) / TicksPerMicrosecond);
+        }
+    }
+
+    json += "]}\n";
+    return json;
+}
+
+std::string ProfilerCapture::ToFoldedStacks() const
+{
+    struct Frame
+    {
+        std::string Stack;
+        uint64 Duration;
+        uint64 ChildDuration;
+    };
+
+    std::map<std::string, uint64> selfTimes;
+    for (Thread const& thread : Threads)
+    {
+        // events are stored as zones end, children before their parent
+        std::vector<Event> events = thread.Events;
+        std::sort(events.begin(), events.end(), [](Event const& left, Event const& right)
+        {
+            return left.Start != right.Start ? left.Start < right.Start : left.Depth < right.Depth;
+        });
+
+        std::vector<Frame> stack;
+        auto popFrame = [&]()
+        {
+            Frame& frame = stack.back();
+            selfTimes[frame.Stack] += frame.Duration - std::min(frame.Duration, frame.ChildDuration);
+            stack.pop_back();
+        };
+
+        for (Event const& event : events)
+        {
+            // Depth counts the recorded zones around this one, a parent that began before the capture is just missing
+            while (stack.size() > event.Depth)
+                popFrame();
+
+            Frame frame;
+            frame.Duration = event.End - event.Start;
+            frame.ChildDuration = 0;
+            if (!stack.empty())
+            {
+                stack.back().ChildDuration += frame.Duration;
+                frame.Stack = stack.back().Stack + ';';
+            }
+            else
+                frame.Stack = Trinity::StringFormat("Thread {};", thread.Id);
+
+            AppendEscaped(frame.Stack, event.Zone, true);
+            stack.push_back(std::move(frame));
+        }
+
+        while (!stack.empty())
+            popFrame();
+    }
+
+    std::string folded;
+    for (auto const& [stack, ticks] : selfTimes)
+        if (uint64 microseconds = uint64(double(ticks) / TicksPerMicrosecond))
+            folded += Trinity::StringFormat("{} {}\n", stack, microseconds);
+
+    return folded;
+}
+}
@@ -0,0 +1,171 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITYCORE_PROFILER_H
+#define TRINITYCORE_PROFILER_H
+
+#include "Define.h"
+#include "Duration.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Trinity
+{
+/// Zones recorded by the profiler between Start and Stop
+struct TC_COMMON_API ProfilerCapture
+{
+    struct Event
+    {
+        char const* Zone;
+        uint64 Start;
+        uint64 End;
+        uint32 Depth;
+    };
+
+    struct Thread
+    {
+        uint32 Id;
+        std::vector<Event> Events;
+        uint32 Dropped;
+    };
+
+    std::vector<Thread> Threads;
+    uint64 StartTicks;
+    double TicksPerMicrosecond;
+
+    /// Chrome trace event format, for chrome://tracing or ui.perfetto.dev
+    std::string ToChromeTrace() const;
+
+    /// One line per call stack with its self time in microseconds, for flamegraph.pl or speedscope
+    std::string ToFoldedStacks() const;
+
+    uint64 GetEventCount() const;
+    uint64 GetDroppedCount() const;
+};
+
+/**
+ * Instrumenting profiler for scoped zones (TC_PROFILE_ZONE)
+ *
+ * Zones are only timed while a capture is running, each thread appends them to its own buffer without locking.
+ * Zones cost a single relaxed load when not recording and nothing at all when built without WITH_PROFILER.
+ */
+class TC_COMMON_API Profiler
+{
+    struct ThreadBuffer;
+
+public:
+    static constexpr uint32 EventsPerChunk = 1 << 16;
+    static constexpr uint32 MaxEventsPerThread = 1 << 22;
+
+    static Profiler* instance();
+
+    static constexpr bool IsCompiledIn()
+    {
+#ifdef WITH_PROFILER
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    class TC_COMMON_API Zone
+    {
+    public:
+        explicit Zone(char const* name) : _name(name), _start(0)
+        {
+            if (Recording.load(std::memory_order_relaxed))
+                Begin();
+        }
+
+        ~Zone()
+        {
+            if (_start)
+                End();
+        }
+
+        Zone(Zone const&) = delete;
+        Zone(Zone&&) = delete;
+        Zone& operator=(Zone const&) = delete;
+        Zone& operator=(Zone&&) = delete;
+
+    private:
+        void Begin();
+        void End();
+
+        char const* _name;
+        uint64 _start;
+    };
+
+    bool IsRecording() const { return Recording.load(std::memory_order_relaxed); }
+
+    /// Starts a capture that Update writes to the logs directory once duration has elapsed, fails when already recording
+    bool Start(Milliseconds duration);
+
+    /// Stops the running capture right away and returns what it recorded
+    std::unique_ptr<ProfilerCapture> Stop();
+
+    /// Queues <LogsDir>/profile_<timestamp>.json and .folded to be written by the writer thread, never blocks on earlier writes
+    void Write(std::unique_ptr<ProfilerCapture> capture);
+
+    /// Ends the running capture once its duration has elapsed, called every world tick
+    void Update();
+
+    static uint64 GetTicks();
+
+private:
+    Profiler();
+    ~Profiler();
+
+    ThreadBuffer* GetThreadBuffer();
+    void WriterThread();
+
+    static std::atomic<bool> Recording;
+
+    std::atomic<uint64> _session;
+    std::mutex _lock;
+    std::vector<std::unique_ptr<ThreadBuffer>> _threads;
+    uint64 _startTicks;
+    TimePoint _startTime;
+    TimePoint _endTime;
+
+    // captures waiting to be written, with the file name they were queued under
+    std::mutex _writeLock;
+    std::condition_variable _writeCondition;
+    std::queue<std::pair<std::string, std::unique_ptr<ProfilerCapture>>> _writeQueue;
+    bool _stopWriter;
+    std::thread _writer;
+};
+}
+
+#define sProfiler Trinity::Profiler::instance()
+
+#define TC_PROFILE_UNIQUE_NAME_INNER(a, b) a ## b
+#define TC_PROFILE_UNIQUE_NAME(a, b) TC_PROFILE_UNIQUE_NAME_INNER(a, b)
+
+#ifdef WITH_PROFILER
+#define TC_PROFILE_ZONE(name) Trinity::Profiler::Zone TC_PROFILE_UNIQUE_NAME(__tc_profile_zone, __LINE__)(name)
+#else
+#define TC_PROFILE_ZONE(name) ((void)0)
+#endif
+
+#endif // TRINITYCORE_PROFILER_H
@@ -0,0 +1,135 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "EpochReclaimer.h"
+#include <algorithm>
+#include <limits>
+
+namespace Trinity
+{
+namespace
+{
+// hands the record back for reuse by other threads when the owning thread exits
+template <class Record>
+struct ThreadRecordOwner
+{
+    Record* Value = nullptr;
+
+    ~ThreadRecordOwner()
+    {
+        if (Value)
+            Value->InUse.store(false, std::memory_order_release);
+    }
+};
+}
+
+EpochReclaimer* EpochReclaimer::instance()
+{
+    static EpochReclaimer instance;
+    return &instance;
+}
+
+EpochReclaimer::~EpochReclaimer()
+{
+    for (RetiredMemory const& retired : _retired)
+        retired.Deleter(retired.Memory);
+
+    // records of threads still running are leaked on purpose, their thread_local owners may outlive us
+}
+
+EpochReclaimer::ThreadRecord* EpochReclaimer::GetThreadRecord()
+{
+    thread_local ThreadRecordOwner<ThreadRecord> owner;
+    if (owner.Value)
+        return owner.Value;
+
+    // reuse a record released by an exited thread before allocating a new one
+    for (ThreadRecord* record = _records.load(std::memory_order_acquire); record; record = record->Next)
+    {
+        bool expected = false;
+        if (!record->InUse.load(std::memory_order_relaxed) && record->InUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            return owner.Value = record;
+    }
+
+    ThreadRecord* record = new ThreadRecord();
+    record->InUse.store(true, std::memory_order_relaxed);
+    ThreadRecord* head = _records.load(std::memory_order_relaxed);
+    do
+        record->Next = head;
+    while (!_records.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+
+    return owner.Value = record;
+}
+
+EpochReclaimer::ReadGuard::ReadGuard() : _record(sEpochReclaimer->GetThreadRecord())
+{
+    if (_record->Depth++)
+        return;
+
+    // acquire pairs with the increment in Retire: a reader pinning the epoch after a retirement also sees
+    // the unlink that came before it, so it can never reach memory retired at an epoch older than its pin
+    _record->PinnedEpoch.store(sEpochReclaimer->_epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+    // pairs with the fence in Reclaim: either the writer sees this pin or this reader sees the unlinked state
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+EpochReclaimer::ReadGuard::~ReadGuard()
+{
+    if (!--_record->Depth)
+        _record->PinnedEpoch.store(0, std::memory_order_release);
+}
+
+void EpochReclaimer::Retire(void* memory, void(*deleter)(void*))
+{
+    std::lock_guard<std::mutex> lock(_retiredLock);
+    _retired.push_back({ _epoch.fetch_add(1, std::memory_order_acq_rel), memory, deleter });
+    ReclaimLocked();
+}
+
+void EpochReclaimer::Reclaim()
+{
+    std::lock_guard<std::mutex> lock(_retiredLock);
+    ReclaimLocked();
+}
+
+void EpochReclaimer::ReclaimLocked()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    uint64 oldestPinned = std::numeric_limits<uint64>::max();
+    for (ThreadRecord* record = _records.load(std::memory_order_acquire); record; record = record->Next)
+        if (uint64 pinned = record->PinnedEpoch.load(std::memory_order_acquire))
+            oldestPinned = std::min(oldestPinned, pinned);
+
+    // a reader pinned at epoch E may still hold memory retired at E or later
+    auto end = std::partition(_retired.begin(), _retired.end(), [oldestPinned](RetiredMemory const& retired)
+    {
+        return retired.Epoch >= oldestPinned;
+    });
+
+    for (auto itr = end; itr != _retired.end(); ++itr)
+        itr->Deleter(itr->Memory);
+
+    _retired.erase(end, _retired.end());
+}
+
+std::size_t EpochReclaimer::GetRetiredCount() const
+{
+    std::lock_guard<std::mutex> lock(_retiredLock);
+    return _retired.size();
+}
+}
@@ -0,0 +1,99 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITYCORE_EPOCH_RECLAIMER_H
+#define TRINITYCORE_EPOCH_RECLAIMER_H
+
+#include "Define.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace Trinity
+{
+/**
+ * Epoch based reclamation for memory read by lock-free readers
+ *
+ * Readers pin the current epoch with a ReadGuard, which only writes to a cache line owned by the calling thread.
+ * Writers unlink memory first and Retire() it afterwards, it is freed once no reader that could still see it is pinned.
+ */
+class TC_COMMON_API EpochReclaimer
+{
+    struct alignas(64) ThreadRecord
+    {
+        std::atomic<uint64> PinnedEpoch = 0;
+        std::atomic<bool> InUse = false;
+        uint32 Depth = 0;
+        ThreadRecord* Next = nullptr;
+    };
+
+    struct RetiredMemory
+    {
+        uint64 Epoch;
+        void* Memory;
+        void(*Deleter)(void*);
+    };
+
+public:
+    static EpochReclaimer* instance();
+
+    class TC_COMMON_API ReadGuard
+    {
+    public:
+        ReadGuard();
+        ~ReadGuard();
+
+        ReadGuard(ReadGuard const&) = delete;
+        ReadGuard(ReadGuard&&) = delete;
+        ReadGuard& operator=(ReadGuard const&) = delete;
+        ReadGuard& operator=(ReadGuard&&) = delete;
+
+    private:
+        ThreadRecord* _record;
+    };
+
+    template <class T>
+    void Retire(T* memory)
+    {
+        Retire(memory, [](void* retired) { delete static_cast<T*>(retired); });
+    }
+
+    void Retire(void* memory, void(*deleter)(void*));
+
+    /// Frees everything retired before the oldest epoch still pinned by a reader
+    void Reclaim();
+
+    std::size_t GetRetiredCount() const;
+
+private:
+    EpochReclaimer() = default;
+    ~EpochReclaimer();
+
+    ThreadRecord* GetThreadRecord();
+    void ReclaimLocked();
+
+    std::atomic<uint64> _epoch = 1;
+    std::atomic<ThreadRecord*> _records = nullptr;
+
+    mutable std::mutex _retiredLock;
+    std::vector<RetiredMemory> _retired;
+};
+}
+
+#define sEpochReclaimer Trinity::EpochReclaimer::instance()
+
+#endif // TRINITYCORE_EPOCH_RECLAIMER_H
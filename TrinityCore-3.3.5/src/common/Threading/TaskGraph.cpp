@@ -0,0 +1,203 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TaskGraph.h"
+#include "Errors.h"
+#include "StringFormat.h"
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+namespace Trinity
+{
+TaskGraph::TaskId TaskGraph::Add(std::string name, Task task, std::vector<TaskId> dependencies /*= {}*/)
+{
+    TaskId id = _tasks.size();
+    for (TaskId dependency : dependencies)
+    {
+        ASSERT(dependency < id, "TaskGraph task %s depends on a task that was not added before it", name.c_str());
+        _tasks[dependency].Dependents.push_back(id);
+    }
+
+    TaskNode& node = _tasks.emplace_back();
+    node.Name = std::move(name);
+    node.Work = std::move(task);
+    node.Dependencies = std::move(dependencies);
+    return id;
+}
+
+void TaskGraph::Execute(TaskNode& node)
+{
+    node.Start = std::chrono::steady_clock::now();
+    node.Work();
+    node.End = std::chrono::steady_clock::now();
+}
+
+void TaskGraph::Run(std::size_t threadCount)
+{
+    _threadCount = std::max<std::size_t>(threadCount, 1);
+    _start = std::chrono::steady_clock::now();
+
+    if (_threadCount == 1 || _tasks.size() < 2)
+    {
+        // declaration order is always a valid dependency order
+        for (TaskNode& node : _tasks)
+            Execute(node);
+
+        _end = std::chrono::steady_clock::now();
+        return;
+    }
+
+    std::mutex lock;
+    std::condition_variable stateChanged;
+    // lowest id first keeps the execution order close to the declaration order
+    std::priority_queue<TaskId, std::vector<TaskId>, std::greater<TaskId>> ready;
+    std::vector<std::size_t> pendingDependencies(_tasks.size());
+    std::size_t finished = 0;
+    std::size_t running = 0;
+    std::exception_ptr error;
+
+    for (TaskId id = 0; id < _tasks.size(); ++id)
+    {
+        pendingDependencies[id] = _tasks[id].Dependencies.size();
+        if (!pendingDependencies[id])
+            ready.push(id);
+    }
+
+    auto worker = [&]()
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        while (true)
+        {
+            stateChanged.wait(guard, [&]
+            {
+                return !ready.empty() || finished == _tasks.size() || (error && !running);
+            });
+
+            if (finished == _tasks.size() || error)
+                break;
+
+            TaskId id = ready.top();
+            ready.pop();
+            ++running;
+            guard.unlock();
+
+            std::exception_ptr taskError;
+            try
+            {
+                Execute(_tasks[id]);
+            }
+            catch (...)
+            {
+                taskError = std::current_exception();
+            }
+
+            guard.lock();
+            --running;
+            ++finished;
+            if (taskError)
+            {
+                if (!error)
+                    error = taskError;
+            }
+            else
+            {
+                for (TaskId dependent : _tasks[id].Dependents)
+                    if (!--pendingDependencies[dependent])
+                        ready.push(dependent);
+            }
+
+            stateChanged.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(_threadCount);
+    for (std::size_t i = 0; i < _threadCount; ++i)
+        threads.emplace_back(worker);
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    _end = std::chrono::steady_clock::now();
+
+    if (error)
+        std::rethrow_exception(error);
+}
+
+Milliseconds TaskGraph::GetTaskDuration(TaskId id) const
+{
+    return std::chrono::duration_cast<Milliseconds>(_tasks[id].End - _tasks[id].Start);
+}
+
+Milliseconds TaskGraph::GetWallTime() const
+{
+    return std::chrono::duration_cast<Milliseconds>(_end - _start);
+}
+
+std::vector<TaskGraph::TaskId> TaskGraph::GetCriticalPath() const
+{
+    std::vector<TaskId> path;
+    if (_tasks.empty())
+        return path;
+
+    // start from the task that finished last and walk back through whichever dependency held it up the longest
+    TaskId current = 0;
+    for (TaskId id = 1; id < _tasks.size(); ++id)
+        if (_tasks[id].End > _tasks[current].End)
+            current = id;
+
+    while (true)
+    {
+        path.push_back(current);
+        std::vector<TaskId> const& dependencies = _tasks[current].Dependencies;
+        if (dependencies.empty())
+            break;
+
+        current = *std::max_element(dependencies.begin(), dependencies.end(), [this](TaskId left, TaskId right)
+        {
+            return _tasks[left].End < _tasks[right].End;
+        });
+    }
+
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+std::string TaskGraph::GetTimingReport() const
+{
+    Milliseconds total = 0ms;
+    for (TaskId id = 0; id < _tasks.size(); ++id)
+        total += GetTaskDuration(id);
+
+    std::vector<TaskId> criticalPath = GetCriticalPath();
+    Milliseconds criticalTotal = 0ms;
+    for (TaskId id : criticalPath)
+        criticalTotal += GetTaskDuration(id);
+
+    std::string report = StringFormat("{} tasks on {} threads: {} ms wall time, {} ms summed task time", _tasks.size(), _threadCount, GetWallTime().count(), total.count());
+    report += StringFormat("\nCritical path ({} ms):", criticalTotal.count());
+    for (TaskId id : criticalPath)
+        report += StringFormat("\n    {:>7} ms  {}", GetTaskDuration(id).count(), _tasks[id].Name);
+
+    return report;
+}
+}
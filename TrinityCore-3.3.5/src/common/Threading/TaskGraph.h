@@ -0,0 +1,78 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_TASK_GRAPH_H
+#define TRINITY_TASK_GRAPH_H
+
+#include "Define.h"
+#include "Duration.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Trinity
+{
+/**
+ * Runs a set of one-shot tasks where each task declares which earlier tasks it depends on.
+ * Tasks whose dependencies have finished run concurrently on worker threads, with a single
+ * thread everything runs on the calling thread in the order it was added.
+ * Used for independent startup loaders, see World::SetInitialWorldSettings
+ */
+class TC_COMMON_API TaskGraph
+{
+public:
+    typedef std::size_t TaskId;
+    typedef std::function<void()> Task;
+
+    /// Dependencies must be ids returned by earlier Add calls, which keeps the graph acyclic
+    TaskId Add(std::string name, Task task, std::vector<TaskId> dependencies = {});
+
+    /// Blocks until every task finished. If a task throws, no new tasks are started and the
+    /// first exception is rethrown once running tasks completed
+    void Run(std::size_t threadCount);
+
+    std::size_t GetTaskCount() const { return _tasks.size(); }
+    Milliseconds GetTaskDuration(TaskId id) const;
+    Milliseconds GetWallTime() const;
+
+    /// Chain of tasks that determined the total run time, ordered from first to last
+    std::vector<TaskId> GetCriticalPath() const;
+
+    /// Multi line summary: wall time, summed task time and the critical path with per task timings
+    std::string GetTimingReport() const;
+
+private:
+    struct TaskNode
+    {
+        std::string Name;
+        Task Work;
+        std::vector<TaskId> Dependencies;
+        std::vector<TaskId> Dependents;
+        TimePoint Start;
+        TimePoint End;
+    };
+
+    void Execute(TaskNode& node);
+
+    std::vector<TaskNode> _tasks;
+    std::size_t _threadCount = 1;
+    TimePoint _start;
+    TimePoint _end;
+};
+}
+
+#endif // TRINITY_TASK_GRAPH_H
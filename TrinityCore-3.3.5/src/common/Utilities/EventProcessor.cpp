@@ -17,6 +17,11 @@
 
 #include "EventProcessor.h"
 #include "Errors.h"
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <tuple>
+#include <vector>
 
 void BasicEvent::ScheduleAbort()
 {
@@ -32,6 +37,10 @@ void BasicEvent::SetAborted()
     m_abortState = AbortState::STATE_ABORTED;
 }
 
+EventProcessor::EventProcessor() : m_time(0), m_wheelTime(0), m_wheelIdleUntil(0), m_nextOrder(0)
+{
+}
+
 EventProcessor::~EventProcessor()
 {
     KillAllEvents(true);
@@ -43,13 +52,8 @@ void EventProcessor::Update(uint32 p_time)
     m_time += p_time;
 
     // main event loop
-    std::multimap<uint64, BasicEvent*>::iterator i;
-    while (((i = m_events.begin()) != m_events.end()) && i->first <= m_time)
+    while (BasicEvent* event = PopDueEvent())
     {
-        // get and remove event from queue
-        BasicEvent* event = i->second;
-        m_events.erase(i);
-
         if (event->IsRunning())
         {
             if (event->Execute(m_time, p_time))
@@ -81,53 +85,268 @@ void EventProcessor::Update(uint32 p_time)
 
 void EventProcessor::KillAllEvents(bool force)
 {
-    for (auto itr = m_events.begin(); itr != m_events.end();)
+    if (!m_wheel)
+        return;
+
+    // take everything out first, Abort may add new events
+    std::vector<BasicEvent*> events;
+    for (BasicEvent* head : m_wheel->Slots)
+    {
+        if (!head)
+            continue;
+
+        BasicEvent* event = head;
+        do
+        {
+            events.push_back(event);
+            event = event->m_queueNext;
+        } while (event != head);
+    }
+
+    for (BasicEvent* event : events)
+        Unlink(event);
+
+    // abort in execution order, events due at the same time in the order they were added
+    std::sort(events.begin(), events.end(), [](BasicEvent const* left, BasicEvent const* right)
+    {
+        return std::tie(left->m_execTime, left->m_queueOrder) < std::tie(right->m_execTime, right->m_queueOrder);
+    });
+
+    for (BasicEvent* event : events)
     {
         // Abort events which weren't aborted already
-        if (!itr->second->IsAborted())
+        if (!event->IsAborted())
         {
-            itr->second->SetAborted();
-            itr->second->Abort(m_time);
+            event->SetAborted();
+            event->Abort(m_time);
         }
 
         // Skip non-deletable events when we are
         // not forcing the event cancellation.
-        if (!force && !itr->second->IsDeletable())
+        if (!force && !event->IsDeletable())
         {
-            ++itr;
+            Schedule(event);
             continue;
         }
 
-        delete itr->second;
-
-        if (force)
-            ++itr; // Clear the whole container when forcing
-        else
-            itr = m_events.erase(itr);
+        delete event;
     }
-
-    if (force)
-        m_events.clear();
 }
 
 void EventProcessor::AddEvent(BasicEvent* event, Milliseconds e_time, bool set_addtime)
 {
+    ASSERT(!event->IsQueued() && "Tried to add an event that is already queued!");
+
     if (set_addtime)
         event->m_addTime = m_time;
     event->m_execTime = e_time.count();
-    m_events.insert(std::pair<uint64, BasicEvent*>(e_time.count(), event));
+    event->m_queueOrder = m_nextOrder++;
+    Schedule(event);
 }
 
 void EventProcessor::ModifyEventTime(BasicEvent* event, Milliseconds newTime)
 {
-    for (auto itr = m_events.begin(); itr != m_events.end(); ++itr)
+    if (!event->IsQueued())
+        return;
+
+    Unlink(event);
+    event->m_execTime = newTime.count();
+    event->m_queueOrder = m_nextOrder++;
+    Schedule(event);
+}
+
+void EventProcessor::Schedule(BasicEvent* event)
+{
+    if (!m_wheel)
+        m_wheel = std::make_unique<Wheel>();
+
+    uint64 execTime = event->m_execTime;
+    if (execTime <= m_wheelTime)
     {
-        if (itr->second != event)
-            continue;
+        InsertSorted(DUE_SLOT, event);
+        return;
+    }
+
+    m_wheelIdleUntil = std::min(m_wheelIdleUntil, execTime);
+
+    // the highest bit that differs from the wheel time picks the level, slots of a level never hold events
+    // of two different rounds so they execute in the order they were added once spread over the lower levels
+    uint32 level = (std::bit_width(execTime ^ m_wheelTime) - 1) / WHEEL_LEVEL_BITS;
+    if (level >= WHEEL_LEVELS)
+    {
+        InsertSorted(OVERFLOW_SLOT, event);
+        return;
+    }
+
+    uint32 index = (execTime >> (level * WHEEL_LEVEL_BITS)) & (WHEEL_SLOTS_PER_LEVEL - 1);
+    m_wheel->Occupied[level] |= uint64(1) << index;
+    Append(uint16(level * WHEEL_SLOTS_PER_LEVEL + index), event);
+}
+
+void EventProcessor::Append(uint16 slot, BasicEvent* event)
+{
+    BasicEvent*& head = m_wheel->Slots[slot];
+    event->m_queueSlot = slot;
+    if (!head)
+    {
+        head = event;
+        event->m_queueNext = event;
+        event->m_queuePrev = event;
+        return;
+    }
+
+    BasicEvent* tail = head->m_queuePrev;
+    event->m_queueNext = head;
+    event->m_queuePrev = tail;
+    tail->m_queueNext = event;
+    head->m_queuePrev = event;
+}
+
+void EventProcessor::InsertSorted(uint16 slot, BasicEvent* event)
+{
+    auto executesBefore = [](BasicEvent const* left, BasicEvent const* right)
+    {
+        return left->m_execTime < right->m_execTime || (left->m_execTime == right->m_execTime && left->m_queueOrder < right->m_queueOrder);
+    };
+
+    BasicEvent*& head = m_wheel->Slots[slot];
+    if (!head || !executesBefore(event, head->m_queuePrev))
+    {
+        Append(slot, event);
+        return;
+    }
+
+    // events are mostly added in order, search from the back
+    BasicEvent* next = head->m_queuePrev;
+    while (next != head && executesBefore(event, next->m_queuePrev))
+        next = next->m_queuePrev;
+
+    BasicEvent* prev = next->m_queuePrev;
+    event->m_queueSlot = slot;
+    event->m_queueNext = next;
+    event->m_queuePrev = prev;
+    prev->m_queueNext = event;
+    next->m_queuePrev = event;
+    if (next == head)
+        head = event;
+}
+
+void EventProcessor::Unlink(BasicEvent* event)
+{
+    uint16 slot = event->m_queueSlot;
+    BasicEvent*& head = m_wheel->Slots[slot];
+    if (event->m_queueNext == event)
+    {
+        head = nullptr;
+        if (slot < DUE_SLOT)
+            m_wheel->Occupied[slot / WHEEL_SLOTS_PER_LEVEL] &= ~(uint64(1) << (slot % WHEEL_SLOTS_PER_LEVEL));
+    }
+    else
+    {
+        event->m_queuePrev->m_queueNext = event->m_queueNext;
+        event->m_queueNext->m_queuePrev = event->m_queuePrev;
+        if (head == event)
+            head = event->m_queueNext;
+    }
+
+    event->m_queueNext = nullptr;
+    event->m_queuePrev = nullptr;
+    event->m_queueSlot = BasicEvent::NotQueued;
+}
+
+BasicEvent* EventProcessor::PopDueEvent()
+{
+    if (!m_wheel)
+        return nullptr;
+
+    if (!m_wheel->Slots[DUE_SLOT] && (m_time < m_wheelIdleUntil || !Advance()))
+        return nullptr;
+
+    BasicEvent* event = m_wheel->Slots[DUE_SLOT];
+    Unlink(event);
+    return event;
+}
+
+bool EventProcessor::Advance()
+{
+    while (m_wheelTime < m_time)
+    {
+        // slots of a level all come before the ones of the next level
+        uint32 level = 0;
+        uint64 slots = 0;
+        for (; level < WHEEL_LEVELS; ++level)
+        {
+            uint32 current = (m_wheelTime >> (level * WHEEL_LEVEL_BITS)) & (WHEEL_SLOTS_PER_LEVEL - 1);
+            if (current + 1 < WHEEL_SLOTS_PER_LEVEL)
+                slots = m_wheel->Occupied[level] & (~uint64(0) << (current + 1));
+            if (slots)
+                break;
+        }
+
+        if (level == WHEEL_LEVELS)
+        {
+            // the wheel is empty, jump to the first overflow event
+            BasicEvent* overflow = m_wheel->Slots[OVERFLOW_SLOT];
+            if (!overflow || overflow->m_execTime > m_time)
+            {
+                m_wheelIdleUntil = overflow ? overflow->m_execTime : std::numeric_limits<uint64>::max();
+                m_wheelTime = m_time;
+                MigrateOverflow();
+                return false;
+            }
+
+            m_wheelTime = overflow->m_execTime;
+            MigrateOverflow();
+        }
+        else
+        {
+            uint32 shift = level * WHEEL_LEVEL_BITS;
+            uint32 index = std::countr_zero(slots);
+            uint64 slotTime = (m_wheelTime >> (shift + WHEEL_LEVEL_BITS) << (shift + WHEEL_LEVEL_BITS)) | (uint64(index) << shift);
+            if (slotTime > m_time)
+            {
+                m_wheelIdleUntil = slotTime;
+                m_wheelTime = m_time;
+                MigrateOverflow();
+                return false;
+            }
+
+            // spread the slot over the due list and the lower levels
+            uint16 slot = uint16(level * WHEEL_SLOTS_PER_LEVEL + index);
+            BasicEvent* head = m_wheel->Slots[slot];
+            m_wheel->Slots[slot] = nullptr;
+            m_wheel->Occupied[level] &= ~(uint64(1) << index);
+            m_wheelTime = slotTime;
+
+            BasicEvent* event = head;
+            do
+            {
+                BasicEvent* next = event->m_queueNext;
+                Schedule(event);
+                event = next;
+            } while (event != head);
+
+            MigrateOverflow();
+        }
+
+        if (m_wheel->Slots[DUE_SLOT])
+            break;
+    }
+
+    // what is left in the wheel is not known here, look again at the next update
+    m_wheelIdleUntil = 0;
+    return m_wheel->Slots[DUE_SLOT] != nullptr;
+}
+
+void EventProcessor::MigrateOverflow()
+{
+    uint64 lastWheelTime = m_wheelTime | (WHEEL_RANGE - 1);
+    while (BasicEvent* event = m_wheel->Slots[OVERFLOW_SLOT])
+    {
+        if (event->m_execTime > lastWheelTime)
+            break;
 
-        event->m_execTime = newTime.count();
-        m_events.erase(itr);
-        m_events.insert(std::pair<uint64, BasicEvent*>(newTime.count(), event));
-        break;
+        Unlink(event);
+        Schedule(event);
     }
 }
@@ -21,7 +21,9 @@
 #include "Define.h"
 #include "Duration.h"
 #include "Random.h"
+#include <array>
 #include <map>
+#include <memory>
 #include <type_traits>
 
 class EventProcessor;
@@ -41,7 +43,8 @@ class TC_COMMON_API BasicEvent
 
     public:
         BasicEvent()
-          : m_abortState(AbortState::STATE_RUNNING), m_addTime(0), m_execTime(0) { }
+          : m_abortState(AbortState::STATE_RUNNING), m_addTime(0), m_execTime(0),
+            m_queueNext(nullptr), m_queuePrev(nullptr), m_queueOrder(0), m_queueSlot(NotQueued) { }
 
         virtual ~BasicEvent() { }                           // override destructor to perform some actions on event removal
 
@@ -62,12 +65,21 @@ class TC_COMMON_API BasicEvent
         bool IsRunning() const { return (m_abortState == AbortState::STATE_RUNNING); }
         bool IsAbortScheduled() const { return (m_abortState == AbortState::STATE_ABORT_SCHEDULED); }
         bool IsAborted() const { return (m_abortState == AbortState::STATE_ABORTED); }
+        bool IsQueued() const { return m_queueSlot != NotQueued; }
+
+        static constexpr uint16 NotQueued = 0xFFFF;
 
         AbortState m_abortState;                            // set by externals when the event is aborted, aborted events don't execute
 
         // these can be used for time offset control
         uint64 m_addTime;                                   // time when the event was added to queue, filled by event handler
         uint64 m_execTime;                                  // planned time of next execution, filled by event handler
+
+        // intrusive links of the EventProcessor queue, events are never copied into a container node
+        BasicEvent* m_queueNext;
+        BasicEvent* m_queuePrev;
+        uint64 m_queueOrder;                                // order of AddEvent calls, breaks ties between events due at the same time
+        uint16 m_queueSlot;                                 // list of the EventProcessor holding the event
 };
 
 template<typename T>
@@ -90,12 +102,21 @@ private:
 template<typename T>
 using is_lambda_event = std::enable_if_t<!std::is_base_of_v<BasicEvent, std::remove_pointer_t<std::remove_cvref_t<T>>>>;
 
+/**
+ * Events are kept in a hierarchical timing wheel: each level has 64 slots, a level 0 slot holds the events due
+ * in one millisecond and a level N slot the ones due in 64^N milliseconds. Slots of higher levels are spread
+ * over the lower ones once the time reaches them, events too far away for the last level wait in an overflow list.
+ * Adding and removing an event is O(1) and events due at the same time execute in the order they were added.
+ */
 class TC_COMMON_API EventProcessor
 {
     public:
-        EventProcessor() : m_time(0) { }
+        EventProcessor();
         ~EventProcessor();
 
+        EventProcessor(EventProcessor const&) = delete;
+        EventProcessor& operator=(EventProcessor const&) = delete;
+
         void Update(uint32 p_time);
         void KillAllEvents(bool force);
 
@@ -113,7 +134,34 @@ class TC_COMMON_API EventProcessor
 
     protected:
         uint64 m_time;
-        std::multimap<uint64, BasicEvent*> m_events;
+
+    private:
+        static constexpr uint32 WHEEL_LEVEL_BITS = 6;
+        static constexpr uint32 WHEEL_SLOTS_PER_LEVEL = 1 << WHEEL_LEVEL_BITS;
+        static constexpr uint32 WHEEL_LEVELS = 4;
+        static constexpr uint64 WHEEL_RANGE = uint64(1) << (WHEEL_LEVELS * WHEEL_LEVEL_BITS);
+        static constexpr uint16 DUE_SLOT = WHEEL_LEVELS * WHEEL_SLOTS_PER_LEVEL;    // events due at or before m_wheelTime, sorted
+        static constexpr uint16 OVERFLOW_SLOT = DUE_SLOT + 1;                       // events beyond WHEEL_RANGE, sorted
+        static constexpr uint16 SLOT_COUNT = OVERFLOW_SLOT + 1;
+
+        struct Wheel
+        {
+            std::array<BasicEvent*, SLOT_COUNT> Slots = { };    // circular lists, the head is the first event
+            std::array<uint64, WHEEL_LEVELS> Occupied = { };    // bit per non empty slot of each level
+        };
+
+        void Schedule(BasicEvent* event);
+        void Append(uint16 slot, BasicEvent* event);
+        void InsertSorted(uint16 slot, BasicEvent* event);
+        void Unlink(BasicEvent* event);
+        BasicEvent* PopDueEvent();
+        bool Advance();
+        void MigrateOverflow();
+
+        std::unique_ptr<Wheel> m_wheel;                     // allocated with the first event, objects without events do not pay for it
+        uint64 m_wheelTime;                                 // every event due at or before it is in the due list
+        uint64 m_wheelIdleUntil;                            // no event in the wheel is due before it, updates skip the wheel until then
+        uint64 m_nextOrder;
 };
 
 #endif
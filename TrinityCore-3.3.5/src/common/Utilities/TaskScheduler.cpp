@@ -52,9 +52,9 @@ TaskScheduler& TaskScheduler::CancelAll()
 
 TaskScheduler& TaskScheduler::CancelGroup(group_t const group)
 {
-    _task_holder.RemoveIf([group](TaskContainer const& task) -> bool
+    _task_holder.RemoveIf([group](Task const& task) -> bool
     {
-        return task->IsInGroup(group);
+        return task.IsInGroup(group);
     });
     return *this;
 }
@@ -67,12 +67,6 @@ TaskScheduler& TaskScheduler::CancelGroupsOf(std::vector<group_t> const& groups)
     return *this;
 }
 
-TaskScheduler& TaskScheduler::InsertTask(TaskContainer task)
-{
-    _task_holder.Push(std::move(task));
-    return *this;
-}
-
 void TaskScheduler::Dispatch(success_t const& callback)
 {
     // If the validation failed abort the dispatching here.
@@ -92,15 +86,31 @@ void TaskScheduler::Dispatch(success_t const& callback)
 
     while (!_task_holder.IsEmpty())
     {
-        if (_task_holder.First()->_end > _now)
+        if (_task_holder.FirstEnd() > _now)
             break;
 
+        uint32 const index = _task_holder.Pop();
+        Task& task = _task_holder.Get(index);
+        task._running = true;
+
         // Perfect forward the context to the handler
         // Use weak references to catch destruction before callbacks.
-        TaskContext context(_task_holder.Pop(), std::weak_ptr<TaskScheduler>(self_reference));
+        // The handler is moved out of the pool while it runs so destroying the scheduler
+        // from within it doesn't destroy the running callable.
+        std::weak_ptr<TaskScheduler> owner(self_reference);
+        task_handler_t handler = std::move(task._task);
+        handler(TaskContext(this, std::weak_ptr<TaskScheduler>(owner), index, ++task._generation));
+
+        // The scheduler was destroyed from within the handler
+        if (owner.expired())
+            return;
 
-        // Invoke the context
-        context.Invoke();
+        // Repeated tasks take their handler back, the others go back to the pool
+        task._running = false;
+        if (task._queued)
+            task._task = std::move(handler);
+        else
+            _task_holder.Free(index);
 
         // If the validation failed abort the dispatching here.
         if (!_predicate())
@@ -111,63 +121,129 @@ void TaskScheduler::Dispatch(success_t const& callback)
     callback();
 }
 
-void TaskScheduler::TaskQueue::Push(TaskContainer&& task)
+uint32 TaskScheduler::TaskQueue::Create(timepoint_t const& end, duration_t const& duration, Optional<group_t> const& group, task_handler_t&& task)
+{
+    uint32 index;
+    if (!_freeTasks.empty())
+    {
+        index = _freeTasks.back();
+        _freeTasks.pop_back();
+    }
+    else
+    {
+        index = uint32(_tasks.size());
+        _tasks.emplace_back();
+    }
+
+    Task& record = _tasks[index];
+    record._end = end;
+    record._duration = duration;
+    record._group = group;
+    record._repeated = 0;
+    record._task = std::move(task);
+    return index;
+}
+
+void TaskScheduler::TaskQueue::Free(uint32 index)
 {
-    container.insert(task);
+    Task& task = _tasks[index];
+    if (task._running)
+        return;
+
+    // Invalidates all contexts which still refer to the task
+    ++task._generation;
+    task._task.Reset();
+    _freeTasks.push_back(index);
 }
 
-auto TaskScheduler::TaskQueue::Pop() -> TaskContainer
+void TaskScheduler::TaskQueue::Push(uint32 index)
 {
-    TaskContainer result = *container.begin();
-    container.erase(container.begin());
-    return result;
+    Task& task = _tasks[index];
+    task._queued = true;
+    _heap.push_back({ task._end, _nextSequence++, index });
+    SiftUp(_heap.size() - 1);
 }
 
-auto TaskScheduler::TaskQueue::First() const -> TaskContainer const&
+uint32 TaskScheduler::TaskQueue::Pop()
 {
-    return *container.begin();
+    uint32 const index = _heap.front().Index;
+    _heap.front() = _heap.back();
+    _heap.pop_back();
+    if (!_heap.empty())
+        SiftDown(0);
+
+    _tasks[index]._queued = false;
+    return index;
 }
 
 void TaskScheduler::TaskQueue::Clear()
 {
-    container.clear();
+    for (Entry const& entry : _heap)
+    {
+        _tasks[entry.Index]._queued = false;
+        Free(entry.Index);
+    }
+
+    _heap.clear();
 }
 
-void TaskScheduler::TaskQueue::RemoveIf(std::function<bool(TaskContainer const&)> const& filter)
+void TaskScheduler::TaskQueue::SiftUp(std::size_t position)
 {
-    for (auto itr = container.begin(); itr != container.end();)
-        if (filter(*itr))
-            itr = container.erase(itr);
-        else
-            ++itr;
+    Entry const entry = _heap[position];
+    while (position > 0)
+    {
+        std::size_t const parent = (position - 1) / Arity;
+        if (!(entry < _heap[parent]))
+            break;
+
+        _heap[position] = _heap[parent];
+        position = parent;
+    }
+
+    _heap[position] = entry;
 }
 
-void TaskScheduler::TaskQueue::ModifyIf(std::function<bool(TaskContainer const&)> const& filter)
+void TaskScheduler::TaskQueue::SiftDown(std::size_t position)
 {
-    std::vector<TaskContainer> cache;
-    for (auto itr = container.begin(); itr != container.end();)
-        if (filter(*itr))
-        {
-            cache.push_back(*itr);
-            itr = container.erase(itr);
-        }
-        else
-            ++itr;
+    Entry const entry = _heap[position];
+    std::size_t const size = _heap.size();
+    while (true)
+    {
+        std::size_t const first = position * Arity + 1;
+        if (first >= size)
+            break;
+
+        std::size_t smallest = first;
+        for (std::size_t child = first + 1; child < std::min(first + Arity, size); ++child)
+            if (_heap[child] < _heap[smallest])
+                smallest = child;
 
-    container.insert(cache.begin(), cache.end());
+        if (!(_heap[smallest] < entry))
+            break;
+
+        _heap[position] = _heap[smallest];
+        position = smallest;
+    }
+
+    _heap[position] = entry;
 }
 
-bool TaskScheduler::TaskQueue::IsEmpty() const
+void TaskScheduler::TaskQueue::Heapify()
 {
-    return container.empty();
+    if (_heap.size() < 2)
+        return;
+
+    for (std::size_t position = (_heap.size() - 2) / Arity + 1; position-- > 0;)
+        SiftDown(position);
 }
 
-TaskContext& TaskContext::Dispatch(std::function<TaskScheduler&(TaskScheduler&)> const& apply)
+TaskScheduler::Task* TaskContext::GetTask() const
 {
-    if (auto const owner = _owner.lock())
-        apply(*owner);
+    if (IsExpired())
+        return nullptr;
 
-    return *this;
+    TaskScheduler::Task& task = _scheduler->_task_holder.Get(_task);
+    return task._generation == _generation ? &task : nullptr;
 }
 
 bool TaskContext::IsExpired() const
@@ -177,24 +253,34 @@ bool TaskContext::IsExpired() const
 
 bool TaskContext::IsInGroup(TaskScheduler::group_t const group) const
 {
-    return _task->IsInGroup(group);
+    TaskScheduler::Task const* task = GetTask();
+    return task && task->IsInGroup(group);
 }
 
 TaskContext& TaskContext::SetGroup(TaskScheduler::group_t const group)
 {
-    _task->_group = group;
+    if (TaskScheduler::Task* task = GetTask())
+        task->_group = group;
     return *this;
 }
 
 TaskContext& TaskContext::ClearGroup()
 {
-    _task->_group = std::nullopt;
+    if (TaskScheduler::Task* task = GetTask())
+        task->_group = std::nullopt;
     return *this;
 }
 
 TaskScheduler::repeated_t TaskContext::GetRepeatCounter() const
 {
-    return _task->_repeated;
+    TaskScheduler::Task const* task = GetTask();
+    return task ? task->_repeated : 0;
+}
+
+TaskContext& TaskContext::Repeat()
+{
+    TaskScheduler::Task const* task = GetTask();
+    return Repeat(task ? task->_duration : TaskScheduler::duration_t::zero());
 }
 
 TaskContext& TaskContext::Async(std::function<void()> const& callable)
@@ -221,10 +307,13 @@ void TaskContext::AssertOnConsumed() const
 {
     // This was adapted to TC to prevent static analysis tools from complaining.
     // If you encounter this assertion check if you repeat a TaskContext more then 1 time!
-    ASSERT(!(*_consumed) && "Bad task logic, task context was consumed already!");
+    TaskScheduler::Task const* task = GetTask();
+    ASSERT(task && !task->_queued && "Bad task logic, task context was consumed already!");
 }
 
-void TaskContext::Invoke()
+TaskScheduler::timepoint_t TaskContext::GetEnd() const
 {
-    _task->_task(*this);
+    // Contexts of a finished task keep scheduling relative to the current time
+    TaskScheduler::Task const* task = GetTask();
+    return task ? task->_end : _scheduler->_now;
 }
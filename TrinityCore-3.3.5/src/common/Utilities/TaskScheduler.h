@@ -22,10 +22,14 @@
 #include "Optional.h"
 #include "Random.h"
 #include <algorithm>
+#include <cstddef>
+#include <deque>
 #include <functional>
 #include <vector>
 #include <queue>
 #include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
 #include <set>
 
@@ -57,8 +61,102 @@ class TC_COMMON_API TaskScheduler
     typedef uint32 group_t;
     // Task repeated type
     typedef uint32 repeated_t;
+
+    /// Move only void(TaskContext) callable, lambdas capturing up to InlineSize bytes are stored without allocating.
+    class TaskHandler
+    {
+    public:
+        static constexpr std::size_t InlineSize = 48;
+
+        TaskHandler() : _operations(nullptr) { }
+
+        template<typename F, typename = std::enable_if_t<!std::is_same_v<std::remove_cvref_t<F>, TaskHandler>>>
+        TaskHandler(F&& function)
+        {
+            using Stored = std::decay_t<F>;
+            if constexpr (IsStoredInline<Stored>())
+            {
+                new (&_storage) Stored(std::forward<F>(function));
+                _operations = &InlineOperations<Stored>;
+            }
+            else
+            {
+                new (&_storage) Stored*(new Stored(std::forward<F>(function)));
+                _operations = &HeapOperations<Stored>;
+            }
+        }
+
+        TaskHandler(TaskHandler&& right) noexcept : _operations(right._operations)
+        {
+            if (_operations)
+                _operations->Move(&right._storage, &_storage);
+            right._operations = nullptr;
+        }
+
+        TaskHandler& operator= (TaskHandler&& right) noexcept
+        {
+            if (this != &right)
+            {
+                Reset();
+                if (right._operations)
+                    right._operations->Move(&right._storage, &_storage);
+                _operations = std::exchange(right._operations, nullptr);
+            }
+            return *this;
+        }
+
+        TaskHandler(TaskHandler const&) = delete;
+        TaskHandler& operator= (TaskHandler const&) = delete;
+
+        ~TaskHandler() { Reset(); }
+
+        void operator()(TaskContext&& context);
+
+        explicit operator bool() const { return _operations != nullptr; }
+
+        void Reset()
+        {
+            if (_operations)
+                _operations->Destroy(&_storage);
+            _operations = nullptr;
+        }
+
+    private:
+        struct Operations
+        {
+            void(*Invoke)(void* storage, TaskContext&& context);
+            void(*Move)(void* from, void* to);               // leaves from destroyed
+            void(*Destroy)(void* storage);
+        };
+
+        template<typename F>
+        static constexpr bool IsStoredInline()
+        {
+            return sizeof(F) <= InlineSize && alignof(F) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible_v<F>;
+        }
+
+        template<typename F>
+        static constexpr Operations InlineOperations =
+        {
+            [](void* storage, TaskContext&& context) { (*static_cast<F*>(storage))(std::move(context)); },
+            [](void* from, void* to) { new (to) F(std::move(*static_cast<F*>(from))); static_cast<F*>(from)->~F(); },
+            [](void* storage) { static_cast<F*>(storage)->~F(); }
+        };
+
+        template<typename F>
+        static constexpr Operations HeapOperations =
+        {
+            [](void* storage, TaskContext&& context) { (**static_cast<F**>(storage))(std::move(context)); },
+            [](void* from, void* to) { new (to) F*(*static_cast<F**>(from)); },
+            [](void* storage) { delete *static_cast<F**>(storage); }
+        };
+
+        alignas(std::max_align_t) std::byte _storage[InlineSize];
+        Operations const* _operations;
+    };
+
     // Task handle type
-    typedef std::function<void(TaskContext)> task_handler_t;
+    typedef TaskHandler task_handler_t;
     // Predicate type
     typedef std::function<bool()> predicate_t;
     // Success handle type
@@ -75,36 +173,18 @@ class TC_COMMON_API TaskScheduler
         repeated_t _repeated;
         task_handler_t _task;
 
-    public:
-        // All Argument construct
-        Task(timepoint_t const& end, duration_t const& duration, Optional<group_t> const& group,
-            repeated_t const repeated, task_handler_t const& task)
-                : _end(end), _duration(duration), _group(group), _repeated(repeated), _task(task) { }
+        /// Increased every time the task is invoked or freed, a TaskContext only acts on the generation it was made for
+        uint32 _generation;
+        /// In the queue, either waiting or repeated from its own context
+        bool _queued;
+        /// The handler is running, freeing the task is deferred until it returns
+        bool _running;
 
-        // Minimal Argument construct
-        Task(timepoint_t const& end, duration_t const& duration, task_handler_t const& task)
-            : _end(end), _duration(duration), _group(std::nullopt), _repeated(0), _task(task) { }
+    public:
+        Task() : _end(), _duration(), _group(), _repeated(0), _generation(0), _queued(false), _running(false) { }
 
-        // Copy construct
         Task(Task const&) = delete;
-        // Move construct
-        Task(Task&&) = delete;
-        // Copy Assign
-        Task& operator= (Task const&) = default;
-        // Move Assign
-        Task& operator= (Task&& right) = delete;
-
-        // Order tasks by its end
-        std::weak_ordering operator<=> (Task const& other) const
-        {
-            return std::compare_weak_order_fallback(_end, other._end);
-        }
-
-        // Compare tasks with its end
-        bool operator== (Task const& other) const
-        {
-            return _end == other._end;
-        }
+        Task& operator= (Task const&) = delete;
 
         // Returns true if the task is in the given group
         inline bool IsInGroup(group_t const group) const
@@ -113,37 +193,97 @@ class TC_COMMON_API TaskScheduler
         }
     };
 
-    typedef std::shared_ptr<Task> TaskContainer;
-
     /// Container which provides Task order, insert and reschedule operations.
-    struct Compare
+    /// Tasks are pooled records addressed by index, the queue itself is a flat 4-ary heap ordered by end time
+    /// and then by insertion order, so tasks ending at the same time are invoked in the order they were queued.
+    class TC_COMMON_API TaskQueue
     {
-        bool operator() (TaskContainer const& left, TaskContainer const& right) const
+        struct Entry
         {
-            return (*left.get()) < (*right.get());
-        }
-    };
+            timepoint_t End;
+            uint64 Sequence;
+            uint32 Index;
 
-    class TC_COMMON_API TaskQueue
-    {
-        std::multiset<TaskContainer, Compare> container;
+            bool operator< (Entry const& right) const
+            {
+                return End < right.End || (End == right.End && Sequence < right.Sequence);
+            }
+        };
+
+        static constexpr std::size_t Arity = 4;
+
+        std::deque<Task> _tasks;                            // never shrinks, so tasks keep their address while their handler runs
+        std::vector<uint32> _freeTasks;
+        std::vector<Entry> _heap;
+        uint64 _nextSequence = 0;
+
+        void SiftUp(std::size_t position);
+        void SiftDown(std::size_t position);
+        void Heapify();
 
     public:
+        /// Takes a task record from the pool, it is not queued yet
+        uint32 Create(timepoint_t const& end, duration_t const& duration, Optional<group_t> const& group, task_handler_t&& task);
+
+        /// Returns the task to the pool unless its handler is running
+        void Free(uint32 index);
+
+        Task& Get(uint32 index) { return _tasks[index]; }
+        Task const& Get(uint32 index) const { return _tasks[index]; }
+
         // Pushes the task in the container
-        void Push(TaskContainer&& task);
+        void Push(uint32 index);
 
         /// Pops the task out of the container
-        TaskContainer Pop();
+        uint32 Pop();
 
-        TaskContainer const& First() const;
+        timepoint_t const& FirstEnd() const { return _heap.front().End; }
 
         void Clear();
 
-        void RemoveIf(std::function<bool(TaskContainer const&)> const& filter);
+        template<typename Filter>
+        void RemoveIf(Filter&& filter)
+        {
+            auto removed = std::remove_if(_heap.begin(), _heap.end(), [&](Entry const& entry)
+            {
+                if (!filter(_tasks[entry.Index]))
+                    return false;
 
-        void ModifyIf(std::function<bool(TaskContainer const&)> const& filter);
+                _tasks[entry.Index]._queued = false;
+                Free(entry.Index);
+                return true;
+            });
+
+            if (removed == _heap.end())
+                return;
+
+            _heap.erase(removed, _heap.end());
+            Heapify();
+        }
+
+        /// Modified tasks are queued again after the ones ending at the same time, in their previous order
+        template<typename Filter>
+        void ModifyIf(Filter&& filter)
+        {
+            std::vector<Entry*> modified;
+            for (Entry& entry : _heap)
+                if (filter(_tasks[entry.Index]))
+                    modified.push_back(&entry);
+
+            if (modified.empty())
+                return;
+
+            std::sort(modified.begin(), modified.end(), [](Entry const* left, Entry const* right) { return *left < *right; });
+            for (Entry* entry : modified)
+            {
+                entry->End = _tasks[entry->Index]._end;
+                entry->Sequence = _nextSequence++;
+            }
+
+            Heapify();
+        }
 
-        bool IsEmpty() const;
+        bool IsEmpty() const { return _heap.empty(); }
     };
 
     /// Contains a self reference to track if this object was deleted or not.
@@ -223,27 +363,27 @@ public:
     /// Never call this from within a task context! Use TaskContext::Schedule instead!
     template<class _Rep, class _Period>
     TaskScheduler& Schedule(std::chrono::duration<_Rep, _Period> const& time,
-        task_handler_t const& task)
+        task_handler_t task)
     {
-        return ScheduleAt(_now, time, task);
+        return ScheduleAt(_now, time, std::move(task));
     }
 
     /// Schedule an event with a fixed rate.
     /// Never call this from within a task context! Use TaskContext::Schedule instead!
     template<class _Rep, class _Period>
     TaskScheduler& Schedule(std::chrono::duration<_Rep, _Period> const& time,
-        group_t const group, task_handler_t const& task)
+        group_t const group, task_handler_t task)
     {
-        return ScheduleAt(_now, time, group, task);
+        return ScheduleAt(_now, time, group, std::move(task));
     }
 
     /// Schedule an event with a randomized rate between min and max rate.
     /// Never call this from within a task context! Use TaskContext::Schedule instead!
     template<class _RepLeft, class _PeriodLeft, class _RepRight, class _PeriodRight>
     TaskScheduler& Schedule(std::chrono::duration<_RepLeft, _PeriodLeft> const& min,
-        std::chrono::duration<_RepRight, _PeriodRight> const& max, task_handler_t const& task)
+        std::chrono::duration<_RepRight, _PeriodRight> const& max, task_handler_t task)
     {
-        return Schedule(randtime(min, max), task);
+        return Schedule(randtime(min, max), std::move(task));
     }
 
     /// Schedule an event with a fixed rate.
@@ -251,9 +391,9 @@ public:
     template<class _RepLeft, class _PeriodLeft, class _RepRight, class _PeriodRight>
     TaskScheduler& Schedule(std::chrono::duration<_RepLeft, _PeriodLeft> const& min,
         std::chrono::duration<_RepRight, _PeriodRight> const& max, group_t const group,
-        task_handler_t const& task)
+        task_handler_t task)
     {
-        return Schedule(randtime(min, max), group, task);
+        return Schedule(randtime(min, max), group, std::move(task));
     }
 
     /// Cancels all tasks.
@@ -272,9 +412,9 @@ public:
     template<class _Rep, class _Period>
     TaskScheduler& DelayAll(std::chrono::duration<_Rep, _Period> const& duration)
     {
-        _task_holder.ModifyIf([&duration](TaskContainer const& task) -> bool
+        _task_holder.ModifyIf([&duration](Task& task) -> bool
         {
-            task->_end += duration;
+            task._end += duration;
             return true;
         });
         return *this;
@@ -292,11 +432,11 @@ public:
     template<class _Rep, class _Period>
     TaskScheduler& DelayGroup(group_t const group, std::chrono::duration<_Rep, _Period> const& duration)
     {
-        _task_holder.ModifyIf([&duration, group](TaskContainer const& task) -> bool
+        _task_holder.ModifyIf([&duration, group](Task& task) -> bool
         {
-            if (task->IsInGroup(group))
+            if (task.IsInGroup(group))
             {
-                task->_end += duration;
+                task._end += duration;
                 return true;
             }
             else
@@ -319,9 +459,9 @@ public:
     TaskScheduler& RescheduleAll(std::chrono::duration<_Rep, _Period> const& duration)
     {
         auto const end = _now + duration;
-        _task_holder.ModifyIf([end](TaskContainer const& task) -> bool
+        _task_holder.ModifyIf([end](Task& task) -> bool
         {
-            task->_end = end;
+            task._end = end;
             return true;
         });
         return *this;
@@ -340,11 +480,11 @@ public:
     TaskScheduler& RescheduleGroup(group_t const group, std::chrono::duration<_Rep, _Period> const& duration)
     {
         auto const end = _now + duration;
-       _task_holder.ModifyIf([end, group](TaskContainer const& task) -> bool
+       _task_holder.ModifyIf([end, group](Task& task) -> bool
         {
-            if (task->IsInGroup(group))
+            if (task.IsInGroup(group))
             {
-                task->_end = end;
+                task._end = end;
                 return true;
             }
             else
@@ -363,14 +503,12 @@ public:
     }
 
 private:
-    /// Insert a new task to the enqueued tasks.
-    TaskScheduler& InsertTask(TaskContainer task);
-
     template<class _Rep, class _Period>
     TaskScheduler& ScheduleAt(timepoint_t const& end,
-        std::chrono::duration<_Rep, _Period> const& time, task_handler_t const& task)
+        std::chrono::duration<_Rep, _Period> const& time, task_handler_t&& task)
     {
-        return InsertTask(TaskContainer(new Task(end + time, time, task)));
+        _task_holder.Push(_task_holder.Create(end + time, time, std::nullopt, std::move(task)));
+        return *this;
     }
 
     /// Schedule an event with a fixed rate.
@@ -378,10 +516,10 @@ private:
     template<class _Rep, class _Period>
     TaskScheduler& ScheduleAt(timepoint_t const& end,
         std::chrono::duration<_Rep, _Period> const& time,
-        group_t const group, task_handler_t const& task)
+        group_t const group, task_handler_t&& task)
     {
-        static repeated_t const DEFAULT_REPEATED = 0;
-        return InsertTask(TaskContainer(new Task(end + time, time, group, DEFAULT_REPEATED, task)));
+        _task_holder.Push(_task_holder.Create(end + time, time, group, std::move(task)));
+        return *this;
     }
 
     /// Dispatch remaining tasks
@@ -392,52 +530,40 @@ class TC_COMMON_API TaskContext
 {
     friend class TaskScheduler;
 
-    /// Associated task
-    TaskScheduler::TaskContainer _task;
-
     /// Owner
+    TaskScheduler* _scheduler;
     std::weak_ptr<TaskScheduler> _owner;
 
-    /// Marks the task as consumed
-    std::shared_ptr<bool> _consumed;
+    /// Associated task, a pooled record of the owner
+    uint32 _task;
+    uint32 _generation;
+
+    /// Returns the associated task, nullptr if the owner is gone or the task moved on to another invocation
+    TaskScheduler::Task* GetTask() const;
 
     /// Dispatches an action safe on the TaskScheduler
-    TaskContext& Dispatch(std::function<TaskScheduler&(TaskScheduler&)> const& apply);
+    template<typename Apply>
+    TaskContext& Dispatch(Apply&& apply)
+    {
+        if (!_owner.expired())
+            apply(*_scheduler);
+
+        return *this;
+    }
 
 public:
     // Empty constructor
     TaskContext()
-        : _task(), _owner(), _consumed(std::make_shared<bool>(true)) { }
+        : _scheduler(nullptr), _owner(), _task(0), _generation(0) { }
 
     // Construct from task and owner
-    explicit TaskContext(TaskScheduler::TaskContainer&& task, std::weak_ptr<TaskScheduler>&& owner)
-        : _task(task), _owner(owner), _consumed(std::make_shared<bool>(false)) { }
-
-    // Copy construct
-    TaskContext(TaskContext const& right)
-        : _task(right._task), _owner(right._owner), _consumed(right._consumed) { }
-
-    // Move construct
-    TaskContext(TaskContext&& right)
-        : _task(std::move(right._task)), _owner(std::move(right._owner)), _consumed(std::move(right._consumed)) { }
-
-    // Copy assign
-    TaskContext& operator= (TaskContext const& right)
-    {
-        _task = right._task;
-        _owner = right._owner;
-        _consumed = right._consumed;
-        return *this;
-    }
+    explicit TaskContext(TaskScheduler* scheduler, std::weak_ptr<TaskScheduler>&& owner, uint32 task, uint32 generation)
+        : _scheduler(scheduler), _owner(std::move(owner)), _task(task), _generation(generation) { }
 
-    // Move assign
-    TaskContext& operator= (TaskContext&& right)
-    {
-        _task = std::move(right._task);
-        _owner = std::move(right._owner);
-        _consumed = std::move(right._consumed);
-        return *this;
-    }
+    TaskContext(TaskContext const& right) = default;
+    TaskContext(TaskContext&& right) noexcept = default;
+    TaskContext& operator= (TaskContext const& right) = default;
+    TaskContext& operator= (TaskContext&& right) noexcept = default;
 
     /// Returns true if the owner was deallocated and this context has expired.
     bool IsExpired() const;
@@ -461,23 +587,25 @@ public:
     template<class _Rep, class _Period>
     TaskContext& Repeat(std::chrono::duration<_Rep, _Period> const& duration)
     {
+        // Contexts of a task which finished already are stale, repeating them does nothing
+        TaskScheduler::Task* task = GetTask();
+        if (!task)
+            return *this;
+
         AssertOnConsumed();
 
         // Set new duration, in-context timing and increment repeat counter
-        _task->_duration = duration;
-        _task->_end += duration;
-        _task->_repeated += 1;
-        (*_consumed) = true;
-        return Dispatch(std::bind(&TaskScheduler::InsertTask, std::placeholders::_1, _task));
+        task->_duration = duration;
+        task->_end += duration;
+        task->_repeated += 1;
+        _scheduler->_task_holder.Push(_task);
+        return *this;
     }
 
     /// Repeats the event with the same duration.
     /// This will consume the task context, its not possible to repeat the task again
     /// from the same task context!
-    TaskContext& Repeat()
-    {
-        return Repeat(_task->_duration);
-    }
+    TaskContext& Repeat();
 
     /// Repeats the event and set a new duration that is randomized between min and max.
     /// std::chrono::seconds(5) for example.
@@ -500,12 +628,11 @@ public:
     /// which will be called at the next update tick.
     template<class _Rep, class _Period>
     TaskContext& Schedule(std::chrono::duration<_Rep, _Period> const& time,
-        TaskScheduler::task_handler_t const& task)
+        TaskScheduler::task_handler_t task)
     {
-        auto const end = _task->_end;
-        return Dispatch([end, time, task](TaskScheduler& scheduler) -> TaskScheduler&
+        return Dispatch([&](TaskScheduler& scheduler) -> TaskScheduler&
         {
-            return scheduler.ScheduleAt<_Rep, _Period>(end, time, task);
+            return scheduler.ScheduleAt<_Rep, _Period>(GetEnd(), time, std::move(task));
         });
     }
 
@@ -515,12 +642,11 @@ public:
     /// which will be called at the next update tick.
     template<class _Rep, class _Period>
     TaskContext& Schedule(std::chrono::duration<_Rep, _Period> const& time,
-        TaskScheduler::group_t const group, TaskScheduler::task_handler_t const& task)
+        TaskScheduler::group_t const group, TaskScheduler::task_handler_t task)
     {
-        auto const end = _task->_end;
-        return Dispatch([end, time, group, task](TaskScheduler& scheduler) -> TaskScheduler&
+        return Dispatch([&](TaskScheduler& scheduler) -> TaskScheduler&
         {
-            return scheduler.ScheduleAt<_Rep, _Period>(end, time, group, task);
+            return scheduler.ScheduleAt<_Rep, _Period>(GetEnd(), time, group, std::move(task));
         });
     }
 
@@ -530,9 +656,9 @@ public:
     /// which will be called at the next update tick.
     template<class _RepLeft, class _PeriodLeft, class _RepRight, class _PeriodRight>
     TaskContext& Schedule(std::chrono::duration<_RepLeft, _PeriodLeft> const& min,
-        std::chrono::duration<_RepRight, _PeriodRight> const& max, TaskScheduler::task_handler_t const& task)
+        std::chrono::duration<_RepRight, _PeriodRight> const& max, TaskScheduler::task_handler_t task)
     {
-        return Schedule(randtime(min, max), task);
+        return Schedule(randtime(min, max), std::move(task));
     }
 
     /// Schedule an event with a randomized rate between min and max rate from within the context.
@@ -542,9 +668,9 @@ public:
     template<class _RepLeft, class _PeriodLeft, class _RepRight, class _PeriodRight>
     TaskContext& Schedule(std::chrono::duration<_RepLeft, _PeriodLeft> const& min,
         std::chrono::duration<_RepRight, _PeriodRight> const& max, TaskScheduler::group_t const group,
-        TaskScheduler::task_handler_t const& task)
+        TaskScheduler::task_handler_t task)
     {
-        return Schedule(randtime(min, max), group, task);
+        return Schedule(randtime(min, max), group, std::move(task));
     }
 
     /// Cancels all tasks from within the context.
@@ -561,7 +687,7 @@ public:
     template<class _Rep, class _Period>
     TaskContext& DelayAll(std::chrono::duration<_Rep, _Period> const& duration)
     {
-        return Dispatch(std::bind(&TaskScheduler::DelayAll<_Rep, _Period>, std::placeholders::_1, duration));
+        return Dispatch([&](TaskScheduler& scheduler) { scheduler.DelayAll(duration); });
     }
 
     /// Delays all tasks with a random duration between min and max from within the context.
@@ -576,7 +702,7 @@ public:
     template<class _Rep, class _Period>
     TaskContext& DelayGroup(TaskScheduler::group_t const group, std::chrono::duration<_Rep, _Period> const& duration)
     {
-        return Dispatch(std::bind(&TaskScheduler::DelayGroup<_Rep, _Period>, std::placeholders::_1, group, duration));
+        return Dispatch([&](TaskScheduler& scheduler) { scheduler.DelayGroup(group, duration); });
     }
 
     /// Delays all tasks of a group with a random duration between min and max from within the context.
@@ -592,7 +718,7 @@ public:
     template<class _Rep, class _Period>
     TaskContext& RescheduleAll(std::chrono::duration<_Rep, _Period> const& duration)
     {
-        return Dispatch(std::bind(&TaskScheduler::RescheduleAll, std::placeholders::_1, duration));
+        return Dispatch([&](TaskScheduler& scheduler) { scheduler.RescheduleAll(duration); });
     }
 
     /// Reschedule all tasks with a random duration between min and max.
@@ -607,7 +733,7 @@ public:
     template<class _Rep, class _Period>
     TaskContext& RescheduleGroup(TaskScheduler::group_t const group, std::chrono::duration<_Rep, _Period> const& duration)
     {
-        return Dispatch(std::bind(&TaskScheduler::RescheduleGroup<_Rep, _Period>, std::placeholders::_1, group, duration));
+        return Dispatch([&](TaskScheduler& scheduler) { scheduler.RescheduleGroup(group, duration); });
     }
 
     /// Reschedule all tasks of a group with a random duration between min and max.
@@ -623,8 +749,13 @@ private:
     /// Asserts if the task was consumed already.
     void AssertOnConsumed() const;
 
-    /// Invokes the associated hook of the task.
-    void Invoke();
+    /// End of the associated task, tasks scheduled from the context start from it
+    TaskScheduler::timepoint_t GetEnd() const;
 };
 
+inline void TaskScheduler::TaskHandler::operator()(TaskContext&& context)
+{
+    _operations->Invoke(&_storage, std::move(context));
+}
+
 #endif /// _TASK_SCHEDULER_H_
@@ -136,7 +136,7 @@ int main(int argc, char** argv)
     std::vector<std::string> overriddenKeys = sConfigMgr->OverrideWithEnvVariablesIfAny();
 
     sLog->RegisterAppender<AppenderDB>();
-    sLog->Initialize(nullptr);
+    sLog->Initialize(false);
 
     Trinity::Banner::Show("authserver",
         [](char const* text)
@@ -16,14 +16,17 @@
  */
 
 #include "DatabaseWorker.h"
+#include "Metric.h"
 #include "SQLOperation.h"
 #include "ProducerConsumerQueue.h"
 
-DatabaseWorker::DatabaseWorker(ProducerConsumerQueue<SQLOperation*>* newQueue, MySQLConnection* connection)
+DatabaseWorker::DatabaseWorker(ProducerConsumerQueue<SQLOperation*>* newQueue, MySQLConnection* connection, std::string database)
 {
     _connection = connection;
     _queue = newQueue;
     _cancelationToken = false;
+    _database = std::move(database);
+    _queueLatency = nullptr;
     _workerThread = std::thread(&DatabaseWorker::WorkerThread, this);
 }
 
@@ -50,6 +53,18 @@ void DatabaseWorker::WorkerThread()
         if (_cancelationToken || !operation)
             return;
 
+#if !defined PERFORMANCE_PROFILING && !defined WITHOUT_METRICS
+        // time spent waiting for a free connection, resolved late as metrics are configured after the databases start
+        if (sMetric->IsLocalEnabled())
+        {
+            if (!_queueLatency)
+                _queueLatency = sMetric->GetHistogram("db_queue_latency", { { "database", _database } }, true);
+
+            if (_queueLatency)
+                _queueLatency->Record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - operation->m_queuedTime).count());
+        }
+#endif
+
         operation->SetConnection(_connection);
         operation->call();
 
@@ -20,18 +20,20 @@
 
 #include "Define.h"
 #include <atomic>
+#include <string>
 #include <thread>
 
 template <typename T>
 class ProducerConsumerQueue;
 
+class MetricHistogram;
 class MySQLConnection;
 class SQLOperation;
 
 class TC_DATABASE_API DatabaseWorker
 {
     public:
-        DatabaseWorker(ProducerConsumerQueue<SQLOperation*>* newQueue, MySQLConnection* connection);
+        DatabaseWorker(ProducerConsumerQueue<SQLOperation*>* newQueue, MySQLConnection* connection, std::string database);
         ~DatabaseWorker();
 
     private:
@@ -43,6 +45,9 @@ class TC_DATABASE_API DatabaseWorker
 
         std::atomic<bool> _cancelationToken;
 
+        std::string _database;
+        MetricHistogram* _queueLatency;
+
         DatabaseWorker(DatabaseWorker const& right) = delete;
         DatabaseWorker& operator=(DatabaseWorker const& right) = delete;
 };
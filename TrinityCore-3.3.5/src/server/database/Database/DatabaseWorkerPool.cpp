@@ -431,6 +431,7 @@ unsigned long DatabaseWorkerPool<T>::EscapeString(char* to, char const* from, un
 template <class T>
 void DatabaseWorkerPool<T>::Enqueue(SQLOperation* op)
 {
+    op->m_queuedTime = std::chrono::steady_clock::now();
     _queue->Push(op);
 }
 
@@ -63,7 +63,7 @@ m_Mysql(nullptr),
 m_connectionInfo(connInfo),
 m_connectionFlags(CONNECTION_ASYNC)
 {
-    m_worker = std::make_unique<DatabaseWorker>(m_queue, this);
+    m_worker = std::make_unique<DatabaseWorker>(m_queue, this, m_connectionInfo.database);
 }
 
 MySQLConnection::~MySQLConnection()
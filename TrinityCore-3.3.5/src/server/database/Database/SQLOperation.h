@@ -20,6 +20,7 @@
 
 #include "Define.h"
 #include "DatabaseEnvFwd.h"
+#include "Duration.h"
 
 //- Union that holds element data
 union SQLElementUnion
@@ -59,6 +60,7 @@ class TC_DATABASE_API SQLOperation
         virtual void SetConnection(MySQLConnection* con) { m_conn = con; }
 
         MySQLConnection* m_conn;
+        TimePoint m_queuedTime;                             //! Set when pushed to the async queue, for the queue latency metric
 
     private:
         SQLOperation(SQLOperation const& right) = delete;
@@ -61,6 +61,7 @@ SmartScript::SmartScript()
     mEventSortingRequired = false;
     mNestedEventsCounter = 0;
     mAllEventFlags = 0;
+    mEventIndex = nullptr;
 }
 
 SmartScript::~SmartScript()
@@ -236,17 +237,14 @@ void SmartScript::ProcessEventsFor(SMART_EVENT e, Unit* unit, uint32 var0, uint3
     {
         TC_LOG_WARN("scripts.ai", "SmartScript::ProcessEventsFor: reached the limit of max allowed nested ProcessEventsFor() calls with event {}, skipping!\n{}", e, GetBaseObject()->GetDebugInfo());
     }
-    else
+    else if (mEventIndex)
     {
-        for (SmartScriptHolder& event : mEvents)
+        // links are not indexed, they are processed from their source event
+        for (uint32 index : mEventIndex->GetEvents(e))
         {
-            SMART_EVENT eventType = SMART_EVENT(event.GetEventType());
-            if (eventType == SMART_EVENT_LINK)//special handling
-                continue;
-
-            if (eventType == e)
-                if (sConditionMgr->IsObjectMeetingSmartEventConditions(event.entryOrGuid, event.event_id, event.source_type, unit, GetBaseObject()))
-                    ProcessEvent(event, unit, var0, var1, bvar, spell, gob);
+            SmartScriptHolder& event = mEvents[index];
+            if (sConditionMgr->IsObjectMeetingSmartEventConditions(event.entryOrGuid, event.event_id, event.source_type, unit, GetBaseObject()))
+                ProcessEvent(event, unit, var0, var1, bvar, spell, gob);
         }
     }
 
@@ -3441,9 +3439,16 @@ void SmartScript::InstallEvents()
             mEvents.push_back(installevent);//must be before UpdateTimers
 
         mInstallEvents.clear();
+        RebuildEventIndex();
     }
 }
 
+void SmartScript::RebuildEventIndex()
+{
+    mOwnEventIndex.Build(mEvents);
+    mEventIndex = &mOwnEventIndex;
+}
+
 void SmartScript::RemoveStoredEvent(uint32 id)
 {
     if (!mStoredEvents.empty())
@@ -3536,6 +3541,7 @@ void SmartScript::OnUpdate(uint32 const diff)
     if (mEventSortingRequired)
     {
         SortEvents(mEvents);
+        RebuildEventIndex();
         mEventSortingRequired = false;
     }
 
@@ -3620,9 +3626,9 @@ void SmartScript::RetryLater(SmartScriptHolder& e, bool ignoreChanceRoll)
     e.runOnce = false;
 }
 
-void SmartScript::FillScript(SmartAIEventList e, WorldObject* obj, AreaTriggerEntry const* at)
+void SmartScript::FillScript(SmartAIEventTablePtr const& table, WorldObject* obj, AreaTriggerEntry const* at)
 {
-    if (e.empty())
+    if (!table || table->Events.empty())
     {
         if (obj)
             TC_LOG_DEBUG("scripts.ai", "SmartScript: EventMap for Entry {} is empty but is using SmartScript.", obj->GetEntry());
@@ -3630,7 +3636,19 @@ void SmartScript::FillScript(SmartAIEventList e, WorldObject* obj, AreaTriggerEn
             TC_LOG_DEBUG("scripts.ai", "SmartScript: EventMap for AreaTrigger {} is empty but is using SmartScript.", at->ID);
         return;
     }
-    for (SmartScriptHolder& scriptholder : e)
+
+    mEventTable = table;
+
+    // common case, every event is used and the index of the table matches our copy
+    if (!table->HasFilteredEvents && mEvents.empty())
+    {
+        mAllEventFlags |= table->AllEventFlags;
+        mEvents = table->Events;
+        mEventIndex = &table->Index;
+        return;
+    }
+
+    for (SmartScriptHolder const& scriptholder : table->Events)
     {
         #ifndef TRINITY_DEBUG
             if (scriptholder.event.event_flags & SMART_EVENT_FLAG_DEBUG_ONLY)
@@ -3648,22 +3666,24 @@ void SmartScript::FillScript(SmartAIEventList e, WorldObject* obj, AreaTriggerEn
         mAllEventFlags |= scriptholder.event.event_flags;
         mEvents.push_back(scriptholder);//NOTE: 'world(0)' events still get processed in ANY instance mode
     }
+
+    RebuildEventIndex();
 }
 
 void SmartScript::GetScript()
 {
-    SmartAIEventList e;
+    SmartAIEventTablePtr e;
     if (me)
     {
         e = sSmartScriptMgr->GetScript(-((int32)me->GetSpawnId()), mScriptType);
-        if (e.empty())
+        if (!e)
             e = sSmartScriptMgr->GetScript((int32)me->GetEntry(), mScriptType);
         FillScript(e, me, nullptr);
     }
     else if (go)
     {
         e = sSmartScriptMgr->GetScript(-((int32)go->GetSpawnId()), mScriptType);
-        if (e.empty())
+        if (!e)
             e = sSmartScriptMgr->GetScript((int32)go->GetEntry(), mScriptType);
         FillScript(e, go, nullptr);
     }
@@ -3803,7 +3823,8 @@ void SmartScript::SetTimedActionList(SmartScriptHolder& e, uint32 entry, Unit* i
         return;
 
     mTimedActionList.clear();
-    mTimedActionList = sSmartScriptMgr->GetScript(entry, SMART_SCRIPT_TYPE_TIMED_ACTIONLIST);
+    if (SmartAIEventTablePtr timedActionList = sSmartScriptMgr->GetScript(entry, SMART_SCRIPT_TYPE_TIMED_ACTIONLIST))
+        mTimedActionList = timedActionList->Events;
     if (mTimedActionList.empty())
         return;
     mTimedActionListInvoker = invoker ? invoker->GetGUID() : ObjectGuid::Empty;
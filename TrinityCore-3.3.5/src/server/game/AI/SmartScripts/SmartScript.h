@@ -35,9 +35,13 @@ class TC_GAME_API SmartScript
         SmartScript();
         ~SmartScript();
 
+        // mEventIndex may point into this object
+        SmartScript(SmartScript const&) = delete;
+        SmartScript& operator=(SmartScript const&) = delete;
+
         void OnInitialize(WorldObject* obj, AreaTriggerEntry const* at = nullptr);
         void GetScript();
-        void FillScript(SmartAIEventList e, WorldObject* obj, AreaTriggerEntry const* at);
+        void FillScript(SmartAIEventTablePtr const& table, WorldObject* obj, AreaTriggerEntry const* at);
 
         void ProcessEventsFor(SMART_EVENT e, Unit* unit = nullptr, uint32 var0 = 0, uint32 var1 = 0, bool bvar = false, SpellInfo const* spell = nullptr, GameObject* gob = nullptr);
         void ProcessEvent(SmartScriptHolder& e, Unit* unit = nullptr, uint32 var0 = 0, uint32 var1 = 0, bool bvar = false, SpellInfo const* spell = nullptr, GameObject* gob = nullptr);
@@ -106,6 +110,10 @@ class TC_GAME_API SmartScript
         void RetryLater(SmartScriptHolder& e, bool ignoreChanceRoll = false);
 
         SmartAIEventList mEvents;
+        SmartAIEventTablePtr mEventTable;
+        // shared with mEventTable until our events are filtered, sorted or extended
+        SmartAIEventIndex const* mEventIndex;
+        SmartAIEventIndex mOwnEventIndex;
         SmartAIEventList mInstallEvents;
         SmartAIEventList mTimedActionList;
         ObjectGuid mTimedActionListInvoker;
@@ -138,6 +146,7 @@ class TC_GAME_API SmartScript
         ObjectVectorMap _storedTargets;
 
         void InstallEvents();
+        void RebuildEventIndex();
 
         void RemoveStoredEvent(uint32 id);
 };
@@ -27,6 +27,7 @@
 #include "ObjectMgr.h"
 #include "SpellInfo.h"
 #include "SpellMgr.h"
+#include "StartupSnapshot.h"
 #include "Timer.h"
 #include "UnitDefines.h"
 #include "Unit.h"
@@ -121,13 +122,36 @@ SmartAIMgr* SmartAIMgr::instance()
 
 void SmartAIMgr::LoadSmartAIFromDB()
 {
-    LoadHelperStores();
-
     uint32 oldMSTime = getMSTime();
 
     for (SmartAIEventMap& eventmap : mEventMap)
         eventmap.clear();  //Drop Existing SmartAI List
 
+    // objects keep using the tables they already have until they are respawned
+    for (SmartAIEventTableMap& tables : mEventTables)
+        tables.clear();
+
+    // every table and client data store the validation below looks up is part of the key
+    StartupSnapshot snapshot("smart_scripts",
+        { "smart_scripts", "creature_template", "creature", "gameobject_template", "gameobject", "creature_text", "quest_template",
+          "item_template", "creature_equip_template", "game_event", "waypoints", "spell_dbc" },
+        { "AreaTable.dbc", "AreaTrigger.dbc", "CreatureDisplayInfo.dbc", "Emotes.dbc", "EmotesText.dbc", "FactionTemplate.dbc",
+          "Item.dbc", "Light.dbc", "Map.dbc", "SoundEntries.dbc", "Spell.dbc", "TaxiPath.dbc" });
+    if (snapshot.Open())
+    {
+        if (Optional<uint32> count = LoadFromSnapshot(snapshot))
+        {
+            BuildEventTables();
+            TC_LOG_INFO("server.loading", ">> Loaded {} SmartAI scripts from startup snapshot in {} ms", *count, GetMSTimeDiffToNow(oldMSTime));
+            return;
+        }
+
+        for (SmartAIEventMap& eventmap : mEventMap)
+            eventmap.clear();
+    }
+
+    LoadHelperStores();
+
     WorldDatabasePreparedStatement* stmt = WorldDatabase.GetPreparedStatement(WORLD_SEL_SMART_SCRIPTS);
     PreparedQueryResult result = WorldDatabase.Query(stmt);
 
@@ -386,22 +410,190 @@ void SmartAIMgr::LoadSmartAIFromDB()
         }
     }
 
+    if (StartupSnapshot::IsEnabled())
+    {
+        WriteSnapshot(snapshot);
+        snapshot.Save();
+    }
+
+    BuildEventTables();
+
     TC_LOG_INFO("server.loading", ">> Loaded {} SmartAI scripts in {} ms", count, GetMSTimeDiffToNow(oldMSTime));
 
     UnLoadHelperStores();
 }
 
-SmartAIEventList SmartAIMgr::GetScript(int32 entry, SmartScriptType type)
+Optional<uint32> SmartAIMgr::LoadFromSnapshot(StartupSnapshot& snapshot)
 {
-    SmartAIEventList temp;
-    if (mEventMap[uint32(type)].find(entry) != mEventMap[uint32(type)].end())
-        return mEventMap[uint32(type)][entry];
-    else
+    uint32 count = 0;
+    try
+    {
+        for (SmartAIEventMap& eventmap : mEventMap)
+        {
+            uint32 entryCount = snapshot.Read<uint32>();
+            eventmap.reserve(entryCount);
+            for (uint32 i = 0; i < entryCount; ++i)
+            {
+                int32 entryOrGuid = snapshot.Read<int32>();
+                SmartAIEventList& eventList = eventmap[entryOrGuid];
+                eventList.resize(snapshot.Read<uint32>());
+                for (SmartScriptHolder& temp : eventList)
+                {
+                    temp.entryOrGuid = entryOrGuid;
+                    temp.source_type = SmartScriptType(snapshot.Read<uint8>());
+                    temp.event_id = snapshot.Read<uint32>();
+                    temp.link = snapshot.Read<uint32>();
+
+                    temp.event.type = SMART_EVENT(snapshot.Read<uint8>());
+                    temp.event.event_phase_mask = snapshot.Read<uint32>();
+                    temp.event.event_chance = snapshot.Read<uint32>();
+                    temp.event.event_flags = snapshot.Read<uint32>();
+                    temp.event.raw.param1 = snapshot.Read<uint32>();
+                    temp.event.raw.param2 = snapshot.Read<uint32>();
+                    temp.event.raw.param3 = snapshot.Read<uint32>();
+                    temp.event.raw.param4 = snapshot.Read<uint32>();
+                    temp.event.raw.param5 = snapshot.Read<uint32>();
+
+                    temp.action.type = SMART_ACTION(snapshot.Read<uint8>());
+                    temp.action.raw.param1 = snapshot.Read<uint32>();
+                    temp.action.raw.param2 = snapshot.Read<uint32>();
+                    temp.action.raw.param3 = snapshot.Read<uint32>();
+                    temp.action.raw.param4 = snapshot.Read<uint32>();
+                    temp.action.raw.param5 = snapshot.Read<uint32>();
+                    temp.action.raw.param6 = snapshot.Read<uint32>();
+
+                    temp.target.type = SMARTAI_TARGETS(snapshot.Read<uint8>());
+                    temp.target.raw.param1 = snapshot.Read<uint32>();
+                    temp.target.raw.param2 = snapshot.Read<uint32>();
+                    temp.target.raw.param3 = snapshot.Read<uint32>();
+                    temp.target.raw.param4 = snapshot.Read<uint32>();
+                    temp.target.x = snapshot.Read<float>();
+                    temp.target.y = snapshot.Read<float>();
+                    temp.target.z = snapshot.Read<float>();
+                    temp.target.o = snapshot.Read<float>();
+                }
+            }
+
+            count += entryCount;
+        }
+    }
+    catch (ByteBufferException const& e)
     {
-        if (entry > 0)//first search is for guid (negative), do not drop error if not found
-            TC_LOG_DEBUG("scripts.ai", "SmartAIMgr::GetScript: Could not load Script for Entry {} ScriptType {}.", entry, uint32(type));
-        return temp;
+        TC_LOG_ERROR("server.loading", "Startup snapshot {} could not be read ({}), loading from the database", snapshot.GetName(), e.what());
+        return {};
     }
+
+    if (!snapshot.IsFullyRead())
+        return {};
+
+    return count;
+}
+
+// stores the events after validation, IsEventValid may have corrected some of their params
+void SmartAIMgr::WriteSnapshot(StartupSnapshot& snapshot) const
+{
+    for (SmartAIEventMap const& eventmap : mEventMap)
+    {
+        snapshot.Write<uint32>(eventmap.size());
+        for (auto const& [entryOrGuid, eventList] : eventmap)
+        {
+            snapshot.Write<int32>(entryOrGuid);
+            snapshot.Write<uint32>(eventList.size());
+            for (SmartScriptHolder const& e : eventList)
+            {
+                snapshot.Write<uint8>(e.source_type);
+                snapshot.Write<uint32>(e.event_id);
+                snapshot.Write<uint32>(e.link);
+
+                snapshot.Write<uint8>(e.event.type);
+                snapshot.Write<uint32>(e.event.event_phase_mask);
+                snapshot.Write<uint32>(e.event.event_chance);
+                snapshot.Write<uint32>(e.event.event_flags);
+                snapshot.Write<uint32>(e.event.raw.param1);
+                snapshot.Write<uint32>(e.event.raw.param2);
+                snapshot.Write<uint32>(e.event.raw.param3);
+                snapshot.Write<uint32>(e.event.raw.param4);
+                snapshot.Write<uint32>(e.event.raw.param5);
+
+                snapshot.Write<uint8>(e.action.type);
+                snapshot.Write<uint32>(e.action.raw.param1);
+                snapshot.Write<uint32>(e.action.raw.param2);
+                snapshot.Write<uint32>(e.action.raw.param3);
+                snapshot.Write<uint32>(e.action.raw.param4);
+                snapshot.Write<uint32>(e.action.raw.param5);
+                snapshot.Write<uint32>(e.action.raw.param6);
+
+                snapshot.Write<uint8>(e.target.type);
+                snapshot.Write<uint32>(e.target.raw.param1);
+                snapshot.Write<uint32>(e.target.raw.param2);
+                snapshot.Write<uint32>(e.target.raw.param3);
+                snapshot.Write<uint32>(e.target.raw.param4);
+                snapshot.Write<float>(e.target.x);
+                snapshot.Write<float>(e.target.y);
+                snapshot.Write<float>(e.target.z);
+                snapshot.Write<float>(e.target.o);
+            }
+        }
+    }
+}
+
+void SmartAIMgr::BuildEventTables()
+{
+    for (uint32 type = 0; type < SMART_SCRIPT_TYPE_MAX; ++type)
+    {
+        mEventTables[type].reserve(mEventMap[type].size());
+        for (std::pair<int32 const, SmartAIEventList>& eventlistpair : mEventMap[type])
+        {
+            std::shared_ptr<SmartAIEventTable> table = std::make_shared<SmartAIEventTable>();
+            table->Events = std::move(eventlistpair.second);
+            table->Index.Build(table->Events);
+            for (SmartScriptHolder const& e : table->Events)
+            {
+                table->AllEventFlags |= e.event.event_flags;
+#ifndef TRINITY_DEBUG
+                if (e.event.event_flags & SMART_EVENT_FLAG_DEBUG_ONLY)
+                    table->HasFilteredEvents = true;
+#endif
+                if (e.event.event_flags & SMART_EVENT_FLAG_DIFFICULTY_ALL)
+                    table->HasFilteredEvents = true;
+            }
+
+            mEventTables[type][eventlistpair.first] = std::move(table);
+        }
+
+        mEventMap[type].clear();
+    }
+}
+
+SmartAIEventTablePtr SmartAIMgr::GetScript(int32 entry, SmartScriptType type) const
+{
+    auto itr = mEventTables[uint32(type)].find(entry);
+    if (itr != mEventTables[uint32(type)].end())
+        return itr->second;
+
+    if (entry > 0)//first search is for guid (negative), do not drop error if not found
+        TC_LOG_DEBUG("scripts.ai", "SmartAIMgr::GetScript: Could not load Script for Entry {} ScriptType {}.", entry, uint32(type));
+    return nullptr;
+}
+
+void SmartAIEventIndex::Build(SmartAIEventList const& events)
+{
+    // counting sort of the event positions by type
+    _offsets.fill(0);
+    for (SmartScriptHolder const& e : events)
+        if (e.GetEventType() < SMART_EVENT_END && e.GetEventType() != SMART_EVENT_LINK)
+            ++_offsets[e.GetEventType() + 1];
+
+    for (uint32 type = 1; type <= SMART_EVENT_END; ++type)
+        _offsets[type] += _offsets[type - 1];
+
+    std::array<uint32, SMART_EVENT_END> next;
+    std::copy_n(_offsets.begin(), SMART_EVENT_END, next.begin());
+
+    _events.resize(_offsets[SMART_EVENT_END]);
+    for (uint32 i = 0; i < events.size(); ++i)
+        if (events[i].GetEventType() < SMART_EVENT_END && events[i].GetEventType() != SMART_EVENT_LINK)
+            _events[next[events[i].GetEventType()]++] = i;
 }
 
 SmartScriptHolder& SmartAIMgr::FindLinkedSourceEvent(SmartAIEventList& list, uint32 eventId)
@@ -20,11 +20,15 @@
 
 #include "Define.h"
 #include "EnumFlag.h"
+#include "IteratorPair.h"
 #include "ObjectGuid.h"
+#include "Optional.h"
 #include "WaypointDefines.h"
 #include "advstd.h"
+#include <array>
 #include <limits>
 #include <map>
+#include <memory>
 #include <string>
 #include <unordered_map>
 
@@ -1648,10 +1652,46 @@ typedef std::vector<SmartScriptHolder> SmartAIEventStoredList;
 // all events for all entries / guids
 typedef std::unordered_map<int32, SmartAIEventList> SmartAIEventMap;
 
+/// Positions of the events of a SmartAIEventList grouped by event type, in list order.
+/// Links are left out, they are only ever reached from their source event.
+class TC_GAME_API SmartAIEventIndex
+{
+    public:
+        void Build(SmartAIEventList const& events);
+
+        Trinity::IteratorPair<uint32 const*> GetEvents(SMART_EVENT type) const
+        {
+            if (type >= SMART_EVENT_END)
+                return { };
+
+            return { _events.data() + _offsets[type], _events.data() + _offsets[type + 1] };
+        }
+
+    private:
+        std::array<uint32, SMART_EVENT_END + 1> _offsets = { };
+        std::vector<uint32> _events;
+};
+
+/// Events of a single entry or guid, shared by every object using them. Objects copy the events for their
+/// timers and share the index as long as their copy keeps the same layout.
+struct SmartAIEventTable
+{
+    SmartAIEventList Events;
+    SmartAIEventIndex Index;
+    uint32 AllEventFlags = 0;
+    /// Some events are only used by debug builds or in specific dungeon difficulties
+    bool HasFilteredEvents = false;
+};
+
+typedef std::shared_ptr<SmartAIEventTable const> SmartAIEventTablePtr;
+typedef std::unordered_map<int32, SmartAIEventTablePtr> SmartAIEventTableMap;
+
 // Helper Stores
 typedef std::map<uint32 /*entry*/, std::pair<uint32 /*spellId*/, SpellEffIndex /*effIndex*/> > CacheSpellContainer;
 typedef std::pair<CacheSpellContainer::const_iterator, CacheSpellContainer::const_iterator> CacheSpellContainerBounds;
 
+class StartupSnapshot;
+
 class TC_GAME_API SmartAIMgr
 {
     private:
@@ -1663,15 +1703,21 @@ class TC_GAME_API SmartAIMgr
 
         void LoadSmartAIFromDB();
 
-        SmartAIEventList GetScript(int32 entry, SmartScriptType type);
+        /// Returns nullptr if there are no events for the entry, tables survive reloads as long as they are in use
+        SmartAIEventTablePtr GetScript(int32 entry, SmartScriptType type) const;
 
         static SmartScriptHolder& FindLinkedSourceEvent(SmartAIEventList& list, uint32 eventId);
 
         static SmartScriptHolder& FindLinkedEvent(SmartAIEventList& list, uint32 link);
 
     private:
-        //event stores
+        //event stores, mEventMap only holds the events while they are loaded and validated
         SmartAIEventMap mEventMap[SMART_SCRIPT_TYPE_MAX];
+        SmartAIEventTableMap mEventTables[SMART_SCRIPT_TYPE_MAX];
+
+        Optional<uint32> LoadFromSnapshot(StartupSnapshot& snapshot);
+        void WriteSnapshot(StartupSnapshot& snapshot) const;
+        void BuildEventTables();
 
         static bool EventHasInvoker(SMART_EVENT event);
 
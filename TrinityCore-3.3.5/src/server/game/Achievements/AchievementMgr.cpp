@@ -35,6 +35,7 @@
 #include "Mail.h"
 #include "Map.h"
 #include "MapManager.h"
+#include "Metric.h"
 #include "ObjectMgr.h"
 #include "Player.h"
 #include "RBAC.h"
@@ -477,7 +478,47 @@ bool AchievementCriteriaDataSet::Meets(Player const* source, WorldObject const*
     return true;
 }
 
-AchievementMgr::AchievementMgr(Player* player) : m_player(player), m_achievementPoints(0)
+void AchievementCriteriaState::Clear()
+{
+    std::fill(_state.begin(), _state.end(), 0);
+    _pendingUpdates.clear();
+}
+
+void AchievementCriteriaState::QueueUpdate(AchievementCriteriaEntry const* criteria, uint32 timeElapsed, bool timedCompleted)
+{
+    if (HasState(criteria->ID, STATE_PENDING_UPDATE))
+    {
+        auto itr = std::find_if(_pendingUpdates.begin(), _pendingUpdates.end(), [criteria](PendingUpdate const& pending)
+        {
+            return pending.Criteria == criteria;
+        });
+
+        if (itr != _pendingUpdates.end())
+        {
+            itr->TimeElapsed = timeElapsed;
+            itr->TimedCompleted = timedCompleted;
+            return;
+        }
+    }
+
+    SetState(criteria->ID, STATE_PENDING_UPDATE);
+    _pendingUpdates.push_back({ criteria, timeElapsed, timedCompleted });
+}
+
+void AchievementCriteriaState::Remove(AchievementCriteriaEntry const* criteria)
+{
+    if (HasState(criteria->ID, STATE_PENDING_UPDATE))
+    {
+        _pendingUpdates.erase(std::remove_if(_pendingUpdates.begin(), _pendingUpdates.end(), [criteria](PendingUpdate const& pending)
+        {
+            return pending.Criteria == criteria;
+        }), _pendingUpdates.end());
+    }
+
+    RemoveState(criteria->ID, STATE_COMPLETED | STATE_PENDING_UPDATE);
+}
+
+AchievementMgr::AchievementMgr(Player* player) : m_player(player), m_achievementPoints(0), m_criteriaState(sAchievementCriteriaStore.GetNumRows())
 {
 }
 
@@ -502,6 +543,9 @@ void AchievementMgr::Reset()
     m_completedAchievements.clear();
     m_achievementPoints = 0;
     m_criteriaProgress.clear();
+    m_criteriaState.Clear();
+    m_changedCriteria.clear();
+    m_changedAchievements.clear();
     DeleteFromDB(m_player->GetGUID());
 
     // re-fill data
@@ -551,53 +595,53 @@ void AchievementMgr::DeleteFromDB(ObjectGuid guid)
 
 void AchievementMgr::SaveToDB(CharacterDatabaseTransaction trans)
 {
-    if (!m_completedAchievements.empty())
+    // only visit what changed since the last save, a player with a long history has thousands of unchanged entries
+    for (uint32 achievementId : m_changedAchievements)
     {
-        for (std::pair<uint32 const, CompletedAchievementData>& completedAchievement : m_completedAchievements)
-        {
-            if (!completedAchievement.second.changed)
-                continue;
+        CompletedAchievementMap::iterator completedAchievement = m_completedAchievements.find(achievementId);
+        if (completedAchievement == m_completedAchievements.end() || !completedAchievement->second.changed)
+            continue;
 
-            CharacterDatabasePreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_DEL_CHAR_ACHIEVEMENT_BY_ACHIEVEMENT);
-            stmt->setUInt16(0, completedAchievement.first);
-            stmt->setUInt32(1, GetPlayer()->GetGUID().GetCounter());
-            trans->Append(stmt);
+        CharacterDatabasePreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_DEL_CHAR_ACHIEVEMENT_BY_ACHIEVEMENT);
+        stmt->setUInt16(0, completedAchievement->first);
+        stmt->setUInt32(1, GetPlayer()->GetGUID().GetCounter());
+        trans->Append(stmt);
 
-            stmt = CharacterDatabase.GetPreparedStatement(CHAR_INS_CHAR_ACHIEVEMENT);
-            stmt->setUInt32(0, GetPlayer()->GetGUID().GetCounter());
-            stmt->setUInt16(1, completedAchievement.first);
-            stmt->setUInt32(2, uint32(completedAchievement.second.date));
-            trans->Append(stmt);
+        stmt = CharacterDatabase.GetPreparedStatement(CHAR_INS_CHAR_ACHIEVEMENT);
+        stmt->setUInt32(0, GetPlayer()->GetGUID().GetCounter());
+        stmt->setUInt16(1, completedAchievement->first);
+        stmt->setUInt32(2, uint32(completedAchievement->second.date));
+        trans->Append(stmt);
 
-            completedAchievement.second.changed = false;
-        }
+        completedAchievement->second.changed = false;
     }
+    m_changedAchievements.clear();
 
-    if (!m_criteriaProgress.empty())
+    for (uint32 criteriaId : m_changedCriteria)
     {
-        for (std::pair<uint32 const, CriteriaProgress>& criteriaProgres : m_criteriaProgress)
-        {
-            if (!criteriaProgres.second.changed)
-                continue;
+        // progress removed since it changed is left as it is in the database
+        CriteriaProgressMap::iterator criteriaProgres = m_criteriaProgress.find(criteriaId);
+        if (criteriaProgres == m_criteriaProgress.end() || !criteriaProgres->second.changed)
+            continue;
+
+        CharacterDatabasePreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_DEL_CHAR_ACHIEVEMENT_PROGRESS_BY_CRITERIA);
+        stmt->setUInt32(0, GetPlayer()->GetGUID().GetCounter());
+        stmt->setUInt16(1, criteriaProgres->first);
+        trans->Append(stmt);
 
-            CharacterDatabasePreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_DEL_CHAR_ACHIEVEMENT_PROGRESS_BY_CRITERIA);
+        if (criteriaProgres->second.counter)
+        {
+            stmt = CharacterDatabase.GetPreparedStatement(CHAR_INS_CHAR_ACHIEVEMENT_PROGRESS);
             stmt->setUInt32(0, GetPlayer()->GetGUID().GetCounter());
-            stmt->setUInt16(1, criteriaProgres.first);
+            stmt->setUInt16(1, criteriaProgres->first);
+            stmt->setUInt32(2, criteriaProgres->second.counter);
+            stmt->setUInt32(3, uint32(criteriaProgres->second.date));
             trans->Append(stmt);
-
-            if (criteriaProgres.second.counter)
-            {
-                stmt = CharacterDatabase.GetPreparedStatement(CHAR_INS_CHAR_ACHIEVEMENT_PROGRESS);
-                stmt->setUInt32(0, GetPlayer()->GetGUID().GetCounter());
-                stmt->setUInt16(1, criteriaProgres.first);
-                stmt->setUInt32(2, criteriaProgres.second.counter);
-                stmt->setUInt32(3, uint32(criteriaProgres.second.date));
-                trans->Append(stmt);
-            }
-
-            criteriaProgres.second.changed = false;
         }
+
+        criteriaProgres->second.changed = false;
     }
+    m_changedCriteria.clear();
 }
 
 void AchievementMgr::LoadFromDB(PreparedQueryResult achievementResult, PreparedQueryResult criteriaResult)
@@ -761,6 +805,54 @@ void AchievementMgr::CheckAllAchievementCriteria()
 
 static const uint32 achievIdByArenaSlot[MAX_ARENA_SLOT] = { 1057, 1107, 1108 };
 
+namespace
+{
+// completing an achievement updates criteria recursively, only the outermost call of a thread is measured
+class AchievementUpdateTimer
+{
+public:
+    AchievementUpdateTimer() : _outermost(_depth++ == 0 && sMetric->IsEnabled())
+    {
+        if (_outermost)
+            _startTime = std::chrono::steady_clock::now();
+    }
+
+    ~AchievementUpdateTimer()
+    {
+        --_depth;
+        if (_outermost)
+            sAchievementMgr->AddUpdateTime(std::chrono::steady_clock::now() - _startTime);
+    }
+
+    AchievementUpdateTimer(AchievementUpdateTimer const&) = delete;
+    AchievementUpdateTimer& operator=(AchievementUpdateTimer const&) = delete;
+
+private:
+    static thread_local uint32 _depth;
+    bool _outermost;
+    TimePoint _startTime;
+};
+
+thread_local uint32 AchievementUpdateTimer::_depth = 0;
+
+// the progress of these criteria mirrors player state that can be lost again (reputation drops),
+// completing them once doesn't make them final
+bool CanCriteriaProgressDecrease(AchievementCriteriaTypes type)
+{
+    switch (type)
+    {
+        case ACHIEVEMENT_CRITERIA_TYPE_GAIN_REPUTATION:
+        case ACHIEVEMENT_CRITERIA_TYPE_GAIN_EXALTED_REPUTATION:
+        case ACHIEVEMENT_CRITERIA_TYPE_GAIN_REVERED_REPUTATION:
+        case ACHIEVEMENT_CRITERIA_TYPE_GAIN_HONORED_REPUTATION:
+        case ACHIEVEMENT_CRITERIA_TYPE_KNOWN_FACTIONS:
+            return true;
+        default:
+            return false;
+    }
+}
+}
+
 /**
  * this function will be called whenever the user might have done a criteria relevant action
  */
@@ -783,10 +875,17 @@ void AchievementMgr::UpdateAchievementCriteria(AchievementCriteriaTypes type, ui
     TC_LOG_DEBUG("achievement", "UpdateAchievementCriteria: {}, {} ({}), {}, {}"
         , m_player->GetGUID().ToString(), AchievementGlobalMgr::GetCriteriaTypeString(type), type, miscValue1, miscValue2);
 
-    AchievementCriteriaEntryList const& achievementCriteriaList = sAchievementMgr->GetAchievementCriteriaByType(type, miscValue1);
-    for (AchievementCriteriaEntry const* achievementCriteria : achievementCriteriaList)
+    AchievementUpdateTimer updateTimer;
+
+    for (AchievementCriteriaDispatchEntry const& dispatchEntry : sAchievementMgr->GetAchievementCriteriaByType(type, miscValue1))
     {
-        AchievementEntry const* achievement = sAchievementStore.LookupEntry(achievementCriteria->AchievementID);
+        AchievementCriteriaEntry const* achievementCriteria = dispatchEntry.Criteria;
+        AchievementEntry const* achievement = dispatchEntry.Achievement;
+
+        // completed criteria can't be updated, skip them before any of the more expensive checks
+        if (m_criteriaState.IsCompleted(achievementCriteria->ID))
+            continue;
+
         if (!CanUpdateCriteria(achievementCriteria, achievement, miscValue1, miscValue2, ref))
             continue;
 
@@ -798,7 +897,7 @@ void AchievementMgr::UpdateAchievementCriteria(AchievementCriteriaTypes type, ui
             case ACHIEVEMENT_CRITERIA_TYPE_ROLL_GREED_ON_LOOT:
                 break;
             default:
-                if (AchievementCriteriaDataSet const* data = sAchievementMgr->GetCriteriaDataSet(achievementCriteria))
+                if (AchievementCriteriaDataSet const* data = dispatchEntry.Data)
                     if (!data->Meets(GetPlayer(), ref, miscValue1, miscValue2))
                         continue;
                 break;
@@ -1135,7 +1234,10 @@ void AchievementMgr::UpdateAchievementCriteria(AchievementCriteriaTypes type, ui
         }
 
         if (IsCompletedCriteria(achievementCriteria, achievement))
+        {
+            MarkCriteriaCompleted(achievementCriteria, achievement);
             CompletedCriteriaFor(achievement);
+        }
 
         // check again the completeness for SUMM and REQ COUNT achievements,
         // as they don't depend on the completed criteria but on the sum of the progress of each individual criteria
@@ -1274,6 +1376,19 @@ bool AchievementMgr::IsCompletedCriteria(AchievementCriteriaEntry const* achieve
     return false;
 }
 
+void AchievementMgr::MarkCriteriaCompleted(AchievementCriteriaEntry const* criteria, AchievementEntry const* achievement)
+{
+    // realm first criteria stop being completed when someone else on the realm gets there first
+    if (achievement->Flags & (ACHIEVEMENT_FLAG_REALM_FIRST_REACH | ACHIEVEMENT_FLAG_REALM_FIRST_KILL))
+        return;
+
+    // must keep being updated to notice the progress going back down
+    if (CanCriteriaProgressDecrease(AchievementCriteriaTypes(criteria->Type)))
+        return;
+
+    m_criteriaState.SetCompleted(criteria->ID);
+}
+
 void AchievementMgr::CompletedCriteriaFor(AchievementEntry const* achievement)
 {
     // counter can never complete
@@ -1403,8 +1518,14 @@ void AchievementMgr::SetCriteriaProgress(AchievementCriteriaEntry const* entry,
         progress->counter = newValue;
     }
 
-    progress->changed = true;
+    if (!progress->changed)
+    {
+        progress->changed = true;
+        m_changedCriteria.push_back(entry->ID);
+    }
+
     progress->date = GameTime::GetGameTime(); // set the date to the latest update.
+    m_criteriaState.ClearCompleted(entry->ID);
 
     uint32 timeElapsed = 0;
     bool timedCompleted = false;
@@ -1421,7 +1542,21 @@ void AchievementMgr::SetCriteriaProgress(AchievementCriteriaEntry const* entry,
             m_timedAchievements.erase(timedIter);
     }
 
-    SendCriteriaUpdate(entry, progress, timeElapsed, timedCompleted);
+    m_criteriaState.QueueUpdate(entry, timeElapsed, timedCompleted);
+}
+
+void AchievementMgr::SendPendingCriteriaUpdates()
+{
+    if (!m_criteriaState.HasPendingUpdates())
+        return;
+
+    AchievementUpdateTimer updateTimer;
+
+    m_criteriaState.FlushPendingUpdates([this](AchievementCriteriaState::PendingUpdate const& pending)
+    {
+        if (CriteriaProgress const* progress = GetCriteriaProgress(pending.Criteria))
+            SendCriteriaUpdate(pending.Criteria, progress, pending.TimeElapsed, pending.TimedCompleted);
+    });
 }
 
 void AchievementMgr::RemoveCriteriaProgress(AchievementCriteriaEntry const* entry)
@@ -1433,6 +1568,8 @@ void AchievementMgr::RemoveCriteriaProgress(AchievementCriteriaEntry const* entr
     if (criteriaProgress == m_criteriaProgress.end())
         return;
 
+    m_criteriaState.Remove(entry);
+
     WorldPacket data(SMSG_CRITERIA_DELETED, 4);
     data << uint32(entry->ID);
     m_player->SendDirectMessage(&data);
@@ -1516,10 +1653,13 @@ void AchievementMgr::CompletedAchievement(AchievementEntry const* achievement)
     TC_LOG_INFO("achievement", "AchievementMgr::CompletedAchievement({}). Player: {} {}",
         achievement->ID, m_player->GetName(), m_player->GetGUID().ToString());
 
+    // the client shows the criteria that completed the achievement before the achievement itself
+    SendPendingCriteriaUpdates();
     SendAchievementEarned(achievement);
     CompletedAchievementData& ca = m_completedAchievements[achievement->ID];
     ca.date = GameTime::GetGameTime();
     ca.changed = true;
+    m_changedAchievements.push_back(achievement->ID);
 
     if (achievement->Flags & (ACHIEVEMENT_FLAG_REALM_FIRST_REACH | ACHIEVEMENT_FLAG_REALM_FIRST_KILL))
         sAchievementMgr->SetRealmCompleted(achievement);
@@ -1688,8 +1828,8 @@ bool AchievementMgr::CanUpdateCriteria(AchievementCriteriaEntry const* criteria,
         if (GetPlayer()->GetSession()->HasPermission(rbac::RBAC_PERM_CANNOT_EARN_REALM_FIRST_ACHIEVEMENTS))
             return false;
 
-    // don't update already completed criteria
-    if (IsCompletedCriteria(criteria, achievement))
+    // don't update already completed criteria, unless their progress can still go down
+    if (!CanCriteriaProgressDecrease(AchievementCriteriaTypes(criteria->Type)) && IsCompletedCriteria(criteria, achievement))
         return false;
 
     return true;
@@ -2225,7 +2365,7 @@ char const* AchievementGlobalMgr::GetCriteriaTypeString(AchievementCriteriaTypes
     return "MISSING_TYPE";
 }
 
-AchievementCriteriaEntryList const AchievementGlobalMgr::EmptyCriteriaList;
+AchievementCriteriaDispatchList const AchievementGlobalMgr::EmptyCriteriaList;
 
 AchievementGlobalMgr* AchievementGlobalMgr::instance()
 {
@@ -2275,7 +2415,7 @@ inline bool IsAchievementCriteriaTypeStoredByMiscValue(AchievementCriteriaTypes
     return false;
 }
 
-AchievementCriteriaEntryList const& AchievementGlobalMgr::GetAchievementCriteriaByType(AchievementCriteriaTypes type, uint32 miscValue) const
+AchievementCriteriaDispatchList const& AchievementGlobalMgr::GetAchievementCriteriaByType(AchievementCriteriaTypes type, uint32 miscValue) const
 {
     if (miscValue && IsAchievementCriteriaTypeStoredByMiscValue(type))
     {
@@ -2336,7 +2476,8 @@ void AchievementGlobalMgr::LoadAchievementCriteriaList()
         if (!criteria)
             continue;
 
-        if (!sAchievementStore.LookupEntry(criteria->AchievementID))
+        AchievementEntry const* achievement = sAchievementStore.LookupEntry(criteria->AchievementID);
+        if (!achievement)
         {
             TC_LOG_DEBUG("server.loading", "Achievement {} referenced by criteria {} doesn't exist, criteria not loaded.", criteria->AchievementID, criteria->ID);
             continue;
@@ -2345,12 +2486,15 @@ void AchievementGlobalMgr::LoadAchievementCriteriaList()
         ASSERT(criteria->Type < ACHIEVEMENT_CRITERIA_TYPE_TOTAL, "ACHIEVEMENT_CRITERIA_TYPE_TOTAL must be greater than or equal to %u but is currently equal to %u",
             criteria->Type + 1, ACHIEVEMENT_CRITERIA_TYPE_TOTAL);
 
-        m_AchievementCriteriasByType[criteria->Type].push_back(criteria);
+        // criteria data is linked by LoadAchievementCriteriaData
+        AchievementCriteriaDispatchEntry dispatchEntry = { criteria, achievement, nullptr };
+
+        m_AchievementCriteriasByType[criteria->Type].push_back(dispatchEntry);
         m_AchievementCriteriaListByAchievement[criteria->AchievementID].push_back(criteria);
         if (IsAchievementCriteriaTypeStoredByMiscValue(AchievementCriteriaTypes(criteria->Type)))
         {
             if (criteria->Type != ACHIEVEMENT_CRITERIA_TYPE_EXPLORE_AREA)
-                m_AchievementCriteriasByMiscValue[criteria->Type][criteria->Asset.ID].push_back(criteria);
+                m_AchievementCriteriasByMiscValue[criteria->Type][criteria->Asset.ID].push_back(dispatchEntry);
             else
             {
                 WorldMapOverlayEntry const* worldOverlayEntry = sWorldMapOverlayStore.LookupEntry(criteria->Asset.WorldMapOverlayID);
@@ -2366,7 +2510,7 @@ void AchievementGlobalMgr::LoadAchievementCriteriaList()
                             if (worldOverlayEntry->AreaID[j] == worldOverlayEntry->AreaID[i])
                                 valid = false;
                         if (valid)
-                            m_AchievementCriteriasByMiscValue[criteria->Type][worldOverlayEntry->AreaID[j]].push_back(criteria);
+                            m_AchievementCriteriasByMiscValue[criteria->Type][worldOverlayEntry->AreaID[j]].push_back(dispatchEntry);
                     }
                 }
             }
@@ -2439,6 +2583,7 @@ void AchievementGlobalMgr::LoadAchievementCriteriaData()
 
     if (!result)
     {
+        LinkCriteriaData();
         TC_LOG_INFO("server.loading", ">> Loaded 0 additional achievement criteria data. DB table `achievement_criteria_data` is empty.");
         return;
     }
@@ -2560,9 +2705,27 @@ void AchievementGlobalMgr::LoadAchievementCriteriaData()
             TC_LOG_ERROR("sql.sql", "Table `achievement_criteria_data` does not contain expected data for criteria (Entry: {} Type: {}) for achievement {}.", criteria->ID, criteria->Type, criteria->AchievementID);
     }
 
+    LinkCriteriaData();
+
     TC_LOG_INFO("server.loading", ">> Loaded {} additional achievement criteria data in {} ms", count, GetMSTimeDiffToNow(oldMSTime));
 }
 
+void AchievementGlobalMgr::LinkCriteriaData()
+{
+    auto link = [this](AchievementCriteriaDispatchList& list)
+    {
+        for (AchievementCriteriaDispatchEntry& dispatchEntry : list)
+            dispatchEntry.Data = GetCriteriaDataSet(dispatchEntry.Criteria);
+    };
+
+    for (uint32 type = 0; type < ACHIEVEMENT_CRITERIA_TYPE_TOTAL; ++type)
+    {
+        link(m_AchievementCriteriasByType[type]);
+        for (std::pair<uint32 const, AchievementCriteriaDispatchList>& miscValueList : m_AchievementCriteriasByMiscValue[type])
+            link(miscValueList.second);
+    }
+}
+
 void AchievementGlobalMgr::LoadCompletedAchievements()
 {
     uint32 oldMSTime = getMSTime();
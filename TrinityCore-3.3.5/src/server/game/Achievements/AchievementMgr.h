@@ -23,6 +23,7 @@
 #include "DBCStores.h"
 #include "Duration.h"
 #include "ObjectGuid.h"
+#include <atomic>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -35,7 +36,6 @@ typedef std::vector<AchievementCriteriaEntry const*> AchievementCriteriaEntryLis
 typedef std::vector<AchievementEntry const*>         AchievementEntryList;
 
 typedef std::unordered_map<uint32, AchievementCriteriaEntryList> AchievementCriteriaListByAchievement;
-typedef std::unordered_map<uint32, AchievementCriteriaEntryList> AchievementCriteriaListByMiscValue;
 typedef std::unordered_map<uint32, AchievementCriteriaEntryList> AchievementCriteriaListByCondition;
 typedef std::unordered_map<uint32, AchievementEntryList>         AchievementListByReferencedId;
 
@@ -234,6 +234,73 @@ struct TC_GAME_API AchievementCriteriaDataSet
 
 typedef std::unordered_map<uint32, AchievementCriteriaDataSet> AchievementCriteriaDataMap;
 
+// everything UpdateAchievementCriteria needs about a criteria, resolved once at startup instead of on every event
+struct AchievementCriteriaDispatchEntry
+{
+    AchievementCriteriaEntry const* Criteria;
+    AchievementEntry const* Achievement;
+    AchievementCriteriaDataSet const* Data;                 // nullptr without achievement_criteria_data rows
+};
+
+typedef std::vector<AchievementCriteriaDispatchEntry> AchievementCriteriaDispatchList;
+typedef std::unordered_map<uint32, AchievementCriteriaDispatchList> AchievementCriteriaDispatchListByMiscValue;
+
+// per player state of every criteria, indexed by criteria id: which criteria UpdateAchievementCriteria skips
+// because they are completed, and which progress changes wait to be sent to the client
+class TC_GAME_API AchievementCriteriaState
+{
+    public:
+        struct PendingUpdate
+        {
+            AchievementCriteriaEntry const* Criteria;
+            uint32 TimeElapsed;
+            bool TimedCompleted;
+        };
+
+        explicit AchievementCriteriaState(std::size_t criteriaCount) : _state(criteriaCount, 0) { }
+
+        void Clear();
+
+        bool IsCompleted(uint32 criteriaId) const { return HasState(criteriaId, STATE_COMPLETED); }
+        void SetCompleted(uint32 criteriaId) { SetState(criteriaId, STATE_COMPLETED); }
+        void ClearCompleted(uint32 criteriaId) { RemoveState(criteriaId, STATE_COMPLETED); }
+
+        // the client only needs the latest progress, a criteria queued many times before the next flush is sent once
+        void QueueUpdate(AchievementCriteriaEntry const* criteria, uint32 timeElapsed, bool timedCompleted);
+
+        // drops the queued update of the criteria and its completed state
+        void Remove(AchievementCriteriaEntry const* criteria);
+
+        bool HasPendingUpdates() const { return !_pendingUpdates.empty(); }
+
+        // calls send once for every criteria queued since the last flush
+        template<typename Sender>
+        void FlushPendingUpdates(Sender&& send)
+        {
+            for (PendingUpdate const& pending : _pendingUpdates)
+            {
+                RemoveState(pending.Criteria->ID, STATE_PENDING_UPDATE);
+                send(pending);
+            }
+
+            _pendingUpdates.clear();
+        }
+
+    private:
+        enum StateFlags : uint8
+        {
+            STATE_COMPLETED         = 0x1,
+            STATE_PENDING_UPDATE    = 0x2                   // queued in _pendingUpdates
+        };
+
+        bool HasState(uint32 criteriaId, uint8 flag) const { return criteriaId < _state.size() && (_state[criteriaId] & flag) != 0; }
+        void SetState(uint32 criteriaId, uint8 flag) { if (criteriaId < _state.size()) _state[criteriaId] |= flag; }
+        void RemoveState(uint32 criteriaId, uint8 flag) { if (criteriaId < _state.size()) _state[criteriaId] &= ~flag; }
+
+        std::vector<uint8> _state;                          // StateFlags
+        std::vector<PendingUpdate> _pendingUpdates;
+};
+
 struct AchievementReward
 {
     uint32 TitleId[2];
@@ -293,6 +360,9 @@ class TC_GAME_API AchievementMgr
         void RemoveTimedAchievement(AchievementCriteriaTimedTypes type, uint32 entry);   // used for quest and scripted timed achievements
 
         uint32 GetAchievementPoints() const { return m_achievementPoints; }
+
+        // sends the criteria progress changed since the last call, once per criteria
+        void SendPendingCriteriaUpdates();
     private:
         void SendAchievementEarned(AchievementEntry const* achievement) const;
         void SendCriteriaUpdate(AchievementCriteriaEntry const* entry, CriteriaProgress const* progress, uint32 timeElapsed, bool timedCompleted) const;
@@ -308,12 +378,20 @@ class TC_GAME_API AchievementMgr
         bool ConditionsSatisfied(AchievementCriteriaEntry const* criteria) const;
         bool RequirementsSatisfied(AchievementCriteriaEntry const* criteria, AchievementEntry const* achievement, uint32 miscValue1, uint32 miscValue2, WorldObject const* ref) const;
 
+        void MarkCriteriaCompleted(AchievementCriteriaEntry const* criteria, AchievementEntry const* achievement);
+
         Player* m_player;
         CriteriaProgressMap m_criteriaProgress;
         CompletedAchievementMap m_completedAchievements;
         typedef std::map<uint32, uint32> TimedAchievementMap;
         TimedAchievementMap m_timedAchievements;      // Criteria id/time left in MS
         uint32 m_achievementPoints;
+
+        AchievementCriteriaState m_criteriaState;
+        std::vector<uint32> m_changedCriteria;        // progress to write in the next SaveToDB
+        std::vector<uint32> m_changedAchievements;    // completed achievements to write in the next SaveToDB
+
+        friend class UnitTestDataLoader;
 };
 
 class TC_GAME_API AchievementGlobalMgr
@@ -327,7 +405,7 @@ class TC_GAME_API AchievementGlobalMgr
 
         static AchievementGlobalMgr* instance();
 
-        AchievementCriteriaEntryList const& GetAchievementCriteriaByType(AchievementCriteriaTypes type, uint32 miscValue) const;
+        AchievementCriteriaDispatchList const& GetAchievementCriteriaByType(AchievementCriteriaTypes type, uint32 miscValue) const;
 
         AchievementCriteriaEntryList const& GetTimedAchievementCriteriaByType(AchievementCriteriaTimedTypes type) const
         {
@@ -379,16 +457,22 @@ class TC_GAME_API AchievementGlobalMgr
         void LoadCompletedAchievements();
         void LoadRewards();
         void LoadRewardLocales();
+
+        // time spent in UpdateAchievementCriteria by all map threads, only measured while metrics are enabled
+        void AddUpdateTime(std::chrono::nanoseconds time) { _updateTime.fetch_add(time.count(), std::memory_order_relaxed); }
+        std::chrono::nanoseconds CollectUpdateTime() { return std::chrono::nanoseconds(_updateTime.exchange(0, std::memory_order_relaxed)); }
     private:
+        void LinkCriteriaData();
+
         AchievementCriteriaDataMap m_criteriaDataMap;
 
         // store achievement criterias by type to speed up lookup
-        AchievementCriteriaEntryList m_AchievementCriteriasByType[ACHIEVEMENT_CRITERIA_TYPE_TOTAL];
+        AchievementCriteriaDispatchList m_AchievementCriteriasByType[ACHIEVEMENT_CRITERIA_TYPE_TOTAL];
 
-        static AchievementCriteriaEntryList const EmptyCriteriaList;
+        static AchievementCriteriaDispatchList const EmptyCriteriaList;
 
         // store achievement criterias split by misc values
-        AchievementCriteriaListByMiscValue m_AchievementCriteriasByMiscValue[ACHIEVEMENT_CRITERIA_TYPE_TOTAL];
+        AchievementCriteriaDispatchListByMiscValue m_AchievementCriteriasByMiscValue[ACHIEVEMENT_CRITERIA_TYPE_TOTAL];
 
         AchievementCriteriaEntryList m_AchievementCriteriasByTimedType[ACHIEVEMENT_TIMED_TYPE_MAX];
 
@@ -408,6 +492,8 @@ class TC_GAME_API AchievementGlobalMgr
         AchievementRewards m_achievementRewards;
         AchievementRewardLocales m_achievementRewardLocales;
 
+        std::atomic<int64> _updateTime = 0;
+
         friend class UnitTestDataLoader;
 };
 
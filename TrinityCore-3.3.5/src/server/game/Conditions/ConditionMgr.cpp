@@ -757,6 +757,54 @@ uint32 Condition::GetMaxAvailableConditionTargets() const
     }
 }
 
+// Rough cost of Meets() for this condition, used to order the checks inside an ElseGroup
+// so that plain field reads can reject a group before inventory, aura or grid searches run
+uint8 Condition::GetEvaluationCost() const
+{
+    if (ReferenceId)
+        return 3;
+
+    switch (ConditionType)
+    {
+        case CONDITION_NONE:
+        case CONDITION_ZONEID:
+        case CONDITION_MAPID:
+        case CONDITION_AREAID:
+        case CONDITION_PHASEMASK:
+        case CONDITION_SPAWNMASK:
+        case CONDITION_DIFFICULTY_ID:
+        case CONDITION_TEAM:
+        case CONDITION_CLASS:
+        case CONDITION_RACE:
+        case CONDITION_GENDER:
+        case CONDITION_LEVEL:
+        case CONDITION_DRUNKENSTATE:
+        case CONDITION_OBJECT_ENTRY_GUID:
+        case CONDITION_TYPE_MASK:
+        case CONDITION_CREATURE_TYPE:
+        case CONDITION_ALIVE:
+        case CONDITION_HP_VAL:
+        case CONDITION_HP_PCT:
+        case CONDITION_UNIT_STATE:
+        case CONDITION_STAND_STATE:
+        case CONDITION_CHARMED:
+        case CONDITION_TAXI:
+        case CONDITION_GAMEMASTER:
+            return 0;
+        case CONDITION_ITEM:
+        case CONDITION_INSTANCE_INFO:
+        case CONDITION_NEAR_CREATURE:
+        case CONDITION_NEAR_GAMEOBJECT:
+        case CONDITION_RELATION_TO:
+        case CONDITION_REACTION_TO:
+        case CONDITION_DISTANCE_TO:
+        case CONDITION_IN_WATER:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
 std::string Condition::ToString(bool ext /*= false*/) const
 {
     std::ostringstream ss;
@@ -796,85 +844,104 @@ uint32 ConditionMgr::GetSearcherTypeMaskForConditionList(ConditionContainer cons
 {
     if (conditions.empty())
         return GRID_MAP_TYPE_MASK_ALL;
-    //     groupId, typeMask
-    std::map<uint32, uint32> elseGroupSearcherTypeMasks;
-    for (ConditionContainer::const_iterator i = conditions.begin(); i != conditions.end(); ++i)
+
+    // lists are kept ordered by ElseGroup (see AddToConditionList), each group is a contiguous range
+    uint32 mask = 0;
+    for (ConditionContainer::const_iterator itr = conditions.begin(); itr != conditions.end();)
     {
-        // no point of having not loaded conditions in list
-        ASSERT((*i)->isLoaded() && "ConditionMgr::GetSearcherTypeMaskForConditionList - not yet loaded condition found in list");
-        std::map<uint32, uint32>::const_iterator itr = elseGroupSearcherTypeMasks.find((*i)->ElseGroup);
+        uint32 elseGroup = (*itr)->ElseGroup;
         // group not filled yet, fill with widest mask possible
-        if (itr == elseGroupSearcherTypeMasks.end())
-            elseGroupSearcherTypeMasks[(*i)->ElseGroup] = GRID_MAP_TYPE_MASK_ALL;
-        // no point of checking anymore, empty mask
-        else if (!itr->second)
-            continue;
+        uint32 groupMask = GRID_MAP_TYPE_MASK_ALL;
+        for (; itr != conditions.end() && (*itr)->ElseGroup == elseGroup; ++itr)
+        {
+            Condition const* condition = *itr;
+            // no point of having not loaded conditions in list
+            ASSERT(condition->isLoaded() && "ConditionMgr::GetSearcherTypeMaskForConditionList - not yet loaded condition found in list");
+            // no point of checking anymore, empty mask
+            if (!groupMask)
+                continue;
 
-        if ((*i)->ReferenceId) // handle reference
-        {
-            ConditionReferenceContainer::const_iterator ref = ConditionReferenceStore.find((*i)->ReferenceId);
-            ASSERT(ref != ConditionReferenceStore.end() && "ConditionMgr::GetSearcherTypeMaskForConditionList - incorrect reference");
-            elseGroupSearcherTypeMasks[(*i)->ElseGroup] &= GetSearcherTypeMaskForConditionList((*ref).second);
-        }
-        else // handle normal condition
-        {
-            // object will match conditions in one ElseGroupStore only when it matches all of them
-            // so, let's find a smallest possible mask which satisfies all conditions
-            elseGroupSearcherTypeMasks[(*i)->ElseGroup] &= (*i)->GetSearcherTypeMaskForCondition();
+            if (condition->ReferenceId) // handle reference
+            {
+                ASSERT(condition->ReferencedConditions && "ConditionMgr::GetSearcherTypeMaskForConditionList - incorrect reference");
+                groupMask &= GetSearcherTypeMaskForConditionList(*condition->ReferencedConditions);
+            }
+            else // handle normal condition
+            {
+                // object will match conditions in one ElseGroupStore only when it matches all of them
+                // so, let's find a smallest possible mask which satisfies all conditions
+                groupMask &= condition->GetSearcherTypeMaskForCondition();
+            }
         }
+
+        // object will match condition when one of the checks in ElseGroupStore is matching
+        // so, let's include all possible masks
+        mask |= groupMask;
     }
-    // object will match condition when one of the checks in ElseGroupStore is matching
-    // so, let's include all possible masks
-    uint32 mask = 0;
-    for (std::map<uint32, uint32>::const_iterator i = elseGroupSearcherTypeMasks.begin(); i != elseGroupSearcherTypeMasks.end(); ++i)
-        mask |= i->second;
 
     return mask;
 }
 
 bool ConditionMgr::IsObjectMeetToConditionList(ConditionSourceInfo& sourceInfo, ConditionContainer const& conditions) const
 {
-    //     groupId, groupCheckPassed
-    std::map<uint32, bool> elseGroupStore;
-    for (Condition const* condition : conditions)
+    // lists are kept ordered by ElseGroup (see AddToConditionList), each group is a contiguous range
+    // and the first group with all of its conditions met makes the whole list pass.
+    // Groups used to be evaluated interleaved in db order, the failed condition reported to callers
+    // (spell cast errors) is still the one that failed last in that order
+    Condition const* lastFailedCondition = nullptr;
+    uint32 lastFailedOrder = 0;
+    for (ConditionContainer::const_iterator itr = conditions.begin(); itr != conditions.end();)
     {
-        TC_LOG_DEBUG("condition", "ConditionMgr::IsPlayerMeetToConditionList {} val1: {}", condition->ToString(), condition->ConditionValue1);
-        if (condition->isLoaded())
-        {
-            //! Find ElseGroup in ElseGroupStore
-            std::map<uint32, bool>::const_iterator itr = elseGroupStore.find(condition->ElseGroup);
-            //! If not found, add an entry in the store and set to true (placeholder)
-            if (itr == elseGroupStore.end())
-                elseGroupStore[condition->ElseGroup] = true;
-            else if (!(*itr).second) //! If another condition in this group was unmatched before this, don't bother checking (the group is false anyway)
+        uint32 elseGroup = (*itr)->ElseGroup;
+        bool hasLoadedCondition = false;
+        bool groupCheckPassed = true;
+        for (; itr != conditions.end() && (*itr)->ElseGroup == elseGroup; ++itr)
+        {
+            Condition const* condition = *itr;
+            //! If another condition in this group was unmatched before this, don't bother checking (the group is false anyway)
+            if (!groupCheckPassed)
                 continue;
 
+            TC_LOG_DEBUG("condition", "ConditionMgr::IsPlayerMeetToConditionList {} val1: {}", condition->ToString(), condition->ConditionValue1);
+            if (!condition->isLoaded())
+                continue;
+
+            hasLoadedCondition = true;
+            sourceInfo.mLastFailedCondition = nullptr;
             if (condition->ReferenceId)//handle reference
             {
-                ConditionReferenceContainer::const_iterator ref = ConditionReferenceStore.find(condition->ReferenceId);
-                if (ref != ConditionReferenceStore.end())
+                if (condition->ReferencedConditions)
                 {
-                    if (!IsObjectMeetToConditionList(sourceInfo, ref->second))
-                        elseGroupStore[condition->ElseGroup] = false;
+                    if (!IsObjectMeetToConditionList(sourceInfo, *condition->ReferencedConditions))
+                        groupCheckPassed = false;
                 }
                 else
                 {
                     TC_LOG_DEBUG("condition", "ConditionMgr::IsPlayerMeetToConditionList {} Reference template -{} not found",
                         condition->ToString(), condition->ReferenceId); // checked at loading, should never happen
                 }
-
             }
             else //handle normal condition
             {
                 if (!condition->Meets(sourceInfo))
-                    elseGroupStore[condition->ElseGroup] = false;
+                    groupCheckPassed = false;
+            }
+
+            if (!groupCheckPassed && sourceInfo.mLastFailedCondition && (!lastFailedCondition || condition->LoadOrder >= lastFailedOrder))
+            {
+                lastFailedCondition = sourceInfo.mLastFailedCondition;
+                lastFailedOrder = condition->LoadOrder;
             }
         }
-    }
-    for (std::map<uint32, bool>::const_iterator i = elseGroupStore.begin(); i != elseGroupStore.end(); ++i)
-        if (i->second)
+
+        if (hasLoadedCondition && groupCheckPassed)
+        {
+            sourceInfo.mLastFailedCondition = lastFailedCondition;
             return true;
+        }
+    }
 
+    sourceInfo.mLastFailedCondition = lastFailedCondition;
     return false;
 }
 
@@ -927,6 +994,28 @@ bool ConditionMgr::CanHaveSourceIdSet(ConditionSourceType sourceType)
     return (sourceType == CONDITION_SOURCE_TYPE_SMART_EVENT);
 }
 
+void ConditionMgr::AddToConditionList(ConditionContainer& conditions, Condition* cond)
+{
+    // Keep every list ordered by ElseGroup so evaluation can walk each group as a contiguous range,
+    // and by evaluation cost inside a group so cheap checks reject it first.
+    // Spell conditions and the reference templates they may use keep their db order, the first failed one
+    // of a group selects the cast error sent to the client
+    auto evaluationOrder = [](Condition const* condition) -> uint8
+    {
+        if (condition->SourceType == CONDITION_SOURCE_TYPE_SPELL || condition->SourceType == CONDITION_SOURCE_TYPE_NONE || condition->ErrorType)
+            return 0;
+        return condition->GetEvaluationCost();
+    };
+
+    ConditionContainer::iterator itr = std::upper_bound(conditions.begin(), conditions.end(), cond, [&](Condition const* left, Condition const* right)
+    {
+        if (left->ElseGroup != right->ElseGroup)
+            return left->ElseGroup < right->ElseGroup;
+        return evaluationOrder(left) < evaluationOrder(right);
+    });
+    conditions.insert(itr, cond);
+}
+
 bool ConditionMgr::IsObjectMeetingNotGroupedConditions(ConditionSourceType sourceType, uint32 entry, ConditionSourceInfo& sourceInfo) const
 {
     if (sourceType > CONDITION_SOURCE_TYPE_NONE && sourceType < CONDITION_SOURCE_TYPE_MAX)
@@ -1088,12 +1177,14 @@ void ConditionMgr::LoadConditions(bool isReload)
     }
 
     uint32 count = 0;
+    uint32 loadOrder = 0;
 
     do
     {
         Field* fields = result->Fetch();
 
         Condition* cond = new Condition();
+        cond->LoadOrder                 = loadOrder++;
         int32 iSourceTypeOrReferenceId  = fields[0].GetInt32();
         cond->SourceGroup               = fields[1].GetUInt32();
         cond->SourceEntry               = fields[2].GetInt32();
@@ -1152,7 +1243,7 @@ void ConditionMgr::LoadConditions(bool isReload)
 
         if (iSourceTypeOrReferenceId < 0)//it is a reference template
         {
-            ConditionReferenceStore[std::abs(iSourceTypeOrReferenceId)].push_back(cond);//add to reference storage
+            AddToConditionList(ConditionReferenceStore[std::abs(iSourceTypeOrReferenceId)], cond);//add to reference storage
             ++count;
             continue;
         }//end of reference templates
@@ -1240,7 +1331,7 @@ void ConditionMgr::LoadConditions(bool isReload)
                     break;
                 case CONDITION_SOURCE_TYPE_SPELL_CLICK_EVENT:
                 {
-                    SpellClickEventConditionStore[cond->SourceGroup][cond->SourceEntry].push_back(cond);
+                    AddToConditionList(SpellClickEventConditionStore[cond->SourceGroup][cond->SourceEntry], cond);
                     if (cond->ConditionType == CONDITION_AURA)
                         SpellsUsedInSpellClickConditions.insert(cond->ConditionValue1);
                     valid = true;
@@ -1252,7 +1343,7 @@ void ConditionMgr::LoadConditions(bool isReload)
                     break;
                 case CONDITION_SOURCE_TYPE_VEHICLE_SPELL:
                 {
-                    VehicleSpellConditionStore[cond->SourceGroup][cond->SourceEntry].push_back(cond);
+                    AddToConditionList(VehicleSpellConditionStore[cond->SourceGroup][cond->SourceEntry], cond);
                     valid = true;
                     ++count;
                     continue;   // do not add to m_AllocatedMemory to avoid double deleting
@@ -1261,14 +1352,14 @@ void ConditionMgr::LoadConditions(bool isReload)
                 {
                     //! TODO: PAIR_32 ?
                     std::pair<int32, uint32> key = std::make_pair(cond->SourceEntry, cond->SourceId);
-                    SmartEventConditionStore[key][cond->SourceGroup].push_back(cond);
+                    AddToConditionList(SmartEventConditionStore[key][cond->SourceGroup], cond);
                     valid = true;
                     ++count;
                     continue;
                 }
                 case CONDITION_SOURCE_TYPE_NPC_VENDOR:
                 {
-                    NpcVendorConditionContainerStore[cond->SourceGroup][cond->SourceEntry].push_back(cond);
+                    AddToConditionList(NpcVendorConditionContainerStore[cond->SourceGroup][cond->SourceEntry], cond);
                     valid = true;
                     ++count;
                     continue;
@@ -1294,14 +1385,53 @@ void ConditionMgr::LoadConditions(bool isReload)
         //add new Condition to storage based on Type/Entry
         if (cond->SourceType == CONDITION_SOURCE_TYPE_SPELL_CLICK_EVENT && cond->ConditionType == CONDITION_AURA)
             SpellsUsedInSpellClickConditions.insert(cond->ConditionValue1);
-        ConditionStore[cond->SourceType][cond->SourceEntry].push_back(cond);
+        AddToConditionList(ConditionStore[cond->SourceType][cond->SourceEntry], cond);
         ++count;
     }
     while (result->NextRow());
 
+    ResolveReferences();
+
     TC_LOG_INFO("server.loading", ">> Loaded {} conditions in {} ms", count, GetMSTimeDiffToNow(oldMSTime));
 }
 
+void ConditionMgr::ResolveReferences()
+{
+    // point every reference straight at its template list, evaluation then never has to search ConditionReferenceStore
+    auto resolve = [this](ConditionContainer const& conditions)
+    {
+        for (Condition* cond : conditions)
+        {
+            if (!cond->ReferenceId)
+                continue;
+
+            ConditionReferenceContainer::const_iterator ref = ConditionReferenceStore.find(cond->ReferenceId);
+            if (ref != ConditionReferenceStore.end())
+                cond->ReferencedConditions = &ref->second;
+            else
+                TC_LOG_ERROR("sql.sql", "{} has reference to not existing reference template -{}.", cond->ToString(), cond->ReferenceId);
+        }
+    };
+
+    for (ConditionReferenceContainer::value_type const& reference : ConditionReferenceStore)
+        resolve(reference.second);
+
+    for (ConditionsByEntryMap const& conditionsByEntry : ConditionStore)
+        for (ConditionsByEntryMap::value_type const& conditions : conditionsByEntry)
+            resolve(conditions.second);
+
+    for (ConditionEntriesByCreatureIdMap const* store : { &VehicleSpellConditionStore, &SpellClickEventConditionStore, &NpcVendorConditionContainerStore })
+        for (ConditionEntriesByCreatureIdMap::value_type const& conditionsByEntry : *store)
+            for (ConditionsByEntryMap::value_type const& conditions : conditionsByEntry.second)
+                resolve(conditions.second);
+
+    for (SmartEventConditionContainer::value_type const& conditionsByEntry : SmartEventConditionStore)
+        for (ConditionsByEntryMap::value_type const& conditions : conditionsByEntry.second)
+            resolve(conditions.second);
+
+    resolve(AllocatedMemoryStore);
+}
+
 bool ConditionMgr::addToLootTemplate(Condition* cond, LootTemplate* loot) const
 {
     if (!loot)
@@ -1327,7 +1457,7 @@ bool ConditionMgr::addToGossipMenus(Condition* cond) const
         {
             if ((*itr).second.MenuID == cond->SourceGroup && (*itr).second.TextID == uint32(cond->SourceEntry))
             {
-                (*itr).second.Conditions.push_back(cond);
+                AddToConditionList((*itr).second.Conditions, cond);
                 return true;
             }
         }
@@ -1346,7 +1476,7 @@ bool ConditionMgr::addToGossipMenuItems(Condition* cond) const
         {
             if ((*itr).second.MenuID == cond->SourceGroup && (*itr).second.OptionID == uint32(cond->SourceEntry))
             {
-                (*itr).second.Conditions.push_back(cond);
+                AddToConditionList((*itr).second.Conditions, cond);
                 return true;
             }
         }
@@ -1461,7 +1591,7 @@ bool ConditionMgr::addToSpellImplicitTargetConditions(Condition* cond) const
                     return false;
                 }
             }
-            sharedList->push_back(cond);
+            AddToConditionList(*sharedList, cond);
             break;
         }
     }
@@ -33,6 +33,8 @@ class WorldObject;
 class LootTemplate;
 struct Condition;
 
+typedef std::vector<Condition*> ConditionContainer;
+
 enum ConditionTypes
 {                                                              // value1                 value2         value3
     CONDITION_NONE                     = 0,                    // 0                      0              0                  always true
@@ -212,7 +214,9 @@ struct TC_GAME_API Condition
     uint32                  ErrorType;
     uint32                  ErrorTextId;
     uint32                  ReferenceId;
+    ConditionContainer const* ReferencedConditions; // resolved from ReferenceId once all conditions are loaded
     uint32                  ScriptId;
+    uint32                  LoadOrder;         // position of the row in `conditions`, failures are reported in this order
     uint8                   ConditionTarget;
     bool                    NegativeCondition;
 
@@ -229,9 +233,11 @@ struct TC_GAME_API Condition
         ConditionValue2    = 0;
         ConditionValue3    = 0;
         ReferenceId        = 0;
+        ReferencedConditions = nullptr;
         ErrorType          = 0;
         ErrorTextId        = 0;
         ScriptId           = 0;
+        LoadOrder          = 0;
         NegativeCondition  = false;
     }
 
@@ -239,11 +245,11 @@ struct TC_GAME_API Condition
     uint32 GetSearcherTypeMaskForCondition() const;
     bool isLoaded() const { return ConditionType > CONDITION_NONE || ReferenceId; }
     uint32 GetMaxAvailableConditionTargets() const;
+    uint8 GetEvaluationCost() const;
 
     std::string ToString(bool ext = false) const; /// For logging purpose
 };
 
-typedef std::vector<Condition*> ConditionContainer;
 typedef std::unordered_map<uint32 /*SourceEntry*/, ConditionContainer> ConditionsByEntryMap;
 typedef std::array<ConditionsByEntryMap, CONDITION_SOURCE_TYPE_MAX> ConditionEntriesByTypeArray;
 typedef std::unordered_map<uint32, ConditionsByEntryMap> ConditionEntriesByCreatureIdMap;
@@ -268,6 +274,7 @@ class TC_GAME_API ConditionMgr
         bool IsObjectMeetToConditions(ConditionSourceInfo& sourceInfo, ConditionContainer const& conditions) const;
         static bool CanHaveSourceGroupSet(ConditionSourceType sourceType);
         static bool CanHaveSourceIdSet(ConditionSourceType sourceType);
+        static void AddToConditionList(ConditionContainer& conditions, Condition* cond);
         bool IsObjectMeetingNotGroupedConditions(ConditionSourceType sourceType, uint32 entry, ConditionSourceInfo& sourceInfo) const;
         bool IsObjectMeetingNotGroupedConditions(ConditionSourceType sourceType, uint32 entry, WorldObject* target0, WorldObject* target1 = nullptr, WorldObject* target2 = nullptr) const;
         bool HasConditionsForNotGroupedEntry(ConditionSourceType sourceType, uint32 entry) const;
@@ -299,6 +306,8 @@ class TC_GAME_API ConditionMgr
 
         static void LogUselessConditionValue(Condition* cond, uint8 index, uint32 value);
 
+        void ResolveReferences();
+
         void Clean(); // free up resources
         std::vector<Condition*> AllocatedMemoryStore; // some garbage collection :)
 
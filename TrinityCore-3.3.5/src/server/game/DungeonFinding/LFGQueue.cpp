@@ -19,8 +19,10 @@
 #include "Containers.h"
 #include "DBCStructure.h"
 #include "DBCStores.h"
+#include "Errors.h"
 #include "GameTime.h"
 #include "Group.h"
+#include "Hash.h"
 #include "LFGQueue.h"
 #include "LFGMgr.h"
 #include "Log.h"
@@ -28,30 +30,6 @@
 namespace lfg
 {
 
-/**
-   Given a list of guids returns the concatenation using | as delimiter
-
-   @param[in]     check list of guids
-   @returns Concatenated string
-*/
-std::string ConcatenateGuids(GuidList const& check)
-{
-    if (check.empty())
-        return "";
-
-    // need the guids in order to avoid duplicates
-    GuidSet guids(check.begin(), check.end());
-
-    std::ostringstream o;
-
-    GuidSet::const_iterator it = guids.begin();
-    o << it->GetRawValue();
-    for (++it; it != guids.end(); ++it)
-        o << '|' << it->GetRawValue();
-
-    return o.str();
-}
-
 char const* GetCompatibleString(LfgCompatibility compatibles)
 {
     switch (compatibles)
@@ -81,6 +59,168 @@ char const* GetCompatibleString(LfgCompatibility compatibles)
     }
 }
 
+LfgDungeonMask::LfgDungeonMask(LfgDungeonSet const& dungeons) : _hasUnmapped(false)
+{
+    for (uint32 dungeonId : dungeons)
+    {
+        if (dungeonId < MaxDungeonId)
+            _bits.set(dungeonId);
+        else
+            _hasUnmapped = true;
+    }
+}
+
+LfgCompatibilityKey::LfgCompatibilityKey(GuidList const& check) : _guids(), _size(0)
+{
+    for (ObjectGuid guid : check)
+    {
+        uint64 rawGuid = guid.GetRawValue();
+        uint8 pos = 0;
+        while (pos < _size && _guids[pos] < rawGuid)
+            ++pos;
+
+        // need the guids only once, same as the set they replace
+        if (pos < _size && _guids[pos] == rawGuid)
+            continue;
+
+        ASSERT(_size < MaxGuids, "Too many guids (%u) for a compatibility key", uint32(check.size()));
+        std::copy_backward(_guids.begin() + pos, _guids.begin() + _size, _guids.begin() + _size + 1);
+        _guids[pos] = rawGuid;
+        ++_size;
+    }
+}
+
+bool LfgCompatibilityKey::Contains(ObjectGuid guid) const
+{
+    return std::find(_guids.begin(), _guids.begin() + _size, guid.GetRawValue()) != _guids.begin() + _size;
+}
+
+std::size_t LfgCompatibilityKey::GetHash() const
+{
+    std::size_t hash = 0;
+    for (uint8 i = 0; i < _size; ++i)
+        Trinity::hash_combine(hash, _guids[i]);
+    return hash;
+}
+
+/**
+   Given a key returns the concatenation of its guids using | as delimiter
+
+   @returns Concatenated string
+*/
+std::string LfgCompatibilityKey::ToString() const
+{
+    std::ostringstream o;
+    for (uint8 i = 0; i < _size; ++i)
+    {
+        if (i)
+            o << '|';
+        o << _guids[i];
+    }
+
+    return o.str();
+}
+
+LfgCompatibilityData* LfgCompatibleContainer::Find(LfgCompatibilityKey const& key)
+{
+    if (_entries.empty())
+        return nullptr;
+
+    uint32 index = _slots[FindSlot(key)];
+    return index != EmptySlot ? &_entries[index].second : nullptr;
+}
+
+LfgCompatibilityData& LfgCompatibleContainer::operator[](LfgCompatibilityKey const& key)
+{
+    if (LfgCompatibilityData* data = Find(key))
+        return *data;
+
+    _entries.emplace_back(key, LfgCompatibilityData());
+
+    // keep at most half of the slots used so probe sequences stay short
+    if (_entries.size() * 2 > _slots.size())
+        Rehash();
+    else
+        _slots[FindSlot(key)] = uint32(_entries.size() - 1);
+
+    return _entries.back().second;
+}
+
+std::size_t LfgCompatibleContainer::FindSlot(LfgCompatibilityKey const& key) const
+{
+    std::size_t mask = _slots.size() - 1;
+    std::size_t slot = key.GetHash() & mask;
+    while (_slots[slot] != EmptySlot && !(_entries[_slots[slot]].first == key))
+        slot = (slot + 1) & mask;
+
+    return slot;
+}
+
+void LfgCompatibleContainer::Rehash()
+{
+    std::size_t slotCount = 16;
+    while (slotCount < _entries.size() * 2)
+        slotCount *= 2;
+
+    _slots.assign(slotCount, EmptySlot);
+    for (uint32 i = 0; i < _entries.size(); ++i)
+        _slots[FindSlot(_entries[i].first)] = i;
+}
+
+void LfgRoleBuckets::Clear()
+{
+    // buckets are kept to reuse their storage, the same roles come back all the time
+    for (Bucket& bucket : _buckets)
+        bucket.entries.clear();
+
+    _selected.clear();
+    _size = 0;
+}
+
+void LfgRoleBuckets::Add(LfgPackedRoles roles)
+{
+    auto itr = _bucketsByRoles.emplace(roles.GetRawValue(), uint32(_buckets.size())).first;
+    if (itr->second == _buckets.size())
+        _buckets.push_back({ roles, {} });
+
+    _buckets[itr->second].entries.push_back(_size++);
+}
+
+void LfgRoleBuckets::Select(LfgPackedRoles groupRoles, uint32 index)
+{
+    _selected.clear();
+    for (Bucket const& bucket : _buckets)
+    {
+        if (bucket.entries.empty() || !(groupRoles + bucket.roles).CanFillRoles())
+            continue;
+
+        uint32 const* end = bucket.entries.data() + bucket.entries.size();
+        uint32 const* current = std::lower_bound(bucket.entries.data(), end, index);
+        if (current != end)
+            _selected.push_back({ current, end });
+    }
+}
+
+bool LfgRoleBuckets::Next(uint32& index)
+{
+    if (_selected.empty())
+        return false;
+
+    std::vector<Range>::iterator first = _selected.begin();
+    for (std::vector<Range>::iterator itr = first + 1; itr != _selected.end(); ++itr)
+        if (*itr->current < *first->current)
+            first = itr;
+
+    index = *first->current++;
+    if (first->current == first->end)
+    {
+        *first = _selected.back();
+        _selected.pop_back();
+    }
+
+    return true;
+}
+
 LfgQueueData::LfgQueueData() : joinTime(GameTime::GetGameTime()), tanks(LFG_TANKS_NEEDED),
 healers(LFG_HEALERS_NEEDED), dps(LFG_DPS_NEEDED)
 { }
@@ -143,17 +283,13 @@ void LFGQueue::RemoveFromQueue(ObjectGuid guid)
     RemoveFromCurrentQueue(guid);
     RemoveFromCompatibles(guid);
 
-    std::ostringstream o;
-    o << guid.GetRawValue();
-    std::string sguid = o.str();
-
     LfgQueueDataContainer::iterator itDelete = QueueDataStore.end();
     for (LfgQueueDataContainer::iterator itr = QueueDataStore.begin(); itr != QueueDataStore.end(); ++itr)
         if (itr->first != guid)
         {
-            if (std::string::npos != itr->second.bestCompatible.find(sguid))
+            if (itr->second.bestCompatible.Contains(guid))
             {
-                itr->second.bestCompatible.clear();
+                itr->second.bestCompatible = LfgCompatibilityKey();
                 FindBestCompatibleInQueue(itr);
             }
         }
@@ -161,7 +297,10 @@ void LFGQueue::RemoveFromQueue(ObjectGuid guid)
             itDelete = itr;
 
     if (itDelete != QueueDataStore.end())
+    {
         QueueDataStore.erase(itDelete);
+        matchCandidatesOutdated = true;
+    }
 }
 
 void LFGQueue::AddToNewQueue(ObjectGuid guid)
@@ -177,21 +316,26 @@ void LFGQueue::RemoveFromNewQueue(ObjectGuid guid)
 void LFGQueue::AddToCurrentQueue(ObjectGuid guid)
 {
     currentQueueStore.push_back(guid);
+    if (!matchCandidatesOutdated)
+        AddMatchCandidate(guid);
 }
 
 void LFGQueue::AddToFrontCurrentQueue(ObjectGuid guid)
 {
     currentQueueStore.push_front(guid);
+    matchCandidatesOutdated = true;
 }
 
 void LFGQueue::RemoveFromCurrentQueue(ObjectGuid guid)
 {
     currentQueueStore.remove(guid);
+    matchCandidatesOutdated = true;
 }
 
 void LFGQueue::AddQueueData(ObjectGuid guid, time_t joinTime, LfgDungeonSet const& dungeons, LfgRolesMap const& rolesMap)
 {
     QueueDataStore[guid] = LfgQueueData(joinTime, dungeons, rolesMap);
+    matchCandidatesOutdated = true;
     AddToQueue(guid);
 }
 
@@ -199,7 +343,28 @@ void LFGQueue::RemoveQueueData(ObjectGuid guid)
 {
     LfgQueueDataContainer::iterator it = QueueDataStore.find(guid);
     if (it != QueueDataStore.end())
+    {
         QueueDataStore.erase(it);
+        matchCandidatesOutdated = true;
+    }
+}
+
+void LFGQueue::AddMatchCandidate(ObjectGuid guid)
+{
+    LfgQueueDataContainer::const_iterator itQueue = QueueDataStore.find(guid);
+    LfgQueueData const* data = itQueue != QueueDataStore.end() ? &itQueue->second : nullptr;
+    matchCandidates.push_back({ guid, data });
+    roleBuckets.Add(data ? data->packedRoles : LfgPackedRoles());
+}
+
+void LFGQueue::RebuildMatchCandidates()
+{
+    matchCandidates.clear();
+    roleBuckets.Clear();
+    for (ObjectGuid guid : currentQueueStore)
+        AddMatchCandidate(guid);
+
+    matchCandidatesOutdated = false;
 }
 
 void LFGQueue::UpdateWaitTimeAvg(int32 waitTime, uint32 dungeonId)
@@ -237,32 +402,26 @@ void LFGQueue::UpdateWaitTimeDps(int32 waitTime, uint32 dungeonId)
 */
 void LFGQueue::RemoveFromCompatibles(ObjectGuid guid)
 {
-    std::stringstream out;
-    out << guid.GetRawValue();
-    std::string strGuid = out.str();
-
     TC_LOG_DEBUG("lfg.queue.data.compatibles.remove", "Removing {}", guid.ToString());
-    for (LfgCompatibleContainer::iterator itNext = CompatibleMapStore.begin(); itNext != CompatibleMapStore.end();)
+    CompatibleMapStore.EraseIf([guid](LfgCompatibleContainer::value_type const& entry)
     {
-        LfgCompatibleContainer::iterator it = itNext++;
-        if (std::string::npos != it->first.find(strGuid))
-            CompatibleMapStore.erase(it);
-    }
+        return entry.first.Contains(guid);
+    });
 }
 
 /**
    Stores the compatibility of a list of guids
 
-   @param[in]     key String concatenation of guids (| used as separator)
+   @param[in]     key Sorted guids of the combination
    @param[in]     compatibles type of compatibility
 */
-void LFGQueue::SetCompatibles(std::string const& key, LfgCompatibility compatibles)
+void LFGQueue::SetCompatibles(LfgCompatibilityKey const& key, LfgCompatibility compatibles)
 {
     LfgCompatibilityData& data = CompatibleMapStore[key];
     data.compatibility = compatibles;
 }
 
-void LFGQueue::SetCompatibilityData(std::string const& key, LfgCompatibilityData const& data)
+void LFGQueue::SetCompatibilityData(LfgCompatibilityKey const& key, LfgCompatibilityData const& data)
 {
     CompatibleMapStore[key] = data;
 }
@@ -270,43 +429,37 @@ void LFGQueue::SetCompatibilityData(std::string const& key, LfgCompatibilityData
 /**
    Get the compatibility of a group of guids
 
-   @param[in]     key String concatenation of guids (| used as separator)
+   @param[in]     key Sorted guids of the combination
    @return LfgCompatibility type of compatibility
 */
-LfgCompatibility LFGQueue::GetCompatibles(std::string const& key)
+LfgCompatibility LFGQueue::GetCompatibles(LfgCompatibilityKey const& key)
 {
-    LfgCompatibleContainer::iterator itr = CompatibleMapStore.find(key);
-    if (itr != CompatibleMapStore.end())
-        return itr->second.compatibility;
+    if (LfgCompatibilityData* data = CompatibleMapStore.Find(key))
+        return data->compatibility;
 
     return LFG_COMPATIBILITY_PENDING;
 }
 
-LfgCompatibilityData* LFGQueue::GetCompatibilityData(std::string const& key)
+LfgCompatibilityData* LFGQueue::GetCompatibilityData(LfgCompatibilityKey const& key)
 {
-    LfgCompatibleContainer::iterator itr = CompatibleMapStore.find(key);
-    if (itr != CompatibleMapStore.end())
-        return &(itr->second);
-
-    return nullptr;
+    return CompatibleMapStore.Find(key);
 }
 
 uint8 LFGQueue::FindGroups()
 {
     uint8 proposals = 0;
-    GuidList firstNew;
     while (!newToQueueStore.empty())
     {
         ObjectGuid frontguid = newToQueueStore.front();
         TC_LOG_DEBUG("lfg.queue.match.check.new", "Checking [{}] newToQueue({}), currentQueue({})", frontguid.ToString(),
             uint32(newToQueueStore.size()), uint32(currentQueueStore.size()));
 
-        firstNew.clear();
-        firstNew.push_back(frontguid);
         RemoveFromNewQueue(frontguid);
 
-        GuidList temporalList = currentQueueStore;
-        LfgCompatibility compatibles = FindNewGroups(firstNew, temporalList);
+        if (matchCandidatesOutdated)
+            RebuildMatchCandidates();
+
+        LfgCompatibility compatibles = FindNewGroups(frontguid);
 
         if (compatibles == LFG_COMPATIBLES_MATCH)
             ++proposals;
@@ -319,39 +472,82 @@ uint8 LFGQueue::FindGroups()
 /**
    Checks que main queue to try to form a Lfg group. Returns first match found (if any)
 
-   @param[in]     check List of guids trying to match with other groups
-   @param[in]     all List of all other guids in main queue to match against
+   Queued groups are tried in queue order and the first one compatible with the new group is
+   kept, the search goes on with the groups after it. Groups whose roles or dungeons can't fit
+   are skipped without checking them.
+
+   @param[in]     guid Guid of the group trying to match with other groups
    @return LfgCompatibility type of compatibility between groups
 */
-LfgCompatibility LFGQueue::FindNewGroups(GuidList& check, GuidList& all)
+LfgCompatibility LFGQueue::FindNewGroups(ObjectGuid guid)
+{
+    GuidList check;
+    check.push_back(guid);
+
+    LfgCompatibility compatibles = CheckCachedCompatibility(check);
+    if (compatibles != LFG_COMPATIBLES_WITH_LESS_PLAYERS)
+        return compatibles;
+
+    LfgQueueDataContainer::const_iterator itQueue = QueueDataStore.find(guid);
+    if (itQueue == QueueDataStore.end())
+        return compatibles;
+
+    LfgPackedRoles groupRoles = itQueue->second.packedRoles;
+    LfgDungeonMask groupDungeons = itQueue->second.dungeonMask;
+
+    // Try to match with queued groups
+    uint32 index;
+    roleBuckets.Select(groupRoles, 0);
+    while (roleBuckets.Next(index))
+    {
+        LfgMatchCandidate const& candidate = matchCandidates[index];
+        if (candidate.data && !groupDungeons.Intersects(candidate.data->dungeonMask))
+            continue;
+
+        check.push_back(candidate.guid);
+        LfgCompatibility subcompatibility = CheckCachedCompatibility(check);
+        if (subcompatibility == LFG_COMPATIBLES_MATCH)
+            return LFG_COMPATIBLES_MATCH;
+
+        if (subcompatibility != LFG_COMPATIBLES_WITH_LESS_PLAYERS)
+        {
+            check.pop_back();
+            continue;
+        }
+
+        if (candidate.data)
+        {
+            groupRoles += candidate.data->packedRoles;
+            groupDungeons &= candidate.data->dungeonMask;
+        }
+
+        roleBuckets.Select(groupRoles, index + 1);
+    }
+    return compatibles;
+}
+
+/**
+   Gets the cached compatibility of a list of guids, checking it if it is not cached yet
+
+   @param[in]     check List of guids to check compatibilities
+   @return LfgCompatibility type of compatibility
+*/
+LfgCompatibility LFGQueue::CheckCachedCompatibility(GuidList const& check)
 {
-    std::string strGuids = ConcatenateGuids(check);
-    LfgCompatibility compatibles = GetCompatibles(strGuids);
+    LfgCompatibilityKey key(check);
+    LfgCompatibility compatibles = GetCompatibles(key);
 
-    TC_LOG_DEBUG("lfg.queue.match.check", "Guids: ({}): {} - all({})", GetDetailedMatchRoles(check), GetCompatibleString(compatibles), GetDetailedMatchRoles(all));
+    TC_LOG_DEBUG("lfg.queue.match.check", "Guids: ({}): {}", GetDetailedMatchRoles(check), GetCompatibleString(compatibles));
     if (compatibles == LFG_COMPATIBILITY_PENDING) // Not previously cached, calculate
         compatibles = CheckCompatibility(check);
 
     if (compatibles == LFG_COMPATIBLES_BAD_STATES && sLFGMgr->AllQueued(check))
     {
         TC_LOG_DEBUG("lfg.queue.match.check", "Guids: ({}) compatibles (cached) changed from bad states to match", GetDetailedMatchRoles(check));
-        SetCompatibles(strGuids, LFG_COMPATIBLES_MATCH);
+        SetCompatibles(key, LFG_COMPATIBLES_MATCH);
         return LFG_COMPATIBLES_MATCH;
     }
 
-    if (compatibles != LFG_COMPATIBLES_WITH_LESS_PLAYERS)
-        return compatibles;
-
-    // Try to match with queued groups
-    while (!all.empty())
-    {
-        check.push_back(all.front());
-        all.pop_front();
-        LfgCompatibility subcompatibility = FindNewGroups(check, all);
-        if (subcompatibility == LFG_COMPATIBLES_MATCH)
-            return LFG_COMPATIBLES_MATCH;
-        check.pop_back();
-    }
     return compatibles;
 }
 
@@ -363,9 +559,7 @@ LfgCompatibility LFGQueue::FindNewGroups(GuidList& check, GuidList& all)
 */
 LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
 {
-    std::string strGuids = ConcatenateGuids(check);
     LfgProposal proposal;
-    LfgDungeonSet proposalDungeons;
     LfgGroupsMap proposalGroups;
     LfgRolesMap proposalRoles;
 
@@ -376,6 +570,8 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
         return LFG_INCOMPATIBLES_WRONG_GROUP_SIZE;
     }
 
+    LfgCompatibilityKey key(check);
+
     // Check all-but-new compatiblitity
     if (check.size() > 2)
     {
@@ -386,8 +582,8 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
         LfgCompatibility child_compatibles = CheckCompatibility(check);
         if (child_compatibles < LFG_COMPATIBLES_WITH_LESS_PLAYERS) // Group not compatible
         {
-            TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: ({}) child {} not compatibles", strGuids, GetDetailedMatchRoles(check));
-            SetCompatibles(strGuids, child_compatibles);
+            TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: ({}) child {} not compatibles", key.ToString(), GetDetailedMatchRoles(check));
+            SetCompatibles(key, child_compatibles);
             return child_compatibles;
         }
         check.push_front(frontGuid);
@@ -431,22 +627,22 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
         data.roles = itQueue->second.roles;
         LFGMgr::CheckGroupRoles(data.roles);
 
-        UpdateBestCompatibleInQueue(itQueue, strGuids, data.roles);
-        SetCompatibilityData(strGuids, data);
+        UpdateBestCompatibleInQueue(itQueue, key, data.roles);
+        SetCompatibilityData(key, data);
         return LFG_COMPATIBLES_WITH_LESS_PLAYERS;
     }
 
     if (numLfgGroups > 1)
     {
         TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: ({}) More than one Lfggroup ({})", GetDetailedMatchRoles(check), numLfgGroups);
-        SetCompatibles(strGuids, LFG_INCOMPATIBLES_MULTIPLE_LFG_GROUPS);
+        SetCompatibles(key, LFG_INCOMPATIBLES_MULTIPLE_LFG_GROUPS);
         return LFG_INCOMPATIBLES_MULTIPLE_LFG_GROUPS;
     }
 
     if (numPlayers > MAX_GROUP_SIZE)
     {
         TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: ({}) Too many players ({})", GetDetailedMatchRoles(check), numPlayers);
-        SetCompatibles(strGuids, LFG_INCOMPATIBLES_TOO_MUCH_PLAYERS);
+        SetCompatibles(key, LFG_INCOMPATIBLES_TOO_MUCH_PLAYERS);
         return LFG_INCOMPATIBLES_TOO_MUCH_PLAYERS;
     }
 
@@ -474,7 +670,7 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
         if (uint8 playersize = numPlayers - proposalRoles.size())
         {
             TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: ({}) not compatible, {} players are ignoring each other", GetDetailedMatchRoles(check), playersize);
-            SetCompatibles(strGuids, LFG_INCOMPATIBLES_HAS_IGNORES);
+            SetCompatibles(key, LFG_INCOMPATIBLES_HAS_IGNORES);
             return LFG_INCOMPATIBLES_HAS_IGNORES;
         }
 
@@ -486,27 +682,20 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
                 o << ", " << it->first.GetRawValue() << ": " << GetRolesString(it->second);
 
             TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: ({}) Roles not compatible{}", GetDetailedMatchRoles(check), o.str());
-            SetCompatibles(strGuids, LFG_INCOMPATIBLES_NO_ROLES);
+            SetCompatibles(key, LFG_INCOMPATIBLES_NO_ROLES);
             return LFG_INCOMPATIBLES_NO_ROLES;
         }
 
-        GuidList::iterator itguid = check.begin();
-        proposalDungeons = QueueDataStore[*itguid].dungeons;
-        std::ostringstream o;
-        o << ", " << itguid->GetRawValue() << ": (" << ConcatenateDungeons(proposalDungeons) << ")";
+        GuidList::const_iterator itguid = check.begin();
+        LfgDungeonMask proposalDungeons = QueueDataStore[*itguid].dungeonMask;
         for (++itguid; itguid != check.end(); ++itguid)
-        {
-            LfgDungeonSet temporal;
-            LfgDungeonSet& dungeons = QueueDataStore[*itguid].dungeons;
-            o << ", " << itguid->GetRawValue() << ": (" << ConcatenateDungeons(dungeons) << ")";
-            std::set_intersection(proposalDungeons.begin(), proposalDungeons.end(), dungeons.begin(), dungeons.end(), std::inserter(temporal, temporal.begin()));
-            proposalDungeons = temporal;
-        }
+            proposalDungeons &= QueueDataStore[*itguid].dungeonMask;
 
-        if (proposalDungeons.empty())
+        // only ids the masks can't hold need the sets to be intersected
+        if (!proposalDungeons.HasMapped() && (!proposalDungeons.HasUnmapped() || GetCommonDungeons(check).empty()))
         {
-            TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: ({}) No compatible dungeons{}", GetDetailedMatchRoles(check), o.str());
-            SetCompatibles(strGuids, LFG_INCOMPATIBLES_NO_DUNGEONS);
+            TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: ({}) No compatible dungeons{}", GetDetailedMatchRoles(check), GetDetailedMatchDungeons(check));
+            SetCompatibles(key, LFG_INCOMPATIBLES_NO_DUNGEONS);
             return LFG_INCOMPATIBLES_NO_DUNGEONS;
         }
     }
@@ -514,7 +703,6 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
     {
         ObjectGuid gguid = *check.begin();
         LfgQueueData const& queue = QueueDataStore[gguid];
-        proposalDungeons = queue.dungeons;
         proposalRoles = queue.roles;
         LFGMgr::CheckGroupRoles(proposalRoles);          // assing new roles
     }
@@ -527,9 +715,9 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
         data.roles = proposalRoles;
 
         for (GuidList::const_iterator itr = check.begin(); itr != check.end(); ++itr)
-            UpdateBestCompatibleInQueue(QueueDataStore.find(*itr), strGuids, data.roles);
+            UpdateBestCompatibleInQueue(QueueDataStore.find(*itr), key, data.roles);
 
-        SetCompatibilityData(strGuids, data);
+        SetCompatibilityData(key, data);
         return LFG_COMPATIBLES_WITH_LESS_PLAYERS;
     }
 
@@ -540,7 +728,7 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
     if (!sLFGMgr->AllQueued(check))
     {
         TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: ({}) Group MATCH but can't create proposal!", GetDetailedMatchRoles(check));
-        SetCompatibles(strGuids, LFG_COMPATIBLES_BAD_STATES);
+        SetCompatibles(key, LFG_COMPATIBLES_BAD_STATES);
         return LFG_COMPATIBLES_BAD_STATES;
     }
 
@@ -548,6 +736,7 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
     proposal.cancelTime = GameTime::GetGameTime() + LFG_TIME_PROPOSAL;
     proposal.state = LFG_PROPOSAL_INITIATING;
     proposal.leader.Clear();
+    LfgDungeonSet proposalDungeons = GetCommonDungeons(check);
     proposal.dungeonId = Trinity::Containers::SelectRandomContainerElement(proposalDungeons);
 
     bool leader = false;
@@ -582,10 +771,38 @@ LfgCompatibility LFGQueue::CheckCompatibility(GuidList check)
     sLFGMgr->AddProposal(proposal);
 
     TC_LOG_DEBUG("lfg.queue.match.compatibility.check", "Guids: ({}) MATCH! Group formed", GetDetailedMatchRoles(check));
-    SetCompatibles(strGuids, LFG_COMPATIBLES_MATCH);
+    SetCompatibles(key, LFG_COMPATIBLES_MATCH);
     return LFG_COMPATIBLES_MATCH;
 }
 
+LfgDungeonSet LFGQueue::GetCommonDungeons(GuidList const& check) const
+{
+    GuidList::const_iterator itguid = check.begin();
+    LfgDungeonSet commonDungeons = QueueDataStore.at(*itguid).dungeons;
+    for (++itguid; itguid != check.end(); ++itguid)
+    {
+        LfgDungeonSet temporal;
+        LfgDungeonSet const& dungeons = QueueDataStore.at(*itguid).dungeons;
+        std::set_intersection(commonDungeons.begin(), commonDungeons.end(), dungeons.begin(), dungeons.end(), std::inserter(temporal, temporal.begin()));
+        commonDungeons = std::move(temporal);
+    }
+
+    return commonDungeons;
+}
+
+std::string LFGQueue::GetDetailedMatchDungeons(GuidList const& check) const
+{
+    std::ostringstream o;
+    for (ObjectGuid guid : check)
+    {
+        LfgQueueDataContainer::const_iterator itQueue = QueueDataStore.find(guid);
+        if (itQueue != QueueDataStore.end())
+            o << ", " << guid.GetRawValue() << ": (" << ConcatenateDungeons(itQueue->second.dungeons) << ")";
+    }
+
+    return o.str();
+}
+
 void LFGQueue::UpdateQueueTimers(time_t currTime)
 {
     TC_LOG_TRACE("lfg.queue.timers.update", "Updating queue timers...");
@@ -674,7 +891,7 @@ std::string LFGQueue::DumpCompatibleInfo(bool full /* = false */) const
     if (full)
         for (LfgCompatibleContainer::const_iterator itr = CompatibleMapStore.begin(); itr != CompatibleMapStore.end(); ++itr)
         {
-            o << "(" << itr->first << "): " << GetCompatibleString(itr->second.compatibility);
+            o << "(" << itr->first.ToString() << "): " << GetCompatibleString(itr->second.compatibility);
             if (!itr->second.roles.empty())
             {
                 o << " (";
@@ -697,32 +914,24 @@ std::string LFGQueue::DumpCompatibleInfo(bool full /* = false */) const
 void LFGQueue::FindBestCompatibleInQueue(LfgQueueDataContainer::iterator itrQueue)
 {
     TC_LOG_DEBUG("lfg.queue.compatibles.find", "{}", itrQueue->first.ToString());
-    std::ostringstream o;
-    o << itrQueue->first.GetRawValue();
-    std::string sguid = o.str();
 
     for (LfgCompatibleContainer::const_iterator itr = CompatibleMapStore.begin(); itr != CompatibleMapStore.end(); ++itr)
         if (itr->second.compatibility == LFG_COMPATIBLES_WITH_LESS_PLAYERS &&
-            std::string::npos != itr->first.find(sguid))
+            itr->first.Contains(itrQueue->first))
         {
             UpdateBestCompatibleInQueue(itrQueue, itr->first, itr->second.roles);
         }
 }
 
-void LFGQueue::UpdateBestCompatibleInQueue(LfgQueueDataContainer::iterator itrQueue, std::string const& key, LfgRolesMap const& roles)
+void LFGQueue::UpdateBestCompatibleInQueue(LfgQueueDataContainer::iterator itrQueue, LfgCompatibilityKey const& key, LfgRolesMap const& roles)
 {
     LfgQueueData& queueData = itrQueue->second;
 
-    uint8 storedSize = queueData.bestCompatible.empty() ? 0 :
-        std::count(queueData.bestCompatible.begin(), queueData.bestCompatible.end(), '|') + 1;
-
-    uint8 size = std::count(key.begin(), key.end(), '|') + 1;
-
-    if (size <= storedSize)
+    if (key.size() <= queueData.bestCompatible.size())
         return;
 
     TC_LOG_DEBUG("lfg.queue.compatibles.update", "Changed ({}) to ({}) as best compatible group for {}",
-        queueData.bestCompatible, key, itrQueue->first.ToString());
+        queueData.bestCompatible.ToString(), key.ToString(), itrQueue->first.ToString());
 
     queueData.bestCompatible = key;
     queueData.tanks = LFG_TANKS_NEEDED;
@@ -19,6 +19,11 @@
 #define _LFGQUEUE_H
 
 #include "LFG.h"
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <unordered_map>
+#include <vector>
 
 namespace lfg
 {
@@ -48,6 +53,169 @@ struct LfgCompatibilityData
     LfgRolesMap roles;
 };
 
+/// Dungeons selected by a queue entry, one bit per dungeon id
+class TC_GAME_API LfgDungeonMask
+{
+    public:
+        static constexpr uint32 MaxDungeonId = 512;
+
+        LfgDungeonMask() : _hasUnmapped(false) { }
+        explicit LfgDungeonMask(LfgDungeonSet const& dungeons);
+
+        LfgDungeonMask& operator&=(LfgDungeonMask const& right)
+        {
+            _bits &= right._bits;
+            _hasUnmapped = _hasUnmapped && right._hasUnmapped;
+            return *this;
+        }
+
+        /// False when both selections can't have a dungeon in common, ids the masks can't hold are assumed to be shared
+        bool Intersects(LfgDungeonMask const& right) const { return (_bits & right._bits).any() || (_hasUnmapped && right._hasUnmapped); }
+        bool HasMapped() const { return _bits.any(); }
+        bool HasUnmapped() const { return _hasUnmapped; }
+
+    private:
+        std::bitset<MaxDungeonId> _bits;
+        bool _hasUnmapped;                                 ///< Selection has ids of MaxDungeonId or above
+};
+
+/**
+    Roles of a group packed in a single integer. Byte N counts the players whose roles are all in
+    role subset N (bit 0 tank, bit 1 healer, bit 2 damage), groups are merged by adding them. Roles
+    can be assigned when no subset has more players than the slots of its roles.
+*/
+class LfgPackedRoles
+{
+    public:
+        LfgPackedRoles() : _counts(0) { }
+        explicit LfgPackedRoles(LfgRolesMap const& roles) : _counts(0)
+        {
+            for (LfgRolesMap::const_iterator itr = roles.begin(); itr != roles.end(); ++itr)
+                AddPlayer(itr->second);
+        }
+
+        void AddPlayer(uint8 roles)
+        {
+            uint8 playerSubset = (roles & (PLAYER_ROLE_TANK | PLAYER_ROLE_HEALER | PLAYER_ROLE_DAMAGE)) >> 1;
+            for (uint8 subset = 0; subset < 8; ++subset)
+                if ((playerSubset & subset) == playerSubset)
+                    _counts += UI64LIT(1) << (subset * 8);
+        }
+
+        LfgPackedRoles& operator+=(LfgPackedRoles right) { _counts += right._counts; return *this; }
+        LfgPackedRoles operator+(LfgPackedRoles right) const { return right += *this; }
+        bool operator==(LfgPackedRoles right) const { return _counts == right._counts; }
+
+        /// Same as LFGMgr::CheckGroupRoles on a non empty group of up to 127 players, without assigning the roles
+        bool CanFillRoles() const { return (((SubsetSlots | LaneHighBits) - _counts) & LaneHighBits) == LaneHighBits; }
+        uint8 GetPlayerCount() const { return uint8(_counts >> 56); }
+        uint64 GetRawValue() const { return _counts; }
+
+    private:
+        // slots of every role in the subset, 0x0504040302010100 with 1 tank, 1 healer and 3 damage
+        static constexpr uint64 SubsetSlots = []
+        {
+            uint64 slots = 0;
+            for (uint8 subset = 0; subset < 8; ++subset)
+                slots |= uint64((subset & 1 ? uint32(LFG_TANKS_NEEDED) : 0) + (subset & 2 ? uint32(LFG_HEALERS_NEEDED) : 0) + (subset & 4 ? uint32(LFG_DPS_NEEDED) : 0)) << (subset * 8);
+            return slots;
+        }();
+        static constexpr uint64 LaneHighBits = UI64LIT(0x8080808080808080);
+
+        uint64 _counts;
+};
+
+/// Queue entries of a combination, sorted so the same entries always give the same key
+class TC_GAME_API LfgCompatibilityKey
+{
+    public:
+        static constexpr std::size_t MaxGuids = LFG_TANKS_NEEDED + LFG_HEALERS_NEEDED + LFG_DPS_NEEDED;
+
+        LfgCompatibilityKey() : _guids(), _size(0) { }
+        explicit LfgCompatibilityKey(GuidList const& check);
+
+        bool Contains(ObjectGuid guid) const;
+        std::size_t size() const { return _size; }
+        bool empty() const { return !_size; }
+        std::size_t GetHash() const;
+        std::string ToString() const;
+
+        bool operator==(LfgCompatibilityKey const& right) const { return _size == right._size && _guids == right._guids; }
+
+    private:
+        std::array<uint64, MaxGuids> _guids;               ///< Raw guids in ascending order, unused ones are 0
+        uint8 _size;
+};
+
+/// Cached compatibilities, entries are stored contiguously and found through an open addressing index
+class TC_GAME_API LfgCompatibleContainer
+{
+    public:
+        typedef std::pair<LfgCompatibilityKey, LfgCompatibilityData> value_type;
+        typedef std::vector<value_type>::const_iterator const_iterator;
+
+        LfgCompatibilityData* Find(LfgCompatibilityKey const& key);
+        LfgCompatibilityData& operator[](LfgCompatibilityKey const& key);
+
+        template<typename Predicate>
+        void EraseIf(Predicate const& predicate)
+        {
+            std::size_t size = _entries.size();
+            _entries.erase(std::remove_if(_entries.begin(), _entries.end(), predicate), _entries.end());
+            if (_entries.size() != size)
+                Rehash();
+        }
+
+        std::size_t size() const { return _entries.size(); }
+        const_iterator begin() const { return _entries.begin(); }
+        const_iterator end() const { return _entries.end(); }
+
+    private:
+        static constexpr uint32 EmptySlot = 0xFFFFFFFF;
+
+        std::size_t FindSlot(LfgCompatibilityKey const& key) const;
+        void Rehash();
+
+        std::vector<value_type> _entries;
+        std::vector<uint32> _slots;                        ///< Power of two sized, index in _entries or EmptySlot
+};
+
+/**
+    Queue entries bucketed by their roles. While a group is formed every bucket whose roles
+    don't fit in the group is skipped at once, the others are still visited in queue order.
+*/
+class TC_GAME_API LfgRoleBuckets
+{
+    public:
+        void Clear();
+        /// Adds the next queue entry, entries are numbered in the order they are added
+        void Add(LfgPackedRoles roles);
+        uint32 GetSize() const { return _size; }
+
+        /// Starts visiting the entries from index on whose roles can be filled together with groupRoles
+        void Select(LfgPackedRoles groupRoles, uint32 index);
+        /// Next selected entry in queue order, false once all were visited
+        bool Next(uint32& index);
+
+    private:
+        struct Bucket
+        {
+            LfgPackedRoles roles;
+            std::vector<uint32> entries;
+        };
+
+        struct Range
+        {
+            uint32 const* current;
+            uint32 const* end;
+        };
+
+        std::vector<Bucket> _buckets;
+        std::unordered_map<uint64, uint32> _bucketsByRoles;
+        std::vector<Range> _selected;
+        uint32 _size = 0;
+};
+
 /// Stores player or group queue info
 struct LfgQueueData
 {
@@ -55,7 +223,7 @@ struct LfgQueueData
 
     LfgQueueData(time_t _joinTime, LfgDungeonSet const& _dungeons, LfgRolesMap const& _roles):
         joinTime(_joinTime), tanks(LFG_TANKS_NEEDED), healers(LFG_HEALERS_NEEDED),
-        dps(LFG_DPS_NEEDED), dungeons(_dungeons), roles(_roles)
+        dps(LFG_DPS_NEEDED), dungeons(_dungeons), roles(_roles), dungeonMask(_dungeons), packedRoles(_roles)
         { }
 
     time_t joinTime;                                       ///< Player queue join time (to calculate wait times)
@@ -64,7 +232,9 @@ struct LfgQueueData
     uint8 dps;                                             ///< Dps needed
     LfgDungeonSet dungeons;                                ///< Selected Player/Group Dungeon/s
     LfgRolesMap roles;                                     ///< Selected Player Role/s
-    std::string bestCompatible;                            ///< Best compatible combination of people queued
+    LfgDungeonMask dungeonMask;                            ///< Selected Player/Group Dungeon/s as bits
+    LfgPackedRoles packedRoles;                            ///< Selected Player Role/s counted by role subset
+    LfgCompatibilityKey bestCompatible;                    ///< Best compatible combination of people queued
 };
 
 struct LfgWaitTime
@@ -75,7 +245,6 @@ struct LfgWaitTime
 };
 
 typedef std::map<uint32, LfgWaitTime> LfgWaitTimesContainer;
-typedef std::map<std::string, LfgCompatibilityData> LfgCompatibleContainer;
 typedef std::map<ObjectGuid, LfgQueueData> LfgQueueDataContainer;
 
 /**
@@ -110,7 +279,12 @@ class TC_GAME_API LFGQueue
         std::string DumpCompatibleInfo(bool full = false) const;
 
     private:
-        void SetQueueUpdateData(std::string const& strGuids, LfgRolesMap const& proposalRoles);
+        /// Queue entry matched against new ones, data is null if the entry lost its queue data
+        struct LfgMatchCandidate
+        {
+            ObjectGuid guid;
+            LfgQueueData const* data;
+        };
 
         void AddToNewQueue(ObjectGuid guid);
         void AddToCurrentQueue(ObjectGuid guid);
@@ -118,17 +292,23 @@ class TC_GAME_API LFGQueue
         void RemoveFromNewQueue(ObjectGuid guid);
         void RemoveFromCurrentQueue(ObjectGuid guid);
 
-        void SetCompatibles(std::string const& key, LfgCompatibility compatibles);
-        LfgCompatibility GetCompatibles(std::string const& key);
+        void SetCompatibles(LfgCompatibilityKey const& key, LfgCompatibility compatibles);
+        LfgCompatibility GetCompatibles(LfgCompatibilityKey const& key);
         void RemoveFromCompatibles(ObjectGuid guid);
 
-        void SetCompatibilityData(std::string const& key, LfgCompatibilityData const& compatibles);
-        LfgCompatibilityData* GetCompatibilityData(std::string const& key);
+        void SetCompatibilityData(LfgCompatibilityKey const& key, LfgCompatibilityData const& compatibles);
+        LfgCompatibilityData* GetCompatibilityData(LfgCompatibilityKey const& key);
         void FindBestCompatibleInQueue(LfgQueueDataContainer::iterator itrQueue);
-        void UpdateBestCompatibleInQueue(LfgQueueDataContainer::iterator itrQueue, std::string const& key, LfgRolesMap const& roles);
+        void UpdateBestCompatibleInQueue(LfgQueueDataContainer::iterator itrQueue, LfgCompatibilityKey const& key, LfgRolesMap const& roles);
+
+        void AddMatchCandidate(ObjectGuid guid);
+        void RebuildMatchCandidates();
 
-        LfgCompatibility FindNewGroups(GuidList& check, GuidList& all);
+        LfgCompatibility FindNewGroups(ObjectGuid guid);
+        LfgCompatibility CheckCachedCompatibility(GuidList const& check);
         LfgCompatibility CheckCompatibility(GuidList check);
+        std::string GetDetailedMatchDungeons(GuidList const& check) const;
+        LfgDungeonSet GetCommonDungeons(GuidList const& check) const;
 
         // Queue
         LfgQueueDataContainer QueueDataStore;              ///< Queued groups
@@ -140,6 +320,10 @@ class TC_GAME_API LFGQueue
         LfgWaitTimesContainer waitTimesDpsStore;           ///< Average wait time to find a group queuing as dps
         GuidList currentQueueStore;                        ///< Ordered list. Used to find groups
         GuidList newToQueueStore;                          ///< New groups to add to queue
+
+        std::vector<LfgMatchCandidate> matchCandidates;    ///< currentQueueStore in order, numbered as in roleBuckets
+        LfgRoleBuckets roleBuckets;                        ///< matchCandidates bucketed by roles
+        bool matchCandidatesOutdated = true;               ///< currentQueueStore or queue data changed since matchCandidates were built
 };
 
 } // namespace lfg
@@ -1054,6 +1054,7 @@ void Player::Update(uint32 p_time)
     }
 
     m_achievementMgr->UpdateTimedAchievements(p_time);
+    m_achievementMgr->SendPendingCriteriaUpdates();
 
     if (HasUnitState(UNIT_STATE_MELEE_ATTACKING) && !HasUnitState(UNIT_STATE_CASTING | UNIT_STATE_CHARGING))
     {
@@ -61,6 +61,7 @@
 #include "PetPackets.h"
 #include "Player.h"
 #include "PlayerAI.h"
+#include "Profiler.h"
 #include "QuestDef.h"
 #include "ReputationMgr.h"
 #include "ScheduledChangeAI.h"
@@ -433,6 +434,8 @@ Unit::~Unit()
 
 void Unit::Update(uint32 p_time)
 {
+    TC_PROFILE_ZONE("Unit::Update");
+
     // WARNING! Order of execution here is important, do not change.
     // Spells must be processed with event system BEFORE they go to _UpdateSpells.
     // Or else we may have some SPELL_STATE_FINISHED spells stalled in pointers, that is bad.
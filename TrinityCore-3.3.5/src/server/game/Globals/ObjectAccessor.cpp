@@ -16,6 +16,7 @@
  */
 
 #include "ObjectAccessor.h"
+#include "ConcurrentPointerMap.h"
 #include "Corpse.h"
 #include "Creature.h"
 #include "DynamicObject.h"
@@ -30,6 +31,17 @@
 #include "Transport.h"
 #include "World.h"
 
+namespace
+{
+// Find() is called from every map and session thread, it reads this index without taking the container lock
+template<class T>
+Trinity::Containers::ConcurrentPointerMap<T>& GetLookupIndex()
+{
+    static Trinity::Containers::ConcurrentPointerMap<T> _index;
+    return _index;
+}
+}
+
 template<class T>
 void HashMapHolder<T>::Insert(T* o)
 {
@@ -40,6 +52,7 @@ void HashMapHolder<T>::Insert(T* o)
     std::unique_lock<std::shared_mutex> lock(*GetLock());
 
     GetContainer()[o->GetGUID()] = o;
+    GetLookupIndex<T>().Insert(o->GetGUID().GetRawValue(), o);
 }
 
 template<class T>
@@ -48,15 +61,13 @@ void HashMapHolder<T>::Remove(T* o)
     std::unique_lock<std::shared_mutex> lock(*GetLock());
 
     GetContainer().erase(o->GetGUID());
+    GetLookupIndex<T>().Remove(o->GetGUID().GetRawValue());
 }
 
 template<class T>
 T* HashMapHolder<T>::Find(ObjectGuid guid)
 {
-    std::shared_lock<std::shared_mutex> lock(*GetLock());
-
-    typename MapType::iterator itr = GetContainer().find(guid);
-    return (itr != GetContainer().end()) ? itr->second : nullptr;
+    return GetLookupIndex<T>().Find(guid.GetRawValue());
 }
 
 template<class T>
@@ -48,6 +48,7 @@
 #include "ScriptMgr.h"
 #include "SpellAuras.h"
 #include "SpellMgr.h"
+#include "StartupSnapshot.h"
 #include "SpellScript.h"
 #include "StringConvert.h"
 #include "TemporarySummon.h"
@@ -521,6 +522,8 @@ void ObjectMgr::LoadCreatureTemplates()
     for (auto const& ctPair : _creatureTemplateStore)
         CheckCreatureTemplate(&ctPair.second);
 
+    _creatureTemplateIndex.Build(_creatureTemplateStore, [](CreatureTemplate const& creatureTemplate) { return &creatureTemplate; });
+
     TC_LOG_INFO("server.loading", ">> Loaded {} creature definitions in {} ms", _creatureTemplateStore.size(), GetMSTimeDiffToNow(oldMSTime));
 }
 
@@ -528,6 +531,7 @@ void ObjectMgr::LoadCreatureTemplate(Field* fields)
 {
     uint32 entry = fields[0].GetUInt32();
     CreatureTemplate& creatureTemplate = _creatureTemplateStore[entry];
+    _creatureTemplateIndex.Insert(entry, &creatureTemplate);
 
     creatureTemplate.Entry = entry;
 
@@ -2163,6 +2167,22 @@ void ObjectMgr::LoadCreatures()
 {
     uint32 oldMSTime = getMSTime();
 
+    // zone/area calculation writes back every spawn, it needs the full load
+    bool useSnapshot = StartupSnapshot::IsEnabled() && !sWorld->getBoolConfig(CONFIG_CALCULATE_CREATURE_ZONE_AREA_DATA);
+    StartupSnapshot snapshot("creature", { "creature", "game_event_creature", "pool_members", "creature_template", "creature_equip_template" });
+    if (useSnapshot && snapshot.Open())
+    {
+        if (Optional<uint32> count = LoadCreaturesFromSnapshot(snapshot))
+        {
+            TC_LOG_INFO("server.loading", ">> Loaded {} creatures from startup snapshot in {} ms", *count, GetMSTimeDiffToNow(oldMSTime));
+            return;
+        }
+
+        for (auto const& [guid, data] : _creatureDataStore)
+            RemoveCreatureFromGrid(guid, &data);
+        _creatureDataStore.clear();
+    }
+
     //                                               0              1   2    3           4           5           6            7        8             9              10
     QueryResult result = WorldDatabase.Query("SELECT creature.guid, id, map, position_x, position_y, position_z, orientation, modelid, equipment_id, spawntimesecs, wander_distance, "
     //   11               12         13       14            15         16          17          18                19                   20                    21
@@ -2188,6 +2208,7 @@ void ObjectMgr::LoadCreatures()
                     spawnMasks[i] |= (1 << k);
 
     _creatureDataStore.rehash(result->GetRowCount());
+    std::unordered_set<ObjectGuid::LowType> gridSpawns;
 
     do
     {
@@ -2335,13 +2356,106 @@ void ObjectMgr::LoadCreatures()
 
         // Add to grid if not managed by the game event or pool system
         if (gameEvent == 0 && PoolId == 0)
+        {
             AddCreatureToGrid(guid, &data);
+            if (useSnapshot)
+                gridSpawns.insert(guid);
+        }
     }
     while (result->NextRow());
 
+    if (useSnapshot)
+    {
+        WriteCreaturesSnapshot(snapshot, gridSpawns);
+        snapshot.Save();
+    }
+
     TC_LOG_INFO("server.loading", ">> Loaded {} creatures in {} ms", _creatureDataStore.size(), GetMSTimeDiffToNow(oldMSTime));
 }
 
+Optional<uint32> ObjectMgr::LoadCreaturesFromSnapshot(StartupSnapshot& snapshot)
+{
+    try
+    {
+        uint32 count = snapshot.Read<uint32>();
+        _creatureDataStore.rehash(count);
+        for (uint32 i = 0; i < count; ++i)
+        {
+            ObjectGuid::LowType guid = snapshot.Read<uint32>();
+            CreatureData& data = _creatureDataStore[guid];
+            data.spawnId        = guid;
+            data.id             = snapshot.Read<uint32>();
+            data.mapId          = snapshot.Read<uint16>();
+            float x             = snapshot.Read<float>();
+            float y             = snapshot.Read<float>();
+            float z             = snapshot.Read<float>();
+            float o             = snapshot.Read<float>();
+            data.spawnPoint.Relocate(x, y, z, o);
+            data.displayid      = snapshot.Read<uint32>();
+            data.equipmentId    = snapshot.Read<int8>();
+            data.spawntimesecs  = snapshot.Read<uint32>();
+            data.wander_distance = snapshot.Read<float>();
+            data.currentwaypoint = snapshot.Read<uint32>();
+            data.curhealth      = snapshot.Read<uint32>();
+            data.curmana        = snapshot.Read<uint32>();
+            data.movementType   = snapshot.Read<uint8>();
+            data.spawnMask      = snapshot.Read<uint8>();
+            data.phaseMask      = snapshot.Read<uint32>();
+            data.npcflag        = snapshot.Read<uint32>();
+            data.unit_flags     = snapshot.Read<uint32>();
+            data.dynamicflags   = snapshot.Read<uint32>();
+            data.scriptId       = GetScriptId(snapshot.ReadString());
+            data.StringId       = snapshot.ReadString();
+            data.spawnGroupData = snapshot.Read<uint8>() ? GetLegacySpawnGroup() : GetDefaultSpawnGroup();
+
+            if (snapshot.Read<uint8>())
+                AddCreatureToGrid(guid, &data);
+        }
+    }
+    catch (ByteBufferException const& e)
+    {
+        TC_LOG_ERROR("server.loading", "Startup snapshot {} could not be read ({}), loading from the database", snapshot.GetName(), e.what());
+        return {};
+    }
+
+    if (!snapshot.IsFullyRead())
+        return {};
+
+    return _creatureDataStore.size();
+}
+
+void ObjectMgr::WriteCreaturesSnapshot(StartupSnapshot& snapshot, std::unordered_set<ObjectGuid::LowType> const& gridSpawns) const
+{
+    snapshot.Write<uint32>(_creatureDataStore.size());
+    for (auto const& [guid, data] : _creatureDataStore)
+    {
+        snapshot.Write<uint32>(guid);
+        snapshot.Write<uint32>(data.id);
+        snapshot.Write<uint16>(data.mapId);
+        snapshot.Write<float>(data.spawnPoint.GetPositionX());
+        snapshot.Write<float>(data.spawnPoint.GetPositionY());
+        snapshot.Write<float>(data.spawnPoint.GetPositionZ());
+        snapshot.Write<float>(data.spawnPoint.GetOrientation());
+        snapshot.Write<uint32>(data.displayid);
+        snapshot.Write<int8>(data.equipmentId);
+        snapshot.Write<uint32>(data.spawntimesecs);
+        snapshot.Write<float>(data.wander_distance);
+        snapshot.Write<uint32>(data.currentwaypoint);
+        snapshot.Write<uint32>(data.curhealth);
+        snapshot.Write<uint32>(data.curmana);
+        snapshot.Write<uint8>(data.movementType);
+        snapshot.Write<uint8>(data.spawnMask);
+        snapshot.Write<uint32>(data.phaseMask);
+        snapshot.Write<uint32>(data.npcflag);
+        snapshot.Write<uint32>(data.unit_flags);
+        snapshot.Write<uint32>(data.dynamicflags);
+        snapshot.WriteString(GetScriptName(data.scriptId));
+        snapshot.WriteString(data.StringId);
+        snapshot.Write<uint8>(data.spawnGroupData == GetLegacySpawnGroup() ? 1 : 0);
+        snapshot.Write<uint8>(gridSpawns.count(guid) ? 1 : 0);
+    }
+}
+
 CellObjectGuids const* ObjectMgr::GetCellObjectGuids(uint16 mapid, uint8 spawnMode, uint32 cell_id)
 {
     if (CellObjectGuidsMap const* mapGuids = Trinity::Containers::MapGetValuePtr(_mapObjectGuidsStore, MAKE_PAIR32(mapid, spawnMode)))
@@ -2485,6 +2599,22 @@ void ObjectMgr::LoadGameObjects()
 {
     uint32 oldMSTime = getMSTime();
 
+    // zone/area calculation writes back every spawn, it needs the full load
+    bool useSnapshot = StartupSnapshot::IsEnabled() && !sWorld->getBoolConfig(CONFIG_CALCULATE_GAMEOBJECT_ZONE_AREA_DATA);
+    StartupSnapshot snapshot("gameobject", { "gameobject", "game_event_gameobject", "pool_members", "gameobject_template" });
+    if (useSnapshot && snapshot.Open())
+    {
+        if (Optional<uint32> count = LoadGameObjectsFromSnapshot(snapshot))
+        {
+            TC_LOG_INFO("server.loading", ">> Loaded {} gameobjects from startup snapshot in {} ms", *count, GetMSTimeDiffToNow(oldMSTime));
+            return;
+        }
+
+        for (auto const& [guid, data] : _gameObjectDataStore)
+            RemoveGameobjectFromGrid(guid, &data);
+        _gameObjectDataStore.clear();
+    }
+
     //                                                0                1   2    3           4           5           6
     QueryResult result = WorldDatabase.Query("SELECT gameobject.guid, id, map, position_x, position_y, position_z, orientation, "
     //   7          8          9          10         11             12            13     14         15         16          17
@@ -2509,6 +2639,7 @@ void ObjectMgr::LoadGameObjects()
                     spawnMasks[i] |= (1 << k);
 
     _gameObjectDataStore.rehash(result->GetRowCount());
+    std::unordered_set<ObjectGuid::LowType> gridSpawns;
 
     do
     {
@@ -2654,13 +2785,100 @@ void ObjectMgr::LoadGameObjects()
         }
 
         if (gameEvent == 0 && PoolId == 0)                      // if not this is to be managed by GameEvent System or Pool system
+        {
             AddGameobjectToGrid(guid, &data);
+            if (useSnapshot)
+                gridSpawns.insert(guid);
+        }
     }
     while (result->NextRow());
 
+    if (useSnapshot)
+    {
+        WriteGameObjectsSnapshot(snapshot, gridSpawns);
+        snapshot.Save();
+    }
+
     TC_LOG_INFO("server.loading", ">> Loaded {} gameobjects in {} ms", _gameObjectDataStore.size(), GetMSTimeDiffToNow(oldMSTime));
 }
 
+Optional<uint32> ObjectMgr::LoadGameObjectsFromSnapshot(StartupSnapshot& snapshot)
+{
+    try
+    {
+        uint32 count = snapshot.Read<uint32>();
+        _gameObjectDataStore.rehash(count);
+        for (uint32 i = 0; i < count; ++i)
+        {
+            ObjectGuid::LowType guid = snapshot.Read<uint32>();
+            GameObjectData& data = _gameObjectDataStore[guid];
+            data.spawnId        = guid;
+            data.id             = snapshot.Read<uint32>();
+            data.mapId          = snapshot.Read<uint16>();
+            float x             = snapshot.Read<float>();
+            float y             = snapshot.Read<float>();
+            float z             = snapshot.Read<float>();
+            float o             = snapshot.Read<float>();
+            data.spawnPoint.Relocate(x, y, z, o);
+            data.rotation.x     = snapshot.Read<float>();
+            data.rotation.y     = snapshot.Read<float>();
+            data.rotation.z     = snapshot.Read<float>();
+            data.rotation.w     = snapshot.Read<float>();
+            data.spawntimesecs  = snapshot.Read<int32>();
+            data.animprogress   = snapshot.Read<uint32>();
+            data.goState        = GOState(snapshot.Read<uint8>());
+            data.artKit         = snapshot.Read<uint8>();
+            data.spawnMask      = snapshot.Read<uint8>();
+            data.phaseMask      = snapshot.Read<uint32>();
+            data.scriptId       = GetScriptId(snapshot.ReadString());
+            data.StringId       = snapshot.ReadString();
+            data.spawnGroupData = snapshot.Read<uint8>() ? GetLegacySpawnGroup() : GetDefaultSpawnGroup();
+
+            if (snapshot.Read<uint8>())
+                AddGameobjectToGrid(guid, &data);
+        }
+    }
+    catch (ByteBufferException const& e)
+    {
+        TC_LOG_ERROR("server.loading", "Startup snapshot {} could not be read ({}), loading from the database", snapshot.GetName(), e.what());
+        return {};
+    }
+
+    if (!snapshot.IsFullyRead())
+        return {};
+
+    return _gameObjectDataStore.size();
+}
+
+void ObjectMgr::WriteGameObjectsSnapshot(StartupSnapshot& snapshot, std::unordered_set<ObjectGuid::LowType> const& gridSpawns) const
+{
+    snapshot.Write<uint32>(_gameObjectDataStore.size());
+    for (auto const& [guid, data] : _gameObjectDataStore)
+    {
+        snapshot.Write<uint32>(guid);
+        snapshot.Write<uint32>(data.id);
+        snapshot.Write<uint16>(data.mapId);
+        snapshot.Write<float>(data.spawnPoint.GetPositionX());
+        snapshot.Write<float>(data.spawnPoint.GetPositionY());
+        snapshot.Write<float>(data.spawnPoint.GetPositionZ());
+        snapshot.Write<float>(data.spawnPoint.GetOrientation());
+        snapshot.Write<float>(data.rotation.x);
+        snapshot.Write<float>(data.rotation.y);
+        snapshot.Write<float>(data.rotation.z);
+        snapshot.Write<float>(data.rotation.w);
+        snapshot.Write<int32>(data.spawntimesecs);
+        snapshot.Write<uint32>(data.animprogress);
+        snapshot.Write<uint8>(data.goState);
+        snapshot.Write<uint8>(data.artKit);
+        snapshot.Write<uint8>(data.spawnMask);
+        snapshot.Write<uint32>(data.phaseMask);
+        snapshot.WriteString(GetScriptName(data.scriptId));
+        snapshot.WriteString(data.StringId);
+        snapshot.Write<uint8>(data.spawnGroupData == GetLegacySpawnGroup() ? 1 : 0);
+        snapshot.Write<uint8>(gridSpawns.count(guid) ? 1 : 0);
+    }
+}
+
 void ObjectMgr::LoadSpawnGroupTemplates()
 {
     uint32 oldMSTime = getMSTime();
@@ -3525,11 +3743,16 @@ void ObjectMgr::LoadItemTemplates()
     for (std::set<uint32>::const_iterator itr = notFoundOutfit.begin(); itr != notFoundOutfit.end(); ++itr)
         TC_LOG_ERROR("sql.sql", "Item (Entry: {}) does not exist in `item_template` but is referenced in `CharStartOutfit.dbc`", *itr);
 
+    _itemTemplateIndex.Build(_itemTemplateStore, [](ItemTemplate const& itemTemplate) { return &itemTemplate; });
+
     TC_LOG_INFO("server.loading", ">> Loaded {} item templates in {} ms", _itemTemplateStore.size(), GetMSTimeDiffToNow(oldMSTime));
 }
 
 ItemTemplate const* ObjectMgr::GetItemTemplate(uint32 entry) const
 {
+    if (_itemTemplateIndex.IsEnabled())
+        return _itemTemplateIndex.Find(entry);
+
     return Trinity::Containers::MapGetValuePtr(_itemTemplateStore, entry);
 }
 
@@ -4717,6 +4940,7 @@ void ObjectMgr::LoadQuests()
     uint32 oldMSTime = getMSTime();
 
     _questTemplates.clear();
+    _questTemplateIndex.Clear();
 
     _exclusiveQuestGroups.clear();
 
@@ -5451,6 +5675,8 @@ void ObjectMgr::LoadQuests()
         }
     }
 
+    _questTemplateIndex.Build(_questTemplates, [](Trinity::unique_trackable_ptr<Quest> const& quest) -> Quest const* { return quest.get(); });
+
     TC_LOG_INFO("server.loading", ">> Loaded {} quests definitions in {} ms", _questTemplates.size(), GetMSTimeDiffToNow(oldMSTime));
 }
 
@@ -6940,6 +7166,9 @@ uint32 ObjectMgr::GetTaxiMountDisplayId(uint32 id, uint32 team, bool allowed_alt
 
 Quest const* ObjectMgr::GetQuestTemplate(uint32 quest_id) const
 {
+    if (_questTemplateIndex.IsEnabled())
+        return _questTemplateIndex.Find(quest_id);
+
     auto itr = _questTemplates.find(quest_id);
     return itr != _questTemplates.end() ? itr->second.get() : nullptr;
 }
@@ -7840,6 +8069,8 @@ void ObjectMgr::LoadGameObjectTemplate()
         }
     } while (result->NextRow());
 
+    _gameObjectTemplateIndex.Build(_gameObjectTemplateStore, [](GameObjectTemplate const& goTemplate) { return &goTemplate; });
+
     TC_LOG_INFO("server.loading", ">> Loaded {} game object templates in {} ms", _gameObjectTemplateStore.size(), GetMSTimeDiffToNow(oldMSTime));
 }
 
@@ -10294,6 +10525,9 @@ void ObjectMgr::LoadFactionChangeTitles()
 
 GameObjectTemplate const* ObjectMgr::GetGameObjectTemplate(uint32 entry) const
 {
+    if (_gameObjectTemplateIndex.IsEnabled())
+        return _gameObjectTemplateIndex.Find(entry);
+
     return Trinity::Containers::MapGetValuePtr(_gameObjectTemplateStore, entry);
 }
 
@@ -10313,6 +10547,9 @@ GameObjectOverride const* ObjectMgr::GetGameObjectOverride(ObjectGuid::LowType s
 
 CreatureTemplate const* ObjectMgr::GetCreatureTemplate(uint32 entry) const
 {
+    if (_creatureTemplateIndex.IsEnabled())
+        return _creatureTemplateIndex.Find(entry);
+
     return Trinity::Containers::MapGetValuePtr(_creatureTemplateStore, entry);
 }
 
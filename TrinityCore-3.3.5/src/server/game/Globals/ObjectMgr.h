@@ -22,6 +22,7 @@
 #include "ConditionMgr.h"
 #include "CreatureData.h"
 #include "DatabaseEnvFwd.h"
+#include "DenseIndex.h"
 #include "Errors.h"
 #include "GameObjectData.h"
 #include "ItemTemplate.h"
@@ -29,6 +30,7 @@
 #include "NPCHandler.h"
 #include "ObjectDefines.h"
 #include "ObjectGuid.h"
+#include "Optional.h"
 #include "Position.h"
 #include "QuestDef.h"
 #include "SharedDefines.h"
@@ -38,8 +40,10 @@
 #include <iterator>
 #include <map>
 #include <unordered_map>
+#include <unordered_set>
 
 class Item;
+class StartupSnapshot;
 class Unit;
 class Vehicle;
 class Map;
@@ -1575,8 +1579,15 @@ class TC_GAME_API ObjectMgr
         // first free low guid for selected guid type
         ObjectGuidGenerator& GetGuidSequenceGenerator(HighGuid high);
 
+        // spawn snapshots also keep which spawns were added to the grid (not managed by game events or pools)
+        Optional<uint32> LoadCreaturesFromSnapshot(StartupSnapshot& snapshot);
+        void WriteCreaturesSnapshot(StartupSnapshot& snapshot, std::unordered_set<ObjectGuid::LowType> const& gridSpawns) const;
+        Optional<uint32> LoadGameObjectsFromSnapshot(StartupSnapshot& snapshot);
+        void WriteGameObjectsSnapshot(StartupSnapshot& snapshot, std::unordered_set<ObjectGuid::LowType> const& gridSpawns) const;
+
         std::map<HighGuid, std::unique_ptr<ObjectGuidGenerator>> _guidGenerators;
         QuestContainer _questTemplates;
+        Trinity::Containers::DenseIndex<Quest const> _questTemplateIndex;
 
         typedef std::unordered_map<uint32, GossipText> GossipTextContainer;
         typedef std::map<uint32, uint32> QuestAreaTriggerContainer;
@@ -1669,6 +1680,7 @@ class TC_GAME_API ObjectMgr
         MapObjectGuids _mapObjectGuidsStore;
         CreatureDataContainer _creatureDataStore;
         CreatureTemplateContainer _creatureTemplateStore;
+        Trinity::Containers::DenseIndex<CreatureTemplate const> _creatureTemplateIndex;
         CreatureModelContainer _creatureModelStore;
         CreatureAddonContainer _creatureAddonStore;
         CreatureTemplateAddonContainer _creatureTemplateAddonStore;
@@ -1682,6 +1694,7 @@ class TC_GAME_API ObjectMgr
         GameObjectDataContainer _gameObjectDataStore;
         GameObjectLocaleContainer _gameObjectLocaleStore;
         GameObjectTemplateContainer _gameObjectTemplateStore;
+        Trinity::Containers::DenseIndex<GameObjectTemplate const> _gameObjectTemplateIndex;
         GameObjectTemplateAddonContainer _gameObjectTemplateAddonStore;
         GameObjectOverrideContainer _gameObjectOverrideStore;
         SpawnGroupDataContainer _spawnGroupDataStore;
@@ -1692,6 +1705,7 @@ class TC_GAME_API ObjectMgr
 
         BroadcastTextContainer _broadcastTextStore;
         ItemTemplateContainer _itemTemplateStore;
+        Trinity::Containers::DenseIndex<ItemTemplate const> _itemTemplateIndex;
         ItemLocaleContainer _itemLocaleStore;
         ItemSetNameLocaleContainer _itemSetNameLocaleStore;
         QuestLocaleContainer _questLocaleStore;
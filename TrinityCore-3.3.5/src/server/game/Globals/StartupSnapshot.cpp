@@ -0,0 +1,261 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StartupSnapshot.h"
+#include "CryptoHash.h"
+#include "DatabaseEnv.h"
+#include "GitRevision.h"
+#include "Log.h"
+#include "World.h"
+#include <boost/filesystem/operations.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <fstream>
+
+namespace
+{
+constexpr std::array<char, 4> SnapshotMagic = { 'T', 'C', 'S', 'S' };
+// bump when the header layout changes, payload layout changes are covered by the core revision in the key
+constexpr uint32 SnapshotFormatVersion = 1;
+
+#pragma pack(push, 1)
+struct SnapshotHeader
+{
+    std::array<char, 4> Magic;
+    uint32 FormatVersion;
+    StartupSnapshot::Digest Key;
+    uint64 PayloadSize;
+    StartupSnapshot::Digest PayloadChecksum;
+};
+#pragma pack(pop)
+
+static_assert(StartupSnapshot::Digest().size() == Trinity::Crypto::SHA256::DIGEST_LENGTH);
+}
+
+StartupSnapshot::StartupSnapshot(std::string name, std::vector<std::string> tables, std::vector<std::string> dbcFiles) : _name(std::move(name)),
+    _tables(std::move(tables)), _dbcFiles(std::move(dbcFiles)), _payload(nullptr), _payloadSize(0), _readPos(0)
+{
+}
+
+StartupSnapshot::StartupSnapshot(std::string name, std::string fileName, Digest const& key) : _name(std::move(name)), _fileName(std::move(fileName)), _key(key),
+    _payload(nullptr), _payloadSize(0), _readPos(0)
+{
+}
+
+StartupSnapshot::~StartupSnapshot() = default;
+
+bool StartupSnapshot::IsEnabled()
+{
+    return sWorld->getBoolConfig(CONFIG_STARTUP_SNAPSHOTS);
+}
+
+bool StartupSnapshot::IsActive() const
+{
+    // snapshots with an explicit path are not tied to Startup.Snapshots
+    return !_fileName.empty() || IsEnabled();
+}
+
+std::string StartupSnapshot::GetFileName() const
+{
+    if (!_fileName.empty())
+        return _fileName;
+
+    return sWorld->GetDataPath() + "snapshots/" + _name + ".snapshot";
+}
+
+StartupSnapshot::Digest const& StartupSnapshot::GetKey()
+{
+    if (_key)
+        return *_key;
+
+    Trinity::Crypto::SHA256 hash;
+    hash.UpdateData(GitRevision::GetFullVersion());
+    hash.UpdateData(sWorld->GetDBVersion());
+    hash.UpdateData(_name);
+
+    // CHECKSUM TABLE is computed by the database server, much cheaper than transferring the rows
+    std::string query = "CHECKSUM TABLE ";
+    for (std::size_t i = 0; i < _tables.size(); ++i)
+    {
+        if (i)
+            query += ", ";
+        query += '`' + _tables[i] + '`';
+    }
+
+    if (QueryResult result = WorldDatabase.Query(query.c_str()))
+    {
+        do
+        {
+            Field* fields = result->Fetch();
+            hash.UpdateData(fields[0].GetString());
+            hash.UpdateData(std::to_string(fields[1].GetUInt64()));
+        } while (result->NextRow());
+    }
+
+    // client data has no version of its own, replacing the extracted files changes their contents
+    for (std::string const& dbcFile : _dbcFiles)
+    {
+        hash.UpdateData(dbcFile);
+
+        std::ifstream file(sWorld->GetDataPath() + "dbc/" + dbcFile, std::ios::binary);
+        if (!file)
+        {
+            hash.UpdateData("missing");
+            continue;
+        }
+
+        std::array<char, 64 * 1024> chunk;
+        while (file.read(chunk.data(), chunk.size()) || file.gcount())
+            hash.UpdateData(reinterpret_cast<uint8 const*>(chunk.data()), std::size_t(file.gcount()));
+    }
+
+    hash.Finalize();
+    _key = hash.GetDigest();
+    return *_key;
+}
+
+bool StartupSnapshot::Open()
+{
+    if (!IsActive())
+        return false;
+
+    Close();
+
+    std::string fileName = GetFileName();
+    boost::system::error_code error;
+    if (!boost::filesystem::exists(fileName, error))
+    {
+        TC_LOG_INFO("server.loading", "Startup snapshot {} not found, loading from the database", fileName);
+        return false;
+    }
+
+    try
+    {
+        _file = std::make_unique<boost::interprocess::file_mapping>(fileName.c_str(), boost::interprocess::read_only);
+        _region = std::make_unique<boost::interprocess::mapped_region>(*_file, boost::interprocess::read_only);
+    }
+    catch (std::exception const& e)
+    {
+        TC_LOG_ERROR("server.loading", "Startup snapshot {} could not be mapped ({}), loading from the database", fileName, e.what());
+        Close();
+        return false;
+    }
+
+    auto reject = [&](char const* reason)
+    {
+        TC_LOG_INFO("server.loading", "Startup snapshot {} is {}, loading from the database", fileName, reason);
+        Close();
+        return false;
+    };
+
+    if (_region->get_size() < sizeof(SnapshotHeader))
+        return reject("truncated");
+
+    SnapshotHeader header;
+    std::memcpy(&header, _region->get_address(), sizeof(header));
+    EndianConvert(header.FormatVersion);
+    EndianConvert(header.PayloadSize);
+
+    if (header.Magic != SnapshotMagic || header.FormatVersion != SnapshotFormatVersion)
+        return reject("not a startup snapshot or of an unsupported format");
+
+    if (header.Key != GetKey())
+        return reject("outdated");
+
+    if (header.PayloadSize != _region->get_size() - sizeof(SnapshotHeader))
+        return reject("truncated");
+
+    _payload = static_cast<uint8 const*>(_region->get_address()) + sizeof(SnapshotHeader);
+    _payloadSize = header.PayloadSize;
+    _readPos = 0;
+
+    if (Trinity::Crypto::SHA256::GetDigestOf(_payload, _payloadSize) != header.PayloadChecksum)
+        return reject("corrupted");
+
+    return true;
+}
+
+void StartupSnapshot::Close()
+{
+    _region.reset();
+    _file.reset();
+    _payload = nullptr;
+    _payloadSize = 0;
+    _readPos = 0;
+}
+
+std::string StartupSnapshot::ReadString()
+{
+    void const* end = _readPos < _payloadSize ? std::memchr(_payload + _readPos, 0, _payloadSize - _readPos) : nullptr;
+    if (!end)
+        throw ByteBufferPositionException(false, _readPos, _payloadSize, 1);
+
+    std::string value(reinterpret_cast<char const*>(_payload + _readPos), static_cast<uint8 const*>(end) - (_payload + _readPos));
+    _readPos += value.length() + 1;
+    return value;
+}
+
+bool StartupSnapshot::Save()
+{
+    if (!IsActive())
+        return false;
+
+    // an open mapping would keep the old file locked on some platforms
+    Close();
+
+    std::string fileName = GetFileName();
+    std::string tempFileName = fileName + ".tmp";
+
+    // ByteBuffer::contents() throws on an empty buffer, a container without rows has an empty payload
+    uint8 const* payload = _writeBuffer.empty() ? nullptr : _writeBuffer.contents();
+
+    SnapshotHeader header;
+    header.Magic = SnapshotMagic;
+    header.FormatVersion = SnapshotFormatVersion;
+    header.Key = GetKey();
+    header.PayloadSize = _writeBuffer.size();
+    header.PayloadChecksum = Trinity::Crypto::SHA256::GetDigestOf(payload, _writeBuffer.size());
+    EndianConvert(header.FormatVersion);
+    EndianConvert(header.PayloadSize);
+
+    boost::system::error_code error;
+    boost::filesystem::create_directories(boost::filesystem::path(fileName).parent_path(), error);
+
+    {
+        std::ofstream file(tempFileName, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        if (payload)
+            file.write(reinterpret_cast<char const*>(payload), _writeBuffer.size());
+        if (!file)
+        {
+            TC_LOG_ERROR("server.loading", "Startup snapshot {} could not be written", tempFileName);
+            return false;
+        }
+    }
+
+    // rename over the old snapshot so a crash while saving never leaves a half written file behind
+    boost::filesystem::rename(tempFileName, fileName, error);
+    if (error)
+    {
+        TC_LOG_ERROR("server.loading", "Startup snapshot {} could not be replaced: {}", fileName, error.message());
+        return false;
+    }
+
+    TC_LOG_INFO("server.loading", ">> Saved startup snapshot {} ({} bytes)", fileName, _writeBuffer.size());
+    _writeBuffer.clear();
+    return true;
+}
@@ -0,0 +1,115 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_STARTUP_SNAPSHOT_H
+#define TRINITY_STARTUP_SNAPSHOT_H
+
+#include "ByteBuffer.h"
+#include "ByteConverter.h"
+#include "Optional.h"
+#include <array>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace boost::interprocess
+{
+class file_mapping;
+class mapped_region;
+}
+
+/**
+ * Binary copy of a container loaded from static world database tables
+ *
+ * After a successful load from the database the owner serializes its container with Write*() and Save()s it,
+ * on the next startup Open() maps the file and the owner rebuilds the container with Read*() instead of querying the tables.
+ * A snapshot is only accepted when its key (core revision, world database version, CHECKSUM TABLE of every source table
+ * and the contents of every client data file the load validates against) and the checksum of its payload match,
+ * otherwise the owner loads from the database as usual and replaces the file.
+ */
+class TC_GAME_API StartupSnapshot
+{
+public:
+    using Digest = std::array<uint8, 32>;
+
+    /// dbcFiles name the files under <DataDir>/dbc/ whose stores the load validates rows against
+    StartupSnapshot(std::string name, std::vector<std::string> tables, std::vector<std::string> dbcFiles = { });
+    /// Snapshot stored at an explicit path under a caller provided key, independent of the world configuration and database
+    StartupSnapshot(std::string name, std::string fileName, Digest const& key);
+    ~StartupSnapshot();
+
+    StartupSnapshot(StartupSnapshot const&) = delete;
+    StartupSnapshot(StartupSnapshot&&) = delete;
+    StartupSnapshot& operator=(StartupSnapshot const&) = delete;
+    StartupSnapshot& operator=(StartupSnapshot&&) = delete;
+
+    static bool IsEnabled();
+
+    std::string const& GetName() const { return _name; }
+
+    /// Maps the snapshot file, returns false when it is missing, stale or corrupted
+    bool Open();
+    void Close();
+
+    template <class T>
+    T Read()
+    {
+        static_assert(std::is_fundamental_v<T>, "StartupSnapshot::Read(compound)");
+        if (_readPos + sizeof(T) > _payloadSize)
+            throw ByteBufferPositionException(false, _readPos, _payloadSize, sizeof(T));
+
+        T value;
+        std::memcpy(&value, _payload + _readPos, sizeof(T));
+        EndianConvert(value);
+        _readPos += sizeof(T);
+        return value;
+    }
+
+    std::string ReadString();
+    bool IsFullyRead() const { return _readPos == _payloadSize; }
+
+    template <class T>
+    void Write(T value) { _writeBuffer.append<T>(value); }
+    void WriteString(std::string_view value) { _writeBuffer << value; }
+
+    /// Replaces the snapshot file with everything written so far
+    bool Save();
+
+private:
+    std::string GetFileName() const;
+    Digest const& GetKey();
+
+    bool IsActive() const;
+
+    std::string _name;
+    std::string _fileName;
+    std::vector<std::string> _tables;
+    std::vector<std::string> _dbcFiles;
+    Optional<Digest> _key;
+
+    std::unique_ptr<boost::interprocess::file_mapping> _file;
+    std::unique_ptr<boost::interprocess::mapped_region> _region;
+    uint8 const* _payload;
+    std::size_t _payloadSize;
+    std::size_t _readPos;
+
+    ByteBuffer _writeBuffer;
+};
+
+#endif // TRINITY_STARTUP_SNAPSHOT_H
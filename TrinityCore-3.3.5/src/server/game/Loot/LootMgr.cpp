@@ -27,6 +27,7 @@
 #include "SharedDefines.h"
 #include "SpellInfo.h"
 #include "SpellMgr.h"
+#include "StartupSnapshot.h"
 #include "Util.h"
 #include "World.h"
 
@@ -97,6 +98,8 @@ class LootTemplate::LootGroup                               // A set of loot def
         LootStoreItemList* GetExplicitlyChancedItemList() { return &ExplicitlyChanced; }
         LootStoreItemList* GetEqualChancedItemList() { return &EqualChanced; }
         void CopyConditions(ConditionContainer conditions);
+        std::size_t GetEntryCount() const { return ExplicitlyChanced.size() + EqualChanced.size(); }
+        void WriteSnapshot(StartupSnapshot& snapshot) const;
     private:
         LootStoreItemList ExplicitlyChanced;                // Entries with chances defined in DB
         LootStoreItemList EqualChanced;                     // Zero chances - every entry takes the same chance
@@ -108,6 +111,27 @@ class LootTemplate::LootGroup                               // A set of loot def
         LootGroup& operator=(LootGroup const&) = delete;
 };
 
+static void WriteLootStoreItem(StartupSnapshot& snapshot, LootStoreItem const* item)
+{
+    snapshot.Write<uint32>(item->itemid);
+    snapshot.Write<uint32>(item->reference);
+    snapshot.Write<float>(item->chance);
+    snapshot.Write<uint16>(item->lootmode);
+    snapshot.Write<uint8>(item->needs_quest ? 1 : 0);
+    snapshot.Write<uint8>(item->groupid);
+    snapshot.Write<uint8>(item->mincount);
+    snapshot.Write<uint8>(item->maxcount);
+}
+
+void LootTemplate::LootGroup::WriteSnapshot(StartupSnapshot& snapshot) const
+{
+    for (LootStoreItem const* item : ExplicitlyChanced)
+        WriteLootStoreItem(snapshot, item);
+
+    for (LootStoreItem const* item : EqualChanced)
+        WriteLootStoreItem(snapshot, item);
+}
+
 //Remove all data and free all memory
 void LootStore::Clear()
 {
@@ -133,6 +157,19 @@ uint32 LootStore::LoadLootTable()
     // Clearing store (for reloading case)
     Clear();
 
+    // item templates are part of the key, rows referencing missing items are dropped by LootStoreItem::IsValid
+    StartupSnapshot snapshot(GetName(), { GetName(), "item_template" });
+    if (snapshot.Open())
+    {
+        if (Optional<uint32> count = LoadFromSnapshot(snapshot))
+        {
+            Verify();
+            return *count;
+        }
+
+        Clear();
+    }
+
     //                                                  0     1            2               3         4         5             6
     QueryResult result = WorldDatabase.PQuery("SELECT Entry, Item, Reference, Chance, QuestRequired, LootMode, GroupId, MinCount, MaxCount FROM {}", GetName());
 
@@ -192,9 +229,67 @@ uint32 LootStore::LoadLootTable()
 
     Verify();                                           // Checks validity of the loot store
 
+    if (StartupSnapshot::IsEnabled())
+    {
+        WriteSnapshot(snapshot);
+        snapshot.Save();
+    }
+
     return count;
 }
 
+Optional<uint32> LootStore::LoadFromSnapshot(StartupSnapshot& snapshot)
+{
+    uint32 count = 0;
+    try
+    {
+        uint32 templateCount = snapshot.Read<uint32>();
+        m_LootTemplates.reserve(templateCount);
+        for (uint32 i = 0; i < templateCount; ++i)
+        {
+            uint32 entry = snapshot.Read<uint32>();
+            LootTemplate* lootTemplate = new LootTemplate();
+            m_LootTemplates[entry] = lootTemplate;
+
+            uint32 itemCount = snapshot.Read<uint32>();
+            for (uint32 j = 0; j < itemCount; ++j)
+            {
+                uint32 item         = snapshot.Read<uint32>();
+                uint32 reference    = snapshot.Read<uint32>();
+                float chance        = snapshot.Read<float>();
+                uint16 lootmode     = snapshot.Read<uint16>();
+                bool needsquest     = snapshot.Read<uint8>() != 0;
+                uint8 groupid       = snapshot.Read<uint8>();
+                uint8 mincount      = snapshot.Read<uint8>();
+                uint8 maxcount      = snapshot.Read<uint8>();
+                lootTemplate->AddEntry(new LootStoreItem(item, reference, chance, needsquest, lootmode, groupid, mincount, maxcount));
+            }
+
+            count += itemCount;
+        }
+    }
+    catch (ByteBufferException const& e)
+    {
+        TC_LOG_ERROR("server.loading", "Startup snapshot {} could not be read ({}), loading from the database", snapshot.GetName(), e.what());
+        return {};
+    }
+
+    if (!snapshot.IsFullyRead())
+        return {};
+
+    return count;
+}
+
+void LootStore::WriteSnapshot(StartupSnapshot& snapshot) const
+{
+    snapshot.Write<uint32>(m_LootTemplates.size());
+    for (auto const& [entry, lootTemplate] : m_LootTemplates)
+    {
+        snapshot.Write<uint32>(entry);
+        lootTemplate->WriteSnapshot(snapshot);
+    }
+}
+
 bool LootStore::HaveQuestLootFor(uint32 loot_id) const
 {
     LootTemplateMap::const_iterator itr = m_LootTemplates.find(loot_id);
@@ -534,6 +629,22 @@ void LootTemplate::AddEntry(LootStoreItem* item)
         Entries.push_back(item);
 }
 
+void LootTemplate::WriteSnapshot(StartupSnapshot& snapshot) const
+{
+    std::size_t count = Entries.size();
+    for (LootGroup const* group : Groups)
+        if (group)
+            count += group->GetEntryCount();
+
+    snapshot.Write<uint32>(count);
+    for (LootStoreItem const* item : Entries)
+        WriteLootStoreItem(snapshot, item);
+
+    for (LootGroup const* group : Groups)
+        if (group)
+            group->WriteSnapshot(snapshot);
+}
+
 void LootTemplate::CopyConditions(ConditionContainer const& conditions)
 {
     for (LootStoreItemList::iterator i = Entries.begin(); i != Entries.end(); ++i)
@@ -724,7 +835,7 @@ bool LootTemplate::addConditionItem(Condition* cond)
         {
             if ((*i)->itemid == uint32(cond->SourceEntry))
             {
-                (*i)->conditions.push_back(cond);
+                ConditionMgr::AddToConditionList((*i)->conditions, cond);
                 return true;
             }
         }
@@ -745,7 +856,7 @@ bool LootTemplate::addConditionItem(Condition* cond)
                 {
                     if ((*i)->itemid == uint32(cond->SourceEntry))
                     {
-                        (*i)->conditions.push_back(cond);
+                        ConditionMgr::AddToConditionList((*i)->conditions, cond);
                         return true;
                     }
                 }
@@ -758,7 +869,7 @@ bool LootTemplate::addConditionItem(Condition* cond)
                 {
                     if ((*i)->itemid == uint32(cond->SourceEntry))
                     {
-                        (*i)->conditions.push_back(cond);
+                        ConditionMgr::AddToConditionList((*i)->conditions, cond);
                         return true;
                     }
                 }
@@ -21,6 +21,7 @@
 #include "Define.h"
 #include "ConditionMgr.h"
 #include "ObjectGuid.h"
+#include "Optional.h"
 #include "SharedDefines.h"
 #include <list>
 #include <vector>
@@ -28,6 +29,7 @@
 class LootStore;
 class LootTemplate;
 class Player;
+class StartupSnapshot;
 struct Loot;
 struct LootItem;
 
@@ -90,6 +92,9 @@ class TC_GAME_API LootStore
         uint32 LoadLootTable();
         void Clear();
     private:
+        Optional<uint32> LoadFromSnapshot(StartupSnapshot& snapshot);
+        void WriteSnapshot(StartupSnapshot& snapshot) const;
+
         LootTemplateMap m_LootTemplates;
         char const* m_name;
         char const* m_entryName;
@@ -122,6 +127,8 @@ class TC_GAME_API LootTemplate
         void CheckLootRefs(LootTemplateMap const& store, LootIdSet* ref_set) const;
         bool addConditionItem(Condition* cond);
         bool isReference(uint32 id);
+        // Writes all entries in an order AddEntry() rebuilds the same template from
+        void WriteSnapshot(StartupSnapshot& snapshot) const;
 
     private:
         LootStoreItemList Entries;                          // not grouped only
@@ -25,6 +25,7 @@
 #include "DetourCommon.h"
 #include "DetourNavMeshQuery.h"
 #include "Metric.h"
+#include "Profiler.h"
 
 ////////////////// PathGenerator //////////////////
 PathGenerator::PathGenerator(WorldObject const* owner) :
@@ -55,6 +56,8 @@ PathGenerator::~PathGenerator()
 
 bool PathGenerator::CalculatePath(float destX, float destY, float destZ, bool forceDest)
 {
+    TC_PROFILE_ZONE("PathGenerator::CalculatePath");
+
     float x, y, z;
     _source->GetPosition(x, y, z);
 
@@ -158,6 +158,8 @@ class TC_GAME_API ReputationMgr
         uint8 _reveredFactionCount;
         uint8 _exaltedFactionCount;
         bool _sendFactionIncreased; //! Play visual effect on next SMSG_SET_FACTION_STANDING sent
+
+        friend class UnitTestDataLoader;
 };
 
 #endif
@@ -0,0 +1,179 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "OpcodeStats.h"
+#include "Metric.h"
+#include <algorithm>
+#include <array>
+
+namespace
+{
+// padded so threads never share a cache line, only the owning thread writes
+struct alignas(64) OpcodeCounters
+{
+    std::atomic<uint64> Calls;
+    std::atomic<uint64> TotalTime;
+    std::atomic<uint64> MaxTime;
+    std::atomic<uint64> Bytes;
+    std::atomic<uint64> Allocations;
+    std::atomic<uint32> Epoch;
+};
+
+void Increase(std::atomic<uint64>& counter, uint64 value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+}
+
+struct OpcodeStats::ThreadCounters
+{
+    ThreadCounters()
+    {
+        for (OpcodeCounters& counters : Opcodes)
+        {
+            counters.Calls.store(0, std::memory_order_relaxed);
+            counters.TotalTime.store(0, std::memory_order_relaxed);
+            counters.MaxTime.store(0, std::memory_order_relaxed);
+            counters.Bytes.store(0, std::memory_order_relaxed);
+            counters.Allocations.store(0, std::memory_order_relaxed);
+            counters.Epoch.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::array<OpcodeCounters, NUM_OPCODE_HANDLERS> Opcodes;
+};
+
+OpcodeStats::OpcodeStats() : _enabled(true), _epoch(0), _exportedEpoch(0)
+{
+}
+
+OpcodeStats::~OpcodeStats() = default;
+
+OpcodeStats* OpcodeStats::instance()
+{
+    static OpcodeStats instance;
+    return &instance;
+}
+
+OpcodeStats::ThreadCounters* OpcodeStats::GetThreadCounters()
+{
+    thread_local ThreadCounters* current = nullptr;
+    if (current)
+        return current;
+
+    // kept after the thread exits, packet handling threads live as long as the server anyway
+    std::lock_guard<std::mutex> lock(_threadsLock);
+    current = _threads.emplace_back(std::make_unique<ThreadCounters>()).get();
+    return current;
+}
+
+void OpcodeStats::Record(OpcodeClient opcode, std::size_t bytes, std::chrono::nanoseconds time, uint64 allocations)
+{
+    if (uint32(opcode) >= NUM_OPCODE_HANDLERS)
+        return;
+
+    OpcodeCounters& counters = GetThreadCounters()->Opcodes[opcode];
+    uint32 epoch = _epoch.load(std::memory_order_relaxed);
+    if (counters.Epoch.load(std::memory_order_relaxed) != epoch)
+    {
+        counters.Calls.store(0, std::memory_order_relaxed);
+        counters.TotalTime.store(0, std::memory_order_relaxed);
+        counters.MaxTime.store(0, std::memory_order_relaxed);
+        counters.Bytes.store(0, std::memory_order_relaxed);
+        counters.Allocations.store(0, std::memory_order_relaxed);
+        counters.Epoch.store(epoch, std::memory_order_release);
+    }
+
+    uint64 nanoseconds = uint64(std::max<int64>(time.count(), 0));
+    Increase(counters.Calls, 1);
+    Increase(counters.TotalTime, nanoseconds);
+    Increase(counters.Bytes, bytes);
+    Increase(counters.Allocations, allocations);
+    if (nanoseconds > counters.MaxTime.load(std::memory_order_relaxed))
+        counters.MaxTime.store(nanoseconds, std::memory_order_relaxed);
+}
+
+std::vector<OpcodeStatsEntry> OpcodeStats::Collect() const
+{
+    std::vector<OpcodeStatsEntry> merged(NUM_OPCODE_HANDLERS);
+    uint32 epoch = _epoch.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(_threadsLock);
+        for (std::unique_ptr<ThreadCounters> const& thread : _threads)
+        {
+            for (uint32 opcode = 0; opcode < NUM_OPCODE_HANDLERS; ++opcode)
+            {
+                OpcodeCounters const& counters = thread->Opcodes[opcode];
+                if (counters.Epoch.load(std::memory_order_acquire) != epoch)
+                    continue;
+
+                OpcodeStatsEntry& entry = merged[opcode];
+                entry.Calls += counters.Calls.load(std::memory_order_relaxed);
+                entry.TotalTime += counters.TotalTime.load(std::memory_order_relaxed);
+                entry.MaxTime = std::max(entry.MaxTime, counters.MaxTime.load(std::memory_order_relaxed));
+                entry.Bytes += counters.Bytes.load(std::memory_order_relaxed);
+                entry.Allocations += counters.Allocations.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::vector<OpcodeStatsEntry> entries;
+    for (uint32 opcode = 0; opcode < NUM_OPCODE_HANDLERS; ++opcode)
+    {
+        if (!merged[opcode].Calls)
+            continue;
+
+        merged[opcode].Opcode = OpcodeClient(opcode);
+        entries.push_back(merged[opcode]);
+    }
+
+    return entries;
+}
+
+void OpcodeStats::Reset()
+{
+    _epoch.fetch_add(1, std::memory_order_relaxed);
+}
+
+void OpcodeStats::ExportToMetric()
+{
+    if (!sMetric->IsEnabled())
+        return;
+
+    uint32 epoch = _epoch.load(std::memory_order_relaxed);
+    if (_exported.empty() || _exportedEpoch != epoch)
+    {
+        _exported.assign(NUM_OPCODE_HANDLERS, OpcodeStatsEntry());
+        _exportedEpoch = epoch;
+    }
+
+    for (OpcodeStatsEntry const& entry : Collect())
+    {
+        OpcodeStatsEntry& exported = _exported[entry.Opcode];
+        if (entry.Calls <= exported.Calls)
+            continue;
+
+        char const* name = opcodeTable[entry.Opcode]->Name;
+        TC_METRIC_VALUE("opcode_calls", entry.Calls - exported.Calls, TC_METRIC_TAG("opcode", name));
+        TC_METRIC_VALUE("opcode_time", std::chrono::nanoseconds(entry.TotalTime - exported.TotalTime), TC_METRIC_TAG("opcode", name));
+        TC_METRIC_VALUE("opcode_bytes", entry.Bytes - exported.Bytes, TC_METRIC_TAG("opcode", name));
+        if (Trinity::IsAllocationCounterEnabled())
+            TC_METRIC_VALUE("opcode_allocations", entry.Allocations - exported.Allocations, TC_METRIC_TAG("opcode", name));
+
+        exported = entry;
+    }
+}
@@ -0,0 +1,113 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITYCORE_OPCODE_STATS_H
+#define TRINITYCORE_OPCODE_STATS_H
+
+#include "AllocationCounter.h"
+#include "Define.h"
+#include "Duration.h"
+#include "Opcodes.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct OpcodeStatsEntry
+{
+    OpcodeClient Opcode = OpcodeClient(0);
+    uint64 Calls = 0;
+    uint64 TotalTime = 0;                                   // nanoseconds
+    uint64 MaxTime = 0;                                     // nanoseconds
+    uint64 Bytes = 0;
+    uint64 Allocations = 0;                                 // only with WITH_ALLOCATION_COUNTER
+};
+
+/**
+ * Time, size and allocations of every client packet handler
+ *
+ * Each thread handling packets (world and map update threads) owns a table of counters it updates without locking,
+ * Collect merges them when someone asks. Reset starts a new epoch instead of touching the tables of other threads.
+ */
+class TC_GAME_API OpcodeStats
+{
+    struct ThreadCounters;
+
+public:
+    class Recorder
+    {
+    public:
+        Recorder(OpcodeClient opcode, std::size_t bytes) : _opcode(opcode), _bytes(bytes), _active(OpcodeStats::instance()->IsEnabled())
+        {
+            if (!_active)
+                return;
+
+            _allocations = Trinity::GetThreadAllocationCount();
+            _start = std::chrono::steady_clock::now();
+        }
+
+        ~Recorder()
+        {
+            if (_active)
+                OpcodeStats::instance()->Record(_opcode, _bytes, std::chrono::steady_clock::now() - _start, Trinity::GetThreadAllocationCount() - _allocations);
+        }
+
+        Recorder(Recorder const&) = delete;
+        Recorder& operator=(Recorder const&) = delete;
+
+    private:
+        OpcodeClient _opcode;
+        std::size_t _bytes;
+        bool _active;
+        uint64 _allocations = 0;
+        TimePoint _start;
+    };
+
+    static OpcodeStats* instance();
+
+    bool IsEnabled() const { return _enabled.load(std::memory_order_relaxed); }
+    void SetEnabled(bool enabled) { _enabled.store(enabled, std::memory_order_relaxed); }
+
+    void Record(OpcodeClient opcode, std::size_t bytes, std::chrono::nanoseconds time, uint64 allocations);
+
+    /// Counters of every opcode handled since the last reset, merged over all threads
+    std::vector<OpcodeStatsEntry> Collect() const;
+
+    void Reset();
+
+    /// Sends what changed since the previous call to the Metric sink, tagged by opcode name
+    void ExportToMetric();
+
+private:
+    OpcodeStats();
+    ~OpcodeStats();
+
+    ThreadCounters* GetThreadCounters();
+
+    std::atomic<bool> _enabled;
+    std::atomic<uint32> _epoch;
+    mutable std::mutex _threadsLock;
+    std::vector<std::unique_ptr<ThreadCounters>> _threads;
+
+    // only touched by ExportToMetric
+    std::vector<OpcodeStatsEntry> _exported;
+    uint32 _exportedEpoch;
+};
+
+#define sOpcodeStats OpcodeStats::instance()
+
+#endif // TRINITYCORE_OPCODE_STATS_H
@@ -42,9 +42,11 @@
 #include "ObjectAccessor.h"
 #include "ObjectMgr.h"
 #include "Opcodes.h"
+#include "OpcodeStats.h"
 #include "OutdoorPvPMgr.h"
 #include "PacketUtilities.h"
 #include "Player.h"
+#include "Profiler.h"
 #include "Realm.h"
 #include "ScriptMgr.h"
 #include "SocialMgr.h"
@@ -279,6 +281,8 @@ void WorldSession::LogUnprocessedTail(WorldPacket* packet)
 /// Update the WorldSession (triggered by World update)
 bool WorldSession::Update(uint32 diff, PacketFilter& updater)
 {
+    TC_PROFILE_ZONE("WorldSession::Update");
+
     ///- Before we process anything:
     /// If necessary, kick the player because the client didn't send anything for too long
     /// (or they've been idling in character select)
@@ -324,6 +328,7 @@ bool WorldSession::Update(uint32 diff, PacketFilter& updater)
                     {
                         if(AntiDOS.EvaluateOpcode(*packet, currentTime))
                         {
+                            OpcodeStats::Recorder opcodeStatsRecorder(opcode, packet->size());
                             sScriptMgr->OnPacketReceive(this, *packet);
                             opHandle->Call(this, *packet);
                             LogUnprocessedTail(packet);
@@ -340,6 +345,7 @@ bool WorldSession::Update(uint32 diff, PacketFilter& updater)
                     else if (AntiDOS.EvaluateOpcode(*packet, currentTime))
                     {
                         // not expected _player or must checked in packet hanlder
+                        OpcodeStats::Recorder opcodeStatsRecorder(opcode, packet->size());
                         sScriptMgr->OnPacketReceive(this, *packet);
                         opHandle->Call(this, *packet);
                         LogUnprocessedTail(packet);
@@ -354,6 +360,7 @@ bool WorldSession::Update(uint32 diff, PacketFilter& updater)
                         LogUnexpectedOpcode(packet, "STATUS_TRANSFER", "the player is still in world");
                     else if (AntiDOS.EvaluateOpcode(*packet, currentTime))
                     {
+                        OpcodeStats::Recorder opcodeStatsRecorder(opcode, packet->size());
                         sScriptMgr->OnPacketReceive(this, *packet);
                         opHandle->Call(this, *packet);
                         LogUnprocessedTail(packet);
@@ -376,6 +383,7 @@ bool WorldSession::Update(uint32 diff, PacketFilter& updater)
 
                     if (AntiDOS.EvaluateOpcode(*packet, currentTime))
                     {
+                        OpcodeStats::Recorder opcodeStatsRecorder(opcode, packet->size());
                         sScriptMgr->OnPacketReceive(this, *packet);
                         opHandle->Call(this, *packet);
                         LogUnprocessedTail(packet);
@@ -1328,6 +1328,8 @@ class TC_GAME_API WorldSession
 
         WorldSession(WorldSession const& right) = delete;
         WorldSession& operator=(WorldSession const& right) = delete;
+
+        friend class UnitTestDataLoader;
 };
 #endif
 /// @}
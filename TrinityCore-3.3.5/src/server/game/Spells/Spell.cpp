@@ -43,6 +43,7 @@
 #include "PathGenerator.h"
 #include "Pet.h"
 #include "Player.h"
+#include "Profiler.h"
 #include "ScriptMgr.h"
 #include "SharedDefines.h"
 #include "SpellAuraEffects.h"
@@ -3801,6 +3802,8 @@ void Spell::SendSpellCooldown()
 
 void Spell::update(uint32 difftime)
 {
+    TC_PROFILE_ZONE("Spell::update");
+
     // update pointers based at it's GUIDs
     if (!UpdatePointers())
     {
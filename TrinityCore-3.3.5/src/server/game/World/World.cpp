@@ -62,11 +62,13 @@
 #include "MMapFactory.h"
 #include "ObjectAccessor.h"
 #include "ObjectMgr.h"
+#include "OpcodeStats.h"
 #include "OutdoorPvPMgr.h"
 #include "PetitionMgr.h"
 #include "Player.h"
 #include "PlayerDump.h"
 #include "PoolMgr.h"
+#include "Profiler.h"
 #include "QueryCallback.h"
 #include "QuestPools.h"
 #include "Realm.h"
@@ -77,6 +79,7 @@
 #include "SkillExtraItems.h"
 #include "SmartScriptMgr.h"
 #include "SpellMgr.h"
+#include "TaskGraph.h"
 #include "TicketMgr.h"
 #include "TransportMgr.h"
 #include "Unit.h"
@@ -491,6 +494,8 @@ void World::LoadConfigSettings(bool reload)
     SetPlayerAmountLimit(sConfigMgr->GetIntDefault("PlayerLimit", 100));
     Motd::SetMotd(sConfigMgr->GetStringDefault("Motd", "Welcome to a Trinity Core Server."));
 
+    sOpcodeStats->SetEnabled(sConfigMgr->GetBoolDefault("OpcodeStats.Enable", true));
+
     ///- Read ticket system setting from the config file
     m_bool_configs[CONFIG_ALLOW_TICKETS] = sConfigMgr->GetBoolDefault("AllowTickets", true);
     m_bool_configs[CONFIG_DELETE_CHARACTER_TICKET_TRACE] = sConfigMgr->GetBoolDefault("DeletedCharacterTicketTrace", false);
@@ -1458,6 +1463,13 @@ void World::LoadConfigSettings(bool reload)
     m_bool_configs[CONFIG_SHOW_MUTE_IN_WORLD] = sConfigMgr->GetBoolDefault("ShowMuteInWorld", false);
     m_bool_configs[CONFIG_SHOW_BAN_IN_WORLD] = sConfigMgr->GetBoolDefault("ShowBanInWorld", false);
     m_int_configs[CONFIG_NUMTHREADS] = sConfigMgr->GetIntDefault("MapUpdate.Threads", 1);
+    m_int_configs[CONFIG_STARTUP_LOADER_THREADS] = sConfigMgr->GetIntDefault("Startup.LoaderThreads", 1);
+    if (m_int_configs[CONFIG_STARTUP_LOADER_THREADS] < 1)
+    {
+        TC_LOG_ERROR("server.loading", "Startup.LoaderThreads ({}) must be > 0. Using 1 instead.", m_int_configs[CONFIG_STARTUP_LOADER_THREADS]);
+        m_int_configs[CONFIG_STARTUP_LOADER_THREADS] = 1;
+    }
+    m_bool_configs[CONFIG_STARTUP_SNAPSHOTS] = sConfigMgr->GetBoolDefault("Startup.Snapshots", false);
     m_int_configs[CONFIG_MAX_RESULTS_LOOKUP_COMMANDS] = sConfigMgr->GetIntDefault("Command.LookupMaxResults", 0);
 
     // Warden
@@ -1969,33 +1981,87 @@ void World::SetInitialWorldSettings()
     TC_LOG_INFO("server.loading", "Loading Player level dependent mail rewards...");
     sObjectMgr->LoadMailLevelRewards();
 
-    // Loot tables
-    LoadLootTables();
+    ///- Load static tables that only depend on the templates loaded above, optionally in parallel
+    ///- Every loader fills its own store, the graph only needs to know about loaders reading each other's data
+    {
+        Trinity::TaskGraph loaders;
+
+        // Loot tables
+        loaders.Add("Loot tables", [] { LoadLootTables(); });
+
+        loaders.Add("Skill discovery", []
+        {
+            TC_LOG_INFO("server.loading", "Loading Skill Discovery Table...");
+            LoadSkillDiscoveryTable();
+        });
+
+        loaders.Add("Skill extra items", []
+        {
+            TC_LOG_INFO("server.loading", "Loading Skill Extra Item Table...");
+            LoadSkillExtraItemTable();
+        });
+
+        loaders.Add("Skill perfection items", []
+        {
+            TC_LOG_INFO("server.loading", "Loading Skill Perfection Data Table...");
+            LoadSkillPerfectItemTable();
+        });
+
+        loaders.Add("Fishing base skill levels", []
+        {
+            TC_LOG_INFO("server.loading", "Loading Skill Fishing base level requirements...");
+            sObjectMgr->LoadFishingBaseSkillLevel();
+        });
+
+        loaders.Add("Achievements", []
+        {
+            TC_LOG_INFO("server.loading", "Loading Achievements...");
+            sAchievementMgr->LoadAchievementReferenceList();
+            TC_LOG_INFO("server.loading", "Loading Achievement Criteria Lists...");
+            sAchievementMgr->LoadAchievementCriteriaList();
+            TC_LOG_INFO("server.loading", "Loading Achievement Criteria Data...");
+            sAchievementMgr->LoadAchievementCriteriaData();
+            TC_LOG_INFO("server.loading", "Loading Achievement Rewards...");
+            sAchievementMgr->LoadRewards();
+            TC_LOG_INFO("server.loading", "Loading Achievement Reward Locales...");
+            sAchievementMgr->LoadRewardLocales();
+            TC_LOG_INFO("server.loading", "Loading Completed Achievements...");
+            sAchievementMgr->LoadCompletedAchievements();
+        });
 
-    TC_LOG_INFO("server.loading", "Loading Skill Discovery Table...");
-    LoadSkillDiscoveryTable();
+        Trinity::TaskGraph::TaskId trainers = loaders.Add("Trainers", []
+        {
+            TC_LOG_INFO("server.loading", "Loading Trainers...");       // must be after LoadCreatureTemplates
+            sObjectMgr->LoadTrainers();
+        });
 
-    TC_LOG_INFO("server.loading", "Loading Skill Extra Item Table...");
-    LoadSkillExtraItemTable();
+        loaders.Add("Creature default trainers", []
+        {
+            TC_LOG_INFO("server.loading", "Loading Creature default trainers...");
+            sObjectMgr->LoadCreatureDefaultTrainers();
+        }, { trainers });
 
-    TC_LOG_INFO("server.loading", "Loading Skill Perfection Data Table...");
-    LoadSkillPerfectItemTable();
+        loaders.Add("Gossip menus", []
+        {
+            TC_LOG_INFO("server.loading", "Loading Gossip menu...");
+            sObjectMgr->LoadGossipMenu();
+        });
+
+        loaders.Add("Gossip menu options", []
+        {
+            TC_LOG_INFO("server.loading", "Loading Gossip menu options...");
+            sObjectMgr->LoadGossipMenuItems();                           // must be after LoadTrainers
+        }, { trainers });
 
-    TC_LOG_INFO("server.loading", "Loading Skill Fishing base level requirements...");
-    sObjectMgr->LoadFishingBaseSkillLevel();
+        loaders.Add("Vendors", []
+        {
+            TC_LOG_INFO("server.loading", "Loading Vendors...");
+            sObjectMgr->LoadVendors();                                   // must be after load CreatureTemplate and ItemTemplate
+        });
 
-    TC_LOG_INFO("server.loading", "Loading Achievements...");
-    sAchievementMgr->LoadAchievementReferenceList();
-    TC_LOG_INFO("server.loading", "Loading Achievement Criteria Lists...");
-    sAchievementMgr->LoadAchievementCriteriaList();
-    TC_LOG_INFO("server.loading", "Loading Achievement Criteria Data...");
-    sAchievementMgr->LoadAchievementCriteriaData();
-    TC_LOG_INFO("server.loading", "Loading Achievement Rewards...");
-    sAchievementMgr->LoadRewards();
-    TC_LOG_INFO("server.loading", "Loading Achievement Reward Locales...");
-    sAchievementMgr->LoadRewardLocales();
-    TC_LOG_INFO("server.loading", "Loading Completed Achievements...");
-    sAchievementMgr->LoadCompletedAchievements();
+        loaders.Run(getIntConfig(CONFIG_STARTUP_LOADER_THREADS));
+        TC_LOG_INFO("server.loading", "{}", loaders.GetTimingReport());
+    }
 
     ///- Load dynamic data tables from the database
     TC_LOG_INFO("server.loading", "Loading Item Auctions...");
@@ -2025,21 +2091,6 @@ void World::SetInitialWorldSettings()
     TC_LOG_INFO("server.loading", "Loading GameTeleports...");
     sObjectMgr->LoadGameTele();
 
-    TC_LOG_INFO("server.loading", "Loading Trainers...");       // must be after LoadCreatureTemplates
-    sObjectMgr->LoadTrainers();
-
-    TC_LOG_INFO("server.loading", "Loading Creature default trainers...");
-    sObjectMgr->LoadCreatureDefaultTrainers();
-
-    TC_LOG_INFO("server.loading", "Loading Gossip menu...");
-    sObjectMgr->LoadGossipMenu();
-
-    TC_LOG_INFO("server.loading", "Loading Gossip menu options...");
-    sObjectMgr->LoadGossipMenuItems();                           // must be after LoadTrainers
-
-    TC_LOG_INFO("server.loading", "Loading Vendors...");
-    sObjectMgr->LoadVendors();                                   // must be after load CreatureTemplate and ItemTemplate
-
     TC_LOG_INFO("server.loading", "Loading Waypoints...");
     sWaypointMgr->Load();
 
@@ -2340,7 +2391,11 @@ void World::LoadAutobroadcasts()
 /// Update the World !
 void World::Update(uint32 diff)
 {
+    // finish a capture that ran its course between ticks, before the zone of this one opens
+    sProfiler->Update();
+
     TC_METRIC_TIMER("world_update_time_total");
+    TC_PROFILE_ZONE("World::Update");
     ///- Update the game time and check for shutdown time
     _UpdateGameTime();
     time_t currentGameTime = GameTime::GetGameTime();
@@ -2447,6 +2502,7 @@ void World::Update(uint32 diff)
     {
         /// <li> Handle session updates when the timer has passed
         TC_METRIC_TIMER("world_update_time", TC_METRIC_TAG("type", "Update sessions"));
+        TC_PROFILE_ZONE("World::UpdateSessions");
         UpdateSessions(diff);
     }
 
@@ -2491,6 +2547,7 @@ void World::Update(uint32 diff)
     ///- Update objects when the timer has passed (maps, transport, creatures, ...)
     {
         TC_METRIC_TIMER("world_update_time", TC_METRIC_TAG("type", "Update maps"));
+        TC_PROFILE_ZONE("MapManager::Update");
         sMapMgr->Update(diff);
     }
 
@@ -2607,6 +2664,7 @@ void World::Update(uint32 diff)
         // Stats logger update
         sMetric->Update();
         TC_METRIC_VALUE("update_time_diff", diff);
+        TC_METRIC_VALUE("achievement_update_time", sAchievementMgr->CollectUpdateTime());
     }
 }
 
@@ -3109,6 +3167,7 @@ void World::UpdateSessions(uint32 diff)
 
         [[maybe_unused]] uint32 currentSessionId = itr->first;
         TC_METRIC_DETAILED_TIMER("world_update_sessions_time", TC_METRIC_TAG("account_id", std::to_string(currentSessionId)));
+        TC_METRIC_HISTOGRAM_TIMER("worldsession_update_time");
 
         if (!pSession->Update(diff, updater))    // As interval = 0
         {
@@ -3569,6 +3628,7 @@ uint64 World::getWorldState(uint32 index) const
 
 void World::ProcessQueryCallbacks()
 {
+    TC_PROFILE_ZONE("World::ProcessQueryCallbacks");
     _queryProcessor.ProcessReadyCallbacks();
 }
 
@@ -178,6 +178,7 @@ enum WorldBoolConfigs : uint32
     CONFIG_RESPAWN_DYNAMIC_ESCORTNPC,
     CONFIG_REGEN_HP_CANNOT_REACH_TARGET_IN_RAID,
     CONFIG_ALLOW_LOGGING_IP_ADDRESSES_IN_DATABASE,
+    CONFIG_STARTUP_SNAPSHOTS,
     BOOL_CONFIG_VALUE_COUNT
 };
 
@@ -401,6 +402,7 @@ enum WorldIntConfigs : uint32
     CONFIG_RESPAWN_GUIDWARNING_FREQUENCY,
     CONFIG_SOCKET_TIMEOUTTIME_ACTIVE,
     CONFIG_PENDING_MOVE_CHANGES_TIMEOUT,
+    CONFIG_STARTUP_LOADER_THREADS,
     INT_CONFIG_VALUE_COUNT
 };
 
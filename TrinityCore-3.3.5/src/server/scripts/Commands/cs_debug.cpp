@@ -39,10 +39,13 @@ EndScriptData */
 #include "MapManager.h"
 #include "ObjectAccessor.h"
 #include "ObjectMgr.h"
+#include "OpcodeStats.h"
 #include "PoolMgr.h"
+#include "Profiler.h"
 #include "QuestPools.h"
 #include "RBAC.h"
 #include "SpellMgr.h"
+#include "StringFormat.h"
 #include "Transport.h"
 #include "Warden.h"
 #include "World.h"
@@ -119,6 +122,9 @@ public:
             { "asan outofbounds",   HandleDebugOutOfBounds,                rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
             { "guidlimits",         HandleDebugGuidLimitsCommand,          rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
             { "objectcount",        HandleDebugObjectCountCommand,         rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
+            { "opcodestats",        HandleDebugOpcodeStatsCommand,         rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
+            { "opcodestats reset",  HandleDebugOpcodeStatsResetCommand,    rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
+            { "profile",            HandleDebugProfileCommand,             rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
             { "questreset",         HandleDebugQuestResetCommand,          rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes },
             { "warden force",       HandleDebugWardenForce,                rbac::RBAC_PERM_COMMAND_DEBUG,   Console::Yes }
         };
@@ -1823,6 +1829,83 @@ public:
             handler->PSendSysMessage("Entry: %u Count: %u", p.first, p.second);
     }
 
+    // count - how many opcodes to list, the ones that took the most time first
+    static bool HandleDebugOpcodeStatsCommand(ChatHandler* handler, Optional<uint32> count)
+    {
+        if (!sOpcodeStats->IsEnabled())
+            handler->SendSysMessage("Opcode statistics are disabled (OpcodeStats.Enable), showing what was recorded before.");
+
+        std::vector<OpcodeStatsEntry> entries = sOpcodeStats->Collect();
+        std::sort(entries.begin(), entries.end(), [](OpcodeStatsEntry const& left, OpcodeStatsEntry const& right)
+        {
+            return left.TotalTime > right.TotalTime;
+        });
+
+        if (entries.size() > count.value_or(10))
+            entries.resize(count.value_or(10));
+
+        if (entries.empty())
+        {
+            handler->SendSysMessage("No client packets handled since the last reset.");
+            return true;
+        }
+
+        for (OpcodeStatsEntry const& entry : entries)
+        {
+            std::string allocations = Trinity::IsAllocationCounterEnabled()
+                ? Trinity::StringFormat(", {:.1f} allocations per call", double(entry.Allocations) / entry.Calls) : "";
+
+            handler->PSendSysMessage("%s: " UI64FMTD " calls, %.3f ms total, %.1f us average, %.1f us max, %.1f bytes per call%s",
+                opcodeTable[entry.Opcode]->Name, entry.Calls, entry.TotalTime / 1000000.0, entry.TotalTime / 1000.0 / entry.Calls,
+                entry.MaxTime / 1000.0, double(entry.Bytes) / entry.Calls, allocations.c_str());
+        }
+
+        return true;
+    }
+
+    static bool HandleDebugOpcodeStatsResetCommand(ChatHandler* handler)
+    {
+        sOpcodeStats->Reset();
+        handler->SendSysMessage("Opcode statistics reset.");
+        return true;
+    }
+
+    // seconds - how long to record, 0 stops the running capture right away
+    static bool HandleDebugProfileCommand(ChatHandler* handler, Optional<uint32> seconds)
+    {
+        if (!Trinity::Profiler::IsCompiledIn())
+        {
+            handler->SendSysMessage("The profiler is not built into this core, rebuild it with -DWITH_PROFILER=1.");
+            handler->SetSentErrorMessage(true);
+            return false;
+        }
+
+        if (seconds == 0u)
+        {
+            if (!sProfiler->IsRecording())
+            {
+                handler->SendSysMessage("The profiler is not recording.");
+                handler->SetSentErrorMessage(true);
+                return false;
+            }
+
+            sProfiler->Write(sProfiler->Stop());
+            handler->SendSysMessage("Profiler stopped, the capture is written to the logs directory.");
+            return true;
+        }
+
+        uint32 duration = seconds.value_or(10);
+        if (!sProfiler->Start(Seconds(duration)))
+        {
+            handler->SendSysMessage("The profiler is already recording, use .debug profile 0 to stop it.");
+            handler->SetSentErrorMessage(true);
+            return false;
+        }
+
+        handler->PSendSysMessage("Profiling for %u seconds, the capture is written to the logs directory (profile_*.json and profile_*.folded).", duration);
+        return true;
+    }
+
     static bool HandleDebugDummyCommand(ChatHandler* handler)
     {
         handler->SendSysMessage("This command does nothing right now. Edit your local core (cs_debug.cpp) to make it do whatever you need for testing.");
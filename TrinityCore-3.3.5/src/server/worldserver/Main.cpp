@@ -38,6 +38,7 @@
 #include "Metric.h"
 #include "MySQLThreading.h"
 #include "ObjectAccessor.h"
+#include "OpcodeStats.h"
 #include "OpenSSLCrypto.h"
 #include "OutdoorPvP/OutdoorPvPMgr.h"
 #include "ProcessPriority.h"
@@ -219,8 +220,8 @@ extern int main(int argc, char** argv)
     std::shared_ptr<Trinity::Asio::IoContext> ioContext = std::make_shared<Trinity::Asio::IoContext>();
 
     sLog->RegisterAppender<AppenderDB>();
-    // If logs are supposed to be handled async then we need to pass the IoContext into the Log singleton
-    sLog->Initialize(sConfigMgr->GetBoolDefault("Log.Async.Enable", false) ? ioContext.get() : nullptr);
+    // Async logs are written by a dedicated logger thread
+    sLog->Initialize(sConfigMgr->GetBoolDefault("Log.Async.Enable", false));
 
     Trinity::Banner::Show("worldserver-daemon",
         [](char const* text)
@@ -302,6 +303,7 @@ extern int main(int argc, char** argv)
         TC_METRIC_VALUE("db_queue_login", uint64(LoginDatabase.QueueSize()));
         TC_METRIC_VALUE("db_queue_character", uint64(CharacterDatabase.QueueSize()));
         TC_METRIC_VALUE("db_queue_world", uint64(WorldDatabase.QueueSize()));
+        sOpcodeStats->ExportToMetric();
     });
 
     TC_METRIC_EVENT("events", "Worldserver started", "");
@@ -0,0 +1,146 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ExtractionManifest.h"
+#include "Util.h"
+#include <boost/filesystem/operations.hpp>
+#include <fstream>
+#include <map>
+#include <vector>
+
+void ExtractionInputHash::UpdateData(std::string_view str)
+{
+    // length prefixed so consecutive strings can't shift into each other
+    UpdateValue(uint64(str.size()));
+    _hash.UpdateData(str);
+}
+
+bool ExtractionInputHash::UpdateFile(std::string const& path)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file)
+    {
+        UpdateValue(uint8(0));
+        return false;
+    }
+
+    UpdateValue(uint8(1));
+    std::vector<char> buffer(64 * 1024);
+    while (file)
+    {
+        file.read(buffer.data(), buffer.size());
+        _hash.UpdateData(reinterpret_cast<uint8 const*>(buffer.data()), std::size_t(file.gcount()));
+    }
+
+    return file.eof();
+}
+
+std::string ExtractionInputHash::Finalize()
+{
+    _hash.Finalize();
+    return ByteArrayToHexStr(_hash.GetDigest());
+}
+
+ExtractionManifest::ExtractionManifest(std::string path) : _path(std::move(path)), _file(nullptr)
+{
+}
+
+ExtractionManifest::~ExtractionManifest()
+{
+    if (_file)
+        fclose(_file);
+}
+
+bool ExtractionManifest::Open()
+{
+    std::lock_guard<std::mutex> lock(_lock);
+
+    // "<input hash> <output>" lines, later lines replace earlier ones
+    std::ifstream in(_path);
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::size_t separator = line.find(' ');
+        if (separator == std::string::npos || separator + 1 == line.size())
+            continue;
+
+        _entries[line.substr(separator + 1)] = line.substr(0, separator);
+    }
+    in.close();
+
+    _file = fopen(_path.c_str(), "a");
+    if (!_file)
+        printf("Can't open extraction manifest '%s', all outputs will be regenerated next time\n", _path.c_str());
+
+    return _file != nullptr;
+}
+
+bool ExtractionManifest::Close()
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    if (!_file)
+        return false;
+
+    fclose(_file);
+    _file = nullptr;
+
+    std::string tempPath = _path + ".tmp";
+    FILE* out = fopen(tempPath.c_str(), "w");
+    if (!out)
+        return false;
+
+    // sorted, outputs generated on several threads are updated in any order
+    for (auto const& [output, inputHash] : std::map<std::string, std::string>(_entries.begin(), _entries.end()))
+        fprintf(out, "%s %s\n", inputHash.c_str(), output.c_str());
+
+    if (fclose(out) != 0)
+        return false;
+
+    boost::system::error_code ec;
+    boost::filesystem::rename(tempPath, _path, ec);
+    return !ec;
+}
+
+bool ExtractionManifest::IsUpToDate(std::string const& output, std::string const& inputHash) const
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        auto itr = _entries.find(output);
+        if (itr == _entries.end() || itr->second != inputHash)
+            return false;
+    }
+
+    boost::system::error_code ec;
+    return boost::filesystem::exists(output, ec);
+}
+
+void ExtractionManifest::Update(std::string const& output, std::string const& inputHash)
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    _entries[output] = inputHash;
+    if (_file)
+    {
+        fprintf(_file, "%s %s\n", inputHash.c_str(), output.c_str());
+        fflush(_file);
+    }
+}
+
+std::size_t ExtractionManifest::GetSize() const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _entries.size();
+}
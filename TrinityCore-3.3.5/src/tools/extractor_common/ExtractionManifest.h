@@ -0,0 +1,83 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef EXTRACTION_MANIFEST_H
+#define EXTRACTION_MANIFEST_H
+
+#include "Define.h"
+#include "CryptoHash.h"
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <cstdio>
+
+// Hash of everything an output file is generated from: tool version, options and input file contents
+class ExtractionInputHash
+{
+public:
+    void UpdateData(uint8 const* data, size_t len) { _hash.UpdateData(data, len); }
+    void UpdateData(std::string_view str);
+
+    template<typename T>
+    void UpdateValue(T const& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "only plain values can be hashed");
+        UpdateData(reinterpret_cast<uint8 const*>(&value), sizeof(value));
+    }
+
+    // a missing file hashes differently than an empty one, returns false when the file can't be read
+    bool UpdateFile(std::string const& path);
+
+    std::string Finalize();
+
+private:
+    Trinity::Crypto::SHA1 _hash;
+};
+
+// Remembers the input hash every output file was last generated from, so tools only regenerate outputs
+// whose inputs changed. Updates are appended to the file right away, an interrupted run keeps the outputs
+// it finished. Deleting the manifest forces a full rebuild.
+class ExtractionManifest
+{
+public:
+    explicit ExtractionManifest(std::string path);
+    ~ExtractionManifest();
+
+    ExtractionManifest(ExtractionManifest const&) = delete;
+    ExtractionManifest& operator=(ExtractionManifest const&) = delete;
+
+    // loads the previous run and opens the manifest for appending updates
+    bool Open();
+    // rewrites the manifest with a single line per output
+    bool Close();
+
+    // true when the output exists and was generated from the same inputs
+    bool IsUpToDate(std::string const& output, std::string const& inputHash) const;
+    void Update(std::string const& output, std::string const& inputHash);
+
+    std::size_t GetSize() const;
+
+private:
+    std::string _path;
+    std::unordered_map<std::string, std::string> _entries;
+    FILE* _file;
+    mutable std::mutex _lock;
+};
+
+#endif
@@ -23,12 +23,153 @@
 #include <boost/filesystem/path.hpp>
 #include <algorithm>
 #include <array>
+#include <list>
+#include <optional>
+#include <shared_mutex>
 #include <stdexcept>
+#include <thread>
+#include <unordered_map>
 #include <cstdio>
 
 ArchiveSet gOpenArchives;
 
-MPQArchive::MPQArchive(char const* filename)
+namespace
+{
+// Where a file was found, archives are searched in priority order
+struct FileLocation
+{
+    std::size_t Archive;
+    uint32 FileNumber;
+    uint32 Blocks;
+    libmpq__off_t Size;
+};
+
+// Name lookups are cached including misses, most files are searched for many times (models, dbc lookups, existence checks)
+// and a miss has to go through the hash table of every archive
+class FileLocationCache
+{
+public:
+    std::optional<FileLocation> Find(char const* filename)
+    {
+        // libmpq hashes names case insensitively
+        std::string key = filename;
+        std::ranges::transform(key, key.begin(), charToUpper);
+
+        {
+            std::shared_lock<std::shared_mutex> lock(_lock);
+            auto itr = _locations.find(key);
+            if (itr != _locations.end())
+                return itr->second;
+        }
+
+        // hash and block tables of the archives are only read after opening them, lookups need no reader
+        std::optional<FileLocation> location;
+        for (std::size_t i = 0; i < gOpenArchives.size(); ++i)
+        {
+            mpq_archive_s* mpq_a = gOpenArchives[i].mpq_a;
+            if (!mpq_a)
+                continue;
+
+            uint32 fileNumber;
+            if (libmpq__file_number(mpq_a, filename, &fileNumber))
+                continue;
+
+            location.emplace();
+            location->Archive = i;
+            location->FileNumber = fileNumber;
+            libmpq__file_blocks(mpq_a, fileNumber, &location->Blocks);
+            libmpq__file_size_unpacked(mpq_a, fileNumber, &location->Size);
+            break;
+        }
+
+        std::unique_lock<std::shared_mutex> lock(_lock);
+        _locations.try_emplace(std::move(key), location);
+        return location;
+    }
+
+    void Clear()
+    {
+        std::unique_lock<std::shared_mutex> lock(_lock);
+        _locations.clear();
+    }
+
+private:
+    std::unordered_map<std::string, std::optional<FileLocation>> _locations;
+    std::shared_mutex _lock;
+};
+
+// Least recently used decompressed blocks. Several extractors read the same files (wmo roots for every tile they are
+// placed on, dbc files, models shared by vmap4 and gameobject extraction) and decompressing is most of the read time.
+class BlockCache
+{
+public:
+    using Block = std::shared_ptr<std::vector<uint8> const>;
+
+    explicit BlockCache(std::size_t capacity) : _capacity(capacity), _size(0) { }
+
+    Block Get(FileLocation const& location, uint32 block)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        auto itr = _blocks.find(MakeKey(location, block));
+        if (itr == _blocks.end())
+            return nullptr;
+
+        _order.splice(_order.begin(), _order, itr->second);
+        return itr->second->second;
+    }
+
+    void Add(FileLocation const& location, uint32 block, Block data)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        auto [itr, inserted] = _blocks.try_emplace(MakeKey(location, block));
+        if (!inserted)
+            return;
+
+        _size += data->size();
+        _order.emplace_front(itr->first, std::move(data));
+        itr->second = _order.begin();
+
+        while (_size > _capacity && _order.size() > 1)
+        {
+            _size -= _order.back().second->size();
+            _blocks.erase(_order.back().first);
+            _order.pop_back();
+        }
+    }
+
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _blocks.clear();
+        _order.clear();
+        _size = 0;
+    }
+
+private:
+    static uint64 MakeKey(FileLocation const& location, uint32 block)
+    {
+        return uint64(location.Archive) << 56 | uint64(location.FileNumber) << 28 | block;
+    }
+
+    std::list<std::pair<uint64, Block>> _order;
+    std::unordered_map<uint64, decltype(_order)::iterator> _blocks;
+    std::size_t _capacity;
+    std::size_t _size;
+    std::mutex _lock;
+};
+
+FileLocationCache FileLocations;
+BlockCache Blocks(64 * 1024 * 1024);
+
+// all blocks but the last one have the size of the archive blocks, the last one ends the file
+void CopyBlock(FileLocation const& location, uint32 block, std::vector<uint8> const& data, char* buffer)
+{
+    std::size_t offset = block + 1 < location.Blocks ? std::size_t(block) * data.size() : std::size_t(location.Size) - data.size();
+    memcpy(buffer + offset, data.data(), data.size());
+}
+}
+
+MPQArchive::MPQArchive(char const* filename) : _readers(std::make_unique<ReaderPool>())
 {
     int result = libmpq__archive_open(&mpq_a, filename, -1);
     printf("Opening %s\n", filename);
@@ -50,10 +191,38 @@ MPQArchive::MPQArchive(char const* filename)
             // success
             break;
     }
+
+    _readers->Path = filename;
+    _readers->Free.push_back(mpq_a);
+    _readers->Opened = 1;
+}
+
+MPQArchive::MPQArchive(MPQArchive&& other) noexcept : mpq_a(std::exchange(other.mpq_a, nullptr)), _readers(std::move(other._readers))
+{
+}
+
+MPQArchive& MPQArchive::operator=(MPQArchive&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        mpq_a = std::exchange(other.mpq_a, nullptr);
+        _readers = std::move(other._readers);
+    }
+    return *this;
 }
 
 void MPQArchive::close()
 {
+    if (_readers)
+    {
+        for (mpq_archive_s* reader : _readers->Free)
+            if (reader != mpq_a)
+                libmpq__archive_close(reader);
+
+        _readers.reset();
+    }
+
     if (mpq_a)
     {
         libmpq__archive_close(mpq_a);
@@ -61,40 +230,137 @@ void MPQArchive::close()
     }
 }
 
+mpq_archive_s* MPQArchive::AcquireReader()
+{
+    std::unique_lock<std::mutex> lock(_readers->Lock);
+    if (_readers->Free.empty() && _readers->Opened < std::max(std::thread::hardware_concurrency(), 1u))
+    {
+        ++_readers->Opened;
+        lock.unlock();
+
+        mpq_archive_s* reader = nullptr;
+        if (!libmpq__archive_open(&reader, _readers->Path.c_str(), -1))
+            return reader;
+
+        // out of file handles, wait for the ones that are open
+        lock.lock();
+        --_readers->Opened;
+    }
+
+    _readers->Released.wait(lock, [this] { return !_readers->Free.empty(); });
+    mpq_archive_s* reader = _readers->Free.back();
+    _readers->Free.pop_back();
+    return reader;
+}
+
+void MPQArchive::ReleaseReader(mpq_archive_s* reader)
+{
+    {
+        std::lock_guard<std::mutex> lock(_readers->Lock);
+        _readers->Free.push_back(reader);
+    }
+    _readers->Released.notify_one();
+}
+
+bool MPQArchive::ReadBlocks(uint32 fileNumber, std::span<uint32 const> blocks, std::vector<uint8>* outputs)
+{
+    if (!mpq_a)
+        return false;
+
+    mpq_archive_s* reader = AcquireReader();
+    bool success = !libmpq__block_open_offset(reader, fileNumber);
+    if (success)
+    {
+        for (std::size_t i = 0; i < blocks.size() && success; ++i)
+        {
+            libmpq__off_t size = 0, transferred = 0;
+            success = !libmpq__block_size_unpacked(reader, fileNumber, blocks[i], &size);
+            if (!success)
+                break;
+
+            outputs[i].resize(size);
+            success = !libmpq__block_read(reader, fileNumber, blocks[i], outputs[i].data(), size, &transferred) && transferred == size;
+        }
+
+        libmpq__block_close_offset(reader, fileNumber);
+    }
+
+    ReleaseReader(reader);
+    return success;
+}
+
+void MPQArchive::GetFileListTo(std::vector<std::string>& filelist)
+{
+    uint32_t filenum;
+    if(!mpq_a || libmpq__file_number(mpq_a, "(listfile)", &filenum)) return;
+    libmpq__off_t size, transferred;
+    libmpq__file_size_unpacked(mpq_a, filenum, &size);
+
+    std::string buffer(size, '\0');
+
+    mpq_archive_s* reader = AcquireReader();
+    libmpq__file_read(reader, filenum, reinterpret_cast<uint8*>(buffer.data()), size, &transferred);
+    ReleaseReader(reader);
+
+    for (std::string_view line : Trinity::Tokenize(buffer, '\n', false))
+    {
+        // lines end with \r\n
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+
+        filelist.emplace_back(line);
+    }
+}
+
 MPQFile::MPQFile(char const* filename):
     eof(false),
     buffer(nullptr),
     pointer(0),
     size(0)
 {
-    for (ArchiveSet::iterator i = gOpenArchives.begin(); i != gOpenArchives.end(); ++i)
+    std::optional<FileLocation> location = FileLocations.Find(filename);
+    if (!location)
     {
-        mpq_archive *mpq_a = i->mpq_a;
-        if (!mpq_a)
-            continue;
+        eof = true;
+        return;
+    }
 
-        uint32_t filenum;
-        if(libmpq__file_number(mpq_a, filename, &filenum)) continue;
-        libmpq__off_t transferred;
-        libmpq__file_size_unpacked(mpq_a, filenum, &size);
+    size = location->Size;
 
-        // HACK: in patch.mpq some files don't want to open and give 1 for filesize
-        if (size<=1) {
+    // HACK: in patch.mpq some files don't want to open and give 1 for filesize
+    if (size<=1) {
 //            printf("warning: file %s has size %d; cannot read.\n", filename, size);
-            eof = true;
-            buffer = 0;
-            return;
-        }
-        buffer = new char[size];
+        eof = true;
+        buffer = 0;
+        return;
+    }
+    buffer = new char[size];
 
-        //libmpq_file_getdata
-        libmpq__file_read(mpq_a, filenum, (unsigned char*)buffer, size, &transferred);
-        /*libmpq_file_getdata(&mpq_a, hash, fileno, (unsigned char*)buffer);*/
+    std::vector<uint32> missing;
+    for (uint32 block = 0; block < location->Blocks; ++block)
+    {
+        if (BlockCache::Block data = Blocks.Get(*location, block))
+            CopyBlock(*location, block, *data, buffer);
+        else
+            missing.push_back(block);
+    }
+
+    if (missing.empty())
         return;
 
+    std::vector<std::vector<uint8>> data(missing.size());
+    if (!gOpenArchives[location->Archive].ReadBlocks(location->FileNumber, missing, data.data()))
+    {
+        // damaged file, nothing of it is cached
+        memset(buffer, 0, size);
+        return;
+    }
+
+    for (std::size_t i = 0; i < missing.size(); ++i)
+    {
+        CopyBlock(*location, missing[i], data[i], buffer);
+        Blocks.Add(*location, missing[i], std::make_shared<std::vector<uint8> const>(std::move(data[i])));
     }
-    eof = true;
-    buffer = nullptr;
 }
 
 size_t MPQFile::read(void* dest, size_t bytes)
@@ -114,6 +380,23 @@ size_t MPQFile::read(void* dest, size_t bytes)
     return bytes;
 }
 
+std::span<char> MPQFile::readSpan(size_t bytes)
+{
+    if (eof) return {};
+
+    size_t rpos = pointer + bytes;
+    if (rpos > size_t(size)) {
+        bytes = size - pointer;
+        eof = true;
+    }
+
+    std::span<char> data(buffer + pointer, bytes);
+
+    pointer = rpos;
+
+    return data;
+}
+
 void MPQFile::seek(int offset)
 {
     pointer = offset;
@@ -226,6 +509,10 @@ bool OpenArchive(std::string_view inputPath, std::string_view localeName, Archiv
 
 bool OpenArchives(std::string_view inputPath, std::string_view localeName)
 {
+    // cached locations refer to archives by index
+    FileLocations.Clear();
+    Blocks.Clear();
+
     for (ArchiveData const& archive : Archives)
         if (!OpenArchive(inputPath, localeName, archive))
             if (archive.Required)
@@ -236,6 +523,8 @@ bool OpenArchives(std::string_view inputPath, std::string_view localeName)
 
 void CloseArchives()
 {
+    FileLocations.Clear();
+    Blocks.Clear();
     gOpenArchives.clear();
 }
 }
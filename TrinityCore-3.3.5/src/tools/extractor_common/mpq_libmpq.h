@@ -20,6 +20,10 @@
 
 #include "Define.h"
 #include <libmpq/mpq.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
 #include <utility>
 #include <vector>
@@ -32,39 +36,32 @@ public:
 
     MPQArchive(char const* filename);
     MPQArchive(MPQArchive const&) = delete;
-    MPQArchive(MPQArchive&& other) noexcept : mpq_a(std::exchange(other.mpq_a, nullptr)) { }
+    MPQArchive(MPQArchive&& other) noexcept;
     MPQArchive& operator=(MPQArchive const&) = delete;
-    MPQArchive& operator=(MPQArchive&& other) noexcept { if (this != &other) mpq_a = std::exchange(other.mpq_a, nullptr); return *this; }
+    MPQArchive& operator=(MPQArchive&& other) noexcept;
     ~MPQArchive() { close(); }
     void close();
 
-    void GetFileListTo(std::vector<std::string>& filelist) {
-        uint32_t filenum;
-        if(!mpq_a || libmpq__file_number(mpq_a, "(listfile)", &filenum)) return;
-        libmpq__off_t size, transferred;
-        libmpq__file_size_unpacked(mpq_a, filenum, &size);
+    // Decompresses blocks of a file into outputs, returns false if one of them can't be read. Several threads can read
+    // at once, each one takes its own handle of the archive because libmpq handles have a single read position.
+    bool ReadBlocks(uint32 fileNumber, std::span<uint32 const> blocks, std::vector<uint8>* outputs);
 
-        char *buffer = new char[size+1];
-        buffer[size] = '\0';
+    void GetFileListTo(std::vector<std::string>& filelist);
 
-        libmpq__file_read(mpq_a, filenum, (unsigned char*)buffer, size, &transferred);
+private:
+    struct ReaderPool
+    {
+        std::string Path;
+        std::mutex Lock;
+        std::condition_variable Released;
+        std::vector<mpq_archive_s*> Free;
+        std::size_t Opened = 0;
+    };
 
-        char seps[] = "\n";
-        char *token;
+    mpq_archive_s* AcquireReader();
+    void ReleaseReader(mpq_archive_s* reader);
 
-        token = strtok( buffer, seps );
-        uint32 counter = 0;
-        while ((token != nullptr) && (counter < size)) {
-            //cout << token << endl;
-            token[strlen(token) - 1] = 0;
-            std::string s = token;
-            filelist.push_back(s);
-            counter += strlen(token) + 2;
-            token = strtok(nullptr, seps);
-        }
-
-        delete[] buffer;
-    }
+    std::unique_ptr<ReaderPool> _readers;
 };
 typedef std::vector<MPQArchive> ArchiveSet;
 extern ArchiveSet gOpenArchives;
@@ -84,6 +81,8 @@ public:
     MPQFile(char const* filename);    // filenames are not case sensitive
     ~MPQFile() { close(); }
     size_t read(void* dest, size_t bytes);
+    // the next bytes without copying them, shorter at the end of the file
+    std::span<char> readSpan(size_t bytes);
     size_t getSize() { return size; }
     size_t getPos() { return pointer; }
     char* getBuffer() { return buffer; }
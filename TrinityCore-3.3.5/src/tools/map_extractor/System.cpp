@@ -17,6 +17,7 @@
 
 #include "dbcfile.h"
 #include "Banner.h"
+#include "ExtractionManifest.h"
 #include "Locales.h"
 #include "mpq_libmpq.h"
 #include "StringFormat.h"
@@ -27,9 +28,15 @@
 #include <boost/filesystem/directory.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/path.hpp>
+#include <algorithm>
+#include <atomic>
 #include <deque>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <thread>
 #include <unordered_map>
 #include <cstdio>
 #include <cstdlib>
@@ -78,6 +85,9 @@ float CONF_float_to_int16_limit = 2048.0f;   // Max accuracy = val/65536
 float CONF_flat_height_delta_limit = 0.005f; // If max - min less this value - surface is flat
 float CONF_flat_liquid_delta_limit = 0.001f; // If max - min less this value - liquid surface is flat
 
+// Number of threads converting adt files
+uint32 CONF_threads = std::max(1u, std::thread::hardware_concurrency());
+
 static constexpr std::array<std::string_view, 12> MpqLocaleNames = { "enGB", "enUS", "deDE", "esES", "frFR", "koKR", "zhCN", "zhTW", "enCN", "enTW", "esMX", "ruRU" };
 
 void CreateDir(boost::filesystem::path const& path)
@@ -99,6 +109,7 @@ void Usage(char* prg)
         "-o set output path (max %d characters)\n"\
         "-e extract only MAP(1)/DBC(2)/Camera(4) - standard: all(7)\n"\
         "-f height stored as int (less map size but lost some accuracy) 1 by default\n"\
+        "--threads number of threads converting map tiles, all cores by default\n"\
         "Example: %s -f 0 -i \"c:\\games\\game\"", prg, MAX_PATH_LENGTH - 1, MAX_PATH_LENGTH - 1, prg);
     exit(1);
 }
@@ -112,6 +123,7 @@ void HandleArgs(int argc, char * arg[])
         // e - extract only MAP(1)/DBC(2) - standard both(3)
         // f - use float to int conversion
         // h - limit minimum height
+        // --threads - number of threads converting adt files
         if(arg[c][0] != '-')
             Usage(arg[0]);
 
@@ -151,6 +163,12 @@ void HandleArgs(int argc, char * arg[])
                 else
                     Usage(arg[0]);
                 break;
+            case '-':
+                if (strcmp(arg[c], "--threads") == 0 && c + 1 < argc)
+                    CONF_threads = std::max(1, atoi(arg[(c++) + 1]));
+                else
+                    Usage(arg[0]);
+                break;
         }
     }
 }
@@ -324,32 +342,65 @@ float selectUInt16StepStore(float maxDiff)
 {
     return 65535 / maxDiff;
 }
-// Temporary grid data store
-uint16 area_ids[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
-
-float V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
-float V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
-uint16 uint16_V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
-uint16 uint16_V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
-uint8  uint8_V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
-uint8  uint8_V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
-
-uint16 liquid_entry[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
-uint8 liquid_flags[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
-bool  liquid_show[ADT_GRID_SIZE][ADT_GRID_SIZE];
-float liquid_height[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
-uint16 holes[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
-
-int16 flight_box_max[3][3];
-int16 flight_box_min[3][3];
-
-bool ConvertADT(std::string const& inputPath, std::string const& outputPath, int /*cell_y*/, int /*cell_x*/, uint32 build)
+// Temporary grid data store, each thread converting adt files has its own
+struct ADTConversionContext
+{
+    uint16 area_ids[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
+
+    float V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
+    float V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
+    uint16 uint16_V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
+    uint16 uint16_V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
+    uint8  uint8_V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
+    uint8  uint8_V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
+
+    uint16 liquid_entry[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
+    uint8 liquid_flags[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
+    bool  liquid_show[ADT_GRID_SIZE][ADT_GRID_SIZE];
+    float liquid_height[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
+    uint16 holes[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
+
+    int16 flight_box_max[3][3];
+    int16 flight_box_min[3][3];
+};
+
+struct ADTTile
+{
+    std::string InputPath;
+    std::string OutputPath;
+    int CellY;
+    int CellX;
+};
+
+bool ConvertADT(ADTConversionContext& context, ExtractionManifest& manifest, ExtractionInputHash const& optionsHash, std::string const& inputPath,
+    std::string const& outputPath, int /*cell_y*/, int /*cell_x*/, uint32 build)
 {
+    auto& area_ids = context.area_ids;
+    auto& V8 = context.V8;
+    auto& V9 = context.V9;
+    auto& uint16_V8 = context.uint16_V8;
+    auto& uint16_V9 = context.uint16_V9;
+    auto& uint8_V8 = context.uint8_V8;
+    auto& uint8_V9 = context.uint8_V9;
+    auto& liquid_entry = context.liquid_entry;
+    auto& liquid_flags = context.liquid_flags;
+    auto& liquid_show = context.liquid_show;
+    auto& liquid_height = context.liquid_height;
+    auto& holes = context.holes;
+    auto& flight_box_max = context.flight_box_max;
+    auto& flight_box_min = context.flight_box_min;
+
     ADT_file adt;
 
     if (!adt.loadFile(inputPath))
         return false;
 
+    ExtractionInputHash inputHash = optionsHash;
+    inputHash.UpdateData(adt.GetData(), adt.GetDataSize());
+    std::string inputHashStr = inputHash.Finalize();
+    if (manifest.IsUpToDate(outputPath, inputHashStr))
+        return true;
+
     adt_MCIN *cells = adt.a_grid->getMCIN();
     if (!cells)
     {
@@ -361,6 +412,9 @@ bool ConvertADT(std::string const& inputPath, std::string const& outputPath, int
     memset(liquid_flags, 0, sizeof(liquid_flags));
     memset(liquid_entry, 0, sizeof(liquid_entry));
 
+    // the row and column past the liquid bounds are stored too, don't let them depend on which tile was converted before
+    std::fill(&liquid_height[0][0], &liquid_height[0][0] + (ADT_GRID_SIZE + 1) * (ADT_GRID_SIZE + 1), CONF_use_minHeight);
+
     memset(holes, 0, sizeof(holes));
 
     // Prepare map header
@@ -902,13 +956,43 @@ bool ConvertADT(std::string const& inputPath, std::string const& outputPath, int
         outFile.write(reinterpret_cast<char const*>(holes), map.holesSize);
 
     outFile.close();
+    if (!outFile)
+        return false;
+
+    manifest.Update(outputPath, inputHashStr);
     return true;
 }
 
+// Threads take the next tile until all of them are converted, the calling thread converts too
+void ConvertADTs(std::vector<ADTTile> const& tiles, std::vector<std::unique_ptr<ADTConversionContext>> const& contexts, ExtractionManifest& manifest,
+    ExtractionInputHash const& optionsHash, uint32 build)
+{
+    std::atomic<std::size_t> nextTile(0);
+    std::size_t convertedTiles = 0;
+    std::mutex progressLock;
+    auto convert = [&](ADTConversionContext* context)
+    {
+        for (std::size_t i = nextTile++; i < tiles.size(); i = nextTile++)
+        {
+            ConvertADT(*context, manifest, optionsHash, tiles[i].InputPath, tiles[i].OutputPath, tiles[i].CellY, tiles[i].CellX, build);
+            // draw progress bar, counting and printing under the lock keeps the percentage from going back
+            std::lock_guard<std::mutex> lock(progressLock);
+            printf("Processing........................%d%%\r", int(100 * ++convertedTiles / tiles.size()));
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < std::min(contexts.size(), tiles.size()); ++i)
+        threads.emplace_back(convert, contexts[i].get());
+
+    convert(contexts[0].get());
+
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
 void ExtractMapsFromMpq(uint32 build)
 {
-    std::string mpqFileName;
-    std::string outputFileName;
     std::string mpqMapName;
 
     printf("Extracting maps...\n");
@@ -921,7 +1005,31 @@ void ExtractMapsFromMpq(uint32 build)
     path += "/maps/";
     CreateDir(path);
 
-    printf("Convert map files\n");
+    // tiles whose adt, client build, LiquidType.dbc and conversion options didn't change since the last run are kept
+    ExtractionManifest manifest(path + "extraction.manifest");
+    manifest.Open();
+
+    ExtractionInputHash optionsHash;
+    optionsHash.UpdateValue(MAP_VERSION_MAGIC);
+    optionsHash.UpdateValue(build);
+    optionsHash.UpdateValue(CONF_allow_height_limit);
+    optionsHash.UpdateValue(CONF_use_minHeight);
+    optionsHash.UpdateValue(CONF_allow_float_to_int);
+    optionsHash.UpdateValue(CONF_float_to_int8_limit);
+    optionsHash.UpdateValue(CONF_float_to_int16_limit);
+    optionsHash.UpdateValue(CONF_flat_height_delta_limit);
+    optionsHash.UpdateValue(CONF_flat_liquid_delta_limit);
+    for (auto const& [id, liquidType] : std::map<uint32, LiquidTypeEntry>(LiquidTypes.begin(), LiquidTypes.end()))
+    {
+        optionsHash.UpdateValue(id);
+        optionsHash.UpdateValue(liquidType.SoundBank);
+    }
+
+    std::vector<std::unique_ptr<ADTConversionContext>> contexts(CONF_threads);
+    for (std::unique_ptr<ADTConversionContext>& context : contexts)
+        context = std::make_unique<ADTConversionContext>();
+
+    printf("Convert map files using %u threads\n", CONF_threads);
     for(uint32 z = 0; z < map_count; ++z)
     {
         printf("Extract %s (%d/%u)                  \n", map_ids[z].name, z+1, map_count);
@@ -935,6 +1043,7 @@ void ExtractMapsFromMpq(uint32 build)
             continue;
         }
 
+        std::vector<ADTTile> tiles;
         for(uint32 y = 0; y < WDT_MAP_SIZE; ++y)
         {
             for(uint32 x = 0; x < WDT_MAP_SIZE; ++x)
@@ -942,14 +1051,15 @@ void ExtractMapsFromMpq(uint32 build)
                 if (!wdt.main->adt_list[y][x].exist)
                     continue;
 
-                mpqFileName = Trinity::StringFormat("World\\Maps\\{}\\{}_{}_{}.adt", map_ids[z].name, map_ids[z].name, x, y);
-                outputFileName = Trinity::StringFormat("{}/maps/{:03}{:02}{:02}.map", output_path, map_ids[z].id, y, x);
-                ConvertADT(mpqFileName, outputFileName, y, x, build);
+                tiles.push_back({ Trinity::StringFormat("World\\Maps\\{}\\{}_{}_{}.adt", map_ids[z].name, map_ids[z].name, x, y),
+                    Trinity::StringFormat("{}/maps/{:03}{:02}{:02}.map", output_path, map_ids[z].id, y, x), int(y), int(x) });
             }
-            // draw progress bar
-            printf("Processing........................%d%%\r", (100 * (y+1)) / WDT_MAP_SIZE);
         }
+
+        ConvertADTs(tiles, contexts, manifest, optionsHash, build);
     }
+
+    manifest.Close();
     printf("\n");
 }
 
@@ -27,6 +27,8 @@
 #include <DetourCommon.h>
 #include <DetourNavMesh.h>
 #include <DetourNavMeshBuilder.h>
+#include <RecastAlloc.h>
+#include <algorithm>
 #include <climits>
 #include <cmath>
 
@@ -38,18 +40,27 @@ namespace MMAP
         m_mapBuilder(mapBuilder),
         m_terrainBuilder(nullptr),
         m_workerThread(&TileBuilder::WorkerThread, this),
-        m_rcContext(nullptr)
+        m_rcContext(nullptr),
+        m_scratch(nullptr),
+        m_subTileBuilder(nullptr),
+        m_navMesh(nullptr),
+        m_navMeshParams()
     {
         m_terrainBuilder = new TerrainBuilder(skipLiquid);
-        m_rcContext = new rcContext(false);
+        m_rcContext = new TileBuildContext();
+        m_scratch = new TileScratch();
+        m_subTileBuilder = new SubTileBuilder(m_rcContext, m_scratch);
     }
 
     TileBuilder::~TileBuilder()
     {
         WaitCompletion();
 
+        dtFreeNavMesh(m_navMesh);
+        delete m_subTileBuilder;
         delete m_terrainBuilder;
         delete m_rcContext;
+        delete m_scratch;
     }
 
     void TileBuilder::WaitCompletion()
@@ -76,6 +87,14 @@ namespace MMAP
         m_totalTiles         (0u),
         m_totalTilesProcessed(0u),
         m_rcContext          (nullptr),
+        m_manifest           ("mmaps/extraction.manifest"),
+        m_tilesQueued        (0u),
+        m_tilesEstimated     (0u),
+        m_tilesScheduled     (0u),
+        m_tilesBuilt         (0u),
+        m_totalCost          (0u),
+        m_builtCost          (0u),
+        m_stageTimes         (),
         _cancelationToken    (false)
     {
         m_terrainBuilder = new TerrainBuilder(skipLiquid);
@@ -85,6 +104,18 @@ namespace MMAP
         // At least 1 thread is needed
         m_threads = std::max(1u, m_threads);
 
+        m_manifest.Open();
+
+        m_settingsHash.UpdateValue(MMAP_VERSION);
+        m_settingsHash.UpdateValue(uint32(DT_NAVMESH_VERSION));
+        m_settingsHash.UpdateValue(m_maxWalkableAngle.value_or(-1.0f));
+        m_settingsHash.UpdateValue(m_maxWalkableAngleNotSteep.value_or(-1.0f));
+        m_settingsHash.UpdateValue(m_skipLiquid);
+        m_settingsHash.UpdateValue(m_bigBaseUnit);
+        m_settingsHash.UpdateFile("dbc/LiquidType.dbc");
+
+        loadOffMeshInputs();
+        loadModelsDigest();
         discoverTiles();
     }
 
@@ -108,6 +139,80 @@ namespace MMAP
 
         delete m_terrainBuilder;
         delete m_rcContext;
+
+        m_manifest.Close();
+    }
+
+    /**************************************************************************/
+    void MapBuilder::loadOffMeshInputs()
+    {
+        if (!m_offMeshFilePath)
+            return;
+
+        FILE* fp = fopen(m_offMeshFilePath, "rb");
+        if (!fp)
+            return;
+
+        // same format TerrainBuilder::loadOffMeshConnections reads
+        char buf[512];
+        while (fgets(buf, sizeof(buf), fp))
+        {
+            float p0[3], p1[3];
+            uint32 mid, tx, ty;
+            float size;
+            if (sscanf(buf, "%u %u,%u (%f %f %f) (%f %f %f) %f", &mid, &tx, &ty,
+                &p0[0], &p0[1], &p0[2], &p1[0], &p1[1], &p1[2], &size) != 10)
+                continue;
+
+            m_offMeshInputs[(uint64(mid) << 32) | StaticMapTree::packTileID(tx, ty)] += buf;
+        }
+
+        fclose(fp);
+    }
+
+    /**************************************************************************/
+    void MapBuilder::loadModelsDigest()
+    {
+        // vmtrees and vmtiles only name the models they place, their geometry is in the .vmo files.
+        // spawns aren't read back to find the models of each tile, so a changed model rebuilds all tiles
+        std::vector<std::string> files;
+        getDirContents(files, "vmaps", "*.vmo");
+        std::sort(files.begin(), files.end());
+
+        ExtractionInputHash hash;
+        for (std::string const& file : files)
+        {
+            hash.UpdateData(file);
+            hash.UpdateFile("vmaps/" + file);
+        }
+
+        m_modelsDigest = hash.Finalize();
+    }
+
+    /**************************************************************************/
+    std::string MapBuilder::getTileInputHash(uint32 mapID, uint32 tileX, uint32 tileY, dtNavMeshParams const& navMeshParams) const
+    {
+        ExtractionInputHash hash = m_settingsHash;
+        hash.UpdateValue(mapID);
+        hash.UpdateValue(tileX);
+        hash.UpdateValue(tileY);
+
+        // tile positions are relative to the navmesh origin, which depends on the other tiles of the map
+        hash.UpdateValue(navMeshParams);
+
+        // the tile and the borders of its neighbours, same as TerrainBuilder::loadMap
+        static constexpr int Neighbours[][2] = { { 0, 0 }, { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+        for (auto const& [x, y] : Neighbours)
+            hash.UpdateFile(Trinity::StringFormat("maps/{:03}{:02}{:02}.map", mapID, int(tileY) + y, int(tileX) + x));
+
+        // model spawns and the geometry of every model
+        hash.UpdateFile(Trinity::StringFormat("vmaps/{:03}.vmtree", mapID));
+        hash.UpdateFile(Trinity::StringFormat("vmaps/{:03}_{:02}_{:02}.vmtile", mapID, tileX, tileY));
+        hash.UpdateData(m_modelsDigest);
+
+        auto offMesh = m_offMeshInputs.find((uint64(mapID) << 32) | StaticMapTree::packTileID(tileX, tileY));
+        hash.UpdateData(offMesh != m_offMeshInputs.end() ? std::string_view(offMesh->second) : std::string_view());
+        return hash.Finalize();
     }
 
     /**************************************************************************/
@@ -118,7 +223,7 @@ namespace MMAP
         char filter[12];
 
         printf("Discovering maps... ");
-        getDirContents(files, "maps");
+        getDirContents(files, "maps", "*.map");
         for (uint32 i = 0; i < files.size(); ++i)
         {
             mapID = uint32(atoi(files[i].substr(0,3).c_str()));
@@ -224,17 +329,33 @@ namespace MMAP
             if (m_mapBuilder->_cancelationToken)
                 return;
 
-            dtNavMesh* navMesh = dtAllocNavMesh();
-            if (!navMesh->init(&tileInfo.m_navMeshParams))
+            if (tileInfo.m_estimate)
             {
-                printf("[Map %03i] Failed creating navmesh for tile %i,%i !\n", tileInfo.m_mapId, tileInfo.m_tileX, tileInfo.m_tileY);
-                dtFreeNavMesh(navMesh);
-                return;
+                auto start = std::chrono::steady_clock::now();
+                bool build = estimateTile(tileInfo);
+                m_rcContext->addStageTime(TILE_STAGE_ESTIMATE, std::chrono::steady_clock::now() - start);
+                m_mapBuilder->onTileEstimated(std::move(tileInfo), build);
+                continue;
             }
 
-            buildTile(tileInfo.m_mapId, tileInfo.m_tileX, tileInfo.m_tileY, navMesh);
+            if (!m_navMesh || memcmp(&m_navMeshParams, &tileInfo.m_navMeshParams, sizeof(dtNavMeshParams)) != 0)
+            {
+                dtFreeNavMesh(m_navMesh);
+                m_navMesh = dtAllocNavMesh();
+                m_navMeshParams = tileInfo.m_navMeshParams;
+                if (!m_navMesh->init(&m_navMeshParams))
+                {
+                    printf("[Map %03i] Failed creating navmesh for tile %i,%i !\n", tileInfo.m_mapId, tileInfo.m_tileX, tileInfo.m_tileY);
+                    dtFreeNavMesh(m_navMesh);
+                    m_navMesh = nullptr;
+                    m_mapBuilder->onTileBuilt(tileInfo, *m_rcContext);
+                    continue;
+                }
+            }
 
-            dtFreeNavMesh(navMesh);
+            buildTile(tileInfo, m_navMesh);
+
+            m_mapBuilder->onTileBuilt(tileInfo, *m_rcContext);
         }
     }
 
@@ -242,6 +363,8 @@ namespace MMAP
     {
         printf("Using %u threads to generate mmaps\n", m_threads);
 
+        m_buildStart = std::chrono::steady_clock::now();
+
         for (unsigned int i = 0; i < m_threads; ++i)
         {
             m_tileBuilders.push_back(new TileBuilder(this, m_skipLiquid, m_bigBaseUnit, m_debugOutput));
@@ -261,9 +384,29 @@ namespace MMAP
             }
         }
 
-        while (!_queue.Empty())
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+            std::unique_lock<std::mutex> lock(m_progressLock);
+            m_progressCondition.wait(lock, [this] { return m_tilesEstimated == m_tilesQueued; });
+
+            // a few huge tiles started last would keep a single thread busy long after the others finished
+            std::stable_sort(m_tilesToBuild.begin(), m_tilesToBuild.end(), [](TileInfo const& left, TileInfo const& right)
+            {
+                return left.m_cost > right.m_cost;
+            });
+
+            printf("%u tiles are up to date or empty, building %u tiles\n", uint32(m_tilesQueued - m_tilesToBuild.size()), uint32(m_tilesToBuild.size()));
+
+            for (TileInfo& tileInfo : m_tilesToBuild)
+                _queue.Push(std::move(tileInfo));
+
+            m_tilesScheduled = uint32(m_tilesToBuild.size());
+            m_tilesToBuild.clear();
+
+            while (!m_progressCondition.wait_for(lock, std::chrono::seconds(30), [this] { return m_tilesBuilt == m_tilesScheduled; }))
+                printProgress();
+
+            printProgress();
+            printStageTimes();
         }
 
         _cancelationToken = true;
@@ -276,6 +419,85 @@ namespace MMAP
         m_tileBuilders.clear();
     }
 
+    /**************************************************************************/
+    void MapBuilder::onTileEstimated(TileInfo&& tileInfo, bool build)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_progressLock);
+            ++m_tilesEstimated;
+            if (build)
+            {
+                m_totalCost += tileInfo.m_cost;
+                m_tilesToBuild.push_back(std::move(tileInfo));
+            }
+            else
+                ++m_totalTilesProcessed;
+        }
+
+        m_progressCondition.notify_all();
+    }
+
+    void MapBuilder::onTileBuilt(TileInfo const& tileInfo, TileBuildContext& context)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_progressLock);
+            ++m_tilesBuilt;
+            m_builtCost += tileInfo.m_cost;
+            for (uint32 i = 0; i < MAX_TILE_STAGES; ++i)
+                m_stageTimes[i] += context.getStageTime(TileBuildStage(i));
+        }
+
+        context.resetTimers();
+        ++m_totalTilesProcessed;
+        m_progressCondition.notify_all();
+    }
+
+    uint32 MapBuilder::getSubTileThreads()
+    {
+        std::lock_guard<std::mutex> lock(m_progressLock);
+        // includes the tile asking, a single tile build has nothing scheduled
+        uint32 unfinished = std::max(m_tilesScheduled - m_tilesBuilt, 1u);
+        return std::max(m_threads / unfinished, 1u);
+    }
+
+    namespace
+    {
+        std::string FormatDuration(std::chrono::steady_clock::duration duration)
+        {
+            uint64 seconds = std::chrono::duration_cast<std::chrono::seconds>(duration).count();
+            return Trinity::StringFormat("{:02}:{:02}:{:02}", seconds / 3600, seconds % 3600 / 60, seconds % 60);
+        }
+    }
+
+    void MapBuilder::printProgress() const
+    {
+        // estimated by vertex count, the largest tiles are built first so this starts pessimistic
+        std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - m_buildStart;
+        std::string eta = "unknown";
+        if (m_builtCost)
+            eta = FormatDuration(std::chrono::duration_cast<std::chrono::steady_clock::duration>(elapsed * double(m_totalCost - m_builtCost) / double(m_builtCost)));
+
+        printf("[Progress] %u/%u tiles built (%u%%), elapsed %s, remaining %s\n", m_tilesBuilt, m_tilesScheduled,
+            m_totalCost ? uint32(m_builtCost * 100 / m_totalCost) : 100u, FormatDuration(elapsed).c_str(), eta.c_str());
+    }
+
+    void MapBuilder::printStageTimes() const
+    {
+        static constexpr char const* StageNames[MAX_TILE_STAGES] =
+        {
+            "estimate", "load", "rasterize", "filter", "regions", "contours", "polymesh", "detail", "write"
+        };
+
+        std::chrono::steady_clock::duration total = std::chrono::steady_clock::duration::zero();
+        for (std::chrono::steady_clock::duration time : m_stageTimes)
+            total += time;
+
+        printf("Time spent per stage, summed over all threads:\n");
+        for (uint32 i = 0; i < MAX_TILE_STAGES; ++i)
+            printf("  %-10s %s (%4.1f%%)\n", StageNames[i], FormatDuration(m_stageTimes[i]).c_str(),
+                total.count() ? 100.0 * m_stageTimes[i].count() / total.count() : 0.0);
+    }
+
     /**************************************************************************/
     void MapBuilder::getGridBounds(uint32 mapID, uint32 &minX, uint32 &minY, uint32 &maxX, uint32 &maxY) const
     {
@@ -407,6 +629,41 @@ namespace MMAP
         fclose(file);
     }
 
+    /**************************************************************************/
+    void MapBuilder::benchmarkTerrain(uint32 mapID)
+    {
+        std::set<uint32>* tiles = getTileList(mapID);
+        printf("[Map %03i] Loading the terrain of %u tiles\n", mapID, uint32(tiles->size()));
+
+        std::chrono::steady_clock::duration loadTime = std::chrono::steady_clock::duration::zero();
+        std::chrono::steady_clock::duration cleanTime = std::chrono::steady_clock::duration::zero();
+        uint64 loadedVerts = 0, cleanVerts = 0, triangles = 0;
+        for (uint32 packedTile : *tiles)
+        {
+            uint32 tileX, tileY;
+            StaticMapTree::unpackTileID(packedTile, tileX, tileY);
+
+            MeshData meshData;
+            auto start = std::chrono::steady_clock::now();
+            m_terrainBuilder->loadMap(mapID, tileX, tileY, meshData);
+            auto loaded = std::chrono::steady_clock::now();
+            loadedVerts += (meshData.solidVerts.size() + meshData.liquidVerts.size()) / 3;
+
+            TerrainBuilder::cleanVertices(meshData.solidVerts, meshData.solidTris);
+            TerrainBuilder::cleanVertices(meshData.liquidVerts, meshData.liquidTris);
+            auto cleaned = std::chrono::steady_clock::now();
+            cleanVerts += (meshData.solidVerts.size() + meshData.liquidVerts.size()) / 3;
+            triangles += (meshData.solidTris.size() + meshData.liquidTris.size()) / 3;
+
+            loadTime += loaded - start;
+            cleanTime += cleaned - loaded;
+        }
+
+        printf("[Map %03i] Terrain of %u tiles: load %.1f ms, clean %.1f ms, " UI64FMTD " vertices welded to " UI64FMTD ", " UI64FMTD " triangles\n",
+            mapID, uint32(tiles->size()), std::chrono::duration<double, std::milli>(loadTime).count(), std::chrono::duration<double, std::milli>(cleanTime).count(),
+            loadedVerts, cleanVerts, triangles);
+    }
+
     /**************************************************************************/
     void MapBuilder::buildSingleTile(uint32 mapID, uint32 tileX, uint32 tileY)
     {
@@ -420,8 +677,16 @@ namespace MMAP
 
         // ToDo: delete the old tile as the user clearly wants to rebuild it
 
+        TileInfo tileInfo;
+        tileInfo.m_mapId = mapID;
+        tileInfo.m_tileX = tileX;
+        tileInfo.m_tileY = tileY;
+        memcpy(&tileInfo.m_navMeshParams, navMesh->getParams(), sizeof(dtNavMeshParams));
+        tileInfo.m_inputHash = getTileInputHash(mapID, tileX, tileY, tileInfo.m_navMeshParams);
+
         TileBuilder tileBuilder = TileBuilder(this, m_skipLiquid, m_bigBaseUnit, m_debugOutput);
-        tileBuilder.buildTile(mapID, tileX, tileY, navMesh);
+        if (!tileBuilder.shouldSkipTile(mapID, tileX, tileY, tileInfo.m_inputHash))
+            tileBuilder.buildTile(tileInfo, navMesh);
         dtFreeNavMesh(navMesh);
 
         _cancelationToken = true;
@@ -446,7 +711,7 @@ namespace MMAP
                 return;
             }
 
-            // now start building mmtiles for each tile
+            // estimate every tile first, see buildMaps
             printf("[Map %03i] We have %u tiles.                          \n", mapID, (unsigned int)tiles->size());
             for (std::set<uint32>::iterator it = tiles->begin(); it != tiles->end(); ++it)
             {
@@ -460,7 +725,9 @@ namespace MMAP
                 tileInfo.m_tileX = tileX;
                 tileInfo.m_tileY = tileY;
                 memcpy(&tileInfo.m_navMeshParams, navMesh->getParams(), sizeof(dtNavMeshParams));
+                tileInfo.m_estimate = true;
                 _queue.Push(tileInfo);
+                ++m_tilesQueued;
             }
 
             dtFreeNavMesh(navMesh);
@@ -468,16 +735,35 @@ namespace MMAP
     }
 
     /**************************************************************************/
-    void TileBuilder::buildTile(uint32 mapID, uint32 tileX, uint32 tileY, dtNavMesh* navMesh)
+    bool TileBuilder::estimateTile(TileInfo& tileInfo)
     {
-        if(shouldSkipTile(mapID, tileX, tileY))
-        {
-            ++m_mapBuilder->m_totalTilesProcessed;
-            return;
-        }
+        tileInfo.m_inputHash = m_mapBuilder->getTileInputHash(tileInfo.m_mapId, tileInfo.m_tileX, tileInfo.m_tileY, tileInfo.m_navMeshParams);
+        if (shouldSkipTile(tileInfo.m_mapId, tileInfo.m_tileX, tileInfo.m_tileY, tileInfo.m_inputHash))
+            return false;
+
+        MeshData meshData;
+        m_terrainBuilder->loadMap(tileInfo.m_mapId, tileInfo.m_tileX, tileInfo.m_tileY, meshData);
+        m_terrainBuilder->loadVMap(tileInfo.m_mapId, tileInfo.m_tileY, tileInfo.m_tileX, meshData);
+
+        // Recast time grows with the geometry it rasterizes
+        tileInfo.m_cost = uint32(meshData.solidVerts.size() + meshData.liquidVerts.size()) / 3;
+        tileInfo.m_estimate = false;
+
+        // buildTile would give up on it
+        return tileInfo.m_cost != 0;
+    }
+
+    /**************************************************************************/
+    void TileBuilder::buildTile(TileInfo const& tileInfo, dtNavMesh* navMesh)
+    {
+        uint32 mapID = tileInfo.m_mapId;
+        uint32 tileX = tileInfo.m_tileX;
+        uint32 tileY = tileInfo.m_tileY;
 
         printf("%u%% [Map %03i] Building tile [%02u,%02u]\n", m_mapBuilder->currentPercentageDone(), mapID, tileX, tileY);
 
+        auto loadStart = std::chrono::steady_clock::now();
+
         MeshData meshData;
 
         // get heightmap data
@@ -488,10 +774,7 @@ namespace MMAP
 
         // if there is no data, give up now
         if (!meshData.solidVerts.size() && !meshData.liquidVerts.size())
-        {
-            ++m_mapBuilder->m_totalTilesProcessed;
             return;
-        }
 
         // remove unused vertices
         TerrainBuilder::cleanVertices(meshData.solidVerts, meshData.solidTris);
@@ -503,10 +786,7 @@ namespace MMAP
         allVerts.append(meshData.solidVerts);
 
         if (!allVerts.size())
-        {
-            ++m_mapBuilder->m_totalTilesProcessed;
             return;
-        }
 
         // get bounds of current tile
         float bmin[3], bmax[3];
@@ -514,10 +794,11 @@ namespace MMAP
 
         m_terrainBuilder->loadOffMeshConnections(mapID, tileX, tileY, meshData, m_mapBuilder->m_offMeshFilePath);
 
-        // build navmesh tile
-        buildMoveMapTile(mapID, tileX, tileY, meshData, bmin, bmax, navMesh);
+        m_rcContext->addStageTime(TILE_STAGE_LOAD, std::chrono::steady_clock::now() - loadStart);
 
-        ++m_mapBuilder->m_totalTilesProcessed;
+        // build navmesh tile
+        if (buildMoveMapTile(mapID, tileX, tileY, meshData, bmin, bmax, navMesh))
+            m_mapBuilder->m_manifest.Update(Trinity::StringFormat("mmaps/{:03}{:02}{:02}.mmtile", mapID, tileY, tileX), tileInfo.m_inputHash);
     }
 
     /**************************************************************************/
@@ -596,7 +877,7 @@ namespace MMAP
     }
 
     /**************************************************************************/
-    void TileBuilder::buildMoveMapTile(uint32 mapID, uint32 tileX, uint32 tileY,
+    bool TileBuilder::buildMoveMapTile(uint32 mapID, uint32 tileX, uint32 tileY,
         MeshData &meshData, float bmin[3], float bmax[3],
         dtNavMesh* navMesh)
     {
@@ -629,132 +910,52 @@ namespace MMAP
         // allocate subregions : tiles
         Tile* tiles = new Tile[TILES_PER_MAP * TILES_PER_MAP];
 
-        // Initialize per tile config.
-        rcConfig tileCfg = config;
-        tileCfg.width = config.tileSize + config.borderSize*2;
-        tileCfg.height = config.tileSize + config.borderSize*2;
-
         // merge per tile poly and detail meshes
         rcPolyMesh** pmmerge = new rcPolyMesh*[TILES_PER_MAP * TILES_PER_MAP];
         rcPolyMeshDetail** dmmerge = new rcPolyMeshDetail*[TILES_PER_MAP * TILES_PER_MAP];
         int nmerge = 0;
-        // build all tiles
-        for (int y = 0; y < TILES_PER_MAP; ++y)
-        {
-            for (int x = 0; x < TILES_PER_MAP; ++x)
-            {
-                Tile& tile = tiles[x + y * TILES_PER_MAP];
-
-                // Calculate the per tile bounding box.
-                tileCfg.bmin[0] = config.bmin[0] + x * float(config.tileSize * config.cs);
-                tileCfg.bmin[2] = config.bmin[2] + y * float(config.tileSize * config.cs);
-                tileCfg.bmax[0] = config.bmin[0] + (x + 1) * float(config.tileSize * config.cs);
-                tileCfg.bmax[2] = config.bmin[2] + (y + 1) * float(config.tileSize * config.cs);
-
-                tileCfg.bmin[0] -= tileCfg.borderSize * tileCfg.cs;
-                tileCfg.bmin[2] -= tileCfg.borderSize * tileCfg.cs;
-                tileCfg.bmax[0] += tileCfg.borderSize * tileCfg.cs;
-                tileCfg.bmax[2] += tileCfg.borderSize * tileCfg.cs;
-
-                // build heightfield
-                tile.solid = rcAllocHeightfield();
-                if (!tile.solid || !rcCreateHeightfield(m_rcContext, *tile.solid, tileCfg.width, tileCfg.height, tileCfg.bmin, tileCfg.bmax, tileCfg.cs, tileCfg.ch))
-                {
-                    printf("%s Failed building heightfield!            \n", tileString);
-                    continue;
-                }
-
-                // mark all walkable tiles, both liquids and solids
-
-                /* we want to have triangles with slope less than walkableSlopeAngleNotSteep (<= 55) to have NAV_AREA_GROUND
-                 * and with slope between walkableSlopeAngleNotSteep and walkableSlopeAngle (55 < .. <= 70) to have NAV_AREA_GROUND_STEEP.
-                 * we achieve this using recast API: memset everything to NAV_AREA_GROUND_STEEP, call rcClearUnwalkableTriangles with 70 so
-                 * any area above that will get RC_NULL_AREA (unwalkable), then call rcMarkWalkableTriangles with 55 to set NAV_AREA_GROUND
-                 * on anything below 55 . Players and idle Creatures can use NAV_AREA_GROUND, while Creatures in combat can use NAV_AREA_GROUND_STEEP.
-                 */
-                unsigned char* triFlags = new unsigned char[tTriCount];
-                memset(triFlags, NAV_AREA_GROUND_STEEP, tTriCount*sizeof(unsigned char));
-                rcClearUnwalkableTriangles(m_rcContext, tileCfg.walkableSlopeAngle, tVerts, tVertCount, tTris, tTriCount, triFlags);
-                rcMarkWalkableTriangles(m_rcContext, tileCfg.walkableSlopeAngleNotSteep, tVerts, tVertCount, tTris, tTriCount, triFlags, NAV_AREA_GROUND);
-                rcRasterizeTriangles(m_rcContext, tVerts, tVertCount, tTris, triFlags, tTriCount, *tile.solid, config.walkableClimb);
-                delete[] triFlags;
-
-                rcFilterLowHangingWalkableObstacles(m_rcContext, config.walkableClimb, *tile.solid);
-                rcFilterLedgeSpans(m_rcContext, tileCfg.walkableHeight, tileCfg.walkableClimb, *tile.solid);
-                rcFilterWalkableLowHeightSpans(m_rcContext, tileCfg.walkableHeight, *tile.solid);
-
-                // add liquid triangles
-                rcRasterizeTriangles(m_rcContext, lVerts, lVertCount, lTris, lTriFlags, lTriCount, *tile.solid, config.walkableClimb);
-
-                // compact heightfield spans
-                tile.chf = rcAllocCompactHeightfield();
-                if (!tile.chf || !rcBuildCompactHeightfield(m_rcContext, tileCfg.walkableHeight, tileCfg.walkableClimb, *tile.solid, *tile.chf))
-                {
-                    printf("%s Failed compacting heightfield!            \n", tileString);
-                    continue;
-                }
-
-                // build polymesh intermediates
-                if (!rcErodeWalkableArea(m_rcContext, config.walkableRadius, *tile.chf))
-                {
-                    printf("%s Failed eroding area!                    \n", tileString);
-                    continue;
-                }
-
-                if (!rcMedianFilterWalkableArea(m_rcContext, *tile.chf))
-                {
-                    printf("%s Failed filtering area!                  \n", tileString);
-                    continue;
-                }
 
-                if (!rcBuildDistanceField(m_rcContext, *tile.chf))
-                {
-                    printf("%s Failed building distance field!         \n", tileString);
-                    continue;
-                }
-
-                if (!rcBuildRegions(m_rcContext, *tile.chf, tileCfg.borderSize, tileCfg.minRegionArea, tileCfg.mergeRegionArea))
-                {
-                    printf("%s Failed building regions!                \n", tileString);
-                    continue;
-                }
-
-                tile.cset = rcAllocContourSet();
-                if (!tile.cset || !rcBuildContours(m_rcContext, *tile.chf, tileCfg.maxSimplificationError, tileCfg.maxEdgeLen, *tile.cset))
-                {
-                    printf("%s Failed building contours!               \n", tileString);
-                    continue;
-                }
+        // mark all walkable tiles, both liquids and solids
+
+        /* we want to have triangles with slope less than walkableSlopeAngleNotSteep (<= 55) to have NAV_AREA_GROUND
+         * and with slope between walkableSlopeAngleNotSteep and walkableSlopeAngle (55 < .. <= 70) to have NAV_AREA_GROUND_STEEP.
+         * we achieve this using recast API: memset everything to NAV_AREA_GROUND_STEEP, call rcClearUnwalkableTriangles with 70 so
+         * any area above that will get RC_NULL_AREA (unwalkable), then call rcMarkWalkableTriangles with 55 to set NAV_AREA_GROUND
+         * on anything below 55 . Players and idle Creatures can use NAV_AREA_GROUND, while Creatures in combat can use NAV_AREA_GROUND_STEEP.
+         */
+        unsigned char* triFlags = new unsigned char[tTriCount];
+        memset(triFlags, NAV_AREA_GROUND_STEEP, tTriCount*sizeof(unsigned char));
+        rcClearUnwalkableTriangles(m_rcContext, config.walkableSlopeAngle, tVerts, tVertCount, tTris, tTriCount, triFlags);
+        rcMarkWalkableTriangles(m_rcContext, config.walkableSlopeAngleNotSteep, tVerts, tVertCount, tTris, tTriCount, triFlags, NAV_AREA_GROUND);
+
+        SubTileInput subTileInput;
+        subTileInput.config = config;
+        subTileInput.tilesPerMap = TILES_PER_MAP;
+        subTileInput.solidVerts = tVerts;
+        subTileInput.solidVertCount = tVertCount;
+        subTileInput.solidTris = tTris;
+        subTileInput.solidTriCount = tTriCount;
+        subTileInput.solidTriAreas = triFlags;
+        subTileInput.liquidVerts = lVerts;
+        subTileInput.liquidVertCount = lVertCount;
+        subTileInput.liquidTris = lTris;
+        subTileInput.liquidTriCount = lTriCount;
+        subTileInput.liquidTriAreas = lTriFlags;
+        subTileInput.tileString = tileString;
 
-                // build polymesh
-                tile.pmesh = rcAllocPolyMesh();
-                if (!tile.pmesh || !rcBuildPolyMesh(m_rcContext, *tile.cset, tileCfg.maxVertsPerPoly, *tile.pmesh))
-                {
-                    printf("%s Failed building polymesh!               \n", tileString);
-                    continue;
-                }
+        // build all tiles
+        m_subTileBuilder->build(subTileInput, tiles, m_mapBuilder->getSubTileThreads());
+        delete[] triFlags;
 
-                tile.dmesh = rcAllocPolyMeshDetail();
-                if (!tile.dmesh || !rcBuildPolyMeshDetail(m_rcContext, *tile.pmesh, *tile.chf, tileCfg.detailSampleDist, tileCfg.detailSampleMaxError, *tile.dmesh))
-                {
-                    printf("%s Failed building polymesh detail!        \n", tileString);
-                    continue;
-                }
+        // merged in the same order no matter which thread built them
+        for (int i = 0; i < TILES_PER_MAP * TILES_PER_MAP; ++i)
+        {
+            if (!tiles[i].dmesh)
+                continue;
 
-                // free those up
-                // we may want to keep them in the future for debug
-                // but right now, we don't have the code to merge them
-                rcFreeHeightField(tile.solid);
-                tile.solid = nullptr;
-                rcFreeCompactHeightfield(tile.chf);
-                tile.chf = nullptr;
-                rcFreeContourSet(tile.cset);
-                tile.cset = nullptr;
-
-                pmmerge[nmerge] = tile.pmesh;
-                dmmerge[nmerge] = tile.dmesh;
-                nmerge++;
-            }
+            pmmerge[nmerge] = tiles[i].pmesh;
+            dmmerge[nmerge] = tiles[i].dmesh;
+            nmerge++;
         }
 
         iv.polyMesh = rcAllocPolyMesh();
@@ -764,7 +965,7 @@ namespace MMAP
             delete[] pmmerge;
             delete[] dmmerge;
             delete[] tiles;
-            return;
+            return false;
         }
         rcMergePolyMeshes(m_rcContext, pmmerge, nmerge, *iv.polyMesh);
 
@@ -775,7 +976,7 @@ namespace MMAP
             delete[] pmmerge;
             delete[] dmmerge;
             delete[] tiles;
-            return;
+            return false;
         }
         rcMergePolyMeshDetails(m_rcContext, dmmerge, nmerge, *iv.polyMeshDetail);
 
@@ -834,9 +1035,12 @@ namespace MMAP
         params.tileLayer = 0;
         params.buildBvTree = true;
 
+        auto writeStart = std::chrono::steady_clock::now();
+
         // will hold final navmesh
         unsigned char* navData = nullptr;
         int navDataSize = 0;
+        bool written = false;
 
         do
         {
@@ -920,13 +1124,15 @@ namespace MMAP
 
             // write data
             fwrite(navData, sizeof(unsigned char), navDataSize, file);
-            fclose(file);
+            written = fclose(file) == 0;
 
             // now that tile is written to disk, we can unload it
             navMesh->removeTile(tileRef, nullptr, nullptr);
         }
         while (false);
 
+        m_rcContext->addStageTime(TILE_STAGE_WRITE, std::chrono::steady_clock::now() - writeStart);
+
         if (m_debugOutput)
         {
             // restore padding so that the debug visualization is correct
@@ -940,6 +1146,8 @@ namespace MMAP
             iv.generateObjFile(mapID, tileX, tileY, meshData);
             iv.writeIV(mapID, tileX, tileY);
         }
+
+        return written;
     }
 
     /**************************************************************************/
@@ -1064,11 +1272,10 @@ namespace MMAP
     }
 
     /**************************************************************************/
-    bool TileBuilder::shouldSkipTile(uint32 mapID, uint32 tileX, uint32 tileY) const
+    bool TileBuilder::shouldSkipTile(uint32 mapID, uint32 tileX, uint32 tileY, std::string const& inputHash) const
     {
-        char fileName[255];
-        sprintf(fileName, "mmaps/%03u%02i%02i.mmtile", mapID, tileY, tileX);
-        FILE* file = fopen(fileName, "rb");
+        std::string fileName = Trinity::StringFormat("mmaps/{:03}{:02}{:02}.mmtile", mapID, tileY, tileX);
+        FILE* file = fopen(fileName.c_str(), "rb");
         if (!file)
             return false;
 
@@ -1084,7 +1291,8 @@ namespace MMAP
         if (header.mmapVersion != MMAP_VERSION)
             return false;
 
-        return true;
+        // rebuild tiles whose terrain, models or offmesh connections changed since they were written
+        return m_mapBuilder->m_manifest.IsUpToDate(fileName, inputHash);
     }
 
     rcConfig MapBuilder::GetMapSpecificConfig(uint32 mapID, float bmin[3], float bmax[3], const TileConfig &tileConfig) const
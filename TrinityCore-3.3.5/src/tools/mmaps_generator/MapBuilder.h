@@ -19,7 +19,9 @@
 #define _MAP_BUILDER_H
 
 #include "TerrainBuilder.h"
+#include "SubTileBuilder.h"
 
+#include "ExtractionManifest.h"
 #include "Recast.h"
 #include "DetourNavMesh.h"
 #include "Optional.h"
@@ -28,8 +30,14 @@
 #include <vector>
 #include <set>
 #include <list>
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
 #include <thread>
+#include <unordered_map>
 
 using namespace VMAP;
 
@@ -53,24 +61,6 @@ namespace MMAP
 
     typedef std::list<MapTiles> TileList;
 
-    struct Tile
-    {
-        Tile() : chf(nullptr), solid(nullptr), cset(nullptr), pmesh(nullptr), dmesh(nullptr) {}
-        ~Tile()
-        {
-            rcFreeCompactHeightfield(chf);
-            rcFreeContourSet(cset);
-            rcFreeHeightField(solid);
-            rcFreePolyMesh(pmesh);
-            rcFreePolyMeshDetail(dmesh);
-        }
-        rcCompactHeightfield* chf;
-        rcHeightfield* solid;
-        rcContourSet* cset;
-        rcPolyMesh* pmesh;
-        rcPolyMeshDetail* dmesh;
-    };
-
     struct TileConfig
     {
         TileConfig(bool bigBaseUnit)
@@ -94,12 +84,17 @@ namespace MMAP
 
     struct TileInfo
     {
-        TileInfo() : m_mapId(uint32(-1)), m_tileX(), m_tileY(), m_navMeshParams() {}
+        TileInfo() : m_mapId(uint32(-1)), m_tileX(), m_tileY(), m_navMeshParams(), m_cost(), m_estimate() {}
 
         uint32 m_mapId;
         uint32 m_tileX;
         uint32 m_tileY;
         dtNavMeshParams m_navMeshParams;
+        std::string m_inputHash;
+        // vertex count of the tile, the largest tiles are built first
+        uint32 m_cost;
+        // only estimate the cost, tiles are queued again once all of them are estimated
+        bool m_estimate;
     };
 
     // ToDo: move this to its own file. For now it will stay here to keep the changes to a minimum, especially in the cpp file
@@ -118,9 +113,11 @@ namespace MMAP
             void WorkerThread();
             void WaitCompletion();
 
-            void buildTile(uint32 mapID, uint32 tileX, uint32 tileY, dtNavMesh* navMesh);
-            // move map building
-            void buildMoveMapTile(uint32 mapID,
+            // computes the input hash and cost of the tile, returns false when it doesn't need to be built
+            bool estimateTile(TileInfo& tileInfo);
+            void buildTile(TileInfo const& tileInfo, dtNavMesh* navMesh);
+            // move map building, returns true when the tile was written
+            bool buildMoveMapTile(uint32 mapID,
                 uint32 tileX,
                 uint32 tileY,
                 MeshData& meshData,
@@ -128,7 +125,7 @@ namespace MMAP
                 float bmax[3],
                 dtNavMesh* navMesh);
 
-            bool shouldSkipTile(uint32 mapID, uint32 tileX, uint32 tileY) const;
+            bool shouldSkipTile(uint32 mapID, uint32 tileX, uint32 tileY, std::string const& inputHash) const;
 
         private:
             bool m_bigBaseUnit;
@@ -137,8 +134,13 @@ namespace MMAP
             MapBuilder* m_mapBuilder;
             TerrainBuilder* m_terrainBuilder;
             std::thread m_workerThread;
-            // build performance - not really used for now
-            rcContext* m_rcContext;
+            TileBuildContext* m_rcContext;
+            TileScratch* m_scratch;
+            SubTileBuilder* m_subTileBuilder;
+
+            // the tile is removed again once written, the navmesh is only created again for the next map
+            dtNavMesh* m_navMesh;
+            dtNavMeshParams m_navMeshParams;
     };
 
     class MapBuilder
@@ -168,15 +170,31 @@ namespace MMAP
             // builds list of maps, then builds all of mmap tiles (based on the skip settings)
             void buildMaps(Optional<uint32> mapID);
 
+            // times loading and cleaning the terrain of every tile of the map, nothing is built
+            void benchmarkTerrain(uint32 mapID);
+
         private:
-            // builds all mmap tiles for the specified map id (ignores skip settings)
+            // queues the cost estimate of all mmap tiles for the specified map id (ignores skip settings)
             void buildMap(uint32 mapID);
+            void onTileEstimated(TileInfo&& tileInfo, bool build);
+            void onTileBuilt(TileInfo const& tileInfo, TileBuildContext& context);
+            void printProgress() const;
+            void printStageTimes() const;
+            // threads a tile can spread its sub tiles over, all of them once fewer tiles than threads are left
+            uint32 getSubTileThreads();
             // detect maps and tiles
             void discoverTiles();
             std::set<uint32>* getTileList(uint32 mapID);
 
             void buildNavMesh(uint32 mapID, dtNavMesh* &navMesh);
 
+            // keeps the offmesh connections of every tile, a changed connection only rebuilds its own tile
+            void loadOffMeshInputs();
+            // digest of all .vmo model files in vmaps
+            void loadModelsDigest();
+            // hash of the .map files of the tile and its neighbours, its vmaps, offmesh connections and the build settings
+            std::string getTileInputHash(uint32 mapID, uint32 tileX, uint32 tileY, dtNavMeshParams const& navMeshParams) const;
+
             void getTileBounds(uint32 tileX, uint32 tileY,
                 float* verts, int vertCount,
                 float* bmin, float* bmax) const;
@@ -215,6 +233,24 @@ namespace MMAP
             // build performance - not really used for now
             rcContext* m_rcContext;
 
+            ExtractionManifest m_manifest;
+            ExtractionInputHash m_settingsHash;
+            std::unordered_map<uint64, std::string> m_offMeshInputs;
+            std::string m_modelsDigest;
+
+            // scheduling and progress of buildMaps
+            std::mutex m_progressLock;
+            std::condition_variable m_progressCondition;
+            uint32 m_tilesQueued;
+            uint32 m_tilesEstimated;
+            uint32 m_tilesScheduled;
+            uint32 m_tilesBuilt;
+            uint64 m_totalCost;
+            uint64 m_builtCost;
+            std::vector<TileInfo> m_tilesToBuild;
+            std::chrono::steady_clock::time_point m_buildStart;
+            std::array<std::chrono::steady_clock::duration, MAX_TILE_STAGES> m_stageTimes;
+
             std::vector<TileBuilder*> m_tileBuilders;
             ProducerConsumerQueue<TileInfo> _queue;
             std::atomic<bool> _cancelationToken;
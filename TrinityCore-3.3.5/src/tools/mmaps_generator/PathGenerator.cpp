@@ -99,7 +99,8 @@ bool handleArgs(int argc, char** argv,
                bool &bigBaseUnit,
                char* &offMeshInputPath,
                char* &file,
-               unsigned int& threads)
+               unsigned int& threads,
+               bool& benchmarkTerrain)
 {
     char* param = nullptr;
     [[maybe_unused]] bool allowDebug = false;
@@ -259,6 +260,10 @@ bool handleArgs(int argc, char** argv,
         {
             allowDebug = true;
         }
+        else if (strcmp(argv[i], "--benchmarkTerrain") == 0)
+        {
+            benchmarkTerrain = true;
+        }
         else if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-?"))
         {
             printf("%s\n", Readme);
@@ -325,14 +330,15 @@ int main(int argc, char** argv)
          skipBattlegrounds = false,
          debugOutput = false,
          silent = false,
-         bigBaseUnit = false;
+         bigBaseUnit = false,
+         benchmarkTerrain = false;
     char* offMeshInputPath = nullptr;
     char* file = nullptr;
 
     bool validParam = handleArgs(argc, argv, mapnum,
                                  tileX, tileY, maxAngle, maxAngleNotSteep,
                                  skipLiquid, skipContinents, skipJunkMaps, skipBattlegrounds,
-                                 debugOutput, silent, bigBaseUnit, offMeshInputPath, file, threads);
+                                 debugOutput, silent, bigBaseUnit, offMeshInputPath, file, threads, benchmarkTerrain);
 
     if (!validParam)
         return silent ? -1 : finish("You have specified invalid parameters", -1);
@@ -360,7 +366,13 @@ int main(int argc, char** argv)
                        skipBattlegrounds, debugOutput, bigBaseUnit, mapnum, offMeshInputPath, threads);
 
     uint32 start = getMSTime();
-    if (file)
+    if (benchmarkTerrain)
+    {
+        if (mapnum < 0)
+            return silent ? -1 : finish("--benchmarkTerrain needs a map id", -1);
+        builder.benchmarkTerrain(uint32(mapnum));
+    }
+    else if (file)
         builder.buildMeshFromFile(file);
     else if (tileX > -1 && tileY > -1 && mapnum >= 0)
         builder.buildSingleTile(mapnum, tileX, tileY);
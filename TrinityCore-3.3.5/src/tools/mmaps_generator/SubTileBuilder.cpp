@@ -0,0 +1,285 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SubTileBuilder.h"
+#include "Optional.h"
+#include <RecastAlloc.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+namespace MMAP
+{
+    /**************************************************************************/
+    bool TileScratch::resetHeightfield(rcContext* context, int width, int height, float const* bmin, float const* bmax, float cs, float ch)
+    {
+        if (solid.spans && solid.width == width && solid.height == height)
+        {
+            memset(solid.spans, 0, sizeof(rcSpan*) * width * height);
+            rcVcopy(solid.bmin, bmin);
+            rcVcopy(solid.bmax, bmax);
+            solid.cs = cs;
+            solid.ch = ch;
+        }
+        else
+        {
+            rcFree(solid.spans);
+            solid.spans = nullptr;
+            if (!rcCreateHeightfield(context, solid, width, height, bmin, bmax, cs, ch))
+                return false;
+        }
+
+        // all spans of the previous sub tile are free again
+        solid.freelist = nullptr;
+        for (rcSpanPool* pool = solid.pools; pool; pool = pool->next)
+        {
+            for (int i = RC_SPANS_PER_POOL - 1; i >= 0; --i)
+            {
+                pool->items[i].next = solid.freelist;
+                solid.freelist = &pool->items[i];
+            }
+        }
+
+        return true;
+    }
+
+    void TileScratch::resetCompactHeightfield()
+    {
+        rcFree(chf.cells);
+        rcFree(chf.spans);
+        rcFree(chf.dist);
+        rcFree(chf.areas);
+        chf.cells = nullptr;
+        chf.spans = nullptr;
+        chf.dist = nullptr;
+        chf.areas = nullptr;
+    }
+
+    /**************************************************************************/
+    namespace
+    {
+        // nested timers are left out, their time is already part of the label containing them
+        Optional<TileBuildStage> GetTimerStage(rcTimerLabel label)
+        {
+            switch (label)
+            {
+                case RC_TIMER_RASTERIZE_TRIANGLES:
+                    return TILE_STAGE_RASTERIZE;
+                case RC_TIMER_FILTER_LOW_OBSTACLES:
+                case RC_TIMER_FILTER_BORDER:
+                case RC_TIMER_FILTER_WALKABLE:
+                case RC_TIMER_BUILD_COMPACTHEIGHTFIELD:
+                case RC_TIMER_ERODE_AREA:
+                case RC_TIMER_MEDIAN_AREA:
+                    return TILE_STAGE_FILTER;
+                case RC_TIMER_BUILD_DISTANCEFIELD:
+                case RC_TIMER_BUILD_REGIONS:
+                    return TILE_STAGE_REGIONS;
+                case RC_TIMER_BUILD_CONTOURS:
+                    return TILE_STAGE_CONTOURS;
+                case RC_TIMER_BUILD_POLYMESH:
+                case RC_TIMER_MERGE_POLYMESH:
+                    return TILE_STAGE_POLYMESH;
+                case RC_TIMER_BUILD_POLYMESHDETAIL:
+                case RC_TIMER_MERGE_POLYMESHDETAIL:
+                    return TILE_STAGE_DETAIL;
+                default:
+                    return {};
+            }
+        }
+    }
+
+    void TileBuildContext::doResetTimers()
+    {
+        m_labelTimes.fill(std::chrono::steady_clock::duration::zero());
+        m_stageTimes.fill(std::chrono::steady_clock::duration::zero());
+    }
+
+    void TileBuildContext::doStartTimer(rcTimerLabel const label)
+    {
+        m_startTimes[label] = std::chrono::steady_clock::now();
+    }
+
+    void TileBuildContext::doStopTimer(rcTimerLabel const label)
+    {
+        std::chrono::steady_clock::duration time = std::chrono::steady_clock::now() - m_startTimes[label];
+        m_labelTimes[label] += time;
+        if (Optional<TileBuildStage> stage = GetTimerStage(label))
+            m_stageTimes[*stage] += time;
+    }
+
+    int TileBuildContext::doGetAccumulatedTime(rcTimerLabel const label) const
+    {
+        return int(std::chrono::duration_cast<std::chrono::microseconds>(m_labelTimes[label]).count());
+    }
+
+    /**************************************************************************/
+    bool buildSubTile(SubTileInput const& input, int x, int y, TileBuildContext& context, TileScratch& scratch, Tile& tile)
+    {
+        rcConfig const& config = input.config;
+        char const* tileString = input.tileString;
+
+        // Initialize per tile config.
+        rcConfig tileCfg = config;
+        tileCfg.width = config.tileSize + config.borderSize*2;
+        tileCfg.height = config.tileSize + config.borderSize*2;
+
+        // Calculate the per tile bounding box.
+        tileCfg.bmin[0] = config.bmin[0] + x * float(config.tileSize * config.cs);
+        tileCfg.bmin[2] = config.bmin[2] + y * float(config.tileSize * config.cs);
+        tileCfg.bmax[0] = config.bmin[0] + (x + 1) * float(config.tileSize * config.cs);
+        tileCfg.bmax[2] = config.bmin[2] + (y + 1) * float(config.tileSize * config.cs);
+
+        tileCfg.bmin[0] -= tileCfg.borderSize * tileCfg.cs;
+        tileCfg.bmin[2] -= tileCfg.borderSize * tileCfg.cs;
+        tileCfg.bmax[0] += tileCfg.borderSize * tileCfg.cs;
+        tileCfg.bmax[2] += tileCfg.borderSize * tileCfg.cs;
+
+        // build heightfield
+        rcHeightfield& solid = scratch.solid;
+        rcCompactHeightfield& chf = scratch.chf;
+        if (!scratch.resetHeightfield(&context, tileCfg.width, tileCfg.height, tileCfg.bmin, tileCfg.bmax, tileCfg.cs, tileCfg.ch))
+        {
+            printf("%s Failed building heightfield!            \n", tileString);
+            return false;
+        }
+
+        rcRasterizeTriangles(&context, input.solidVerts, input.solidVertCount, input.solidTris, input.solidTriAreas, input.solidTriCount, solid, config.walkableClimb);
+
+        rcFilterLowHangingWalkableObstacles(&context, config.walkableClimb, solid);
+        rcFilterLedgeSpans(&context, tileCfg.walkableHeight, tileCfg.walkableClimb, solid);
+        rcFilterWalkableLowHeightSpans(&context, tileCfg.walkableHeight, solid);
+
+        // add liquid triangles
+        rcRasterizeTriangles(&context, input.liquidVerts, input.liquidVertCount, input.liquidTris, input.liquidTriAreas, input.liquidTriCount, solid, config.walkableClimb);
+
+        // compact heightfield spans
+        scratch.resetCompactHeightfield();
+        if (!rcBuildCompactHeightfield(&context, tileCfg.walkableHeight, tileCfg.walkableClimb, solid, chf))
+        {
+            printf("%s Failed compacting heightfield!            \n", tileString);
+            return false;
+        }
+
+        // build polymesh intermediates
+        if (!rcErodeWalkableArea(&context, config.walkableRadius, chf))
+        {
+            printf("%s Failed eroding area!                    \n", tileString);
+            return false;
+        }
+
+        if (!rcMedianFilterWalkableArea(&context, chf))
+        {
+            printf("%s Failed filtering area!                  \n", tileString);
+            return false;
+        }
+
+        if (!rcBuildDistanceField(&context, chf))
+        {
+            printf("%s Failed building distance field!         \n", tileString);
+            return false;
+        }
+
+        if (!rcBuildRegions(&context, chf, tileCfg.borderSize, tileCfg.minRegionArea, tileCfg.mergeRegionArea))
+        {
+            printf("%s Failed building regions!                \n", tileString);
+            return false;
+        }
+
+        tile.cset = rcAllocContourSet();
+        if (!tile.cset || !rcBuildContours(&context, chf, tileCfg.maxSimplificationError, tileCfg.maxEdgeLen, *tile.cset))
+        {
+            printf("%s Failed building contours!               \n", tileString);
+            return false;
+        }
+
+        // build polymesh
+        tile.pmesh = rcAllocPolyMesh();
+        if (!tile.pmesh || !rcBuildPolyMesh(&context, *tile.cset, tileCfg.maxVertsPerPoly, *tile.pmesh))
+        {
+            printf("%s Failed building polymesh!               \n", tileString);
+            return false;
+        }
+
+        tile.dmesh = rcAllocPolyMeshDetail();
+        if (!tile.dmesh || !rcBuildPolyMeshDetail(&context, *tile.pmesh, chf, tileCfg.detailSampleDist, tileCfg.detailSampleMaxError, *tile.dmesh))
+        {
+            printf("%s Failed building polymesh detail!        \n", tileString);
+            return false;
+        }
+
+        // free those up
+        // we may want to keep them in the future for debug
+        // but right now, we don't have the code to merge them
+        rcFreeContourSet(tile.cset);
+        tile.cset = nullptr;
+        return true;
+    }
+
+    /**************************************************************************/
+    SubTileBuilder::SubTileBuilder(TileBuildContext* context, TileScratch* scratch) : m_context(context), m_scratch(scratch)
+    {
+    }
+
+    SubTileBuilder::~SubTileBuilder() = default;
+
+    void SubTileBuilder::build(SubTileInput const& input, Tile* tiles, uint32 threads)
+    {
+        int const tileCount = input.tilesPerMap * input.tilesPerMap;
+        uint32 const helperCount = std::min<uint32>(std::max(threads, 1u), tileCount) - 1;
+        while (m_helpers.size() < helperCount)
+            m_helpers.push_back(std::make_unique<Helper>());
+
+        // sub tiles are handed out one at a time, their cost varies too much to split them up front
+        std::atomic<int> nextTile(0);
+        auto buildTiles = [&input, tiles, tileCount, &nextTile](TileBuildContext& context, TileScratch& scratch)
+        {
+            for (int i = nextTile++; i < tileCount; i = nextTile++)
+            {
+                Tile& tile = tiles[i];
+                if (buildSubTile(input, i % input.tilesPerMap, i / input.tilesPerMap, context, scratch, tile))
+                    continue;
+
+                // only complete sub tiles are merged
+                rcFreePolyMeshDetail(tile.dmesh);
+                tile.dmesh = nullptr;
+            }
+        };
+
+        std::vector<std::thread> helperThreads;
+        helperThreads.reserve(helperCount);
+        for (uint32 i = 0; i < helperCount; ++i)
+            helperThreads.emplace_back(buildTiles, std::ref(m_helpers[i]->context), std::ref(m_helpers[i]->scratch));
+
+        buildTiles(*m_context, *m_scratch);
+
+        for (std::thread& thread : helperThreads)
+            thread.join();
+
+        // the stage times of a tile include the work of its helpers
+        for (uint32 i = 0; i < helperCount; ++i)
+        {
+            TileBuildContext& context = m_helpers[i]->context;
+            for (uint32 stage = 0; stage < MAX_TILE_STAGES; ++stage)
+                m_context->addStageTime(TileBuildStage(stage), context.getStageTime(TileBuildStage(stage)));
+            context.resetTimers();
+        }
+    }
+}
@@ -0,0 +1,145 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SUB_TILE_BUILDER_H
+#define _SUB_TILE_BUILDER_H
+
+#include "Define.h"
+#include "Recast.h"
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace MMAP
+{
+    struct Tile
+    {
+        Tile() : cset(nullptr), pmesh(nullptr), dmesh(nullptr) {}
+        ~Tile()
+        {
+            rcFreeContourSet(cset);
+            rcFreePolyMesh(pmesh);
+            rcFreePolyMeshDetail(dmesh);
+        }
+        rcContourSet* cset;
+        rcPolyMesh* pmesh;
+        rcPolyMeshDetail* dmesh;
+    };
+
+    // Heightfields of the sub tiles, a builder reuses them for every sub tile of every tile it builds
+    // instead of allocating the span grid and span pools again each time
+    struct TileScratch
+    {
+        rcHeightfield solid;
+        rcCompactHeightfield chf;
+
+        // empties the heightfield, keeping its spans allocated
+        bool resetHeightfield(rcContext* context, int width, int height, float const* bmin, float const* bmax, float cs, float ch);
+        // rcBuildCompactHeightfield allocates its arrays itself, the previous ones are released first
+        void resetCompactHeightfield();
+    };
+
+    enum TileBuildStage
+    {
+        TILE_STAGE_ESTIMATE,    // input hash and vertex count used for scheduling
+        TILE_STAGE_LOAD,        // terrain and model data
+        TILE_STAGE_RASTERIZE,
+        TILE_STAGE_FILTER,      // span filters, compacting and eroding
+        TILE_STAGE_REGIONS,     // distance field and watershed
+        TILE_STAGE_CONTOURS,
+        TILE_STAGE_POLYMESH,
+        TILE_STAGE_DETAIL,
+        TILE_STAGE_WRITE,       // detour tile data and file output
+        MAX_TILE_STAGES
+    };
+
+    // Collects the Recast timers of a single builder as time spent per stage
+    class TileBuildContext : public rcContext
+    {
+        public:
+            TileBuildContext() : rcContext(true), m_startTimes(), m_labelTimes(), m_stageTimes() {}
+
+            void addStageTime(TileBuildStage stage, std::chrono::steady_clock::duration time) { m_stageTimes[stage] += time; }
+            std::chrono::steady_clock::duration getStageTime(TileBuildStage stage) const { return m_stageTimes[stage]; }
+
+        protected:
+            void doResetTimers() override;
+            void doStartTimer(rcTimerLabel const label) override;
+            void doStopTimer(rcTimerLabel const label) override;
+            int doGetAccumulatedTime(rcTimerLabel const label) const override;
+
+        private:
+            std::array<std::chrono::steady_clock::time_point, RC_MAX_TIMERS> m_startTimes;
+            std::array<std::chrono::steady_clock::duration, RC_MAX_TIMERS> m_labelTimes;
+            std::array<std::chrono::steady_clock::duration, MAX_TILE_STAGES> m_stageTimes;
+    };
+
+    // Geometry and settings shared by all sub tiles of a tile, only read while they are built
+    struct SubTileInput
+    {
+        // config of the whole tile, sub tile bounds are derived from its bmin and tileSize
+        rcConfig config;
+        int tilesPerMap;
+
+        float const* solidVerts;
+        int solidVertCount;
+        int const* solidTris;
+        int solidTriCount;
+        // area of every solid triangle, the walkable slope doesn't depend on the sub tile
+        unsigned char const* solidTriAreas;
+
+        float const* liquidVerts;
+        int liquidVertCount;
+        int const* liquidTris;
+        int liquidTriCount;
+        unsigned char const* liquidTriAreas;
+
+        // prefix of the error messages
+        char const* tileString;
+    };
+
+    // Runs rasterization up to the detail mesh for every sub tile of a tile. The sub tiles are independent until
+    // their meshes are merged, so they are spread over the calling thread and helper threads that each own a context
+    // and heightfields. The result doesn't depend on the number of threads.
+    class SubTileBuilder
+    {
+        public:
+            SubTileBuilder(TileBuildContext* context, TileScratch* scratch);
+            ~SubTileBuilder();
+
+            // tiles must hold tilesPerMap * tilesPerMap entries, sub tile x,y ends up at x + y * tilesPerMap.
+            // Sub tiles that failed to build have no detail mesh.
+            void build(SubTileInput const& input, Tile* tiles, uint32 threads);
+
+        private:
+            struct Helper
+            {
+                TileBuildContext context;
+                TileScratch scratch;
+            };
+
+            TileBuildContext* m_context;
+            TileScratch* m_scratch;
+            std::vector<std::unique_ptr<Helper>> m_helpers;
+    };
+
+    bool buildSubTile(SubTileInput const& input, int x, int y, TileBuildContext& context, TileScratch& scratch, Tile& tile);
+}
+
+#endif
@@ -23,7 +23,10 @@
 #include "ModelInstance.h"
 #include "VMapFactory.h"
 #include "VMapManager2.h"
-#include <map>
+#include <array>
+#include <bitset>
+#include <cstring>
+#include <vector>
 
 // ******************************************
 // Map file format defines
@@ -87,6 +90,158 @@ namespace MMAP
     TerrainBuilder::TerrainBuilder(bool skipLiquid) : m_skipLiquid (skipLiquid){ }
     TerrainBuilder::~TerrainBuilder() { }
 
+    namespace
+    {
+        /// Appends the vertices of a size x size height grid. wow coords: x, y, height, the grid is mirrored about
+        /// the horizontal axes and stored as x, height, y. Coordinates of rows and columns are computed once,
+        /// the inner loop only interleaves them with the heights so it can be vectorized.
+        template<typename HeightGetter>
+        void appendGridVertices(G3D::Array<float>& dest, int size, float xOffset, float yOffset, bool centered, HeightGetter&& getHeight)
+        {
+            std::array<float, V9_SIZE> coords;
+            for (int i = 0; i < size; ++i)
+            {
+                float x = xOffset + i * GRID_PART_SIZE;
+                if (centered)
+                    x += GRID_PART_SIZE / 2.f;
+                coords[i] = x * -1.f;
+            }
+
+            int first = dest.size();
+            dest.resize(first + size * size * 3, false);
+            float* out = dest.getCArray() + first;
+            for (int row = 0; row < size; ++row)
+            {
+                float y = yOffset + row * GRID_PART_SIZE;
+                if (centered)
+                    y += GRID_PART_SIZE / 2.f;
+                y *= -1.f;
+
+                for (int col = 0; col < size; ++col, out += 3)
+                {
+                    out[0] = coords[col];
+                    out[1] = getHeight(row, col);
+                    out[2] = y;
+                }
+            }
+        }
+
+        /// Appends the four triangles of every terrain square, in TOP, RIGHT, LEFT, BOTTOM order
+        void appendHeightTriangles(G3D::Array<int>& dest, int loopStart, int loopEnd, int loopInc, int offset)
+        {
+            int first = dest.size();
+            dest.resize(first + (loopEnd - loopStart + loopInc - 1) / loopInc * 12, false);
+            int* out = dest.getCArray() + first;
+            for (int square = loopStart; square < loopEnd; square += loopInc, out += 12)
+            {
+                //           0-----1 .... 128
+                //           |\ T /|
+                //           | \ / |
+                //           |L 0 R| .. 127
+                //           | / \ |
+                //           |/ B \|
+                //          129---130 ... 386
+                int topLeft = square + square / V8_SIZE + offset;
+                int topRight = topLeft + 1;
+                int bottomLeft = topLeft + V9_SIZE;
+                int bottomRight = bottomLeft + 1;
+                int center = V9_SIZE_SQ + square + offset;
+
+                // stored in reverse order
+                int const triangles[12] =
+                {
+                    center, topRight, topLeft,
+                    center, bottomRight, topRight,
+                    bottomLeft, center, topLeft,
+                    bottomLeft, bottomRight, center
+                };
+                memcpy(out, triangles, sizeof(triangles));
+            }
+        }
+
+        /// Appends the two triangles of every liquid square, in TOP, BOTTOM order
+        void appendLiquidTriangles(G3D::Array<int>& dest, int loopStart, int loopEnd, int loopInc, int offset)
+        {
+            int first = dest.size();
+            dest.resize(first + (loopEnd - loopStart + loopInc - 1) / loopInc * 6, false);
+            int* out = dest.getCArray() + first;
+            for (int square = loopStart; square < loopEnd; square += loopInc, out += 6)
+            {
+                //           0-----1 .... 128
+                //           |\    |
+                //           | \ T |
+                //           |  \  |
+                //           | B \ |
+                //           |    \|
+                //          129---130 ... 386
+                int topLeft = square + square / V8_SIZE + offset;
+                int topRight = topLeft + 1;
+                int bottomLeft = topLeft + V9_SIZE;
+                int bottomRight = bottomLeft + 1;
+
+                // stored in reverse order
+                int const triangles[6] =
+                {
+                    bottomRight, topRight, topLeft,
+                    bottomLeft, bottomRight, topLeft
+                };
+                memcpy(out, triangles, sizeof(triangles));
+            }
+        }
+
+        /// Squares of the terrain that are holes, every chunk has 4x4 holes each covering 2x2 squares
+        std::bitset<V8_SIZE_SQ> getHoleSquares(uint16 const holes[16][16])
+        {
+            std::bitset<V8_SIZE_SQ> squares;
+            for (int cellRow = 0; cellRow < 16; ++cellRow)
+            {
+                for (int cellCol = 0; cellCol < 16; ++cellCol)
+                {
+                    uint16 hole = holes[cellRow][cellCol];
+                    if (!hole)
+                        continue;
+
+                    for (int row = 0; row < 8; ++row)
+                        for (int col = 0; col < 8; ++col)
+                            if (hole & (1 << (row / 2 * 4 + col / 2)))
+                                squares.set((cellRow * 8 + row) * V8_SIZE + cellCol * 8 + col);
+                }
+            }
+
+            return squares;
+        }
+
+        /// Sorts the squares by the liquid flags of their chunk
+        void getLiquidSquares(uint8 const liquidFlags[16][16], std::bitset<V8_SIZE_SQ>& darkWaterSquares, std::bitset<V8_SIZE_SQ>& liquidSquares, uint8 liquidAreas[16][16])
+        {
+            std::bitset<V8_SIZE_SQ> chunk;
+            for (int row = 0; row < 8; ++row)
+                for (int col = 0; col < 8; ++col)
+                    chunk.set(row * V8_SIZE + col);
+
+            for (int cellRow = 0; cellRow < 16; ++cellRow)
+            {
+                for (int cellCol = 0; cellCol < 16; ++cellCol)
+                {
+                    uint8 flags = liquidFlags[cellRow][cellCol];
+                    std::bitset<V8_SIZE_SQ> const squares = chunk << (cellRow * 8 * V8_SIZE + cellCol * 8);
+                    if (flags & MAP_LIQUID_TYPE_DARK_WATER)
+                        darkWaterSquares |= squares;
+                    else if (flags & (MAP_LIQUID_TYPE_WATER | MAP_LIQUID_TYPE_OCEAN))
+                    {
+                        liquidSquares |= squares;
+                        liquidAreas[cellRow][cellCol] = NAV_AREA_WATER;
+                    }
+                    else if (flags & (MAP_LIQUID_TYPE_MAGMA | MAP_LIQUID_TYPE_SLIME))
+                    {
+                        liquidSquares |= squares;
+                        liquidAreas[cellRow][cellCol] = NAV_AREA_MAGMA_SLIME;
+                    }
+                }
+            }
+        }
+    }
+
     /**************************************************************************/
     void TerrainBuilder::getLoopVars(Spot portion, int &loopStart, int &loopEnd, int &loopInc)
     {
@@ -178,6 +333,8 @@ namespace MMAP
         memset(liquid_flags, 0, sizeof(liquid_flags));
         G3D::Array<int> ltriangles;
         G3D::Array<int> ttriangles;
+        int loopStart = 0, loopEnd = 0, loopInc = 0;
+        getLoopVars(portion, loopStart, loopEnd, loopInc);
 
         // terrain data
         if (haveTerrain)
@@ -244,38 +401,14 @@ namespace MMAP
             float xoffset = (float(tileX)-32)*GRID_SIZE;
             float yoffset = (float(tileY)-32)*GRID_SIZE;
 
-            float coord[3];
-
-            for (int i = 0; i < V9_SIZE_SQ; ++i)
-            {
-                getHeightCoord(i, GRID_V9, xoffset, yoffset, coord, V9);
-                meshData.solidVerts.append(coord[0]);
-                meshData.solidVerts.append(coord[2]);
-                meshData.solidVerts.append(coord[1]);
-            }
-
-            for (int i = 0; i < V8_SIZE_SQ; ++i)
-            {
-                getHeightCoord(i, GRID_V8, xoffset, yoffset, coord, V8);
-                meshData.solidVerts.append(coord[0]);
-                meshData.solidVerts.append(coord[2]);
-                meshData.solidVerts.append(coord[1]);
-            }
+            appendGridVertices(meshData.solidVerts, V9_SIZE, xoffset, yoffset, false, [&V9](int row, int col) { return V9[row * V9_SIZE + col]; });
+            appendGridVertices(meshData.solidVerts, V8_SIZE, xoffset, yoffset, true, [&V8](int row, int col) { return V8[row * V8_SIZE + col]; });
 
-            int indices[] = { 0, 0, 0 };
-            int loopStart = 0, loopEnd = 0, loopInc = 0;
-            getLoopVars(portion, loopStart, loopEnd, loopInc);
-            for (int i = loopStart; i < loopEnd; i+=loopInc)
-                for (int j = TOP; j <= BOTTOM; j+=1)
-                {
-                    getHeightTriangle(i, Spot(j), indices);
-                    ttriangles.append(indices[2] + count);
-                    ttriangles.append(indices[1] + count);
-                    ttriangles.append(indices[0] + count);
-                }
+            appendHeightTriangles(ttriangles, loopStart, loopEnd, loopInc, count);
         }
 
         // liquid data
+        int liquidVertOffset = meshData.liquidVerts.size() / 3;
         if (haveLiquid)
         {
             map_liquidHeader lheader;
@@ -310,124 +443,74 @@ namespace MMAP
                 }
             }
 
-            int count = meshData.liquidVerts.size() / 3;
             float xoffset = (float(tileX)-32)*GRID_SIZE;
             float yoffset = (float(tileY)-32)*GRID_SIZE;
 
-            float coord[3];
-            int row, col;
-
             // generate coordinates
             if (!(lheader.flags & MAP_LIQUID_NO_HEIGHT))
             {
-                int j = 0;
-                for (int i = 0; i < V9_SIZE_SQ; ++i)
+                appendGridVertices(meshData.liquidVerts, V9_SIZE, xoffset, yoffset, false, [&lheader, liquid_map](int row, int col)
                 {
-                    row = i / V9_SIZE;
-                    col = i % V9_SIZE;
-
-                    if (row < lheader.offsetY || row >= lheader.offsetY + lheader.height ||
+                    // dummy vert using invalid height
+                    if (!liquid_map || row < lheader.offsetY || row >= lheader.offsetY + lheader.height ||
                         col < lheader.offsetX || col >= lheader.offsetX + lheader.width)
-                    {
-                        // dummy vert using invalid height
-                        meshData.liquidVerts.append((xoffset+col*GRID_PART_SIZE)*-1, INVALID_MAP_LIQ_HEIGHT, (yoffset+row*GRID_PART_SIZE)*-1);
-                        continue;
-                    }
+                        return INVALID_MAP_LIQ_HEIGHT;
 
-                    getLiquidCoord(i, j, xoffset, yoffset, coord, liquid_map);
-                    meshData.liquidVerts.append(coord[0]);
-                    meshData.liquidVerts.append(coord[2]);
-                    meshData.liquidVerts.append(coord[1]);
-                    j++;
-                }
+                    return liquid_map[(row - lheader.offsetY) * lheader.width + col - lheader.offsetX];
+                });
             }
             else
-            {
-                for (int i = 0; i < V9_SIZE_SQ; ++i)
-                {
-                    row = i / V9_SIZE;
-                    col = i % V9_SIZE;
-                    meshData.liquidVerts.append((xoffset+col*GRID_PART_SIZE)*-1, lheader.liquidLevel, (yoffset+row*GRID_PART_SIZE)*-1);
-                }
-            }
+                appendGridVertices(meshData.liquidVerts, V9_SIZE, xoffset, yoffset, false, [&lheader](int, int) { return lheader.liquidLevel; });
 
             delete[] liquid_map;
 
-            int indices[] = { 0, 0, 0 };
-            int loopStart = 0, loopEnd = 0, loopInc = 0, triInc = BOTTOM-TOP;
-            getLoopVars(portion, loopStart, loopEnd, loopInc);
-
-            // generate triangles
-            for (int i = loopStart; i < loopEnd; i += loopInc)
-            {
-                for (int j = TOP; j <= BOTTOM; j += triInc)
-                {
-                    getHeightTriangle(i, Spot(j), indices, true);
-                    ltriangles.append(indices[2] + count);
-                    ltriangles.append(indices[1] + count);
-                    ltriangles.append(indices[0] + count);
-                }
-            }
+            appendLiquidTriangles(ltriangles, loopStart, loopEnd, loopInc, liquidVertOffset);
         }
 
         fclose(mapFile);
 
+        if ((ltriangles.size() + ttriangles.size()) == 0)
+            return false;
+
         // now that we have gathered the data, we can figure out which parts to keep:
         // liquid above ground, ground above liquid
-        int loopStart = 0, loopEnd = 0, loopInc = 0, tTriCount = 4;
-        bool useTerrain, useLiquid;
+        std::bitset<V8_SIZE_SQ> holeSquares;
+        if (fheader.holesSize != 0)
+            holeSquares = getHoleSquares(holes);
 
-        float* lverts = meshData.liquidVerts.getCArray();
-        int* ltris = ltriangles.getCArray();
+        // squares covered by dark water keep neither terrain nor liquid, players should not be there
+        std::bitset<V8_SIZE_SQ> darkWaterSquares;
+        std::bitset<V8_SIZE_SQ> liquidSquares;
+        uint8 liquidAreas[16][16];
+        memset(liquidAreas, NAV_AREA_EMPTY, sizeof(liquidAreas));
+        if (meshData.liquidVerts.size() && ltriangles.size())
+            getLiquidSquares(liquid_flags, darkWaterSquares, liquidSquares, liquidAreas);
 
-        float* tverts = meshData.solidVerts.getCArray();
-        int* ttris = ttriangles.getCArray();
+        bool const haveTerrainTris = ttriangles.size() != 0;
 
-        if ((ltriangles.size() + ttriangles.size()) == 0)
-            return false;
+        float* lverts = meshData.liquidVerts.getCArray();
+        float const* tverts = meshData.solidVerts.getCArray();
 
-        // make a copy of liquid vertices
+        // a copy of the liquid vertices of this file, the heights of lverts are changed below
         // used to pad right-bottom frame due to lost vertex data at extraction
-        float* lverts_copy = nullptr;
-        if (meshData.liquidVerts.size())
-        {
-            lverts_copy = new float[meshData.liquidVerts.size()];
-            memcpy(lverts_copy, lverts, sizeof(float)*meshData.liquidVerts.size());
-        }
+        std::vector<float> lvertsCopy;
+        if (liquidSquares.any())
+            lvertsCopy.assign(lverts + liquidVertOffset * 3, lverts + meshData.liquidVerts.size());
 
-        getLoopVars(portion, loopStart, loopEnd, loopInc);
-        for (int i = loopStart; i < loopEnd; i+=loopInc)
+        int triangle = 0;
+        for (int i = loopStart; i < loopEnd; i += loopInc)
         {
-            for (int j = 0; j < 2; ++j)
-            {
-                // default is true, will change to false if needed
-                useTerrain = true;
-                useLiquid = true;
-                uint8 liquidType = MAP_LIQUID_TYPE_NO_WATER;
-
-                // if there is no liquid, don't use liquid
-                if (!meshData.liquidVerts.size() || !ltriangles.size())
-                    useLiquid = false;
-                else
-                {
-                    liquidType = getLiquidType(i, liquid_flags);
-                    if (liquidType & MAP_LIQUID_TYPE_DARK_WATER)
-                    {
-                        // players should not be here, so logically neither should creatures
-                        useTerrain = false;
-                        useLiquid = false;
-                    }
-                    else if ((liquidType & (MAP_LIQUID_TYPE_WATER | MAP_LIQUID_TYPE_OCEAN)) != 0)
-                        liquidType = NAV_AREA_WATER;
-                    else if ((liquidType & (MAP_LIQUID_TYPE_MAGMA | MAP_LIQUID_TYPE_SLIME)) != 0)
-                        liquidType = NAV_AREA_MAGMA_SLIME;
-                    else
-                        useLiquid = false;
-                }
+            bool const squareHasTerrain = haveTerrainTris && !darkWaterSquares[i] && !holeSquares[i];
+            bool const squareHasLiquid = liquidSquares[i];
+            uint8 const liquidType = squareHasLiquid ? liquidAreas[i / V8_SIZE / 8][i % V8_SIZE / 8] : uint8(NAV_AREA_EMPTY);
 
-                // if there is no terrain, don't use terrain
-                if (!ttriangles.size())
-                    useTerrain = false;
+            // the liquid square is split in two triangles, each covers two of the four terrain triangles
+            for (int j = 0; j < 2; ++j, ++triangle)
+            {
+                bool useTerrain = squareHasTerrain;
+                bool useLiquid = squareHasLiquid;
+                int const* ltris = useLiquid ? &ltriangles[triangle * 3] : nullptr;
+                int const* ttris = useTerrain ? &ttriangles[triangle * 6] : nullptr;
 
                 // while extracting ADT data we are losing right-bottom vertices
                 // this code adds fair approximation of lost data
@@ -435,9 +518,9 @@ namespace MMAP
                 {
                     float quadHeight = 0;
                     uint32 validCount = 0;
-                    for(uint32 idx = 0; idx < 3; idx++)
+                    for (uint32 idx = 0; idx < 3; idx++)
                     {
-                        float h = lverts_copy[ltris[idx]*3 + 1];
+                        float h = lvertsCopy[(ltris[idx] - liquidVertOffset) * 3 + 1];
                         if (h != INVALID_MAP_LIQ_HEIGHT && h < INVALID_MAP_LIQ_HEIGHT_MAX)
                         {
                             quadHeight += h;
@@ -449,7 +532,7 @@ namespace MMAP
                     if (validCount > 0 && validCount < 3)
                     {
                         quadHeight /= validCount;
-                        for(uint32 idx = 0; idx < 3; idx++)
+                        for (uint32 idx = 0; idx < 3; idx++)
                         {
                             float h = lverts[ltris[idx]*3 + 1];
                             if (h == INVALID_MAP_LIQ_HEIGHT || h > INVALID_MAP_LIQ_HEIGHT_MAX)
@@ -462,16 +545,12 @@ namespace MMAP
                         useLiquid = false;
                 }
 
-                // if there is a hole here, don't use the terrain
-                if (useTerrain && fheader.holesSize != 0)
-                    useTerrain = !isHole(i, holes);
-
                 // we use only one terrain kind per quad - pick higher one
                 if (useTerrain && useLiquid)
                 {
                     float minLLevel = INVALID_MAP_LIQ_HEIGHT_MAX;
                     float maxLLevel = INVALID_MAP_LIQ_HEIGHT;
-                    for(uint32 x = 0; x < 3; x++)
+                    for (uint32 x = 0; x < 3; x++)
                     {
                         float h = lverts[ltris[x]*3 + 1];
                         if (minLLevel > h)
@@ -483,7 +562,7 @@ namespace MMAP
 
                     float maxTLevel = INVALID_MAP_LIQ_HEIGHT;
                     float minTLevel = INVALID_MAP_LIQ_HEIGHT_MAX;
-                    for(uint32 x = 0; x < 6; x++)
+                    for (uint32 x = 0; x < 6; x++)
                     {
                         float h = tverts[ttris[x]*3 + 1];
                         if (maxTLevel < h)
@@ -506,132 +585,18 @@ namespace MMAP
                 if (useLiquid)
                 {
                     meshData.liquidType.append(liquidType);
-                    for (int k = 0; k < 3; ++k)
-                        meshData.liquidTris.append(ltris[k]);
+                    meshData.liquidTris.append(ltris[0], ltris[1], ltris[2]);
                 }
 
                 if (useTerrain)
-                    for (int k = 0; k < 3*tTriCount/2; ++k)
+                    for (int k = 0; k < 6; ++k)
                         meshData.solidTris.append(ttris[k]);
-
-                // advance to next set of triangles
-                ltris += 3;
-                ttris += 3*tTriCount/2;
             }
         }
 
-        if (lverts_copy)
-            delete [] lverts_copy;
-
         return meshData.solidTris.size() || meshData.liquidTris.size();
     }
 
-    /**************************************************************************/
-    void TerrainBuilder::getHeightCoord(int index, Grid grid, float xOffset, float yOffset, float* coord, float* v)
-    {
-        // wow coords: x, y, height
-        // coord is mirroed about the horizontal axes
-        switch (grid)
-        {
-        case GRID_V9:
-            coord[0] = (xOffset + index%(V9_SIZE)*GRID_PART_SIZE) * -1.f;
-            coord[1] = (yOffset + (int)(index/(V9_SIZE))*GRID_PART_SIZE) * -1.f;
-            coord[2] = v[index];
-            break;
-        case GRID_V8:
-            coord[0] = (xOffset + index%(V8_SIZE)*GRID_PART_SIZE + GRID_PART_SIZE/2.f) * -1.f;
-            coord[1] = (yOffset + (int)(index/(V8_SIZE))*GRID_PART_SIZE + GRID_PART_SIZE/2.f) * -1.f;
-            coord[2] = v[index];
-            break;
-        }
-    }
-
-    /**************************************************************************/
-    void TerrainBuilder::getHeightTriangle(int square, Spot triangle, int* indices, bool liquid/* = false*/)
-    {
-        int rowOffset = square/V8_SIZE;
-        if (!liquid)
-            switch (triangle)
-        {
-            case TOP:
-                indices[0] = square+rowOffset;                  //           0-----1 .... 128
-                indices[1] = square+1+rowOffset;                //           |\ T /|
-                indices[2] = (V9_SIZE_SQ)+square;               //           | \ / |
-                break;                                          //           |L 0 R| .. 127
-            case LEFT:                                          //           | / \ |
-                indices[0] = square+rowOffset;                  //           |/ B \|
-                indices[1] = (V9_SIZE_SQ)+square;               //          129---130 ... 386
-                indices[2] = square+V9_SIZE+rowOffset;          //           |\   /|
-                break;                                          //           | \ / |
-            case RIGHT:                                         //           | 128 | .. 255
-                indices[0] = square+1+rowOffset;                //           | / \ |
-                indices[1] = square+V9_SIZE+1+rowOffset;        //           |/   \|
-                indices[2] = (V9_SIZE_SQ)+square;               //          258---259 ... 515
-                break;
-            case BOTTOM:
-                indices[0] = (V9_SIZE_SQ)+square;
-                indices[1] = square+V9_SIZE+1+rowOffset;
-                indices[2] = square+V9_SIZE+rowOffset;
-                break;
-            default: break;
-        }
-        else
-            switch (triangle)
-        {                                                           //           0-----1 .... 128
-            case TOP:                                               //           |\    |
-                indices[0] = square+rowOffset;                      //           | \ T |
-                indices[1] = square+1+rowOffset;                    //           |  \  |
-                indices[2] = square+V9_SIZE+1+rowOffset;            //           | B \ |
-                break;                                              //           |    \|
-            case BOTTOM:                                            //          129---130 ... 386
-                indices[0] = square+rowOffset;                      //           |\    |
-                indices[1] = square+V9_SIZE+1+rowOffset;            //           | \   |
-                indices[2] = square+V9_SIZE+rowOffset;              //           |  \  |
-                break;                                              //           |   \ |
-            default: break;                                         //           |    \|
-        }                                                           //          258---259 ... 515
-
-    }
-
-    /**************************************************************************/
-    void TerrainBuilder::getLiquidCoord(int index, int index2, float xOffset, float yOffset, float* coord, float* v)
-    {
-        // wow coords: x, y, height
-        // coord is mirroed about the horizontal axes
-        coord[0] = (xOffset + index%(V9_SIZE)*GRID_PART_SIZE) * -1.f;
-        coord[1] = (yOffset + (int)(index/(V9_SIZE))*GRID_PART_SIZE) * -1.f;
-        coord[2] = v[index2];
-    }
-
-    static uint16 holetab_h[4] = {0x1111, 0x2222, 0x4444, 0x8888};
-    static uint16 holetab_v[4] = {0x000F, 0x00F0, 0x0F00, 0xF000};
-
-    /**************************************************************************/
-    bool TerrainBuilder::isHole(int square, const uint16 holes[16][16])
-    {
-        int row = square / 128;
-        int col = square % 128;
-        int cellRow = row / 8;     // 8 squares per cell
-        int cellCol = col / 8;
-        int holeRow = row % 8 / 2;
-        int holeCol = (square - (row * 128 + cellCol * 8)) / 2;
-
-        uint16 hole = holes[cellRow][cellCol];
-
-        return (hole & holetab_h[holeCol] & holetab_v[holeRow]) != 0;
-    }
-
-    /**************************************************************************/
-    uint8 TerrainBuilder::getLiquidType(int square, const uint8 liquid_type[16][16])
-    {
-        int row = square / 128;
-        int col = square % 128;
-        int cellRow = row / 8;     // 8 squares per cell
-        int cellCol = col / 8;
-
-        return liquid_type[cellRow][cellCol];
-    }
-
     /**************************************************************************/
     bool TerrainBuilder::loadVMap(uint32 mapID, uint32 tileX, uint32 tileY, MeshData &meshData)
     {
@@ -844,44 +809,47 @@ namespace MMAP
     /**************************************************************************/
     void TerrainBuilder::cleanVertices(G3D::Array<float> &verts, G3D::Array<int> &tris)
     {
-        std::map<int, int> vertMap;
+        // vertices on the borders of neighbouring map files and between model groups are stored more than once,
+        // equal positions are welded and unused vertices dropped. Vertices keep the order they are first used in.
+        std::vector<int> vertMap(verts.size() / 3, -1);
+
+        // open addressing over the positions of the kept vertices
+        size_t buckets = 16;
+        while (buckets < vertMap.size() * 2)
+            buckets <<= 1;
+        std::vector<int> positions(buckets, -1);
 
         int* t = tris.getCArray();
-        float* v = verts.getCArray();
+        float const* v = verts.getCArray();
 
         G3D::Array<float> cleanVerts;
-        int index, count = 0;
-        // collect all the vertex indices from triangle
         for (int i = 0; i < tris.size(); ++i)
         {
-            if (vertMap.find(t[i]) != vertMap.end())
-                continue;
-            std::pair<int, int> val;
-            val.first = t[i];
-
-            index = val.first;
-            val.second = count;
+            int& index = vertMap[t[i]];
+            if (index < 0)
+            {
+                float const* vert = &v[t[i] * 3];
+                uint32 bits[3];
+                memcpy(bits, vert, sizeof(bits));
 
-            vertMap.insert(val);
-            cleanVerts.append(v[index * 3], v[index * 3 + 1], v[index * 3 + 2]);
-            count++;
-        }
+                size_t bucket = ((bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u)) & (buckets - 1);
+                while (positions[bucket] >= 0 && memcmp(&cleanVerts[positions[bucket] * 3], vert, sizeof(bits)) != 0)
+                    bucket = (bucket + 1) & (buckets - 1);
 
-        verts.fastClear();
-        verts.append(cleanVerts);
-        cleanVerts.clear();
+                if (positions[bucket] < 0)
+                {
+                    positions[bucket] = cleanVerts.size() / 3;
+                    cleanVerts.append(vert[0], vert[1], vert[2]);
+                }
 
-        // update triangles to use new indices
-        for (int i = 0; i < tris.size(); ++i)
-        {
-            std::map<int, int>::iterator it;
-            if ((it = vertMap.find(t[i])) == vertMap.end())
-                continue;
+                index = positions[bucket];
+            }
 
-            t[i] = (*it).second;
+            t[i] = index;
         }
 
-        vertMap.clear();
+        verts.fastClear();
+        verts.append(cleanVerts);
     }
 
     /**************************************************************************/
@@ -104,21 +104,6 @@ namespace MMAP
 
             /// Controls whether liquids are loaded
             bool m_skipLiquid;
-
-            /// Get the vector coordinate for a specific position
-            void getHeightCoord(int index, Grid grid, float xOffset, float yOffset, float* coord, float* v);
-
-            /// Get the triangle's vector indices for a specific position
-            void getHeightTriangle(int square, Spot triangle, int* indices, bool liquid = false);
-
-            /// Determines if the specific position's triangles should be rendered
-            bool isHole(int square, const uint16 holes[16][16]);
-
-            /// Get the liquid vector coordinate for a specific position
-            void getLiquidCoord(int index, int index2, float xOffset, float yOffset, float* coord, float* v);
-
-            /// Get the liquid type for a specific position
-            uint8 getLiquidType(int square, const uint8 liquid_type[16][16]);
     };
 }
 
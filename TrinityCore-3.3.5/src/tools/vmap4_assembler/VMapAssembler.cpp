@@ -20,8 +20,36 @@
 
 #include "TileAssembler.h"
 #include "Banner.h"
+#include "ExtractionManifest.h"
 #include "Locales.h"
 #include "Util.h"
+#include "VMapDefinitions.h"
+#include <boost/filesystem/directory.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <algorithm>
+#include <vector>
+
+// everything vmap4extractor wrote: the spawn list, the gameobject model list and all models
+std::string GetInputHash(std::string const& src)
+{
+    std::vector<boost::filesystem::path> files;
+    boost::system::error_code ec;
+    for (boost::filesystem::directory_iterator itr(src, ec), end; itr != end; itr.increment(ec))
+        if (boost::filesystem::is_regular_file(itr->path()) && itr->path().filename().string().find(".manifest") == std::string::npos)
+            files.push_back(itr->path());
+
+    std::sort(files.begin(), files.end());
+
+    ExtractionInputHash hash;
+    hash.UpdateData(VMAP::VMAP_MAGIC);
+    for (boost::filesystem::path const& file : files)
+    {
+        hash.UpdateData(file.filename().string());
+        hash.UpdateFile(file.string());
+    }
+
+    return hash.Finalize();
+}
 
 int main(int argc, char* argv[])
 {
@@ -49,6 +77,16 @@ int main(int argc, char* argv[])
 
     std::cout << "using " << src << " as source directory and writing output to " << dest << std::endl;
 
+    // the assembler always converts the whole world, skip it when no extracted file changed
+    ExtractionManifest manifest(dest + "/extraction.manifest");
+    std::string inputHash = GetInputHash(src);
+    if (manifest.Open() && manifest.IsUpToDate(dest, inputHash))
+    {
+        std::cout << "Extracted vmaps did not change since the last run, nothing to do" << std::endl;
+        manifest.Close();
+        return 0;
+    }
+
     VMAP::TileAssembler* ta = new VMAP::TileAssembler(src, dest);
 
     if (!ta->convertWorld2())
@@ -59,6 +97,9 @@ int main(int argc, char* argv[])
     }
 
     delete ta;
+
+    manifest.Update(dest, inputHash);
+    manifest.Close();
     std::cout << "Ok, all done" << std::endl;
     return 0;
 }
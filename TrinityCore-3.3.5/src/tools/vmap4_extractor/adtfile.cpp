@@ -74,7 +74,7 @@ char* GetExtension(char* FileName)
     return nullptr;
 }
 
-ADTFile::ADTFile(char* filename): _file(filename)
+ADTFile::ADTFile(char* filename): _file(filename), _mapId(0), _tileX(0), _tileY(0)
 {
     Adtfilename.append(filename);
 }
@@ -84,15 +84,11 @@ bool ADTFile::init(uint32 map_num, uint32 tileX, uint32 tileY)
     if (_file.isEof())
         return false;
 
+    _mapId = map_num;
+    _tileX = tileX;
+    _tileY = tileY;
+
     uint32 size;
-    std::string dirname = std::string(szWorkDirWmo) + "/dir_bin";
-    FILE *dirfile;
-    dirfile = fopen(dirname.c_str(), "ab");
-    if(!dirfile)
-    {
-        printf("Can't open dirfile!'%s'\n", dirname.c_str());
-        return false;
-    }
 
     while (!_file.isEof())
     {
@@ -114,10 +110,10 @@ bool ADTFile::init(uint32 map_num, uint32 tileX, uint32 tileY)
         {
             if (size)
             {
-                char *buf = new char[size];
-                _file.read(buf, size);
-                char *p = buf;
-                while (p < buf + size)
+                // names are fixed in place in the file buffer
+                std::span<char> names = _file.readSpan(size);
+                char *p = names.data();
+                while (p < names.data() + names.size())
                 {
                     fixnamen(p, strlen(p));
                     char* s = GetPlainName(p);
@@ -126,21 +122,19 @@ bool ADTFile::init(uint32 map_num, uint32 tileX, uint32 tileY)
                     ModelInstanceNames.emplace_back(s);
 
                     std::string path(p);
-                    ExtractSingleModel(path);
+                    RegisterModel(path);
 
                     p = p+strlen(p)+1;
                 }
-                delete[] buf;
             }
         }
         else if (!strcmp(fourcc,"MWMO"))
         {
             if (size)
             {
-                char* buf = new char[size];
-                _file.read(buf, size);
-                char* p = buf;
-                while (p < buf + size)
+                std::span<char> names = _file.readSpan(size);
+                char* p = names.data();
+                while (p < names.data() + names.size())
                 {
                     std::string path(p);
 
@@ -149,11 +143,10 @@ bool ADTFile::init(uint32 map_num, uint32 tileX, uint32 tileY)
                     fixname2(s, strlen(s));
                     WmoInstanceNames.emplace_back(s);
 
-                    ExtractSingleWmo(path);
+                    RegisterWmo(path);
 
                     p += strlen(p) + 1;
                 }
-                delete[] buf;
             }
         }
         //======================
@@ -164,9 +157,8 @@ bool ADTFile::init(uint32 map_num, uint32 tileX, uint32 tileY)
                 uint32 doodadCount = size / sizeof(ADT::MDDF);
                 for (uint32 i = 0; i < doodadCount; ++i)
                 {
-                    ADT::MDDF doodadDef;
+                    ADT::MDDF& doodadDef = _doodadDefs.emplace_back();
                     _file.read(&doodadDef, sizeof(ADT::MDDF));
-                    Doodad::Extract(doodadDef, ModelInstanceNames[doodadDef.Id].c_str(), map_num, tileX, tileY, dirfile);
                 }
             }
         }
@@ -177,10 +169,8 @@ bool ADTFile::init(uint32 map_num, uint32 tileX, uint32 tileY)
                 uint32 mapObjectCount = size / sizeof(ADT::MODF);
                 for (uint32 i = 0; i < mapObjectCount; ++i)
                 {
-                    ADT::MODF mapObjDef;
+                    ADT::MODF& mapObjDef = _mapObjDefs.emplace_back();
                     _file.read(&mapObjDef, sizeof(ADT::MODF));
-                    MapObject::Extract(mapObjDef, WmoInstanceNames[mapObjDef.Id].c_str(), map_num, tileX, tileY, dirfile);
-                    Doodad::ExtractSet(WmoDoodads[WmoInstanceNames[mapObjDef.Id]], mapObjDef, map_num, tileX, tileY, dirfile);
                 }
             }
         }
@@ -188,10 +178,23 @@ bool ADTFile::init(uint32 map_num, uint32 tileX, uint32 tileY)
         _file.seek(nextpos);
     }
     _file.close();
-    fclose(dirfile);
     return true;
 }
 
+void ADTFile::GetSpawns(std::vector<ModelSpawn>& spawns) const
+{
+    for (ADT::MDDF const& doodadDef : _doodadDefs)
+        Doodad::Extract(doodadDef, ModelInstanceNames[doodadDef.Id].c_str(), _mapId, _tileX, _tileY, spawns);
+
+    for (ADT::MODF const& mapObjDef : _mapObjDefs)
+    {
+        MapObject::Extract(mapObjDef, WmoInstanceNames[mapObjDef.Id].c_str(), _mapId, _tileX, _tileY, spawns);
+        auto doodads = WmoDoodads.find(WmoInstanceNames[mapObjDef.Id]);
+        if (doodads != WmoDoodads.end())
+            Doodad::ExtractSet(doodads->second, mapObjDef, _mapId, _tileX, _tileY, spawns);
+    }
+}
+
 ADTFile::~ADTFile()
 {
     _file.close();
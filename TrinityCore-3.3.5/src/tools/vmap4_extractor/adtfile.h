@@ -50,17 +50,27 @@ namespace ADT
 }
 #pragma pack(pop)
 
+struct ModelSpawn;
+
 class ADTFile
 {
 private:
     MPQFile _file;
     std::string Adtfilename;
+    uint32 _mapId;
+    uint32 _tileX;
+    uint32 _tileY;
+    std::vector<ADT::MDDF> _doodadDefs;
+    std::vector<ADT::MODF> _mapObjDefs;
 public:
     ADTFile(char* filename);
     ~ADTFile();
     std::vector<std::string> WmoInstanceNames;
     std::vector<std::string> ModelInstanceNames;
+    // reads the tile and registers its models
     bool init(uint32 map_num, uint32 tileX, uint32 tileY);
+    // spawns of the tile, its models must have been converted
+    void GetSpawns(std::vector<ModelSpawn>& spawns) const;
     //void LoadMapChunks();
 
     //uint32 wmo_count;
@@ -19,43 +19,37 @@
 #include "dbcfile.h"
 #include "adtfile.h"
 #include "vmapexport.h"
+#include "ExtractionManifest.h"
+#include "mpq_libmpq.h"
 #include "VMapDefinitions.h"
 #include <algorithm>
+#include <vector>
 #include <stdio.h>
 
-bool ExtractSingleModel(std::string& fname)
+bool ExtractSingleModel(ModelExtraction& model)
 {
-    if (fname.length() < 4)
-        return false;
-
-    std::string extension = fname.substr(fname.length() - 4, 4);
-    if (extension == ".mdx" || extension == ".MDX" || extension == ".mdl" || extension == ".MDL")
+    std::string inputHash;
     {
-        // replace .mdx -> .m2
-        fname.erase(fname.length()-2,2);
-        fname.append("2");
+        MPQFile file(model.Path.c_str());
+        if (file.isEof())
+            return false;
+
+        ExtractionInputHash hash;
+        hash.UpdateData(VMAP::RAW_VMAP_MAGIC);
+        hash.UpdateData(reinterpret_cast<uint8 const*>(file.getBuffer()), file.getSize());
+        inputHash = hash.Finalize();
     }
-    // >= 3.1.0 ADT MMDX section store filename.m2 filenames for corresponded .m2 file
-    // nothing do
-
-    std::string originalName = fname;
-
-    char* name = GetPlainName((char*)fname.c_str());
-    fixnamen(name, strlen(name));
-    fixname2(name, strlen(name));
 
-    std::string output(szWorkDirWmo);
-    output += "/";
-    output += name;
-
-    if (FileExists(output.c_str()))
-        return true;
+    if (!ModelManifest.IsUpToDate(model.OutputPath, inputHash))
+    {
+        Model mdl(model.Path);
+        if (!mdl.open() || !mdl.ConvertToVMAPModel(model.OutputPath.c_str()))
+            return false;
 
-    Model mdl(originalName);
-    if (!mdl.open())
-        return false;
+        ModelManifest.Update(model.OutputPath, inputHash);
+    }
 
-    return mdl.ConvertToVMAPModel(output.c_str());
+    return true;
 }
 
 void ExtractGameobjectModels()
@@ -82,6 +76,16 @@ void ExtractGameobjectModels()
 
     fwrite(VMAP::RAW_VMAP_MAGIC, 1, 8, model_list);
 
+    struct GameObjectModel
+    {
+        uint32 DisplayId;
+        uint8 IsWmo;
+        std::string Name;
+        ModelExtraction const* Model;
+    };
+
+    // the models are registered first and converted together
+    std::vector<GameObjectModel> models;
     for (DBCFile::Iterator it = dbc.begin(); it != dbc.end(); ++it)
     {
         path = it->getString(1);
@@ -99,12 +103,12 @@ void ExtractGameobjectModels()
 
         strToLower(ch_ext);
 
-        bool result = false;
+        ModelExtraction const* model = nullptr;
         uint8 isWmo = 0;
         if (!strcmp(ch_ext, ".wmo"))
         {
             isWmo = 1;
-            result = ExtractSingleWmo(path);
+            model = RegisterWmo(path);
         }
         else if (!strcmp(ch_ext, ".mdl"))
         {
@@ -113,17 +117,24 @@ void ExtractGameobjectModels()
         }
         else //if (!strcmp(ch_ext, ".mdx") || !strcmp(ch_ext, ".m2"))
         {
-            result = ExtractSingleModel(path);
+            model = RegisterModel(path);
         }
 
-        if (result)
+        // registering renames .mdx to .m2 in place
+        models.push_back({ it->getUInt(0), isWmo, name, model });
+    }
+
+    ExtractRegisteredModels();
+
+    for (GameObjectModel const& model : models)
+    {
+        if (model.Model && model.Model->Result)
         {
-            uint32 displayId = it->getUInt(0);
-            uint32 path_length = strlen(name);
-            fwrite(&displayId, sizeof(uint32), 1, model_list);
-            fwrite(&isWmo, sizeof(uint8), 1, model_list);
+            uint32 path_length = model.Name.length();
+            fwrite(&model.DisplayId, sizeof(uint32), 1, model_list);
+            fwrite(&model.IsWmo, sizeof(uint8), 1, model_list);
             fwrite(&path_length, sizeof(uint32), 1, model_list);
-            fwrite(name, sizeof(char), path_length, model_list);
+            fwrite(model.Name.c_str(), sizeof(char), path_length, model_list);
         }
     }
 
@@ -138,21 +138,12 @@ Vec3D fixCoordSystem(Vec3D const& v)
     return Vec3D(v.x, v.z, -v.y);
 }
 
-void Doodad::Extract(ADT::MDDF const& doodadDef, char const* ModelInstName, uint32 mapID, uint32 tileX, uint32 tileY, FILE* pDirfile)
+void Doodad::Extract(ADT::MDDF const& doodadDef, char const* ModelInstName, uint32 mapID, uint32 tileX, uint32 tileY, std::vector<ModelSpawn>& spawns)
 {
     char tempname[1036];
     sprintf(tempname, "%s/%s", szWorkDirWmo, ModelInstName);
-    FILE* input = fopen(tempname, "r+b");
-
-    if (!input)
-        return;
-
-    fseek(input, 8, SEEK_SET); // get the correct no of vertices
-    int nVertices;
-    int count = fread(&nVertices, sizeof(int), 1, input);
-    fclose(input);
-
-    if (count != 1 || nVertices == 0)
+    std::optional<int> nVertices = GetModelVertexCount(tempname);
+    if (!nVertices || *nVertices == 0)
         return;
 
     // scale factor - divide by 1024. blizzard devs must be on crack, why not just use a float?
@@ -160,28 +151,25 @@ void Doodad::Extract(ADT::MDDF const& doodadDef, char const* ModelInstName, uint
 
     Vec3D position = fixCoords(doodadDef.Position);
 
-    uint16 nameSet = 0;// not used for models
-    uint32 uniqueId = GenerateUniqueObjectId(doodadDef.UniqueId, 0);
     uint32 tcflags = MOD_M2;
     if (tileX == 65 && tileY == 65)
         tcflags |= MOD_WORLDSPAWN;
 
-    //write mapID, tileX, tileY, Flags, NameSet, UniqueId, Pos, Rot, Scale, name
-    fwrite(&mapID, sizeof(uint32), 1, pDirfile);
-    fwrite(&tileX, sizeof(uint32), 1, pDirfile);
-    fwrite(&tileY, sizeof(uint32), 1, pDirfile);
-    fwrite(&tcflags, sizeof(uint32), 1, pDirfile);
-    fwrite(&nameSet, sizeof(uint16), 1, pDirfile);
-    fwrite(&uniqueId, sizeof(uint32), 1, pDirfile);
-    fwrite(&position, sizeof(Vec3D), 1, pDirfile);
-    fwrite(&doodadDef.Rotation, sizeof(Vec3D), 1, pDirfile);
-    fwrite(&sc, sizeof(float), 1, pDirfile);
-    uint32 nlen = strlen(ModelInstName);
-    fwrite(&nlen, sizeof(uint32), 1, pDirfile);
-    fwrite(ModelInstName, sizeof(char), nlen, pDirfile);
+    ModelSpawn& spawn = spawns.emplace_back();
+    spawn.MapId = mapID;
+    spawn.TileX = tileX;
+    spawn.TileY = tileY;
+    spawn.Flags = tcflags;
+    spawn.NameSet = 0;      // not used for models
+    spawn.ClientId = doodadDef.UniqueId;
+    spawn.ClientDoodadId = 0;
+    spawn.Position = position;
+    spawn.Rotation = doodadDef.Rotation;
+    spawn.Scale = sc;
+    spawn.Name = ModelInstName;
 }
 
-void Doodad::ExtractSet(WMODoodadData const& doodadData, ADT::MODF const& wmo, uint32 mapID, uint32 tileX, uint32 tileY, FILE* pDirfile)
+void Doodad::ExtractSet(WMODoodadData const& doodadData, ADT::MODF const& wmo, uint32 mapID, uint32 tileX, uint32 tileY, std::vector<ModelSpawn>& spawns)
 {
     if (wmo.DoodadSet >= doodadData.Sets.size())
         return;
@@ -216,16 +204,8 @@ void Doodad::ExtractSet(WMODoodadData const& doodadData, ADT::MODF const& wmo, u
 
         char tempname[1036];
         sprintf(tempname, "%s/%s", szWorkDirWmo, ModelInstName);
-        FILE* input = fopen(tempname, "r+b");
-        if (!input)
-            continue;
-
-        fseek(input, 8, SEEK_SET); // get the correct no of vertices
-        int nVertices;
-        int count = fread(&nVertices, sizeof(int), 1, input);
-        fclose(input);
-
-        if (count != 1 || nVertices == 0)
+        std::optional<int> nVertices = GetModelVertexCount(tempname);
+        if (!nVertices || *nVertices == 0)
             continue;
 
         ASSERT(doodadId < std::numeric_limits<uint16>::max());
@@ -242,23 +222,22 @@ void Doodad::ExtractSet(WMODoodadData const& doodadData, ADT::MODF const& wmo, u
         rotation.x = G3D::toDegrees(rotation.x);
         rotation.y = G3D::toDegrees(rotation.y);
 
-        uint16 nameSet = 0;     // not used for models
-        uint32 uniqueId = GenerateUniqueObjectId(wmo.UniqueId, doodadId);
         uint32 tcflags = MOD_M2;
         if (tileX == 65 && tileY == 65)
             tcflags |= MOD_WORLDSPAWN;
 
-        //write mapID, tileX, tileY, Flags, NameSet, UniqueId, Pos, Rot, Scale, name
-        fwrite(&mapID, sizeof(uint32), 1, pDirfile);
-        fwrite(&tileX, sizeof(uint32), 1, pDirfile);
-        fwrite(&tileY, sizeof(uint32), 1, pDirfile);
-        fwrite(&tcflags, sizeof(uint32), 1, pDirfile);
-        fwrite(&nameSet, sizeof(uint16), 1, pDirfile);
-        fwrite(&uniqueId, sizeof(uint32), 1, pDirfile);
-        fwrite(&position, sizeof(Vec3D), 1, pDirfile);
-        fwrite(&rotation, sizeof(Vec3D), 1, pDirfile);
-        fwrite(&doodad.Scale, sizeof(float), 1, pDirfile);
-        fwrite(&nlen, sizeof(uint32), 1, pDirfile);
-        fwrite(ModelInstName, sizeof(char), nlen, pDirfile);
+        ModelSpawn& spawn = spawns.emplace_back();
+        spawn.MapId = mapID;
+        spawn.TileX = tileX;
+        spawn.TileY = tileY;
+        spawn.Flags = tcflags;
+        spawn.NameSet = 0;      // not used for models
+        spawn.ClientId = wmo.UniqueId;
+        spawn.ClientDoodadId = doodadId;
+        spawn.Position = Vec3D(position.x, position.y, position.z);
+        spawn.Rotation = rotation;
+        spawn.Scale = doodad.Scale;
+        // the length is taken before .mdx is renamed, the name keeps its terminator then
+        spawn.Name.assign(ModelInstName, nlen);
     }
 }
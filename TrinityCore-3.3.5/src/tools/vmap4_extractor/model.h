@@ -25,6 +25,7 @@
 
 class MPQFile;
 struct WMODoodadData;
+struct ModelSpawn;
 namespace ADT { struct MDDF; struct MODF; }
 
 Vec3D fixCoordSystem(Vec3D const& v);
@@ -54,9 +55,9 @@ public:
 
 namespace Doodad
 {
-    void Extract(ADT::MDDF const& doodadDef, char const* ModelInstName, uint32 mapID, uint32 tileX, uint32 tileY, FILE* pDirfile);
+    void Extract(ADT::MDDF const& doodadDef, char const* ModelInstName, uint32 mapID, uint32 tileX, uint32 tileY, std::vector<ModelSpawn>& spawns);
 
-    void ExtractSet(WMODoodadData const& doodadData, ADT::MODF const& wmo, uint32 mapID, uint32 tileX, uint32 tileY, FILE* pDirfile);
+    void ExtractSet(WMODoodadData const& doodadData, ADT::MODF const& wmo, uint32 mapID, uint32 tileX, uint32 tileY, std::vector<ModelSpawn>& spawns);
 }
 
 #endif
@@ -18,6 +18,7 @@
 #include "adtfile.h"
 #include "Banner.h"
 #include "dbcfile.h"
+#include "ExtractionManifest.h"
 #include "StringFormat.h"
 #include "vmapexport.h"
 #include "Locales.h"
@@ -27,8 +28,11 @@
 #include "mpq_libmpq.h"
 #include <boost/filesystem/directory.hpp>
 #include <boost/filesystem/operations.hpp>
+#include <algorithm>
+#include <atomic>
 #include <list>
 #include <map>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 #include <cstdio>
@@ -47,13 +51,23 @@ char output_path[128]=".";
 char input_path[1024]=".";
 bool hasInputPathParam = false;
 bool preciseVectorData = false;
+// Number of threads converting models and collecting spawns
+uint32 threadCount = std::max(1u, std::thread::hardware_concurrency());
 std::unordered_map<std::string, WMODoodadData> WmoDoodads;
+std::mutex WmoDoodadsLock;
 
 // Constants
 static constexpr std::array<std::string_view, 12> MpqLocaleNames = { "enGB", "enUS", "deDE", "esES", "frFR", "koKR", "zhCN", "zhTW", "enCN", "enTW", "esMX", "ruRU" };
 
 char const* szWorkDirWmo = "./Buildings";
 
+// m2 models whose file didn't change since the last run are kept, wmos are always converted again for their doodad data
+ExtractionManifest ModelManifest(std::string(szWorkDirWmo) + "/extraction.manifest");
+// models registered during this run by output file
+std::unordered_map<std::string, ModelExtraction> ExtractedModels;
+// registered models that weren't converted yet
+std::vector<ModelExtraction*> PendingModels;
+
 std::map<std::pair<uint32, uint16>, uint32> uniqueObjectIds;
 
 uint32 GenerateUniqueObjectId(uint32 clientId, uint16 clientDoodadId)
@@ -61,6 +75,57 @@ uint32 GenerateUniqueObjectId(uint32 clientId, uint16 clientDoodadId)
     return uniqueObjectIds.emplace(std::make_pair(clientId, clientDoodadId), uniqueObjectIds.size() + 1).first->second;
 }
 
+ModelExtraction::ModelExtraction() : IsWmo(false), Result(false)
+{
+}
+
+ModelExtraction::~ModelExtraction() = default;
+
+void WriteModelSpawns(std::vector<ModelSpawn> const& spawns, FILE* dirfile)
+{
+    for (ModelSpawn const& spawn : spawns)
+    {
+        uint32 uniqueId = GenerateUniqueObjectId(spawn.ClientId, spawn.ClientDoodadId);
+
+        //write mapID, tileX, tileY, Flags, NameSet, UniqueId, Pos, Rot, Scale, [Bound_lo, Bound_hi], name
+        fwrite(&spawn.MapId, sizeof(uint32), 1, dirfile);
+        fwrite(&spawn.TileX, sizeof(uint32), 1, dirfile);
+        fwrite(&spawn.TileY, sizeof(uint32), 1, dirfile);
+        fwrite(&spawn.Flags, sizeof(uint32), 1, dirfile);
+        fwrite(&spawn.NameSet, sizeof(uint16), 1, dirfile);
+        fwrite(&uniqueId, sizeof(uint32), 1, dirfile);
+        fwrite(&spawn.Position, sizeof(Vec3D), 1, dirfile);
+        fwrite(&spawn.Rotation, sizeof(Vec3D), 1, dirfile);
+        fwrite(&spawn.Scale, sizeof(float), 1, dirfile);
+        if (spawn.Flags & MOD_HAS_BOUND)
+            fwrite(&spawn.Bounds, sizeof(AaBox3D), 1, dirfile);
+        uint32 nlen = spawn.Name.length();
+        fwrite(&nlen, sizeof(uint32), 1, dirfile);
+        fwrite(spawn.Name.data(), sizeof(char), nlen, dirfile);
+    }
+}
+
+// Threads take the next item until all of them are processed, the calling thread works too
+template<typename Work>
+void ProcessInParallel(std::size_t count, Work work)
+{
+    std::atomic<std::size_t> next(0);
+    auto process = [&]()
+    {
+        for (std::size_t i = next++; i < count; i = next++)
+            work(i);
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < std::min<std::size_t>(threadCount, count); ++i)
+        threads.emplace_back(process);
+
+    process();
+
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
 // Local testing functions
 
 bool FileExists(char const* file)
@@ -82,9 +147,8 @@ void strToLower(char* str)
     }
 }
 
-bool ExtractSingleWmo(std::string& fname)
+ModelExtraction* RegisterWmo(std::string& fname)
 {
-    // Copy files from archive
     std::string originalName = fname;
 
     char szLocalFile[1024];
@@ -93,8 +157,16 @@ bool ExtractSingleWmo(std::string& fname)
     fixname2(plain_name, strlen(plain_name));
     sprintf(szLocalFile, "%s/%s", szWorkDirWmo, plain_name);
 
-    if (FileExists(szLocalFile))
-        return true;
+    auto [extracted, inserted] = ExtractedModels.try_emplace(szLocalFile);
+    ModelExtraction& wmo = extracted->second;
+    if (!inserted)
+        return &wmo;
+
+    // group files are converted with their root
+    wmo.Path = fname;
+    wmo.OutputPath = szLocalFile;
+    wmo.IsWmo = true;
+    PendingModels.push_back(&wmo);
 
     int p = 0;
     // Select root wmo files
@@ -112,25 +184,123 @@ bool ExtractSingleWmo(std::string& fname)
     }
 
     if (p == 3)
-        return true;
+        return &wmo;
 
-    bool file_ok = true;
     printf("Extracting %s\n", originalName.c_str());
-    WMORoot froot(originalName);
-    if (!froot.open())
+    wmo.Root = std::make_unique<WMORoot>(originalName);
+    if (!wmo.Root->open())
     {
         printf("Couldn't open RootWmo!!!\n");
-        return true;
+        wmo.Root.reset();
     }
-    FILE *output = fopen(szLocalFile,"wb");
+    return &wmo;
+}
+
+ModelExtraction* RegisterModel(std::string& fname)
+{
+    if (fname.length() < 4)
+        return nullptr;
+
+    std::string extension = fname.substr(fname.length() - 4, 4);
+    if (extension == ".mdx" || extension == ".MDX" || extension == ".mdl" || extension == ".MDL")
+    {
+        // replace .mdx -> .m2
+        fname.erase(fname.length()-2,2);
+        fname.append("2");
+    }
+    // >= 3.1.0 ADT MMDX section store filename.m2 filenames for corresponded .m2 file
+    // nothing do
+
+    std::string originalName = fname;
+
+    char* name = GetPlainName(&fname[0]);
+    fixnamen(name, strlen(name));
+    fixname2(name, strlen(name));
+
+    std::string output(szWorkDirWmo);
+    output += "/";
+    output += name;
+
+    auto [extracted, inserted] = ExtractedModels.try_emplace(output);
+    ModelExtraction& model = extracted->second;
+    if (inserted)
+    {
+        model.Path = originalName;
+        model.OutputPath = output;
+        PendingModels.push_back(&model);
+    }
+    return &model;
+}
+
+std::optional<int> ReadModelVertexCount(std::string const& outputPath)
+{
+    FILE* input = fopen(outputPath.c_str(), "rb");
+    if (!input)
+        return {};
+
+    fseek(input, 8, SEEK_SET); // get the correct no of vertices
+    int nVertices;
+    int count = fread(&nVertices, sizeof(int), 1, input);
+    fclose(input);
+
+    if (count != 1)
+        return 0;
+
+    return nVertices;
+}
+
+void ExtractRegisteredModels()
+{
+    // wmos only keep the doodads whose model could be converted, all m2 models are converted before them
+    std::vector<ModelExtraction*> models;
+    std::vector<ModelExtraction*> wmos;
+    for (ModelExtraction* model : PendingModels)
+        (model->IsWmo ? wmos : models).push_back(model);
+
+    PendingModels.clear();
+
+    for (std::vector<ModelExtraction*> const* pending : { &models, &wmos })
+    {
+        ProcessInParallel(pending->size(), [pending](std::size_t i)
+        {
+            ModelExtraction& model = *(*pending)[i];
+            model.Result = model.IsWmo ? ExtractSingleWmo(model) : ExtractSingleModel(model);
+            model.VertexCount = ReadModelVertexCount(model.OutputPath);
+        });
+    }
+}
+
+std::optional<int> GetModelVertexCount(std::string const& outputPath)
+{
+    auto model = ExtractedModels.find(outputPath);
+    if (model != ExtractedModels.end())
+        return model->second.VertexCount;
+
+    return ReadModelVertexCount(outputPath);
+}
+
+bool ExtractSingleWmo(ModelExtraction& wmo)
+{
+    if (!wmo.Root)
+        return true;
+
+    WMORoot& froot = *wmo.Root;
+    char const* plain_name = GetPlainName(wmo.Path.c_str());
+
+    bool file_ok = true;
+    FILE *output = fopen(wmo.OutputPath.c_str(),"wb");
     if(!output)
     {
-        printf("couldn't open %s for writing!\n", szLocalFile);
+        printf("couldn't open %s for writing!\n", wmo.OutputPath.c_str());
         return false;
     }
     froot.ConvertToVMAPRootWmo(output);
-    WMODoodadData& doodads = WmoDoodads[plain_name];
-    std::swap(doodads, froot.DoodadData);
+    WMODoodadData* doodads;
+    {
+        std::lock_guard<std::mutex> lock(WmoDoodadsLock);
+        doodads = &WmoDoodads[plain_name];
+    }
+    std::swap(*doodads, froot.DoodadData);
     int Wmo_nVertices = 0;
     uint32 groupCount = 0;
     //printf("root has %d groups\n", froot->nGroups);
@@ -139,8 +309,8 @@ bool ExtractSingleWmo(std::string& fname)
         for (uint32 i = 0; i < froot.nGroups; ++i)
         {
             char temp[1024];
-            strncpy(temp, fname.c_str(), 1024);
-            temp[fname.length()-4] = 0;
+            strncpy(temp, wmo.Path.c_str(), 1024);
+            temp[wmo.Path.length()-4] = 0;
 
             WMOGroup fgroup(Trinity::StringFormat("{}_{:03}.wmo", temp, i));
             if (!fgroup.open(&froot))
@@ -157,14 +327,15 @@ bool ExtractSingleWmo(std::string& fname)
             ++groupCount;
             for (uint16 groupReference : fgroup.DoodadReferences)
             {
-                if (groupReference >= doodads.Spawns.size())
+                if (groupReference >= doodads->Spawns.size())
                     continue;
 
-                uint32 doodadNameIndex = doodads.Spawns[groupReference].NameIndex;
-                if (froot.ValidDoodadNames.find(doodadNameIndex) == froot.ValidDoodadNames.end())
+                uint32 doodadNameIndex = doodads->Spawns[groupReference].NameIndex;
+                auto doodadModel = froot.DoodadModels.find(doodadNameIndex);
+                if (doodadModel == froot.DoodadModels.end() || !doodadModel->second->Result)
                     continue;
 
-                doodads.References.insert(groupReference);
+                doodads->References.insert(groupReference);
             }
         }
     }
@@ -177,14 +348,23 @@ bool ExtractSingleWmo(std::string& fname)
 
     // Delete the extracted file in the case of an error
     if (!file_ok)
-        remove(szLocalFile);
+        remove(wmo.OutputPath.c_str());
+
+    wmo.Root.reset();
     return true;
 }
 
 void ParsMapFiles()
 {
+    std::string dirname = std::string(szWorkDirWmo) + "/dir_bin";
+    FILE* dirfile = fopen(dirname.c_str(), "ab");
+    if (!dirfile)
+    {
+        printf("Can't open dirfile!'%s'\n", dirname.c_str());
+        return;
+    }
+
     char fn[512];
-    //char id_filename[64];
     for (unsigned int i=0; i<map_count; ++i)
     {
         sprintf(fn,"World\\Maps\\%s\\%s.wdt", map_ids[i].name, map_ids[i].name);
@@ -192,23 +372,38 @@ void ParsMapFiles()
         if (WDT.init(map_ids[i].id))
         {
             printf("Processing Map %u\n[", map_ids[i].id);
+            // tiles register their models while they are read, in the order their spawns are written
+            std::vector<std::unique_ptr<ADTFile>> tiles;
             for (int x=0; x<64; ++x)
             {
                 for (int y=0; y<64; ++y)
                 {
-                    if (ADTFile *ADT = WDT.GetMap(x,y))
-                    {
-                        //sprintf(id_filename,"%02u %02u %03u",x,y,map_ids[i].id);//!!!!!!!!!
-                        ADT->init(map_ids[i].id, x, y);
-                        delete ADT;
-                    }
+                    std::unique_ptr<ADTFile> ADT(WDT.GetMap(x,y));
+                    if (ADT && ADT->init(map_ids[i].id, x, y))
+                        tiles.push_back(std::move(ADT));
                 }
                 printf("#");
                 fflush(stdout);
             }
             printf("]\n");
+
+            ExtractRegisteredModels();
+
+            std::vector<std::vector<ModelSpawn>> tileSpawns(tiles.size());
+            ProcessInParallel(tiles.size(), [&](std::size_t tile)
+            {
+                tiles[tile]->GetSpawns(tileSpawns[tile]);
+            });
+
+            std::vector<ModelSpawn> spawns;
+            WDT.GetSpawns(spawns);
+            WriteModelSpawns(spawns, dirfile);
+            for (std::vector<ModelSpawn> const& tile : tileSpawns)
+                WriteModelSpawns(tile, dirfile);
         }
     }
+
+    fclose(dirfile);
 }
 
 bool processArgv(int argc, char ** argv, const char *versionString)
@@ -248,6 +443,18 @@ bool processArgv(int argc, char ** argv, const char *versionString)
         {
             preciseVectorData = true;
         }
+        else if(strcmp("--threads",argv[i]) == 0)
+        {
+            if((i+1)<argc)
+            {
+                threadCount = std::max(1, atoi(argv[i + 1]));
+                ++i;
+            }
+            else
+            {
+                result = false;
+            }
+        }
         else
         {
             result = false;
@@ -257,10 +464,11 @@ bool processArgv(int argc, char ** argv, const char *versionString)
     if(!result)
     {
         printf("Extract %s.\n",versionString);
-        printf("%s [-?][-s][-l][-d <path>]\n", argv[0]);
+        printf("%s [-?][-s][-l][-d <path>][--threads <count>]\n", argv[0]);
         printf("   -s : (default) small size (data size optimization), ~500MB less vmap data.\n");
         printf("   -l : large size, ~500MB more vmap data. (might contain more details)\n");
         printf("   -d <path>: Path to the vector data source folder.\n");
+        printf("   --threads <count>: Number of threads converting models, all cores by default.\n");
         printf("   -? : This message.\n");
     }
     return result;
@@ -296,17 +504,27 @@ int main(int argc, char ** argv)
         boost::system::error_code ec;
         if (boost::filesystem::exists(sdir_bin, ec))
         {
-            printf("Your output directory seems to be polluted, please use an empty directory!\n");
-            printf("<press return to exit>");
-            char garbage[2];
-            return scanf("%c", garbage);
+            if (!boost::filesystem::exists(boost::filesystem::path(szWorkDirWmo) / "extraction.manifest", ec))
+            {
+                printf("Your output directory seems to be polluted, please use an empty directory!\n");
+                printf("<press return to exit>");
+                char garbage[2];
+                return scanf("%c", garbage);
+            }
+
+            // extracted by a previous run, spawns are collected again and unchanged models are kept
+            printf("Updating the previous extraction\n");
+            boost::filesystem::remove(sdir_bin, ec);
         }
     }
 
     printf("Extract %s. Beginning work ....\n", versionString);
+    printf("Converting models using %u threads\n", threadCount);
     //xxxxxxxxxxxxxxxxxxxxxxxxxxxxxx
     // Create the working directory
     success = boost::filesystem::create_directories(szWorkDirWmo) || boost::filesystem::is_directory(szWorkDirWmo);
+    if (success)
+        ModelManifest.Open();
 
     auto foundLocale = std::ranges::find_if(MpqLocaleNames, [](std::string_view localeName)
     {
@@ -357,6 +575,8 @@ int main(int argc, char ** argv)
         ExtractGameobjectModels();
     }
 
+    ModelManifest.Close();
+
     printf("\n");
     if (!success)
     {
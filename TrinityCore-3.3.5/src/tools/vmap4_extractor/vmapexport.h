@@ -19,8 +19,14 @@
 #define VMAPEXPORT_H
 
 #include "Define.h"
+#include "vec3d.h"
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <vector>
+#include <cstdio>
 
 enum ModelFlags
 {
@@ -30,17 +36,65 @@ enum ModelFlags
 };
 
 struct WMODoodadData;
+class WMORoot;
+class ExtractionManifest;
+
+// Models are extracted in two steps: maps and gameobjects register the models they use first, in the order they are
+// referenced, then the registered models are converted on several threads. The first model registered for an output
+// file is the one converted.
+struct ModelExtraction
+{
+    ModelExtraction();
+    ~ModelExtraction();
+
+    std::string Path;                   // name in the archives
+    std::string OutputPath;
+    bool IsWmo;
+    std::unique_ptr<WMORoot> Root;      // read when the wmo is registered, its doodad models are registered with it
+    bool Result;
+    // header of the output file once the model was converted, the file doesn't exist if unset
+    std::optional<int> VertexCount;
+};
+
+// Spawn of a model in dir_bin. Unique ids are assigned when the spawns are written, in the order of the tiles.
+struct ModelSpawn
+{
+    uint32 MapId;
+    uint32 TileX;
+    uint32 TileY;
+    uint32 Flags;
+    uint16 NameSet;
+    uint32 ClientId;
+    uint16 ClientDoodadId;
+    Vec3D Position;
+    Vec3D Rotation;
+    float Scale;
+    AaBox3D Bounds;                     // only written for MOD_HAS_BOUND
+    std::string Name;
+};
 
 extern const char * szWorkDirWmo;
 extern std::unordered_map<std::string, WMODoodadData> WmoDoodads;
+extern std::mutex WmoDoodadsLock;
+extern ExtractionManifest ModelManifest;
+extern std::unordered_map<std::string, ModelExtraction> ExtractedModels;
 
-uint32 GenerateUniqueObjectId(uint32 clientId, uint16 clientDoodadId);
+// assigns the unique ids in the order of the spawns
+void WriteModelSpawns(std::vector<ModelSpawn> const& spawns, FILE* dirfile);
 
 bool FileExists(const char * file);
 void strToLower(char* str);
 
-bool ExtractSingleWmo(std::string& fname);
-bool ExtractSingleModel(std::string& fname);
+// both return the registered model, nullptr if the name can't be a model
+ModelExtraction* RegisterWmo(std::string& fname);
+ModelExtraction* RegisterModel(std::string& fname);
+// converts the models registered since the last call
+void ExtractRegisteredModels();
+// vertex count of a converted model, unset if its file doesn't exist
+std::optional<int> GetModelVertexCount(std::string const& outputPath);
+
+bool ExtractSingleWmo(ModelExtraction& wmo);
+bool ExtractSingleModel(ModelExtraction& model);
 
 void ExtractGameobjectModels();
 
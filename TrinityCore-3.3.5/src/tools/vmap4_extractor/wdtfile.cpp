@@ -31,7 +31,7 @@ char * wdtGetPlainName(char * FileName)
     return FileName;
 }
 
-WDTFile::WDTFile(char* file_name, char* file_name1) : _file(file_name)
+WDTFile::WDTFile(char* file_name, char* file_name1) : _file(file_name), _mapId(0)
 {
     filename.append(file_name1,strlen(file_name1));
 }
@@ -44,18 +44,11 @@ bool WDTFile::init(uint32 mapId)
         return false;
     }
 
+    _mapId = mapId;
+
     char fourcc[5];
     uint32 size;
 
-    std::string dirname = std::string(szWorkDirWmo) + "/dir_bin";
-    FILE *dirfile;
-    dirfile = fopen(dirname.c_str(), "ab");
-    if(!dirfile)
-    {
-        printf("Can't open dirfile!'%s'\n", dirname.c_str());
-        return false;
-    }
-
     while (!_file.isEof())
     {
         _file.read(fourcc,4);
@@ -74,10 +67,9 @@ bool WDTFile::init(uint32 mapId)
             // global map objects
             if (size)
             {
-                char *buf = new char[size];
-                _file.read(buf, size);
-                char *p = buf;
-                while (p < buf + size)
+                std::span<char> names = _file.readSpan(size);
+                char *p = names.data();
+                while (p < names.data() + names.size())
                 {
                     std::string path(p);
 
@@ -87,9 +79,8 @@ bool WDTFile::init(uint32 mapId)
                     p = p + strlen(p) + 1;
                     _wmoNames.push_back(s);
 
-                    ExtractSingleWmo(path);
+                    RegisterWmo(path);
                 }
-                delete[] buf;
             }
         }
         else if (!strcmp(fourcc, "MODF"))
@@ -100,10 +91,8 @@ bool WDTFile::init(uint32 mapId)
                 uint32 mapObjectCount = size / sizeof(ADT::MODF);
                 for (uint32 i = 0; i < mapObjectCount; ++i)
                 {
-                    ADT::MODF mapObjDef;
+                    ADT::MODF& mapObjDef = _mapObjDefs.emplace_back();
                     _file.read(&mapObjDef, sizeof(ADT::MODF));
-                    MapObject::Extract(mapObjDef, _wmoNames[mapObjDef.Id].c_str(), mapId, 65, 65, dirfile);
-                    Doodad::ExtractSet(WmoDoodads[_wmoNames[mapObjDef.Id]], mapObjDef, mapId, 65, 65, dirfile);
                 }
             }
         }
@@ -111,10 +100,20 @@ bool WDTFile::init(uint32 mapId)
     }
 
     _file.close();
-    fclose(dirfile);
     return true;
 }
 
+void WDTFile::GetSpawns(std::vector<ModelSpawn>& spawns) const
+{
+    for (ADT::MODF const& mapObjDef : _mapObjDefs)
+    {
+        MapObject::Extract(mapObjDef, _wmoNames[mapObjDef.Id].c_str(), _mapId, 65, 65, spawns);
+        auto doodads = WmoDoodads.find(_wmoNames[mapObjDef.Id]);
+        if (doodads != WmoDoodads.end())
+            Doodad::ExtractSet(doodads->second, mapObjDef, _mapId, 65, 65, spawns);
+    }
+}
+
 WDTFile::~WDTFile(void)
 {
     _file.close();
@@ -19,9 +19,11 @@
 #define WDTFILE_H
 
 #include "mpq_libmpq.h"
+#include "adtfile.h"
 #include <string>
+#include <vector>
 
-class ADTFile;
+struct ModelSpawn;
 
 class WDTFile
 {
@@ -29,14 +31,19 @@ public:
     WDTFile(char* file_name, char* file_name1);
     ~WDTFile(void);
 
+    // reads the global map objects and registers their models
     bool init(uint32 mapId);
     ADTFile* GetMap(int x, int z);
+    // spawns of the global map objects, their models must have been converted
+    void GetSpawns(std::vector<ModelSpawn>& spawns) const;
 
     std::vector<std::string> _wmoNames;
 
 private:
     MPQFile _file;
     std::string filename;
+    uint32 _mapId;
+    std::vector<ADT::MODF> _mapObjDefs;
 };
 
 #endif
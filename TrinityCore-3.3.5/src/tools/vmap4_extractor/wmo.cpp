@@ -97,8 +97,8 @@ bool WMORoot::open()
                 uint32 doodadNameIndex = ptr - f.getPointer();
                 ptr += path.length() + 1;
 
-                if (ExtractSingleModel(path))
-                    ValidDoodadNames.insert(doodadNameIndex);
+                if (ModelExtraction const* model = RegisterModel(path))
+                    DoodadModels[doodadNameIndex] = model;
             }
         }
         else if (!strcmp(fourcc,"MODD"))
@@ -524,7 +524,7 @@ WMOGroup::~WMOGroup()
     delete [] LiquBytes;
 }
 
-void MapObject::Extract(ADT::MODF const& mapObjDef, char const* WmoInstName, uint32 mapID, uint32 tileX, uint32 tileY, FILE* pDirfile)
+void MapObject::Extract(ADT::MODF const& mapObjDef, char const* WmoInstName, uint32 mapID, uint32 tileX, uint32 tileY, std::vector<ModelSpawn>& spawns)
 {
     // destructible wmo, do not dump. we can handle the vmap for these
     // in dynamic tree (gameobject vmaps)
@@ -535,21 +535,14 @@ void MapObject::Extract(ADT::MODF const& mapObjDef, char const* WmoInstName, uin
 
     char tempname[512];
     sprintf(tempname, "%s/%s", szWorkDirWmo, WmoInstName);
-    FILE *input;
-    input = fopen(tempname, "r+b");
-
-    if (!input)
+    std::optional<int> nVertices = GetModelVertexCount(tempname);
+    if (!nVertices)
     {
         printf("WMOInstance::WMOInstance: couldn't open %s\n", tempname);
         return;
     }
 
-    fseek(input, 8, SEEK_SET); // get the correct no of vertices
-    int nVertices;
-    int count = fread(&nVertices, sizeof(int), 1, input);
-    fclose(input);
-
-    if (count != 1 || nVertices == 0)
+    if (*nVertices == 0)
         return;
 
     Vec3D position = mapObjDef.Position;
@@ -567,23 +560,20 @@ void MapObject::Extract(ADT::MODF const& mapObjDef, char const* WmoInstName, uin
     bounds.min = fixCoords(mapObjDef.Bounds.min);
     bounds.max = fixCoords(mapObjDef.Bounds.max);
 
-    float scale = 1.0f;
-    uint32 uniqueId = GenerateUniqueObjectId(mapObjDef.UniqueId, 0);
     uint32 flags = MOD_HAS_BOUND;
     if (tileX == 65 && tileY == 65) flags |= MOD_WORLDSPAWN;
-    //write mapID, tileX, tileY, Flags, NameSet, UniqueId, Pos, Rot, Scale, Bound_lo, Bound_hi, name
-    fwrite(&mapID, sizeof(uint32), 1, pDirfile);
-    fwrite(&tileX, sizeof(uint32), 1, pDirfile);
-    fwrite(&tileY, sizeof(uint32), 1, pDirfile);
-    fwrite(&flags, sizeof(uint32), 1, pDirfile);
-    fwrite(&mapObjDef.NameSet, sizeof(uint16), 1, pDirfile);
-    fwrite(&uniqueId, sizeof(uint32), 1, pDirfile);
-    fwrite(&position, sizeof(Vec3D), 1, pDirfile);
-    fwrite(&mapObjDef.Rotation, sizeof(Vec3D), 1, pDirfile);
-    fwrite(&scale, sizeof(float), 1, pDirfile);
-    fwrite(&bounds, sizeof(AaBox3D), 1, pDirfile);
-    uint32 nlen = strlen(WmoInstName);
-    fwrite(&nlen, sizeof(uint32), 1, pDirfile);
-    fwrite(WmoInstName, sizeof(char), nlen, pDirfile);
 
+    ModelSpawn& spawn = spawns.emplace_back();
+    spawn.MapId = mapID;
+    spawn.TileX = tileX;
+    spawn.TileY = tileY;
+    spawn.Flags = flags;
+    spawn.NameSet = mapObjDef.NameSet;
+    spawn.ClientId = mapObjDef.UniqueId;
+    spawn.ClientDoodadId = 0;
+    spawn.Position = position;
+    spawn.Rotation = mapObjDef.Rotation;
+    spawn.Scale = 1.0f;
+    spawn.Bounds = bounds;
+    spawn.Name = WmoInstName;
 }
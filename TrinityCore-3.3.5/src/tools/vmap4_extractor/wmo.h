@@ -19,6 +19,7 @@
 #define WMO_H
 
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <memory>
@@ -38,6 +39,8 @@ enum MopyFlags
     WMO_MATERIAL_COLLIDE_HIT    = 0x80
 };
 
+struct ModelExtraction;
+struct ModelSpawn;
 class WMOInstance;
 class WMOManager;
 class MPQFile;
@@ -86,7 +89,8 @@ public:
 
     std::vector<char> GroupNames;
     WMODoodadData DoodadData;
-    std::unordered_set<uint32> ValidDoodadNames;
+    // doodad models registered by the offset of their name
+    std::unordered_map<uint32, ModelExtraction const*> DoodadModels;
 
     WMORoot(std::string const& filename);
 
@@ -159,7 +163,7 @@ public:
 
 namespace MapObject
 {
-    void Extract(ADT::MODF const& mapObjDef, char const* WmoInstName, uint32 mapID, uint32 tileX, uint32 tileY, FILE* pDirfile);
+    void Extract(ADT::MODF const& mapObjDef, char const* WmoInstName, uint32 mapID, uint32 tileX, uint32 tileY, std::vector<ModelSpawn>& spawns);
 }
 
 #endif
@@ -21,8 +21,12 @@
 #include "ItemDefines.h"
 #include "ItemTemplate.h"
 #include "ObjectMgr.h"
+#include "Player.h"
+#include "RBAC.h"
+#include "ReputationMgr.h"
 #include "SpellInfo.h"
 #include "SpellMgr.h"
+#include "WorldSession.h"
 
 /*static*/ ItemTemplate& UnitTestDataLoader::GetItemTemplate(uint32 itemId, std::string_view name)
 {
@@ -155,6 +159,87 @@ static UnitTestDataLoader::DBC<AchievementEntry, &AchievementEntry::ID> achievem
     toc5.Title[LOCALE_esES] = "Heroico: Prueba del Campe\xc3\xb3n";
     toc5.Category = 14921;
     toc5.Points = 10;
+
+    // not in the client: a reputation criteria, which can be lost again, next to one that can't
+    AchievementEntry& ambassador = loader.Add();
+    ambassador = {};
+    ambassador.ID = 10000;
+    ambassador.Faction = ACHIEVEMENT_FACTION_ANY;
+    ambassador.InstanceID = -1;
+    ambassador.Title.fill("");
+    ambassador.Title[LOCALE_enUS] = "Exalted Ambassador";
+    ambassador.Points = 10;
+    ambassador.Flags = ACHIEVEMENT_FLAG_HIDDEN;
+}
+
+static UnitTestDataLoader::DBC<AchievementCriteriaEntry, &AchievementCriteriaEntry::ID> achievementCriteria(sAchievementCriteriaStore);
+/*static*/ void UnitTestDataLoader::LoadAchievementCriteria()
+{
+    if (!achievementCriteria.Empty())
+        return;
+
+    LoadAchievementTemplates();
+
+    {
+        auto loader = achievementCriteria.Loader();
+        auto addBossKill = [&loader](uint32 id, uint32 creatureId)
+        {
+            AchievementCriteriaEntry& criteria = loader.Add();
+            criteria = {};
+            criteria.ID = id;
+            criteria.AchievementID = 4298;
+            criteria.Type = ACHIEVEMENT_CRITERIA_TYPE_KILL_CREATURE;
+            criteria.Asset.CreatureID = creatureId;
+            criteria.Quantity = 1;
+        };
+
+        addBossKill(11497, 35119); // Eadric the Pure
+        addBossKill(11498, 34928); // Argent Confessor Paletress
+        addBossKill(11789, 35451); // The Black Knight
+
+        AchievementCriteriaEntry& exalted = loader.Add();
+        exalted = {};
+        exalted.ID = 20000;
+        exalted.AchievementID = 10000;
+        exalted.Type = ACHIEVEMENT_CRITERIA_TYPE_GAIN_EXALTED_REPUTATION;
+        exalted.Quantity = 1;
+
+        AchievementCriteriaEntry& kill = loader.Add();
+        kill = {};
+        kill.ID = 20001;
+        kill.AchievementID = 10000;
+        kill.Type = ACHIEVEMENT_CRITERIA_TYPE_KILL_CREATURE;
+        kill.Asset.CreatureID = 23576; // Nalorakk
+        kill.Quantity = 1;
+    }
+
+    sAchievementMgr->LoadAchievementCriteriaList();
+}
+
+/*static*/ Player* UnitTestDataLoader::CreatePlayer()
+{
+    WorldSession* session = new WorldSession(1, "TEST", nullptr, SEC_PLAYER, EXPANSION_WRATH_OF_THE_LICH_KING, 0, Minutes(0), LOCALE_enUS, 0, false);
+    // no permissions loaded from the db
+    session->_RBACData = new rbac::RBACData(1, "TEST", 1, SEC_PLAYER);
+    return new Player(session);
+}
+
+/*static*/ void UnitTestDataLoader::DeletePlayer(Player* player)
+{
+    WorldSession* session = player->GetSession();
+    delete player;
+    delete session;
+}
+
+/*static*/ void UnitTestDataLoader::SetExaltedFactionCount(Player* player, uint8 count)
+{
+    player->GetReputationMgr()._exaltedFactionCount = count;
+}
+
+/*static*/ uint32 UnitTestDataLoader::GetCriteriaCounter(AchievementMgr const& achievementMgr, uint32 criteriaId)
+{
+    auto itr = achievementMgr.m_criteriaProgress.find(criteriaId);
+    return itr != achievementMgr.m_criteriaProgress.end() ? itr->second.counter : 0;
 }
 
 static UnitTestDataLoader::DBC<SpellEntry, &SpellEntry::ID> spells(sSpellStore);
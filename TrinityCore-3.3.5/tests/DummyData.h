@@ -27,6 +27,8 @@
 
 struct ItemTemplate;
 
+class AchievementMgr;
+class Player;
 class SpellInfo;
 
 class UnitTestDataLoader
@@ -73,9 +75,16 @@ class UnitTestDataLoader
         };
 
         static void LoadAchievementTemplates();
+        static void LoadAchievementCriteria();
         static void LoadItemTemplates();
         static void LoadSpellInfo();
 
+        // a player that only exists in memory: no socket, no map and no permissions
+        static Player* CreatePlayer();
+        static void DeletePlayer(Player* player);
+        static void SetExaltedFactionCount(Player* player, uint8 count);
+        static uint32 GetCriteriaCounter(AchievementMgr const& achievementMgr, uint32 criteriaId);
+
     private:
         static ItemTemplate& GetItemTemplate(uint32 id, std::string_view name);
         static void SetItemLocale(uint32 id, LocaleConstant locale, std::string_view name);
@@ -0,0 +1,211 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "AsyncLogQueue.h"
+#include "LogMessage.h"
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Trinity::Logging;
+
+namespace
+{
+struct WrittenMessages
+{
+    std::mutex Lock;
+    std::vector<std::string> Filters;
+    std::vector<std::string> Texts;
+    uint32 Flushes = 0;
+
+    AsyncLogQueue::WriteFn Writer()
+    {
+        return [this](LogMessage* message)
+        {
+            std::lock_guard<std::mutex> lock(Lock);
+            Filters.push_back(message->type);
+            Texts.push_back(message->text);
+        };
+    }
+
+    AsyncLogQueue::FlushFn Flusher()
+    {
+        return [this]
+        {
+            std::lock_guard<std::mutex> lock(Lock);
+            ++Flushes;
+        };
+    }
+};
+
+template <typename... Args>
+void Enqueue(AsyncLogQueue& queue, std::string_view filter, Trinity::FormatString<Args...> fmt, Args&&... args)
+{
+    static_assert(AreArgsDeferrable<Args...>);
+    REQUIRE(queue.EnqueueDeferred(filter, LOG_LEVEL_INFO, fmt, args...));
+}
+}
+
+TEST_CASE("Deferred formatting", "[AsyncLogQueue]")
+{
+    WrittenMessages written;
+    {
+        AsyncLogQueue queue({}, written.Writer(), written.Flusher());
+
+        std::string name = "Arthas";
+        char const* zone = "Icecrown";
+        Enqueue(queue, "entities.player", "Player {} (guid {}) entered {} at {:.2f} with {}% health, {}", name, uint64(0x1234), zone, 12.5f, int8(-3), true);
+        Enqueue(queue, "maps", "{:>6}|{:<4}|{}", std::string_view("abc"), 'x', "literal");
+        Enqueue(queue, "server", "no arguments");
+
+        queue.Flush();
+        REQUIRE(written.Flushes >= 1);
+    }
+
+    REQUIRE(written.Texts.size() == 3);
+    REQUIRE(written.Filters[0] == "entities.player");
+    REQUIRE(written.Texts[0] == "Player Arthas (guid 4660) entered Icecrown at 12.50 with -3% health, true");
+    REQUIRE(written.Filters[1] == "maps");
+    REQUIRE(written.Texts[1] == "   abc|x   |literal");
+    REQUIRE(written.Texts[2] == "no arguments");
+}
+
+TEST_CASE("Arguments that cannot be deferred", "[AsyncLogQueue]")
+{
+    WrittenMessages written;
+    AsyncLogQueue queue({}, written.Writer(), written.Flusher());
+
+    char const* null = nullptr;
+    REQUIRE_FALSE(queue.EnqueueDeferred("server", LOG_LEVEL_INFO, "{}", null));
+
+    std::string huge(1024 * 1024, 'x');
+    REQUIRE_FALSE(queue.EnqueueDeferred("server", LOG_LEVEL_INFO, "{}", huge));
+
+    // too large for the ring, passed along as a whole message instead
+    REQUIRE(queue.EnqueueFormatted("server", LOG_LEVEL_INFO, "{}", Trinity::MakeFormatArgs(huge)));
+    queue.Flush();
+
+    REQUIRE(written.Texts.size() == 1);
+    REQUIRE(written.Texts[0] == huge);
+}
+
+TEST_CASE("Messages keep their per thread order", "[AsyncLogQueue]")
+{
+    constexpr uint32 Threads = 4;
+    constexpr uint32 MessagesPerThread = 20000;
+
+    WrittenMessages written;
+    {
+        AsyncLogOptions options;
+        options.QueueSize = 4096;
+        options.DropPolicy = LogDropPolicy::Block;
+        options.FlushInterval = 1ms;
+        AsyncLogQueue queue(options, written.Writer(), written.Flusher());
+
+        std::vector<std::thread> producers;
+        for (uint32 t = 0; t < Threads; ++t)
+        {
+            producers.emplace_back([&queue, t]
+            {
+                for (uint32 i = 0; i < MessagesPerThread; ++i)
+                    queue.EnqueueDeferred("server", LOG_LEVEL_INFO, "{} {}", t, i);
+            });
+        }
+
+        for (std::thread& producer : producers)
+            producer.join();
+
+        REQUIRE(queue.GetDroppedCount() == 0);
+    }
+
+    REQUIRE(written.Texts.size() == Threads * MessagesPerThread);
+
+    std::vector<uint32> next(Threads, 0);
+    uint32 outOfOrder = 0;
+    for (std::string const& text : written.Texts)
+    {
+        uint32 thread = 0, index = 0;
+        std::sscanf(text.c_str(), "%u %u", &thread, &index);
+        if (next[thread]++ != index)
+            ++outOfOrder;
+    }
+
+    REQUIRE(outOfOrder == 0);
+}
+
+TEST_CASE("Dropping messages when the queue is full", "[AsyncLogQueue]")
+{
+    WrittenMessages written;
+    std::mutex stallWriter;
+    uint32 sent = 0;
+    uint64 dropped = 0;
+    {
+        AsyncLogOptions options;
+        options.QueueSize = 4096;
+        options.DropPolicy = LogDropPolicy::DropNewest;
+        options.FlushInterval = 1ms;
+
+        AsyncLogQueue queue(options, [&](LogMessage* message)
+        {
+            std::lock_guard<std::mutex> stall(stallWriter);
+            written.Writer()(message);
+        }, written.Flusher());
+
+        {
+            // the logger thread is stuck writing, the ring of this thread has to overflow
+            std::lock_guard<std::mutex> stall(stallWriter);
+            for (; sent < 1000; ++sent)
+                queue.EnqueueDeferred("server", LOG_LEVEL_INFO, "message {}", sent);
+        }
+
+        queue.Flush();
+        dropped = queue.GetDroppedCount();
+    }
+
+    REQUIRE(dropped > 0);
+
+    // every message either made it or was counted, plus one report about the drops
+    REQUIRE(written.Texts.size() == sent - dropped + 1);
+    REQUIRE(written.Filters.back() == "server");
+    REQUIRE(written.Texts.back().find(std::to_string(dropped)) != std::string::npos);
+}
+
+TEST_CASE("Logging thread cost", "[AsyncLogQueue][.][benchmark]")
+{
+    std::string name = "Arthas";
+    uint64 guid = 0x1234;
+    float x = 5764.61f, y = 2068.95f;
+
+    // what the calling thread paid before: formatting and a heap allocated LogMessage per line
+    BENCHMARK("Format on calling thread")
+    {
+        return std::make_unique<LogMessage>(LOG_LEVEL_DEBUG, "maps", Trinity::StringFormat("Player {} (guid {}) moved to {} {}", name, guid, x, y));
+    };
+
+    AsyncLogOptions options;
+    options.QueueSize = 16 * 1024 * 1024;
+    options.DropPolicy = LogDropPolicy::Block;
+    AsyncLogQueue queue(options, [](LogMessage*) { }, [] { });
+
+    BENCHMARK("Enqueue deferred arguments")
+    {
+        return queue.EnqueueDeferred("maps", LOG_LEVEL_DEBUG, "Player {} (guid {}) moved to {} {}", name, guid, x, y);
+    };
+}
@@ -0,0 +1,247 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "ConcurrentPointerMap.h"
+#include <array>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+struct DummyPlayer
+{
+    uint64 Guid;
+};
+
+// HighGuid::Player is 0, raw player guids are their sequential low guid
+constexpr uint64 MakeGuid(uint32 counter) { return counter; }
+}
+
+TEST_CASE("Insert, find and remove", "[ConcurrentPointerMap]")
+{
+    Trinity::Containers::ConcurrentPointerMap<DummyPlayer> map;
+    DummyPlayer first{ MakeGuid(1) };
+    DummyPlayer second{ MakeGuid(2) };
+
+    REQUIRE(map.Find(first.Guid) == nullptr);
+
+    map.Insert(first.Guid, &first);
+    map.Insert(second.Guid, &second);
+    REQUIRE(map.Size() == 2);
+    REQUIRE(map.Find(first.Guid) == &first);
+    REQUIRE(map.Find(second.Guid) == &second);
+    REQUIRE(map.Find(MakeGuid(3)) == nullptr);
+
+    map.Remove(first.Guid);
+    REQUIRE(map.Size() == 1);
+    REQUIRE(map.Find(first.Guid) == nullptr);
+    REQUIRE(map.Find(second.Guid) == &second);
+
+    SECTION("Removing twice is harmless")
+    {
+        map.Remove(first.Guid);
+        REQUIRE(map.Size() == 1);
+    }
+
+    SECTION("Reinserting reuses the slot")
+    {
+        std::size_t capacity = map.Capacity();
+        map.Insert(first.Guid, &first);
+        REQUIRE(map.Size() == 2);
+        REQUIRE(map.Capacity() == capacity);
+        REQUIRE(map.Find(first.Guid) == &first);
+    }
+
+    SECTION("Inserting an existing key replaces the value")
+    {
+        DummyPlayer replacement{ second.Guid };
+        map.Insert(second.Guid, &replacement);
+        REQUIRE(map.Size() == 1);
+        REQUIRE(map.Find(second.Guid) == &replacement);
+    }
+}
+
+TEST_CASE("Growth and removed key cleanup", "[ConcurrentPointerMap]")
+{
+    Trinity::Containers::ConcurrentPointerMap<DummyPlayer> map;
+    std::vector<DummyPlayer> players(5000);
+    for (uint32 i = 0; i < players.size(); ++i)
+    {
+        players[i].Guid = MakeGuid(i + 1);
+        map.Insert(players[i].Guid, &players[i]);
+    }
+
+    REQUIRE(map.Size() == players.size());
+    for (DummyPlayer& player : players)
+        REQUIRE(map.Find(player.Guid) == &player);
+
+    // logging out everyone but a few must not keep the table at its peak size forever
+    for (uint32 i = 10; i < players.size(); ++i)
+        map.Remove(players[i].Guid);
+
+    for (uint32 i = 0; i < 20000; ++i)
+    {
+        DummyPlayer& player = players[10 + i % 100];
+        player.Guid = MakeGuid(100000 + i);
+        map.Insert(player.Guid, &player);
+        map.Remove(player.Guid);
+    }
+
+    REQUIRE(map.Size() == 10);
+    REQUIRE(map.Capacity() < 1024);
+    for (uint32 i = 0; i < 10; ++i)
+        REQUIRE(map.Find(players[i].Guid) == &players[i]);
+
+    sEpochReclaimer->Reclaim();
+    REQUIRE(sEpochReclaimer->GetRetiredCount() == 0);
+}
+
+TEST_CASE("Lookups during writer churn", "[ConcurrentPointerMap]")
+{
+    Trinity::Containers::ConcurrentPointerMap<DummyPlayer> map;
+    std::vector<DummyPlayer> players(2000);
+    for (uint32 i = 0; i < players.size(); ++i)
+        players[i].Guid = MakeGuid(i + 1);
+
+    for (uint32 i = 0; i < players.size(); i += 2)
+        map.Insert(players[i].Guid, &players[i]);
+
+    std::atomic<bool> stop = false;
+    std::atomic<uint32> errors = 0;
+    std::vector<std::thread> readers;
+    for (uint32 t = 0; t < 4; ++t)
+    {
+        readers.emplace_back([&, t]
+        {
+            while (!stop.load(std::memory_order_relaxed))
+            {
+                for (uint32 i = t; i < players.size(); i += 4)
+                {
+                    DummyPlayer* found = map.Find(players[i].Guid);
+                    // odd players come and go, even players must always be there
+                    if ((found && found != &players[i]) || (!found && i % 2 == 0))
+                        ++errors;
+                }
+            }
+        });
+    }
+
+    for (uint32 round = 0; round < 50; ++round)
+    {
+        for (uint32 i = 1; i < players.size(); i += 2)
+            map.Insert(players[i].Guid, &players[i]);
+        for (uint32 i = 1; i < players.size(); i += 2)
+            map.Remove(players[i].Guid);
+    }
+
+    stop = true;
+    for (std::thread& reader : readers)
+        reader.join();
+
+    REQUIRE(errors == 0);
+    REQUIRE(map.Size() == players.size() / 2);
+}
+
+TEST_CASE("Player lookup contention", "[ConcurrentPointerMap][.][benchmark]")
+{
+    constexpr uint32 OnlinePlayers = 3000;
+    constexpr uint32 ReaderThreads = 16;
+    constexpr uint32 LookupsPerReader = 200000;
+
+    std::vector<DummyPlayer> players(OnlinePlayers + 100);
+    for (uint32 i = 0; i < players.size(); ++i)
+        players[i].Guid = MakeGuid(i + 1);
+
+    // 16 map/session threads looking players up while one thread logs characters in and out
+    auto run = [&](auto find, auto insert, auto remove)
+    {
+        std::atomic<bool> stop = false;
+        std::thread writer([&]
+        {
+            for (uint32 i = 0; !stop.load(std::memory_order_relaxed); i = (i + 1) % 100)
+            {
+                DummyPlayer& player = players[OnlinePlayers + i];
+                insert(player);
+                remove(player);
+            }
+        });
+
+        std::array<uint32, ReaderThreads> found = { };
+        std::vector<std::thread> readers;
+        for (uint32 t = 0; t < ReaderThreads; ++t)
+        {
+            readers.emplace_back([&, t]
+            {
+                uint32 hits = 0;
+                for (uint32 i = 0; i < LookupsPerReader; ++i)
+                    if (find(players[(i * 7 + t) % players.size()].Guid))
+                        ++hits;
+
+                found[t] = hits;
+            });
+        }
+
+        for (std::thread& reader : readers)
+            reader.join();
+
+        stop = true;
+        writer.join();
+        return found[0];
+    };
+
+    {
+        std::unordered_map<uint64, DummyPlayer*> map;
+        std::shared_mutex lock;
+        for (uint32 i = 0; i < OnlinePlayers; ++i)
+            map[players[i].Guid] = &players[i];
+
+        BENCHMARK("std::shared_mutex + std::unordered_map")
+        {
+            return run([&](uint64 guid) -> DummyPlayer*
+            {
+                std::shared_lock<std::shared_mutex> guard(lock);
+                auto itr = map.find(guid);
+                return itr != map.end() ? itr->second : nullptr;
+            }, [&](DummyPlayer& player)
+            {
+                std::unique_lock<std::shared_mutex> guard(lock);
+                map[player.Guid] = &player;
+            }, [&](DummyPlayer& player)
+            {
+                std::unique_lock<std::shared_mutex> guard(lock);
+                map.erase(player.Guid);
+            });
+        };
+    }
+
+    {
+        Trinity::Containers::ConcurrentPointerMap<DummyPlayer> map;
+        for (uint32 i = 0; i < OnlinePlayers; ++i)
+            map.Insert(players[i].Guid, &players[i]);
+
+        BENCHMARK("ConcurrentPointerMap")
+        {
+            return run([&](uint64 guid) { return map.Find(guid); },
+                [&](DummyPlayer& player) { map.Insert(player.Guid, &player); },
+                [&](DummyPlayer& player) { map.Remove(player.Guid); });
+        };
+    }
+}
@@ -0,0 +1,140 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "DenseIndex.h"
+#include <memory>
+#include <unordered_map>
+
+namespace
+{
+struct DummyTemplate
+{
+    uint32 Entry;
+};
+
+using DummyTemplateContainer = std::unordered_map<uint32, DummyTemplate>;
+
+DummyTemplateContainer MakeStore(std::initializer_list<uint32> entries)
+{
+    DummyTemplateContainer store;
+    for (uint32 entry : entries)
+        store[entry].Entry = entry;
+    return store;
+}
+
+auto const ProjectTemplate = [](DummyTemplate const& dummy) { return &dummy; };
+}
+
+TEST_CASE("Lookup", "[DenseIndex]")
+{
+    DummyTemplateContainer store = MakeStore({ 1, 2, 3, 10, 25 });
+    Trinity::Containers::DenseIndex<DummyTemplate const> index;
+
+    REQUIRE_FALSE(index.IsEnabled());
+    REQUIRE(index.Find(1) == nullptr);
+
+    index.Build(store, ProjectTemplate);
+
+    REQUIRE(index.IsEnabled());
+    REQUIRE(index.Capacity() == 26);
+    for (auto const& [entry, dummy] : store)
+        REQUIRE(index.Find(entry) == &dummy);
+
+    REQUIRE(index.Find(0) == nullptr);
+    REQUIRE(index.Find(4) == nullptr);
+    REQUIRE(index.Find(26) == nullptr);
+    REQUIRE(index.Find(0xFFFFFFFF) == nullptr);
+}
+
+TEST_CASE("Sparse keys", "[DenseIndex]")
+{
+    DummyTemplateContainer store = MakeStore({ 1, 2, 3, 500000 });
+    Trinity::Containers::DenseIndex<DummyTemplate const> index;
+    index.Build(store, ProjectTemplate);
+
+    REQUIRE_FALSE(index.IsEnabled());
+    REQUIRE(index.Capacity() == 0);
+}
+
+TEST_CASE("Insert after build", "[DenseIndex]")
+{
+    DummyTemplateContainer store = MakeStore({ 1, 2, 3 });
+    Trinity::Containers::DenseIndex<DummyTemplate const> index;
+    index.Build(store, ProjectTemplate);
+
+    SECTION("Key within dense range")
+    {
+        DummyTemplate& dummy = store[20];
+        index.Insert(20, &dummy);
+
+        REQUIRE(index.IsEnabled());
+        REQUIRE(index.Find(20) == &dummy);
+    }
+
+    SECTION("Key too far away disables the index")
+    {
+        DummyTemplate& dummy = store[1000000];
+        index.Insert(1000000, &dummy);
+
+        REQUIRE_FALSE(index.IsEnabled());
+        REQUIRE(index.Find(1) == nullptr);
+    }
+}
+
+TEST_CASE("Owning pointer store", "[DenseIndex]")
+{
+    std::unordered_map<uint32, std::unique_ptr<DummyTemplate>> store;
+    store.emplace(7, std::make_unique<DummyTemplate>(DummyTemplate{ 7 }));
+
+    Trinity::Containers::DenseIndex<DummyTemplate const> index;
+    index.Build(store, [](std::unique_ptr<DummyTemplate> const& dummy) -> DummyTemplate const* { return dummy.get(); });
+
+    REQUIRE(index.Find(7) == store[7].get());
+}
+
+TEST_CASE("Lookup latency", "[DenseIndex][.][benchmark]")
+{
+    // entry distribution similar to item_template: ~40k rows spread over ids up to ~56k
+    DummyTemplateContainer store;
+    for (uint32 entry = 1; entry < 56000; ++entry)
+        if (entry % 7 != 0 && entry % 5 != 0)
+            store[entry].Entry = entry;
+
+    Trinity::Containers::DenseIndex<DummyTemplate const> index;
+    index.Build(store, ProjectTemplate);
+    REQUIRE(index.IsEnabled());
+
+    BENCHMARK("std::unordered_map")
+    {
+        uint32 found = 0;
+        for (uint32 entry = 0; entry < 60000; ++entry)
+            if (store.find(entry) != store.end())
+                ++found;
+        return found;
+    };
+
+    BENCHMARK("DenseIndex")
+    {
+        uint32 found = 0;
+        for (uint32 entry = 0; entry < 60000; ++entry)
+            if (index.Find(entry))
+                ++found;
+        return found;
+    };
+}
@@ -0,0 +1,472 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "EventProcessor.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace
+{
+// what EventProcessor used to be: a std::multimap of heap allocated events, kept to compare and benchmark against
+class ReferenceBasicEvent
+{
+public:
+    virtual ~ReferenceBasicEvent() { }
+    virtual bool Execute(uint64 /*e_time*/, uint32 /*p_time*/) { return true; }
+    virtual bool IsDeletable() const { return true; }
+    virtual void Abort(uint64 /*e_time*/) { }
+
+    void ScheduleAbort() { AbortScheduled = true; }
+
+    bool AbortScheduled = false;
+    bool Aborted = false;
+    uint64 AddTime = 0;
+    uint64 ExecTime = 0;
+};
+
+class ReferenceEventProcessor
+{
+public:
+    ~ReferenceEventProcessor()
+    {
+        for (std::pair<uint64 const, ReferenceBasicEvent*>& event : _events)
+            delete event.second;
+    }
+
+    void Update(uint32 p_time)
+    {
+        _time += p_time;
+
+        std::multimap<uint64, ReferenceBasicEvent*>::iterator i;
+        while (((i = _events.begin()) != _events.end()) && i->first <= _time)
+        {
+            ReferenceBasicEvent* event = i->second;
+            _events.erase(i);
+
+            if (!event->AbortScheduled && !event->Aborted)
+            {
+                if (event->Execute(_time, p_time))
+                    delete event;
+                continue;
+            }
+
+            if (event->AbortScheduled)
+            {
+                event->Abort(_time);
+                event->AbortScheduled = false;
+                event->Aborted = true;
+            }
+
+            if (event->IsDeletable())
+            {
+                delete event;
+                continue;
+            }
+
+            AddEvent(event, CalculateTime(1ms), false);
+        }
+    }
+
+    void AddEvent(ReferenceBasicEvent* event, Milliseconds e_time, bool set_addtime = true)
+    {
+        if (set_addtime)
+            event->AddTime = _time;
+        event->ExecTime = e_time.count();
+        _events.insert(std::pair<uint64, ReferenceBasicEvent*>(e_time.count(), event));
+    }
+
+    void AddEventAtOffset(ReferenceBasicEvent* event, Milliseconds offset) { AddEvent(event, CalculateTime(offset)); }
+
+    void ModifyEventTime(ReferenceBasicEvent* event, Milliseconds newTime)
+    {
+        for (auto itr = _events.begin(); itr != _events.end(); ++itr)
+        {
+            if (itr->second != event)
+                continue;
+
+            event->ExecTime = newTime.count();
+            _events.erase(itr);
+            _events.insert(std::pair<uint64, ReferenceBasicEvent*>(newTime.count(), event));
+            break;
+        }
+    }
+
+    void KillAllEvents(bool force)
+    {
+        for (auto itr = _events.begin(); itr != _events.end();)
+        {
+            if (!itr->second->Aborted)
+            {
+                itr->second->Aborted = true;
+                itr->second->Abort(_time);
+            }
+
+            if (!force && !itr->second->IsDeletable())
+            {
+                ++itr;
+                continue;
+            }
+
+            delete itr->second;
+            itr = _events.erase(itr);
+        }
+    }
+
+    Milliseconds CalculateTime(Milliseconds t_offset) const { return Milliseconds(_time) + t_offset; }
+
+private:
+    uint64 _time = 0;
+    std::multimap<uint64, ReferenceBasicEvent*> _events;
+};
+
+template<typename Event>
+struct EventLog
+{
+    std::vector<int32> Executed;                            // event ids, negative when aborted
+    std::vector<Event*> Events;                             // indexed by id, null once deleted
+    uint32 AliveCount = 0;
+
+    void Add(uint32 id, Event* event)
+    {
+        if (id >= Events.size())
+            Events.resize(std::max<std::size_t>(id + 1, Events.size() * 2));
+
+        Events[id] = event;
+        ++AliveCount;
+    }
+
+    void Remove(uint32 id)
+    {
+        Events[id] = nullptr;
+        --AliveCount;
+    }
+
+    Event* Find(uint32 id) const { return id < Events.size() ? Events[id] : nullptr; }
+};
+
+template<typename Base, typename Processor>
+class TestEvent : public Base
+{
+public:
+    TestEvent(EventLog<TestEvent>& log, Processor& events, uint32 id, uint32 repeat = 0, uint32 period = 0, bool deletable = true)
+        : _log(log), _events(events), _id(id), _repeat(repeat), _period(period), _deletable(deletable)
+    {
+        _log.Add(_id, this);
+    }
+
+    ~TestEvent() { _log.Remove(_id); }
+
+    bool Execute(uint64 e_time, uint32 /*p_time*/) override
+    {
+        _log.Executed.push_back(int32(_id));
+        if (!_repeat)
+            return true;
+
+        // periodic events add themselves again
+        --_repeat;
+        _events.AddEvent(this, Milliseconds(e_time + _period));
+        return false;
+    }
+
+    bool IsDeletable() const override { return _deletable; }
+
+    void Abort(uint64 /*e_time*/) override { _log.Executed.push_back(-int32(_id)); }
+
+    void SetDeletable() { _deletable = true; }
+
+private:
+    EventLog<TestEvent>& _log;
+    Processor& _events;
+    uint32 _id;
+    uint32 _repeat;
+    uint32 _period;
+    bool _deletable;
+};
+
+using WheelEvent = TestEvent<BasicEvent, EventProcessor>;
+using ReferenceEvent = TestEvent<ReferenceBasicEvent, ReferenceEventProcessor>;
+
+// applies the same operations to both processors
+struct EventProcessorPair
+{
+    EventLog<WheelEvent> Log;
+    EventLog<ReferenceEvent> ReferenceLog;
+    EventProcessor Events;
+    ReferenceEventProcessor Reference;
+    std::vector<bool> AbortScheduled;
+
+    void AddEvent(uint32 id, Milliseconds offset, uint32 repeat = 0, uint32 period = 0)
+    {
+        Events.AddEventAtOffset(new WheelEvent(Log, Events, id, repeat, period), offset);
+        Reference.AddEventAtOffset(new ReferenceEvent(ReferenceLog, Reference, id, repeat, period), offset);
+        AbortScheduled.resize(std::max<std::size_t>(AbortScheduled.size(), id + 1));
+    }
+
+    void ScheduleAbort(uint32 id)
+    {
+        WheelEvent* event = Log.Find(id);
+        if (!event || AbortScheduled[id])
+            return;
+
+        event->ScheduleAbort();
+        ReferenceLog.Find(id)->ScheduleAbort();
+        AbortScheduled[id] = true;
+    }
+
+    void ModifyEventTime(uint32 id, Milliseconds offset)
+    {
+        WheelEvent* event = Log.Find(id);
+        if (!event)
+            return;
+
+        Events.ModifyEventTime(event, Events.CalculateTime(offset));
+        Reference.ModifyEventTime(ReferenceLog.Find(id), Reference.CalculateTime(offset));
+    }
+
+    void Update(uint32 diff)
+    {
+        Events.Update(diff);
+        Reference.Update(diff);
+    }
+
+    void KillAllEvents(bool force)
+    {
+        Events.KillAllEvents(force);
+        Reference.KillAllEvents(force);
+    }
+};
+
+Milliseconds RandomDelay(std::mt19937& random)
+{
+    uint32 roll = random() % 100;
+    if (roll < 60)
+        return Milliseconds(random() % 300);
+    if (roll < 90)
+        return Milliseconds(random() % 20000);
+    if (roll < 98)
+        return Milliseconds(random() % 40000000);
+
+    return Milliseconds(random() % 200000000);
+}
+
+// roughly what the units of a 25 player raid encounter schedule: spell hits, periodic auras re-adding themselves,
+// interrupted casts and a few long despawn timers
+template<typename AddEvent, typename Abort, typename Update>
+void ReplayEncounter(std::vector<uint32> const& randomValues, AddEvent addEvent, Abort abort, Update update)
+{
+    constexpr uint32 Units = 30;
+    constexpr uint32 Ticks = 2400;                          // two minutes of 50ms world updates
+
+    uint32 nextId = 1;
+    std::vector<bool> aborted(1);
+    std::size_t r = 0;
+    auto next = [&] { return randomValues[r++ % randomValues.size()]; };
+
+    for (uint32 tick = 0; tick < Ticks; ++tick)
+    {
+        for (uint32 unit = 0; unit < Units; ++unit)
+        {
+            uint32 roll = next() % 100;
+            if (roll < 40)
+                addEvent(unit, nextId++, Milliseconds(next() % 3000), 0, 0);
+            else if (roll < 45)
+                addEvent(unit, nextId++, Milliseconds(next() % 3000), 5, 1000 + next() % 2000);
+            else if (roll < 46)
+                addEvent(unit, nextId++, Milliseconds(30000 + next() % 570000), 0, 0);
+            else if (roll < 52 && nextId > 20)
+            {
+                uint32 id = nextId - 1 - next() % 20;
+                if (!aborted[id])
+                    abort(id);
+                aborted[id] = true;
+            }
+
+            aborted.resize(nextId);
+        }
+
+        update(50);
+    }
+}
+}
+
+TEST_CASE("Events execute in time order", "[EventProcessor]")
+{
+    EventProcessorPair events;
+    events.AddEvent(1, 300ms);
+    events.AddEvent(2, 5ms);
+    events.AddEvent(3, 20h);                                // beyond the last wheel level
+    events.AddEvent(4, 70ms);
+    events.AddEvent(5, 5ms);
+    events.AddEvent(6, 5s);
+    events.AddEvent(7, 20h);
+
+    events.Update(4);
+    REQUIRE(events.Log.Executed.empty());
+
+    events.Update(1);
+    REQUIRE(events.Log.Executed == std::vector<int32>{ 2, 5 });
+
+    SECTION("Events added later for the same time execute after the earlier ones")
+    {
+        // 1 and 4 sit in higher wheel levels, 8 and 9 go straight to level 0
+        events.Update(60);
+        events.AddEvent(8, 5ms);
+        events.AddEvent(9, 235ms);
+        events.Update(300);
+        REQUIRE(events.Log.Executed == std::vector<int32>{ 2, 5, 4, 8, 1, 9 });
+    }
+
+    SECTION("A long update executes everything it covers")
+    {
+        events.Update(uint32(Milliseconds(20h).count()));
+        REQUIRE(events.Log.Executed == std::vector<int32>{ 2, 5, 4, 1, 6, 3, 7 });
+        REQUIRE(events.Log.AliveCount == 0);
+    }
+
+    SECTION("Aborted events are not executed")
+    {
+        events.ScheduleAbort(4);
+        events.Update(100);
+        REQUIRE(events.Log.Executed == std::vector<int32>{ 2, 5, -4 });
+        REQUIRE_FALSE(events.Log.Find(4));
+    }
+
+    SECTION("Modified events move to their new time")
+    {
+        events.ModifyEventTime(3, 1ms);
+        events.ModifyEventTime(1, 1ms);
+        events.Update(1);
+        REQUIRE(events.Log.Executed == std::vector<int32>{ 2, 5, 3, 1 });
+    }
+
+    REQUIRE(events.Log.Executed == events.ReferenceLog.Executed);
+}
+
+TEST_CASE("Killing events aborts them in time order", "[EventProcessor]")
+{
+    EventProcessorPair events;
+    events.AddEvent(1, 20h);
+    events.AddEvent(2, 300ms);
+    events.AddEvent(3, 5ms);
+    events.AddEvent(4, 300ms);
+    events.AddEvent(5, 5s);
+    events.AddEvent(6, 5ms);
+    events.ModifyEventTime(2, 300ms);
+
+    events.KillAllEvents(true);
+    REQUIRE(events.Log.Executed == std::vector<int32>{ -3, -6, -4, -2, -5, -1 });
+    REQUIRE(events.Log.Executed == events.ReferenceLog.Executed);
+    REQUIRE(events.Log.AliveCount == 0);
+}
+
+TEST_CASE("Killing events keeps the non deletable ones", "[EventProcessor]")
+{
+    EventLog<WheelEvent> log;
+    EventProcessor events;
+    WheelEvent* kept = new WheelEvent(log, events, 1, 0, 0, false);
+    events.AddEventAtOffset(kept, 10ms);
+    events.AddEventAtOffset(new WheelEvent(log, events, 2), 10ms);
+
+    events.KillAllEvents(false);
+    REQUIRE(log.Executed == std::vector<int32>{ -1, -2 });
+    REQUIRE(log.AliveCount == 1);
+
+    // checked again every update until it can be deleted
+    events.Update(20);
+    events.Update(20);
+    REQUIRE(log.AliveCount == 1);
+
+    kept->SetDeletable();
+    events.Update(1);
+    REQUIRE(log.AliveCount == 0);
+    REQUIRE(log.Executed == std::vector<int32>{ -1, -2 });
+}
+
+TEST_CASE("Same execution order as a std::multimap", "[EventProcessor]")
+{
+    std::mt19937 random(12345);
+    EventProcessorPair events;
+    uint32 nextId = 1;
+
+    for (uint32 i = 0; i < 200000; ++i)
+    {
+        uint32 roll = random() % 100;
+        if (roll < 45)
+        {
+            bool repeat = random() % 5 == 0;
+            events.AddEvent(nextId++, RandomDelay(random), repeat ? random() % 4 : 0, repeat ? random() % 2000 : 0);
+        }
+        else if (roll < 60)
+            events.ScheduleAbort(1 + random() % nextId);
+        else if (roll < 75)
+            events.ModifyEventTime(1 + random() % nextId, RandomDelay(random));
+        else
+        {
+            uint32 diffRoll = random() % 100;
+            events.Update(diffRoll < 80 ? random() % 200 : diffRoll < 99 ? random() % 5000 : random() % 50000000);
+            REQUIRE(events.Log.Executed.size() == events.ReferenceLog.Executed.size());
+        }
+    }
+
+    REQUIRE(events.Log.Executed == events.ReferenceLog.Executed);
+    REQUIRE(events.Log.AliveCount == events.ReferenceLog.AliveCount);
+
+    // repeating events are added again at the time of the update
+    for (uint32 i = 0; i < 4; ++i)
+        events.Update(400000000);
+
+    REQUIRE(events.Log.Executed == events.ReferenceLog.Executed);
+    REQUIRE(events.Log.AliveCount == 0);
+}
+
+template<typename Event, typename Processor>
+std::size_t BenchmarkEncounter(std::vector<uint32> const& randomValues)
+{
+    EventLog<Event> log;
+    std::vector<std::unique_ptr<Processor>> units(30);
+    for (std::unique_ptr<Processor>& unit : units)
+        unit = std::make_unique<Processor>();
+
+    ReplayEncounter(randomValues,
+        [&](uint32 unit, uint32 id, Milliseconds offset, uint32 repeat, uint32 period) { units[unit]->AddEventAtOffset(new Event(log, *units[unit], id, repeat, period), offset); },
+        [&](uint32 id) { if (Event* event = log.Find(id)) event->ScheduleAbort(); },
+        [&](uint32 diff) { for (std::unique_ptr<Processor>& unit : units) unit->Update(diff); });
+
+    return log.Executed.size();
+}
+
+TEST_CASE("EventProcessor raid encounter", "[EventProcessor][.][benchmark]")
+{
+    std::mt19937 random(42);
+    std::vector<uint32> randomValues(1 << 16);
+    for (uint32& value : randomValues)
+        value = random();
+
+    BENCHMARK("Timing wheel")
+    {
+        return BenchmarkEncounter<WheelEvent, EventProcessor>(randomValues);
+    };
+
+    BENCHMARK("std::multimap")
+    {
+        return BenchmarkEncounter<ReferenceEvent, ReferenceEventProcessor>(randomValues);
+    };
+}
@@ -0,0 +1,172 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "Config.h"
+#include "Log.h"
+#include <boost/filesystem.hpp>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// loggers write to a console appender that has every level disabled, nothing gets printed
+void LoadLogConfig()
+{
+    boost::filesystem::path file = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("deleteme.ini");
+    {
+        std::ofstream ini(file.c_str());
+        ini << "[test]\n";
+        ini << "Appender.Null = 1,0\n";
+        ini << "Logger.root = 5,Null\n";
+        ini << "Logger.maps = 2,Null\n";
+        ini << "Logger.spells = 0,Null\n";
+    }
+
+    std::string error;
+    REQUIRE(sConfigMgr->LoadInitial(file.string(), {}, error));
+    sLog->LoadFromConfig();
+    std::remove(file.string().c_str());
+}
+
+uint32 MapsDebugCallSite()
+{
+    uint32 evaluated = 0;
+    TC_LOG_DEBUG("maps.pathfinding", "{}", ++evaluated);
+    return evaluated;
+}
+
+uint32 DynamicCallSite(std::string const& filter)
+{
+    uint32 evaluated = 0;
+    TC_LOG_DEBUG(filter, "{}", ++evaluated);
+    return evaluated;
+}
+}
+
+TEST_CASE("Call site level cache", "[Log]")
+{
+    LoadLogConfig();
+
+    SECTION("Categories resolve to their closest configured logger")
+    {
+        REQUIRE(sLog->GetCategory("maps") == sLog->GetCategory("maps"));
+        REQUIRE(sLog->GetCategory("maps.pathfinding")->IsEnabled(LOG_LEVEL_DEBUG));
+        REQUIRE_FALSE(sLog->GetCategory("maps.pathfinding")->IsEnabled(LOG_LEVEL_TRACE));
+        REQUIRE_FALSE(sLog->GetCategory("spells.effect")->IsEnabled(LOG_LEVEL_FATAL));
+        REQUIRE(sLog->GetCategory("network")->IsEnabled(LOG_LEVEL_ERROR));
+        REQUIRE_FALSE(sLog->GetCategory("network")->IsEnabled(LOG_LEVEL_WARN));
+    }
+
+    SECTION("Level changes apply to call sites that already ran")
+    {
+        REQUIRE(MapsDebugCallSite() == 1);
+
+        REQUIRE(sLog->SetLogLevel("maps", LOG_LEVEL_ERROR));
+        REQUIRE(MapsDebugCallSite() == 0);
+        REQUIRE(DynamicCallSite("maps.pathfinding") == 0);
+
+        REQUIRE(sLog->SetLogLevel("maps", LOG_LEVEL_TRACE));
+        REQUIRE(MapsDebugCallSite() == 1);
+        REQUIRE(DynamicCallSite("maps.pathfinding") == 1);
+        REQUIRE(DynamicCallSite("spells") == 0);
+
+        // reloading the config replaces every logger
+        LoadLogConfig();
+        REQUIRE(MapsDebugCallSite() == 1);
+        REQUIRE(sLog->SetLogLevel("maps", LOG_LEVEL_DISABLED));
+        REQUIRE(MapsDebugCallSite() == 0);
+    }
+}
+
+TEST_CASE("Synchronous file appender", "[Log]")
+{
+    boost::filesystem::path logFile = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("deleteme-%%%%-%%%%.log");
+    boost::filesystem::path file = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("deleteme.ini");
+    {
+        std::ofstream ini(file.c_str());
+        ini << "[test]\n";
+        ini << "LogsDir = " << logFile.parent_path().string() << "\n";
+        ini << "Appender.Null = 1,0\n";
+        ini << "Appender.File = 2,3,0," << logFile.filename().string() << ",w\n";
+        ini << "Logger.root = 5,Null\n";
+        ini << "Logger.entities = 3,File\n";
+    }
+
+    std::string error;
+    REQUIRE(sConfigMgr->LoadInitial(file.string(), {}, error));
+    sLog->LoadFromConfig();
+    std::remove(file.string().c_str());
+
+    // without the logger thread every caller appends to the appender buffer and flushes it itself
+    std::vector<std::thread> writers;
+    for (uint32 i = 0; i < 8; ++i)
+    {
+        writers.emplace_back([i]()
+        {
+            for (uint32 j = 0; j < 2000; ++j)
+                TC_LOG_INFO("entities.player", "writer {} message {}", i, j);
+        });
+    }
+
+    for (std::thread& writer : writers)
+        writer.join();
+
+    // closes the file appender
+    LoadLogConfig();
+
+    uint32 lines = 0;
+    {
+        std::ifstream log(logFile.string());
+        std::string line;
+        while (std::getline(log, line))
+        {
+            REQUIRE(line.rfind("writer ", 0) == 0);
+            ++lines;
+        }
+    }
+
+    REQUIRE(lines == 8 * 2000);
+    boost::filesystem::remove(logFile);
+}
+
+TEST_CASE("Log call site cost", "[Log][.][benchmark]")
+{
+    LoadLogConfig();
+    uint32 value = 0;
+
+    BENCHMARK("Disabled, uncached logger lookup")
+    {
+        return sLog->ShouldLog("maps.pathfinding", LOG_LEVEL_TRACE);
+    };
+
+    BENCHMARK("Disabled call site")
+    {
+        TC_LOG_TRACE("maps.pathfinding", "Path generated with {} points", ++value);
+        return value;
+    };
+
+    BENCHMARK("Enabled call site")
+    {
+        TC_LOG_DEBUG("maps.pathfinding", "Path generated with {} points", ++value);
+        return value;
+    };
+}
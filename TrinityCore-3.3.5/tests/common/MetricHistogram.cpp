@@ -0,0 +1,139 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "Metric.h"
+#include "MetricHistogram.h"
+#include <random>
+#include <thread>
+#include <vector>
+
+TEST_CASE("Bucket layout", "[MetricHistogram]")
+{
+    // small values are exact
+    for (uint64 value = 0; value < 2 * MetricHistogram::SubBucketCount; ++value)
+    {
+        REQUIRE(MetricHistogram::GetBucketIndex(value) == value);
+        REQUIRE(MetricHistogram::GetBucketHighestValue(uint32(value)) == value);
+    }
+
+    // every bucket covers the values up to its highest one, with a bounded relative error
+    for (uint64 value = 1; value <= MetricHistogram::MaxValue; value = value * 3 / 2 + 1)
+    {
+        uint32 index = MetricHistogram::GetBucketIndex(value);
+        uint64 highest = MetricHistogram::GetBucketHighestValue(index);
+        REQUIRE(index < MetricHistogram::BucketCount);
+        REQUIRE(highest >= value);
+        REQUIRE(MetricHistogram::GetBucketIndex(highest) == index);
+        REQUIRE(MetricHistogram::GetBucketIndex(highest + 1) == index + 1);
+        REQUIRE(double(highest - value) <= double(value) / MetricHistogram::SubBucketCount);
+    }
+
+    REQUIRE(MetricHistogram::GetBucketIndex(MetricHistogram::MaxValue) == MetricHistogram::BucketCount - 1);
+}
+
+TEST_CASE("Percentiles", "[MetricHistogram]")
+{
+    MetricHistogram histogram;
+    for (uint64 value = 1; value <= 10000; ++value)
+        histogram.Record(value);
+
+    MetricHistogramSnapshot snapshot = histogram.Collect();
+    REQUIRE(snapshot.Count == 10000);
+    REQUIRE(snapshot.Sum == 10000 * 10001 / 2);
+    REQUIRE(snapshot.Max == 10000);
+    REQUIRE(snapshot.GetValueAtPercentile(0.0) == 1);
+    REQUIRE(snapshot.GetValueAtPercentile(100.0) == 10000);
+
+    for (double percentile : { 50.0, 90.0, 99.0, 99.9 })
+    {
+        double exact = percentile * 100.0;
+        double value = double(snapshot.GetValueAtPercentile(percentile));
+        REQUIRE(value >= exact);
+        REQUIRE(value <= exact * (1.0 + 1.0 / MetricHistogram::SubBucketCount));
+    }
+
+    SECTION("Collecting starts the next interval")
+    {
+        MetricHistogramSnapshot empty = histogram.Collect();
+        REQUIRE(empty.Count == 0);
+        REQUIRE(empty.Max == 0);
+        REQUIRE(empty.GetValueAtPercentile(99.0) == 0);
+    }
+}
+
+TEST_CASE("Concurrent recording", "[MetricHistogram]")
+{
+    constexpr uint32 Threads = 4;
+    constexpr uint32 ValuesPerThread = 100000;
+
+    MetricHistogram histogram;
+    std::vector<std::thread> threads;
+    uint64 collected = 0;
+    for (uint32 t = 0; t < Threads; ++t)
+        threads.emplace_back([&histogram, t] { for (uint32 i = 0; i < ValuesPerThread; ++i) histogram.Record(t * 1000 + i % 1000); });
+
+    // values recorded while collecting land in one snapshot or the next, never in both
+    for (uint32 i = 0; i < 10; ++i)
+        collected += histogram.Collect().Count;
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    MetricHistogramSnapshot last = histogram.Collect();
+    REQUIRE(collected + last.Count == Threads * ValuesPerThread);
+}
+
+TEST_CASE("Prometheus snapshot", "[MetricHistogram]")
+{
+    MetricHistogram* latency = sMetric->GetHistogram("test.latency", {}, true);
+    REQUIRE(latency == sMetric->GetHistogram("test.latency", {}, true));
+    for (uint32 i = 1; i <= 100; ++i)
+        latency->Record(i * 1000);
+
+    std::string text = sMetric->BuildLocalSnapshot();
+    REQUIRE(text.find("# TYPE test_latency_seconds summary\n") != std::string::npos);
+    REQUIRE(text.find("test_latency_seconds{quantile=\"0.5\"} 0.05") != std::string::npos);
+    REQUIRE(text.find("test_latency_seconds_count 100\n") != std::string::npos);
+    REQUIRE(text.find("# TYPE test_latency_seconds_max gauge\ntest_latency_seconds_max 0.1\n") != std::string::npos);
+
+    // quantiles only cover the last interval, counts keep growing
+    text = sMetric->BuildLocalSnapshot();
+    REQUIRE(text.find("test_latency_seconds{quantile=\"0.99\"} NaN\n") != std::string::npos);
+    REQUIRE(text.find("test_latency_seconds_count 100\n") != std::string::npos);
+}
+
+TEST_CASE("Metric histogram cost", "[MetricHistogram][.][benchmark]")
+{
+    MetricHistogram histogram;
+    std::mt19937_64 random(42);
+    std::vector<uint64> values(4096);
+    for (uint64& value : values)
+        value = random() % 100000;
+
+    uint32 i = 0;
+    BENCHMARK("Record")
+    {
+        histogram.Record(values[++i % values.size()]);
+    };
+
+    BENCHMARK("Collect")
+    {
+        return histogram.Collect().Count;
+    };
+}
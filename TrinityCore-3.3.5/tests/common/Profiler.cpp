@@ -0,0 +1,172 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "Profiler.h"
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using Trinity::Profiler;
+using Trinity::ProfilerCapture;
+
+namespace
+{
+// every zone spends some time of its own, so each stack shows up in the folded output
+void Spin(std::chrono::microseconds duration)
+{
+    TimePoint end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end)
+        ;
+}
+
+// TC_PROFILE_ZONE is compiled out unless WITH_PROFILER is set, zones are used directly here
+void UpdateUnit()
+{
+    Profiler::Zone zone("Unit::Update");
+    {
+        Profiler::Zone spell("Spell::update");
+        Spin(20us);
+    }
+    Spin(20us);
+}
+
+void UpdateWorld()
+{
+    Profiler::Zone zone("World::Update");
+    Spin(20us);
+    for (uint32 i = 0; i < 3; ++i)
+        UpdateUnit();
+
+    Profiler::Zone queries("World::ProcessQueryCallbacks");
+    Spin(20us);
+}
+
+// self time in microseconds by stack, without the thread frame
+std::map<std::string, uint64> ParseFoldedStacks(std::string const& folded)
+{
+    std::map<std::string, uint64> stacks;
+    std::istringstream lines(folded);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        std::string::size_type threadEnd = line.find(';');
+        std::string::size_type countStart = line.rfind(' ');
+        REQUIRE(threadEnd != std::string::npos);
+        REQUIRE(countStart != std::string::npos);
+        REQUIRE(line.starts_with("Thread "));
+        stacks[line.substr(threadEnd + 1, countStart - threadEnd - 1)] += std::stoull(line.substr(countStart + 1));
+    }
+
+    return stacks;
+}
+}
+
+TEST_CASE("Zones are only recorded while capturing", "[Profiler]")
+{
+    UpdateWorld();
+
+    REQUIRE(sProfiler->Start(1h));
+    REQUIRE_FALSE(sProfiler->Start(1h));
+    REQUIRE(sProfiler->IsRecording());
+
+    UpdateWorld();
+    std::thread([] { UpdateUnit(); }).join();
+
+    std::unique_ptr<ProfilerCapture> capture = sProfiler->Stop();
+    REQUIRE_FALSE(sProfiler->IsRecording());
+    REQUIRE(sProfiler->Stop() == nullptr);
+
+    UpdateWorld();
+
+    REQUIRE(capture);
+    REQUIRE(capture->Threads.size() == 2);
+    REQUIRE(capture->GetEventCount() == 10);
+    REQUIRE(capture->GetDroppedCount() == 0);
+
+    SECTION("Folded stacks nest zones by depth")
+    {
+        std::map<std::string, uint64> stacks = ParseFoldedStacks(capture->ToFoldedStacks());
+        REQUIRE(stacks.size() == 6);
+
+        // zones report their own time only, children are split off into deeper stacks
+        REQUIRE(stacks["World::Update"] >= 20);
+        REQUIRE(stacks["World::Update;World::ProcessQueryCallbacks"] >= 20);
+        REQUIRE(stacks["World::Update;Unit::Update"] >= 3 * 20);
+        REQUIRE(stacks["World::Update;Unit::Update;Spell::update"] >= 3 * 20);
+
+        // the unit updated on the other thread starts a stack of its own
+        REQUIRE(stacks["Unit::Update"] >= 20);
+        REQUIRE(stacks["Unit::Update;Spell::update"] >= 20);
+    }
+
+    SECTION("Chrome trace names every zone")
+    {
+        std::string json = capture->ToChromeTrace();
+        REQUIRE(json.starts_with("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+        REQUIRE(json.ends_with("]}\n"));
+
+        uint32 completeEvents = 0;
+        for (std::string::size_type pos = json.find("\"ph\":\"X\""); pos != std::string::npos; pos = json.find("\"ph\":\"X\"", pos + 1))
+            ++completeEvents;
+
+        REQUIRE(completeEvents == 10);
+        REQUIRE(json.find("\"name\":\"World::ProcessQueryCallbacks\"") != std::string::npos);
+    }
+}
+
+TEST_CASE("Folded stack self time", "[Profiler]")
+{
+    ProfilerCapture capture;
+    capture.StartTicks = 0;
+    capture.TicksPerMicrosecond = 1.0;
+
+    // stored in the order zones end, children first
+    ProfilerCapture::Thread& thread = capture.Threads.emplace_back();
+    thread.Id = 1;
+    thread.Dropped = 0;
+    thread.Events =
+    {
+        { "Unit::Update", 10, 40, 1 },
+        { "Unit::Update", 50, 60, 1 },
+        { "Map Update", 0, 100, 0 },
+        { "Map Update", 100, 150, 0 }
+    };
+
+    REQUIRE(capture.ToFoldedStacks() ==
+        "Thread 1;Map Update 110\n"
+        "Thread 1;Map Update;Unit::Update 40\n");
+}
+
+TEST_CASE("Profiler zone cost", "[Profiler][.][benchmark]")
+{
+    BENCHMARK("Zone while idle")
+    {
+        Profiler::Zone zone("Unit::Update");
+    };
+
+    sProfiler->Start(1h);
+
+    BENCHMARK("Zone while recording")
+    {
+        Profiler::Zone zone("Unit::Update");
+    };
+
+    sProfiler->Stop();
+}
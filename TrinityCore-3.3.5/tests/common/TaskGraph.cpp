@@ -0,0 +1,123 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "TaskGraph.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+using Trinity::TaskGraph;
+
+TEST_CASE("Single thread keeps declaration order", "[TaskGraph]")
+{
+    TaskGraph graph;
+    std::vector<int> order;
+
+    TaskGraph::TaskId first = graph.Add("first", [&] { order.push_back(1); });
+    graph.Add("second", [&] { order.push_back(2); });
+    graph.Add("third", [&] { order.push_back(3); }, { first });
+
+    graph.Run(1);
+
+    REQUIRE(order == std::vector<int>{ 1, 2, 3 });
+    REQUIRE(graph.GetCriticalPath().size() >= 1);
+}
+
+TEST_CASE("Dependencies finish before dependents", "[TaskGraph]")
+{
+    TaskGraph graph;
+    std::mutex lock;
+    std::vector<std::string> order;
+    auto record = [&](std::string name)
+    {
+        return [&, name]
+        {
+            std::this_thread::sleep_for(1ms);
+            std::lock_guard<std::mutex> guard(lock);
+            order.push_back(name);
+        };
+    };
+
+    TaskGraph::TaskId templates = graph.Add("templates", record("templates"));
+    TaskGraph::TaskId trainers = graph.Add("trainers", record("trainers"), { templates });
+    TaskGraph::TaskId loot = graph.Add("loot", record("loot"), { templates });
+    graph.Add("gossip", record("gossip"), { trainers });
+    graph.Add("conditions", record("conditions"), { loot, trainers });
+
+    graph.Run(4);
+
+    auto position = [&](std::string const& name) { return std::find(order.begin(), order.end(), name) - order.begin(); };
+    REQUIRE(order.size() == 5);
+    REQUIRE(position("templates") < position("trainers"));
+    REQUIRE(position("templates") < position("loot"));
+    REQUIRE(position("trainers") < position("gossip"));
+    REQUIRE(position("trainers") < position("conditions"));
+    REQUIRE(position("loot") < position("conditions"));
+}
+
+TEST_CASE("Independent tasks run concurrently", "[TaskGraph]")
+{
+    TaskGraph graph;
+    std::atomic<int> running = 0;
+    std::atomic<int> maxRunning = 0;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        graph.Add("sleeper", [&]
+        {
+            int now = ++running;
+            int expected = maxRunning;
+            while (now > expected && !maxRunning.compare_exchange_weak(expected, now));
+            std::this_thread::sleep_for(20ms);
+            --running;
+        });
+    }
+
+    graph.Run(4);
+
+    REQUIRE(maxRunning > 1);
+}
+
+TEST_CASE("Critical path follows the slowest chain", "[TaskGraph]")
+{
+    TaskGraph graph;
+    TaskGraph::TaskId fast = graph.Add("fast", [] { });
+    TaskGraph::TaskId slow = graph.Add("slow", [] { std::this_thread::sleep_for(30ms); });
+    TaskGraph::TaskId last = graph.Add("last", [] { }, { fast, slow });
+
+    graph.Run(2);
+
+    REQUIRE(graph.GetCriticalPath() == std::vector<TaskGraph::TaskId>{ slow, last });
+    REQUIRE(graph.GetTaskDuration(slow) >= 30ms);
+    REQUIRE(graph.GetTimingReport().find("slow") != std::string::npos);
+}
+
+TEST_CASE("Exception stops scheduling and is rethrown", "[TaskGraph]")
+{
+    TaskGraph graph;
+    bool dependentRan = false;
+
+    TaskGraph::TaskId failing = graph.Add("failing", [] { throw std::runtime_error("load failed"); });
+    graph.Add("dependent", [&] { dependentRan = true; }, { failing });
+
+    REQUIRE_THROWS_AS(graph.Run(2), std::runtime_error);
+    REQUIRE_FALSE(dependentRan);
+}
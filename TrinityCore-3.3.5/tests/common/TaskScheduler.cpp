@@ -0,0 +1,365 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "TaskScheduler.h"
+#include <array>
+#include <functional>
+#include <memory>
+#include <set>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace
+{
+// what TaskScheduler used to be: shared_ptr tasks in a std::multiset invoking std::function handlers, kept to benchmark against
+class ReferenceTaskScheduler
+{
+public:
+    class Context;
+
+    struct Task
+    {
+        std::chrono::steady_clock::time_point End;
+        std::chrono::steady_clock::duration Duration;
+        uint32 Repeated = 0;
+        std::function<void(Context)> Handler;
+    };
+
+    struct Compare
+    {
+        bool operator()(std::shared_ptr<Task> const& left, std::shared_ptr<Task> const& right) const { return left->End < right->End; }
+    };
+
+    class Context
+    {
+    public:
+        Context(std::shared_ptr<Task>&& task, std::weak_ptr<ReferenceTaskScheduler>&& owner) : _task(task), _owner(owner), _consumed(std::make_shared<bool>(false)) { }
+
+        void Repeat()
+        {
+            REQUIRE(!*_consumed);
+            _task->End += _task->Duration;
+            ++_task->Repeated;
+            *_consumed = true;
+            Dispatch(std::bind(&ReferenceTaskScheduler::Insert, std::placeholders::_1, _task));
+        }
+
+        void Schedule(std::chrono::steady_clock::duration time, std::function<void(Context)> const& handler)
+        {
+            auto const end = _task->End;
+            Dispatch([end, time, handler](ReferenceTaskScheduler& scheduler) -> ReferenceTaskScheduler&
+            {
+                return scheduler.Insert(std::make_shared<Task>(Task{ end + time, time, 0, handler }));
+            });
+        }
+
+        uint32 GetRepeatCounter() const { return _task->Repeated; }
+
+        void Invoke() { _task->Handler(*this); }
+
+    private:
+        void Dispatch(std::function<ReferenceTaskScheduler&(ReferenceTaskScheduler&)> const& apply)
+        {
+            if (auto const owner = _owner.lock())
+                apply(*owner);
+        }
+
+        std::shared_ptr<Task> _task;
+        std::weak_ptr<ReferenceTaskScheduler> _owner;
+        std::shared_ptr<bool> _consumed;
+    };
+
+    ReferenceTaskScheduler() : _self(this, [](ReferenceTaskScheduler const*) { }), _predicate([] { return true; }) { }
+
+    void Schedule(std::chrono::steady_clock::duration time, std::function<void(Context)> const& handler)
+    {
+        Insert(std::make_shared<Task>(Task{ _now + time, time, 0, handler }));
+    }
+
+    void Update(std::chrono::steady_clock::duration difftime, std::function<void()> const& callback = [] { })
+    {
+        _now += difftime;
+        if (!_predicate())
+            return;
+
+        while (!_tasks.empty() && (*_tasks.begin())->End <= _now)
+        {
+            std::shared_ptr<Task> task = *_tasks.begin();
+            _tasks.erase(_tasks.begin());
+            Context context(std::move(task), std::weak_ptr<ReferenceTaskScheduler>(_self));
+            context.Invoke();
+            if (!_predicate())
+                return;
+        }
+
+        callback();
+    }
+
+private:
+    ReferenceTaskScheduler& Insert(std::shared_ptr<Task> task)
+    {
+        _tasks.insert(std::move(task));
+        return *this;
+    }
+
+    std::shared_ptr<ReferenceTaskScheduler> _self;
+    std::chrono::steady_clock::time_point _now = std::chrono::steady_clock::now();
+    std::multiset<std::shared_ptr<Task>, Compare> _tasks;
+    std::function<bool()> _predicate;
+};
+
+// a boss fight: every creature repeats a few abilities, some of which schedule a short follow-up
+template<typename Scheduler, typename Context>
+uint32 ReplayEncounter(uint32 creatures, uint32 ticks)
+{
+    uint32 invocations = 0;
+    std::vector<Scheduler> schedulers(creatures);
+    for (uint32 i = 0; i < creatures; ++i)
+    {
+        for (uint32 ability = 0; ability < 6; ++ability)
+        {
+            schedulers[i].Schedule(std::chrono::milliseconds(1000 + 400 * ability + 37 * i), [&invocations, ability](Context context)
+            {
+                ++invocations;
+                if (ability == 0 && context.GetRepeatCounter() % 2)
+                    context.Schedule(1500ms, [&invocations](Context) { ++invocations; });
+                context.Repeat();
+            });
+        }
+    }
+
+    for (uint32 tick = 0; tick < ticks; ++tick)
+        for (Scheduler& scheduler : schedulers)
+            scheduler.Update(50ms);
+
+    return invocations;
+}
+}
+
+TEST_CASE("Tasks are invoked in time order", "[TaskScheduler]")
+{
+    TaskScheduler scheduler;
+    std::vector<uint32> invoked;
+
+    scheduler.Schedule(3s, [&](TaskContext) { invoked.push_back(3); });
+    scheduler.Schedule(1s, [&](TaskContext) { invoked.push_back(1); });
+    scheduler.Schedule(2s, [&](TaskContext) { invoked.push_back(2); });
+    scheduler.Schedule(2s, [&](TaskContext) { invoked.push_back(4); });
+
+    scheduler.Update(1500ms);
+    REQUIRE(invoked == std::vector<uint32>{ 1 });
+
+    // tasks ending at the same time keep the order they were scheduled in
+    scheduler.Update(1500ms);
+    REQUIRE(invoked == std::vector<uint32>{ 1, 2, 4, 3 });
+}
+
+TEST_CASE("Repeating tasks", "[TaskScheduler]")
+{
+    TaskScheduler scheduler;
+    std::vector<uint32> counters;
+
+    scheduler.Schedule(1s, [&](TaskContext context)
+    {
+        counters.push_back(context.GetRepeatCounter());
+        if (context.GetRepeatCounter() < 3)
+            context.Repeat();
+    });
+
+    for (uint32 i = 0; i < 10; ++i)
+        scheduler.Update(1s);
+
+    REQUIRE(counters == std::vector<uint32>{ 0, 1, 2, 3 });
+
+    SECTION("Repeat keeps the original timing")
+    {
+        std::vector<uint32> times;
+        scheduler.Schedule(300ms, [&](TaskContext context)
+        {
+            times.push_back(context.GetRepeatCounter());
+            context.Repeat(300ms);
+        });
+
+        // a late update runs every missed repetition at once
+        scheduler.Update(1s);
+        REQUIRE(times.size() == 3);
+    }
+}
+
+TEST_CASE("Groups", "[TaskScheduler]")
+{
+    TaskScheduler scheduler;
+    uint32 invoked = 0;
+
+    scheduler.Schedule(1s, 1, [&](TaskContext) { ++invoked; });
+    scheduler.Schedule(1s, 2, [&](TaskContext) { ++invoked; });
+    scheduler.Schedule(2s, 1, [&](TaskContext) { ++invoked; });
+
+    SECTION("Cancel")
+    {
+        scheduler.CancelGroup(1);
+        scheduler.Update(5s);
+        REQUIRE(invoked == 1);
+    }
+
+    SECTION("Cancel from within a task")
+    {
+        scheduler.Schedule(500ms, [&](TaskContext context)
+        {
+            context.CancelGroup(1);
+            context.Repeat();
+        });
+        scheduler.Update(5s);
+        REQUIRE(invoked == 1);
+    }
+
+    SECTION("Delay")
+    {
+        scheduler.DelayGroup(1, 2s);
+        scheduler.Update(1s);
+        REQUIRE(invoked == 1);
+        scheduler.Update(2s);
+        REQUIRE(invoked == 2);
+        scheduler.Update(1s);
+        REQUIRE(invoked == 3);
+    }
+
+    SECTION("Reschedule")
+    {
+        scheduler.RescheduleAll(3s);
+        scheduler.Update(2s);
+        REQUIRE(invoked == 0);
+        scheduler.Update(1s);
+        REQUIRE(invoked == 3);
+    }
+}
+
+TEST_CASE("Task contexts", "[TaskScheduler]")
+{
+    TaskScheduler scheduler;
+    std::vector<uint32> invoked;
+
+    SECTION("Canceling everything doesn't stop the running task from repeating")
+    {
+        scheduler.Schedule(1s, 1, [&](TaskContext context)
+        {
+            invoked.push_back(context.GetRepeatCounter());
+            REQUIRE(context.IsInGroup(1));
+            context.CancelAll();
+            if (!context.GetRepeatCounter())
+                context.Repeat();
+        });
+
+        scheduler.Update(5s);
+        REQUIRE(invoked == std::vector<uint32>{ 0, 1 });
+    }
+
+    SECTION("Scheduling from a context starts from the end of its task")
+    {
+        scheduler.Schedule(1s, [&](TaskContext context)
+        {
+            context.Schedule(1s, [&](TaskContext) { invoked.push_back(2); });
+            invoked.push_back(1);
+        });
+
+        scheduler.Update(1500ms);
+        REQUIRE(invoked == std::vector<uint32>{ 1 });
+        scheduler.Update(500ms);
+        REQUIRE(invoked == std::vector<uint32>{ 1, 2 });
+    }
+
+    SECTION("Task records are reused")
+    {
+        uint32 counter = 0;
+        for (uint32 i = 0; i < 100; ++i)
+        {
+            scheduler.Schedule(1s, [&](TaskContext context) { ++counter; REQUIRE(context.GetRepeatCounter() == 0); });
+            scheduler.Update(1s);
+        }
+
+        REQUIRE(counter == 100);
+    }
+
+    SECTION("Large handlers")
+    {
+        std::array<uint64, 32> payload = { };
+        payload.back() = 42;
+        scheduler.Schedule(1s, [&invoked, payload](TaskContext) { invoked.push_back(uint32(payload.back())); });
+        scheduler.Update(1s);
+        REQUIRE(invoked == std::vector<uint32>{ 42 });
+    }
+
+    SECTION("Contexts of finished tasks are ignored when repeated")
+    {
+        std::vector<TaskContext> contexts;
+        scheduler.Schedule(1s, [&](TaskContext context)
+        {
+            invoked.push_back(context.GetRepeatCounter());
+            contexts.push_back(context);
+        });
+
+        scheduler.Update(1s);
+        REQUIRE(invoked == std::vector<uint32>{ 0 });
+
+        contexts.front().Repeat(1s);
+        contexts.front().Schedule(1s, [&](TaskContext) { invoked.push_back(2); });
+        scheduler.Update(1s);
+        REQUIRE(invoked == std::vector<uint32>{ 0, 2 });
+    }
+}
+
+TEST_CASE("Destroying the scheduler from within a task", "[TaskScheduler]")
+{
+    auto scheduler = std::make_unique<TaskScheduler>();
+    auto alive = std::make_shared<bool>(true);
+    std::weak_ptr<bool> captured(alive);
+    bool invoked = false;
+
+    scheduler->Schedule(1s, [&, alive = std::move(alive)](TaskContext context)
+    {
+        scheduler.reset();
+        invoked = true;
+
+        // the lambda and its captures outlive the scheduler until it returns
+        REQUIRE(*alive);
+        REQUIRE(!captured.expired());
+        REQUIRE(context.IsExpired());
+        context.Repeat(1s);
+    });
+
+    scheduler->Update(1s);
+    REQUIRE(invoked);
+    REQUIRE(captured.expired());
+}
+
+TEST_CASE("TaskScheduler throughput", "[TaskScheduler][.][benchmark]")
+{
+    REQUIRE(ReplayEncounter<TaskScheduler, TaskContext>(10, 200) == ReplayEncounter<ReferenceTaskScheduler, ReferenceTaskScheduler::Context>(10, 200));
+
+    BENCHMARK("TaskScheduler")
+    {
+        return ReplayEncounter<TaskScheduler, TaskContext>(40, 2400);
+    };
+
+    BENCHMARK("std::multiset and std::function")
+    {
+        return ReplayEncounter<ReferenceTaskScheduler, ReferenceTaskScheduler::Context>(40, 2400);
+    };
+}
@@ -0,0 +1,177 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "AchievementMgr.h"
+#include "DBCStores.h"
+#include "DummyData.h"
+#include <vector>
+
+namespace
+{
+struct SentUpdate
+{
+    uint32 CriteriaId;
+    uint32 TimeElapsed;
+
+    bool operator==(SentUpdate const& right) const { return CriteriaId == right.CriteriaId && TimeElapsed == right.TimeElapsed; }
+};
+
+std::vector<SentUpdate> Flush(AchievementCriteriaState& state)
+{
+    std::vector<SentUpdate> sent;
+    state.FlushPendingUpdates([&](AchievementCriteriaState::PendingUpdate const& pending)
+    {
+        sent.push_back({ pending.Criteria->ID, pending.TimeElapsed });
+    });
+    return sent;
+}
+
+struct TestPlayer
+{
+    TestPlayer() : Owner(UnitTestDataLoader::CreatePlayer()), Achievements(Owner) { }
+    ~TestPlayer() { UnitTestDataLoader::DeletePlayer(Owner); }
+
+    Player* Owner;
+    AchievementMgr Achievements;
+};
+}
+
+TEST_CASE("Criteria dispatch lists", "[AchievementMgr]")
+{
+    UnitTestDataLoader::LoadAchievementCriteria();
+    AchievementCriteriaState state(sAchievementCriteriaStore.GetNumRows());
+
+    SECTION("Entries are resolved at load")
+    {
+        AchievementCriteriaDispatchList const& byCreature = sAchievementMgr->GetAchievementCriteriaByType(ACHIEVEMENT_CRITERIA_TYPE_KILL_CREATURE, 35451);
+        REQUIRE(byCreature.size() == 1);
+        REQUIRE(byCreature.front().Criteria == sAchievementCriteriaStore.LookupEntry(11789));
+        REQUIRE(byCreature.front().Achievement == sAchievementStore.LookupEntry(4298));
+        REQUIRE(byCreature.front().Data == nullptr);
+
+        REQUIRE(sAchievementMgr->GetAchievementCriteriaByType(ACHIEVEMENT_CRITERIA_TYPE_KILL_CREATURE, 0).size() == 4);
+        REQUIRE(sAchievementMgr->GetAchievementCriteriaByType(ACHIEVEMENT_CRITERIA_TYPE_KILL_CREATURE, 1).empty());
+    }
+
+    SECTION("Criteria outside of the store are never completed")
+    {
+        state.SetCompleted(sAchievementCriteriaStore.GetNumRows());
+        REQUIRE(!state.IsCompleted(sAchievementCriteriaStore.GetNumRows()));
+    }
+}
+
+TEST_CASE("Completed criteria", "[AchievementMgr]")
+{
+    UnitTestDataLoader::LoadAchievementCriteria();
+    TestPlayer test;
+
+    SECTION("Completed criteria aren't updated again")
+    {
+        test.Achievements.UpdateAchievementCriteria(ACHIEVEMENT_CRITERIA_TYPE_KILL_CREATURE, 23576, 1);
+        REQUIRE(UnitTestDataLoader::GetCriteriaCounter(test.Achievements, 20001) == 1);
+
+        test.Achievements.UpdateAchievementCriteria(ACHIEVEMENT_CRITERIA_TYPE_KILL_CREATURE, 23576, 1);
+        REQUIRE(UnitTestDataLoader::GetCriteriaCounter(test.Achievements, 20001) == 1);
+    }
+
+    SECTION("Completed reputation criteria follow the reputation back down")
+    {
+        UnitTestDataLoader::SetExaltedFactionCount(test.Owner, 1);
+        test.Achievements.UpdateAchievementCriteria(ACHIEVEMENT_CRITERIA_TYPE_GAIN_EXALTED_REPUTATION, 1);
+        REQUIRE(UnitTestDataLoader::GetCriteriaCounter(test.Achievements, 20000) == 1);
+
+        UnitTestDataLoader::SetExaltedFactionCount(test.Owner, 0);
+        test.Achievements.UpdateAchievementCriteria(ACHIEVEMENT_CRITERIA_TYPE_GAIN_EXALTED_REPUTATION, 1);
+        REQUIRE(UnitTestDataLoader::GetCriteriaCounter(test.Achievements, 20000) == 0);
+
+        // the lost reputation keeps the achievement from completing with its other criteria
+        test.Achievements.UpdateAchievementCriteria(ACHIEVEMENT_CRITERIA_TYPE_KILL_CREATURE, 23576, 1);
+        REQUIRE(UnitTestDataLoader::GetCriteriaCounter(test.Achievements, 20001) == 1);
+        REQUIRE(!test.Achievements.HasAchieved(10000));
+
+        UnitTestDataLoader::SetExaltedFactionCount(test.Owner, 1);
+        test.Achievements.UpdateAchievementCriteria(ACHIEVEMENT_CRITERIA_TYPE_GAIN_EXALTED_REPUTATION, 1);
+        REQUIRE(test.Achievements.HasAchieved(10000));
+    }
+}
+
+TEST_CASE("Batched criteria updates", "[AchievementMgr]")
+{
+    UnitTestDataLoader::LoadAchievementCriteria();
+    AchievementCriteriaEntry const* eadric = sAchievementCriteriaStore.LookupEntry(11497);
+    AchievementCriteriaEntry const* paletress = sAchievementCriteriaStore.LookupEntry(11498);
+    AchievementCriteriaEntry const* blackKnight = sAchievementCriteriaStore.LookupEntry(11789);
+
+    AchievementCriteriaState state(sAchievementCriteriaStore.GetNumRows());
+    REQUIRE(!state.HasPendingUpdates());
+
+    SECTION("A change is sent exactly once")
+    {
+        state.QueueUpdate(eadric, 0, false);
+        REQUIRE(state.HasPendingUpdates());
+        REQUIRE(Flush(state) == std::vector<SentUpdate>{ { 11497, 0 } });
+
+        REQUIRE(!state.HasPendingUpdates());
+        REQUIRE(Flush(state).empty());
+    }
+
+    SECTION("Criteria queued many times are sent once with their latest progress, in queue order")
+    {
+        state.QueueUpdate(paletress, 1, false);
+        state.QueueUpdate(eadric, 5, false);
+        state.QueueUpdate(paletress, 2, false);
+        state.QueueUpdate(paletress, 3, true);
+
+        REQUIRE(Flush(state) == std::vector<SentUpdate>{ { 11498, 3 }, { 11497, 5 } });
+        REQUIRE(Flush(state).empty());
+
+        // sent criteria can be queued again
+        state.QueueUpdate(paletress, 4, false);
+        REQUIRE(Flush(state) == std::vector<SentUpdate>{ { 11498, 4 } });
+    }
+
+    SECTION("Removed criteria aren't sent")
+    {
+        state.QueueUpdate(eadric, 0, false);
+        state.QueueUpdate(blackKnight, 0, false);
+        state.Remove(eadric);
+        REQUIRE(Flush(state) == std::vector<SentUpdate>{ { 11789, 0 } });
+
+        state.QueueUpdate(eadric, 7, false);
+        REQUIRE(Flush(state) == std::vector<SentUpdate>{ { 11497, 7 } });
+    }
+
+    SECTION("Clearing drops the queue")
+    {
+        state.QueueUpdate(eadric, 0, false);
+        state.Clear();
+        REQUIRE(!state.HasPendingUpdates());
+
+        state.QueueUpdate(eadric, 1, false);
+        REQUIRE(Flush(state) == std::vector<SentUpdate>{ { 11497, 1 } });
+    }
+
+    SECTION("Completing a criteria doesn't affect its queued update")
+    {
+        state.QueueUpdate(blackKnight, 0, false);
+        state.SetCompleted(11789);
+        REQUIRE(Flush(state) == std::vector<SentUpdate>{ { 11789, 0 } });
+        REQUIRE(state.IsCompleted(11789));
+    }
+}
@@ -0,0 +1,231 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "ConditionMgr.h"
+#include "Object.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+// a plain world object only answers the location and type checks, unit and player checks fail on it
+class ConditionObject : public WorldObject
+{
+public:
+    ConditionObject(uint32 mapId, uint32 zoneId, uint32 areaId) : WorldObject(false)
+    {
+        SetLocationMapId(mapId);
+        m_zoneId = zoneId;
+        m_areaId = areaId;
+    }
+
+    bool AddToObjectUpdate() override { return false; }
+    void RemoveFromObjectUpdate() override { }
+    ObjectGuid GetOwnerGUID() const override { return ObjectGuid::Empty; }
+    uint32 GetFaction() const override { return 0; }
+};
+
+// IsObjectMeetToConditionList as it was before the lists were ordered at load time
+bool IsObjectMeetToConditionListInterpreted(ConditionSourceInfo& sourceInfo, ConditionContainer const& conditions,
+    std::unordered_map<uint32, ConditionContainer> const& references)
+{
+    std::map<uint32, bool> elseGroupStore;
+    for (Condition const* condition : conditions)
+    {
+        if (!condition->isLoaded())
+            continue;
+
+        std::map<uint32, bool>::const_iterator itr = elseGroupStore.find(condition->ElseGroup);
+        if (itr == elseGroupStore.end())
+            elseGroupStore[condition->ElseGroup] = true;
+        else if (!itr->second)
+            continue;
+
+        if (condition->ReferenceId)
+        {
+            auto ref = references.find(condition->ReferenceId);
+            if (ref != references.end() && !IsObjectMeetToConditionListInterpreted(sourceInfo, ref->second, references))
+                elseGroupStore[condition->ElseGroup] = false;
+        }
+        else if (!condition->Meets(sourceInfo))
+            elseGroupStore[condition->ElseGroup] = false;
+    }
+
+    for (std::map<uint32, bool>::value_type const& group : elseGroupStore)
+        if (group.second)
+            return true;
+
+    return false;
+}
+
+struct ConditionLists
+{
+    std::vector<std::unique_ptr<Condition>> Storage;
+    std::unordered_map<uint32, ConditionContainer> References;
+    std::vector<ConditionContainer> DbOrder;
+    std::vector<ConditionContainer> Compiled;
+};
+
+// gossip and loot sized lists: 1 to 4 else groups of 1 to 5 conditions, mixing location checks,
+// unit checks, item and aura checks and references to a few shared templates
+ConditionLists MakeConditionLists(std::mt19937& random, uint32 count, ConditionSourceType sourceType = CONDITION_SOURCE_TYPE_GOSSIP_MENU)
+{
+    ConditionLists lists;
+
+    auto makeCondition = [&](uint32 elseGroup) -> Condition*
+    {
+        Condition* cond = lists.Storage.emplace_back(std::make_unique<Condition>()).get();
+        cond->SourceType = sourceType;
+        cond->LoadOrder = uint32(lists.Storage.size());
+        cond->ElseGroup = elseGroup;
+        cond->NegativeCondition = random() % 4 == 0;
+        switch (random() % 8)
+        {
+            case 0: cond->ConditionType = CONDITION_MAPID; cond->ConditionValue1 = random() % 2; break;
+            case 1: cond->ConditionType = CONDITION_ZONEID; cond->ConditionValue1 = random() % 3; break;
+            case 2: cond->ConditionType = CONDITION_AREAID; cond->ConditionValue1 = random() % 3; break;
+            case 3: cond->ConditionType = CONDITION_PHASEMASK; cond->ConditionValue1 = 1 << (random() % 2); break;
+            case 4: cond->ConditionType = CONDITION_TYPE_MASK; cond->ConditionValue1 = TYPEMASK_OBJECT; break;
+            case 5: cond->ConditionType = CONDITION_CLASS; cond->ConditionValue1 = 1; break;
+            case 6: cond->ConditionType = CONDITION_ITEM; cond->ConditionValue1 = 6948; cond->ConditionValue2 = 1; break;
+            default: cond->ConditionType = CONDITION_AURA; cond->ConditionValue1 = 8326; break;
+        }
+        return cond;
+    };
+
+    for (uint32 referenceId = 1; referenceId <= 8; ++referenceId)
+    {
+        ConditionContainer& reference = lists.References[referenceId];
+        for (uint32 i = 0, size = 1 + random() % 3; i < size; ++i)
+        {
+            // reference templates have no source type of their own
+            Condition* cond = makeCondition(0);
+            cond->SourceType = CONDITION_SOURCE_TYPE_NONE;
+            ConditionMgr::AddToConditionList(reference, cond);
+        }
+    }
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        ConditionContainer dbOrder;
+        for (uint32 elseGroup = 0, groups = 1 + random() % 4; elseGroup < groups; ++elseGroup)
+        {
+            for (uint32 j = 0, size = 1 + random() % 5; j < size; ++j)
+            {
+                Condition* cond = makeCondition(elseGroup);
+                if (random() % 10 == 0)
+                {
+                    cond->ConditionType = CONDITION_NONE;
+                    cond->ReferenceId = 1 + random() % 8;
+                    cond->ReferencedConditions = &lists.References[cond->ReferenceId];
+                }
+                dbOrder.push_back(cond);
+            }
+        }
+
+        // rows are read ordered by SourceEntry only, else groups come interleaved
+        std::shuffle(dbOrder.begin(), dbOrder.end(), random);
+        for (std::size_t j = 0; j < dbOrder.size(); ++j)
+            dbOrder[j]->LoadOrder = uint32(lists.Storage.size() + j);
+
+        ConditionContainer& compiled = lists.Compiled.emplace_back();
+        for (Condition* cond : dbOrder)
+            ConditionMgr::AddToConditionList(compiled, cond);
+
+        lists.DbOrder.push_back(std::move(dbOrder));
+    }
+
+    return lists;
+}
+}
+
+TEST_CASE("Failed spell conditions are reported in db order", "[ConditionMgr]")
+{
+    std::mt19937 random(7);
+    ConditionLists lists = MakeConditionLists(random, 500, CONDITION_SOURCE_TYPE_SPELL);
+
+    for (uint32 i = 0; i < 6; ++i)
+    {
+        ConditionObject target(i % 2, i % 3, (i / 3) % 3);
+        for (std::size_t j = 0; j < lists.Compiled.size(); ++j)
+        {
+            ConditionSourceInfo compiled(&target);
+            ConditionSourceInfo interpreted(&target);
+            bool const passed = sConditionMgr->IsObjectMeetToConditions(compiled, lists.Compiled[j]);
+            REQUIRE(passed == IsObjectMeetToConditionListInterpreted(interpreted, lists.DbOrder[j], lists.References));
+            if (!passed)
+                REQUIRE(compiled.mLastFailedCondition == interpreted.mLastFailedCondition);
+        }
+    }
+}
+
+TEST_CASE("Condition list evaluation", "[ConditionMgr][.][benchmark]")
+{
+    std::mt19937 random(42);
+    ConditionLists lists = MakeConditionLists(random, 2000);
+
+    std::vector<std::unique_ptr<ConditionObject>> targets;
+    for (uint32 i = 0; i < 16; ++i)
+        targets.push_back(std::make_unique<ConditionObject>(i % 2, i % 3, (i / 3) % 3));
+
+    auto evaluateCompiled = [&]()
+    {
+        uint32 passed = 0;
+        for (std::unique_ptr<ConditionObject> const& target : targets)
+        {
+            ConditionSourceInfo sourceInfo(target.get());
+            for (ConditionContainer const& conditions : lists.Compiled)
+                passed += sConditionMgr->IsObjectMeetToConditions(sourceInfo, conditions);
+        }
+        return passed;
+    };
+
+    auto evaluateInterpreted = [&]()
+    {
+        uint32 passed = 0;
+        for (std::unique_ptr<ConditionObject> const& target : targets)
+        {
+            ConditionSourceInfo sourceInfo(target.get());
+            for (ConditionContainer const& conditions : lists.DbOrder)
+                passed += IsObjectMeetToConditionListInterpreted(sourceInfo, conditions, lists.References);
+        }
+        return passed;
+    };
+
+    for (std::unique_ptr<ConditionObject> const& target : targets)
+    {
+        ConditionSourceInfo sourceInfo(target.get());
+        for (std::size_t i = 0; i < lists.Compiled.size(); ++i)
+            REQUIRE(sConditionMgr->IsObjectMeetToConditions(sourceInfo, lists.Compiled[i]) == IsObjectMeetToConditionListInterpreted(sourceInfo, lists.DbOrder[i], lists.References));
+    }
+
+    BENCHMARK("Interpreted, std::map per else group")
+    {
+        return evaluateInterpreted();
+    };
+
+    BENCHMARK("Compiled, ordered else groups")
+    {
+        return evaluateCompiled();
+    };
+}
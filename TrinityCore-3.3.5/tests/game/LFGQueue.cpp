@@ -0,0 +1,457 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "Group.h"
+#include "LFGMgr.h"
+#include "LFGQueue.h"
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <map>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using namespace lfg;
+
+namespace
+{
+struct SyntheticEntrant
+{
+    ObjectGuid Guid;
+    LfgRolesMap Roles;
+    LfgDungeonSet Dungeons;
+};
+
+// players and small premades of a busy realm, most of them queued for one of the random dungeons
+std::vector<SyntheticEntrant> MakeEntrants(uint32 count)
+{
+    static constexpr uint8 SoloRoles[] = { PLAYER_ROLE_DAMAGE, PLAYER_ROLE_DAMAGE, PLAYER_ROLE_DAMAGE, PLAYER_ROLE_DAMAGE, PLAYER_ROLE_DAMAGE,
+        PLAYER_ROLE_TANK, PLAYER_ROLE_HEALER, PLAYER_ROLE_TANK | PLAYER_ROLE_DAMAGE, PLAYER_ROLE_HEALER | PLAYER_ROLE_DAMAGE,
+        PLAYER_ROLE_TANK | PLAYER_ROLE_HEALER | PLAYER_ROLE_DAMAGE };
+
+    std::mt19937 random(42);
+    std::vector<SyntheticEntrant> entrants(count);
+    uint32 playerCounter = 0;
+    for (uint32 i = 0; i < count; ++i)
+    {
+        SyntheticEntrant& entrant = entrants[i];
+        uint32 members = random() % 8 ? 1 : 2 + random() % 2;
+        for (uint32 member = 0; member < members; ++member)
+        {
+            uint8 roles = members == 1 ? SoloRoles[random() % std::size(SoloRoles)] : (member ? PLAYER_ROLE_DAMAGE : PLAYER_ROLE_HEALER | PLAYER_ROLE_DAMAGE);
+            entrant.Roles[ObjectGuid::Create<HighGuid::Player>(++playerCounter)] = roles | (member ? 0 : PLAYER_ROLE_LEADER);
+        }
+
+        entrant.Guid = members == 1 ? entrant.Roles.begin()->first : ObjectGuid::Create<HighGuid::Group>(i + 1);
+
+        // the dungeons of one expansion, all of them or a few picked by hand
+        uint32 expansion = random() % 3;
+        if (random() % 4)
+            for (uint32 dungeon = 0; dungeon < 16; ++dungeon)
+                entrant.Dungeons.insert(1 + expansion * 100 + dungeon);
+        else
+            for (uint32 dungeon = 1 + random() % 3; dungeon; --dungeon)
+                entrant.Dungeons.insert(1 + expansion * 100 + random() % 16);
+    }
+
+    return entrants;
+}
+
+// what LFGQueue used to be: string keys in a std::map and dungeon sets intersected for every combination
+class ReferenceMatcher
+{
+public:
+    explicit ReferenceMatcher(std::vector<SyntheticEntrant> const& entrants)
+    {
+        for (SyntheticEntrant const& entrant : entrants)
+            _entrants[entrant.Guid] = &entrant;
+    }
+
+    std::vector<std::string> Run(std::vector<SyntheticEntrant> const& entrants)
+    {
+        std::vector<std::string> groups;
+        for (SyntheticEntrant const& entrant : entrants)
+        {
+            GuidList check = { entrant.Guid };
+            GuidList all = _queue;
+            if (FindNewGroups(check, all) != LFG_COMPATIBLES_MATCH)
+                _queue.push_back(entrant.Guid);
+            else
+                groups.push_back(_lastMatch);
+        }
+        return groups;
+    }
+
+private:
+    static std::string ConcatenateGuids(GuidList const& check)
+    {
+        GuidSet guids(check.begin(), check.end());
+        std::ostringstream o;
+        for (GuidSet::const_iterator itr = guids.begin(); itr != guids.end(); ++itr)
+            o << (itr == guids.begin() ? "" : "|") << itr->GetRawValue();
+        return o.str();
+    }
+
+    LfgCompatibility FindNewGroups(GuidList& check, GuidList& all)
+    {
+        std::string key = ConcatenateGuids(check);
+        auto itr = _compatibles.find(key);
+        LfgCompatibility compatibles = itr != _compatibles.end() ? itr->second : (_compatibles[key] = CheckCompatibility(check, key));
+        if (compatibles != LFG_COMPATIBLES_WITH_LESS_PLAYERS)
+            return compatibles;
+
+        while (!all.empty())
+        {
+            check.push_back(all.front());
+            all.pop_front();
+            if (FindNewGroups(check, all) == LFG_COMPATIBLES_MATCH)
+                return LFG_COMPATIBLES_MATCH;
+            check.pop_back();
+        }
+        return compatibles;
+    }
+
+    LfgCompatibility CheckCompatibility(GuidList const& check, std::string const& key)
+    {
+        LfgRolesMap roles;
+        LfgDungeonSet dungeons = _entrants[check.front()]->Dungeons;
+        for (ObjectGuid guid : check)
+        {
+            SyntheticEntrant const* entrant = _entrants[guid];
+            roles.insert(entrant->Roles.begin(), entrant->Roles.end());
+
+            LfgDungeonSet temporal;
+            std::set_intersection(dungeons.begin(), dungeons.end(), entrant->Dungeons.begin(), entrant->Dungeons.end(), std::inserter(temporal, temporal.begin()));
+            dungeons = temporal;
+        }
+
+        if (roles.size() > MAX_GROUP_SIZE)
+            return LFG_INCOMPATIBLES_TOO_MUCH_PLAYERS;
+        if (!LFGMgr::CheckGroupRoles(roles))
+            return LFG_INCOMPATIBLES_NO_ROLES;
+        if (dungeons.empty())
+            return LFG_INCOMPATIBLES_NO_DUNGEONS;
+        if (roles.size() != MAX_GROUP_SIZE)
+            return LFG_COMPATIBLES_WITH_LESS_PLAYERS;
+
+        for (ObjectGuid guid : check)
+        {
+            _queue.remove(guid);
+
+            std::string strGuid = std::to_string(guid.GetRawValue());
+            for (auto itr = _compatibles.begin(); itr != _compatibles.end();)
+            {
+                if (itr->first.find(strGuid) != std::string::npos)
+                    itr = _compatibles.erase(itr);
+                else
+                    ++itr;
+            }
+        }
+
+        _lastMatch = key;
+        return LFG_COMPATIBLES_MATCH;
+    }
+
+    std::map<ObjectGuid, SyntheticEntrant const*> _entrants;
+    std::map<std::string, LfgCompatibility> _compatibles;
+    GuidList _queue;
+    std::string _lastMatch;
+};
+
+// the search LFGQueue::FindNewGroups does now, on the same entrants
+class BucketedMatcher
+{
+public:
+    explicit BucketedMatcher(std::vector<SyntheticEntrant> const& entrants)
+    {
+        for (SyntheticEntrant const& entrant : entrants)
+            _entrants[entrant.Guid] = { &entrant, LfgDungeonMask(entrant.Dungeons), LfgPackedRoles(entrant.Roles) };
+    }
+
+    std::vector<std::string> Run(std::vector<SyntheticEntrant> const& entrants)
+    {
+        std::vector<std::string> groups;
+        for (SyntheticEntrant const& entrant : entrants)
+        {
+            if (FindNewGroups(entrant.Guid))
+            {
+                groups.push_back(_lastMatch);
+                continue;
+            }
+
+            _queue.push_back(entrant.Guid);
+            _buckets.Add(_entrants[entrant.Guid].Roles);
+        }
+        return groups;
+    }
+
+private:
+    struct Entrant
+    {
+        SyntheticEntrant const* Source;
+        LfgDungeonMask Dungeons;
+        LfgPackedRoles Roles;
+    };
+
+    bool FindNewGroups(ObjectGuid guid)
+    {
+        GuidList check = { guid };
+        Entrant const& entrant = _entrants[guid];
+        LfgPackedRoles groupRoles = entrant.Roles;
+        LfgDungeonMask groupDungeons = entrant.Dungeons;
+
+        uint32 index;
+        _buckets.Select(groupRoles, 0);
+        while (_buckets.Next(index))
+        {
+            Entrant const& candidate = _entrants[_queue[index]];
+            if (!groupDungeons.Intersects(candidate.Dungeons))
+                continue;
+
+            check.push_back(_queue[index]);
+            LfgCompatibilityKey key(check);
+            LfgCompatibilityData& data = _compatibles[key];
+            if (data.compatibility == LFG_COMPATIBILITY_PENDING)
+                data.compatibility = CheckCompatibility(groupRoles + candidate.Roles);
+
+            if (data.compatibility == LFG_COMPATIBLES_MATCH)
+            {
+                Match(check, key);
+                return true;
+            }
+
+            if (data.compatibility != LFG_COMPATIBLES_WITH_LESS_PLAYERS)
+            {
+                check.pop_back();
+                continue;
+            }
+
+            groupRoles += candidate.Roles;
+            groupDungeons &= candidate.Dungeons;
+            _buckets.Select(groupRoles, index + 1);
+        }
+        return false;
+    }
+
+    // dungeons were already checked by the masks
+    static LfgCompatibility CheckCompatibility(LfgPackedRoles roles)
+    {
+        if (roles.GetPlayerCount() > MAX_GROUP_SIZE)
+            return LFG_INCOMPATIBLES_TOO_MUCH_PLAYERS;
+        if (!roles.CanFillRoles())
+            return LFG_INCOMPATIBLES_NO_ROLES;
+        return roles.GetPlayerCount() != MAX_GROUP_SIZE ? LFG_COMPATIBLES_WITH_LESS_PLAYERS : LFG_COMPATIBLES_MATCH;
+    }
+
+    void Match(GuidList const& check, LfgCompatibilityKey const& key)
+    {
+        for (ObjectGuid guid : check)
+            _queue.erase(std::remove(_queue.begin(), _queue.end(), guid), _queue.end());
+
+        _compatibles.EraseIf([&check](LfgCompatibleContainer::value_type const& entry)
+        {
+            return std::any_of(check.begin(), check.end(), [&entry](ObjectGuid guid) { return entry.first.Contains(guid); });
+        });
+
+        _buckets.Clear();
+        for (ObjectGuid guid : _queue)
+            _buckets.Add(_entrants[guid].Roles);
+
+        _lastMatch = key.ToString();
+    }
+
+    std::map<ObjectGuid, Entrant> _entrants;
+    LfgCompatibleContainer _compatibles;
+    LfgRoleBuckets _buckets;
+    std::vector<ObjectGuid> _queue;
+    std::string _lastMatch;
+};
+}
+
+TEST_CASE("Packed roles agree with role assignment", "[LFGQueue]")
+{
+    // every group of up to 5 players, each with any combination of roles, the first one leading
+    std::vector<uint8> roles;
+    std::function<void(uint8)> check = [&](uint8 firstRoles)
+    {
+        if (!roles.empty())
+        {
+            LfgRolesMap rolesMap;
+            LfgPackedRoles packedRoles;
+            for (std::size_t i = 0; i < roles.size(); ++i)
+            {
+                uint8 playerRoles = roles[i] | (i ? PLAYER_ROLE_NONE : PLAYER_ROLE_LEADER);
+                rolesMap[ObjectGuid::Create<HighGuid::Player>(i + 1)] = playerRoles;
+                packedRoles.AddPlayer(playerRoles);
+            }
+
+            REQUIRE(packedRoles == LfgPackedRoles(rolesMap));
+            REQUIRE(packedRoles.GetPlayerCount() == roles.size());
+            REQUIRE(packedRoles.CanFillRoles() == LFGMgr::CheckGroupRoles(rolesMap));
+        }
+
+        if (roles.size() == MAX_GROUP_SIZE)
+            return;
+
+        for (uint8 playerRoles = firstRoles; playerRoles <= PLAYER_ROLE_ANY; playerRoles += PLAYER_ROLE_TANK)
+        {
+            roles.push_back(playerRoles);
+            check(playerRoles);
+            roles.pop_back();
+        }
+    };
+
+    check(PLAYER_ROLE_NONE);
+
+    // a sixth player never fits, whatever the roles
+    LfgPackedRoles full;
+    for (uint8 i = 0; i <= MAX_GROUP_SIZE; ++i)
+        full.AddPlayer(PLAYER_ROLE_TANK | PLAYER_ROLE_HEALER | PLAYER_ROLE_DAMAGE);
+    REQUIRE_FALSE(full.CanFillRoles());
+}
+
+TEST_CASE("Compatibility keys", "[LFGQueue]")
+{
+    ObjectGuid first = ObjectGuid::Create<HighGuid::Player>(1);
+    ObjectGuid second = ObjectGuid::Create<HighGuid::Player>(11);
+    ObjectGuid group = ObjectGuid::Create<HighGuid::Group>(1);
+
+    LfgCompatibilityKey key({ second, group, first, second });
+    REQUIRE(key.size() == 3);
+    REQUIRE(key == LfgCompatibilityKey({ group, first, second }));
+    REQUIRE(key.GetHash() == LfgCompatibilityKey({ first, second, group }).GetHash());
+    REQUIRE(key.ToString() == std::to_string(first.GetRawValue()) + "|" + std::to_string(second.GetRawValue()) + "|" + std::to_string(group.GetRawValue()));
+    REQUIRE_FALSE(key == LfgCompatibilityKey({ first, second }));
+
+    // guids are compared whole, 1 is not part of 11 like it was in the strings
+    LfgCompatibilityKey single({ second });
+    REQUIRE(single.Contains(second));
+    REQUIRE_FALSE(single.Contains(first));
+    REQUIRE(LfgCompatibilityKey().empty());
+}
+
+TEST_CASE("Compatibility cache", "[LFGQueue]")
+{
+    LfgCompatibleContainer compatibles;
+    for (uint32 i = 1; i <= 1000; ++i)
+        compatibles[LfgCompatibilityKey({ ObjectGuid::Create<HighGuid::Player>(i), ObjectGuid::Create<HighGuid::Player>(i % 7 + 1) })].compatibility = LfgCompatibility(i % 10);
+
+    REQUIRE(compatibles.size() == 1000);
+    for (uint32 i = 1; i <= 1000; ++i)
+    {
+        LfgCompatibilityData* data = compatibles.Find(LfgCompatibilityKey({ ObjectGuid::Create<HighGuid::Player>(i % 7 + 1), ObjectGuid::Create<HighGuid::Player>(i) }));
+        REQUIRE(data);
+        REQUIRE(data->compatibility == LfgCompatibility(i % 10));
+    }
+
+    ObjectGuid removed = ObjectGuid::Create<HighGuid::Player>(3);
+    compatibles.EraseIf([removed](LfgCompatibleContainer::value_type const& entry) { return entry.first.Contains(removed); });
+    REQUIRE(compatibles.size() == 1000 - 144);
+    REQUIRE_FALSE(compatibles.Find(LfgCompatibilityKey({ removed, ObjectGuid::Create<HighGuid::Player>(9) })));
+    REQUIRE(compatibles.Find(LfgCompatibilityKey({ ObjectGuid::Create<HighGuid::Player>(10), ObjectGuid::Create<HighGuid::Player>(4) })));
+}
+
+TEST_CASE("Dungeon masks", "[LFGQueue]")
+{
+    LfgDungeonMask classic({ 1, 2, 3 });
+    REQUIRE(classic.Intersects(LfgDungeonMask({ 3, 4 })));
+    REQUIRE_FALSE(classic.Intersects(LfgDungeonMask({ 4, 5 })));
+
+    // ids past the mask never make two selections incompatible
+    LfgDungeonMask unmapped({ LfgDungeonMask::MaxDungeonId + 10 });
+    REQUIRE(unmapped.Intersects(LfgDungeonMask({ 1, LfgDungeonMask::MaxDungeonId + 20 })));
+    REQUIRE_FALSE(unmapped.Intersects(classic));
+
+    classic &= LfgDungeonMask({ 2, 3, 4 });
+    REQUIRE(classic.HasMapped());
+    classic &= LfgDungeonMask({ 4 });
+    REQUIRE_FALSE(classic.HasMapped());
+    REQUIRE_FALSE(classic.HasUnmapped());
+}
+
+TEST_CASE("Role buckets", "[LFGQueue]")
+{
+    auto single = [](uint8 roles)
+    {
+        LfgPackedRoles packed;
+        packed.AddPlayer(roles);
+        return packed;
+    };
+
+    LfgRoleBuckets buckets;
+    for (uint8 roles : { PLAYER_ROLE_DAMAGE, PLAYER_ROLE_TANK, PLAYER_ROLE_DAMAGE, PLAYER_ROLE_HEALER, PLAYER_ROLE_TANK, PLAYER_ROLE_DAMAGE })
+        buckets.Add(single(roles));
+
+    auto select = [&buckets](LfgPackedRoles groupRoles, uint32 from)
+    {
+        std::vector<uint32> entries;
+        uint32 index;
+        buckets.Select(groupRoles, from);
+        while (buckets.Next(index))
+            entries.push_back(index);
+        return entries;
+    };
+
+    REQUIRE(select(LfgPackedRoles(), 0) == std::vector<uint32>{ 0, 1, 2, 3, 4, 5 });
+    REQUIRE(select(single(PLAYER_ROLE_TANK), 0) == std::vector<uint32>{ 0, 2, 3, 5 });
+    REQUIRE(select(single(PLAYER_ROLE_TANK), 3) == std::vector<uint32>{ 3, 5 });
+
+    LfgPackedRoles damage = single(PLAYER_ROLE_DAMAGE);
+    REQUIRE(select(damage + damage + damage, 0) == std::vector<uint32>{ 1, 3, 4 });
+
+    SECTION("Clearing keeps the buckets usable")
+    {
+        buckets.Clear();
+        REQUIRE(select(LfgPackedRoles(), 0).empty());
+        buckets.Add(single(PLAYER_ROLE_HEALER));
+        buckets.Add(single(PLAYER_ROLE_DAMAGE));
+        REQUIRE(select(single(PLAYER_ROLE_HEALER), 0) == std::vector<uint32>{ 1 });
+    }
+}
+
+TEST_CASE("LFG matching", "[LFGQueue][.][benchmark]")
+{
+    std::vector<SyntheticEntrant> small = MakeEntrants(1000);
+    std::vector<SyntheticEntrant> large = MakeEntrants(5000);
+
+    std::vector<std::string> groups = BucketedMatcher(small).Run(small);
+    REQUIRE(groups.size() > 100);
+    REQUIRE(groups == ReferenceMatcher(small).Run(small));
+
+    BENCHMARK("1k entrants, string keys and dungeon sets")
+    {
+        return ReferenceMatcher(small).Run(small).size();
+    };
+
+    BENCHMARK("1k entrants, packed keys and role buckets")
+    {
+        return BucketedMatcher(small).Run(small).size();
+    };
+
+    BENCHMARK("5k entrants, string keys and dungeon sets")
+    {
+        return ReferenceMatcher(large).Run(large).size();
+    };
+
+    BENCHMARK("5k entrants, packed keys and role buckets")
+    {
+        return BucketedMatcher(large).Run(large).size();
+    };
+}
@@ -0,0 +1,64 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "OpcodeStats.h"
+#include <thread>
+
+TEST_CASE("Opcode stats merge threads", "[OpcodeStats]")
+{
+    sOpcodeStats->Reset();
+
+    sOpcodeStats->Record(CMSG_MESSAGECHAT, 20, 3us, 2);
+    std::thread([]
+    {
+        sOpcodeStats->Record(CMSG_MESSAGECHAT, 40, 5us, 0);
+        sOpcodeStats->Record(CMSG_CAST_SPELL, 10, 1us, 1);
+    }).join();
+
+    std::vector<OpcodeStatsEntry> entries = sOpcodeStats->Collect();
+    REQUIRE(entries.size() == 2);
+    REQUIRE(entries[0].Opcode == CMSG_MESSAGECHAT);
+    REQUIRE(entries[0].Calls == 2);
+    REQUIRE(entries[0].TotalTime == 8000);
+    REQUIRE(entries[0].MaxTime == 5000);
+    REQUIRE(entries[0].Bytes == 60);
+    REQUIRE(entries[0].Allocations == 2);
+    REQUIRE(entries[1].Opcode == CMSG_CAST_SPELL);
+
+    SECTION("Reset clears every thread")
+    {
+        sOpcodeStats->Reset();
+        REQUIRE(sOpcodeStats->Collect().empty());
+
+        sOpcodeStats->Record(CMSG_MESSAGECHAT, 20, 3us, 0);
+        entries = sOpcodeStats->Collect();
+        REQUIRE(entries.size() == 1);
+        REQUIRE(entries[0].Calls == 1);
+    }
+
+    SECTION("Disabled recorders leave the counters alone")
+    {
+        sOpcodeStats->SetEnabled(false);
+        {
+            OpcodeStats::Recorder recorder(CMSG_MESSAGECHAT, 20);
+        }
+        sOpcodeStats->SetEnabled(true);
+        REQUIRE(sOpcodeStats->Collect()[0].Calls == 2);
+    }
+}
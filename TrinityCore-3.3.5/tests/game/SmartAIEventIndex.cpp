@@ -0,0 +1,149 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "SmartScriptMgr.h"
+#include <random>
+#include <vector>
+
+namespace
+{
+SmartScriptHolder MakeEvent(SMART_EVENT type, uint32 id)
+{
+    SmartScriptHolder holder;
+    holder.entryOrGuid = 1;
+    holder.event_id = id;
+    holder.event.type = type;
+    return holder;
+}
+
+std::vector<uint32> GetIndexed(SmartAIEventIndex const& index, SMART_EVENT type)
+{
+    std::vector<uint32> events;
+    for (uint32 event : index.GetEvents(type))
+        events.push_back(event);
+    return events;
+}
+
+// what every creature of a trash pack runs: combat timers, a few reactions and their links
+SmartAIEventList MakeTrashScript(std::mt19937& random)
+{
+    static constexpr SMART_EVENT Types[] = { SMART_EVENT_UPDATE_IC, SMART_EVENT_UPDATE_IC, SMART_EVENT_HEALTH_PCT, SMART_EVENT_AGGRO,
+        SMART_EVENT_DEATH, SMART_EVENT_SPELLHIT, SMART_EVENT_DAMAGED, SMART_EVENT_RESET, SMART_EVENT_EVADE, SMART_EVENT_LINK };
+
+    SmartAIEventList events;
+    uint32 count = 6 + random() % 10;
+    for (uint32 i = 0; i < count; ++i)
+        events.push_back(MakeEvent(Types[random() % std::size(Types)], i));
+    return events;
+}
+}
+
+TEST_CASE("Events are grouped by type in list order", "[SmartAIEventIndex]")
+{
+    SmartAIEventList events =
+    {
+        MakeEvent(SMART_EVENT_UPDATE_IC, 0),
+        MakeEvent(SMART_EVENT_SPELLHIT, 1),
+        MakeEvent(SMART_EVENT_LINK, 2),
+        MakeEvent(SMART_EVENT_UPDATE_IC, 3),
+        MakeEvent(SMART_EVENT_DEATH, 4),
+    };
+
+    SmartAIEventIndex index;
+    REQUIRE(GetIndexed(index, SMART_EVENT_UPDATE_IC).empty());
+
+    index.Build(events);
+    REQUIRE(GetIndexed(index, SMART_EVENT_UPDATE_IC) == std::vector<uint32>{ 0, 3 });
+    REQUIRE(GetIndexed(index, SMART_EVENT_SPELLHIT) == std::vector<uint32>{ 1 });
+    REQUIRE(GetIndexed(index, SMART_EVENT_DEATH) == std::vector<uint32>{ 4 });
+    REQUIRE(GetIndexed(index, SMART_EVENT_AGGRO).empty());
+    REQUIRE(GetIndexed(index, SMART_EVENT_END).empty());
+
+    // links are only reached from their source event
+    REQUIRE(GetIndexed(index, SMART_EVENT_LINK).empty());
+
+    SECTION("Rebuilding after the events were reordered")
+    {
+        std::swap(events[0], events[4]);
+        events.push_back(MakeEvent(SMART_EVENT_DEATH, 5));
+        index.Build(events);
+        REQUIRE(GetIndexed(index, SMART_EVENT_UPDATE_IC) == std::vector<uint32>{ 3, 4 });
+        REQUIRE(GetIndexed(index, SMART_EVENT_DEATH) == std::vector<uint32>{ 0, 5 });
+    }
+}
+
+TEST_CASE("SmartAI event dispatch", "[SmartAIEventIndex][.][benchmark]")
+{
+    // an instance full of trash packs, 40 different entries spawned 600 times
+    std::mt19937 random(42);
+    std::vector<SmartAIEventTable> tables(40);
+    for (SmartAIEventTable& table : tables)
+    {
+        table.Events = MakeTrashScript(random);
+        table.Index.Build(table.Events);
+    }
+
+    std::vector<SmartAIEventList> creatures;
+    std::vector<SmartAIEventIndex const*> indexes;
+    for (uint32 i = 0; i < 600; ++i)
+    {
+        SmartAIEventTable const& table = tables[random() % tables.size()];
+        creatures.push_back(table.Events);
+        indexes.push_back(&table.Index);
+    }
+
+    // the events an AoE pull fires on every creature
+    static constexpr SMART_EVENT Fired[] = { SMART_EVENT_DAMAGED, SMART_EVENT_SPELLHIT, SMART_EVENT_HEALTH_PCT, SMART_EVENT_DAMAGED, SMART_EVENT_KILL };
+
+    BENCHMARK("Scan every event")
+    {
+        uint32 matched = 0;
+        for (SmartAIEventList& events : creatures)
+            for (SMART_EVENT fired : Fired)
+                for (SmartScriptHolder& event : events)
+                    if (event.GetEventType() != SMART_EVENT_LINK && event.GetEventType() == uint32(fired))
+                        matched += event.event_id;
+        return matched;
+    };
+
+    BENCHMARK("Indexed by type")
+    {
+        uint32 matched = 0;
+        for (uint32 i = 0; i < creatures.size(); ++i)
+            for (SMART_EVENT fired : Fired)
+                for (uint32 index : indexes[i]->GetEvents(fired))
+                    matched += creatures[i][index].event_id;
+        return matched;
+    };
+
+    BENCHMARK("Spawn, copying the list")
+    {
+        SmartAIEventList copy = tables[0].Events;
+        SmartAIEventList events;
+        for (SmartScriptHolder& event : copy)
+            events.push_back(event);
+        return events.size();
+    };
+
+    BENCHMARK("Spawn, sharing the table")
+    {
+        SmartAIEventList events = tables[0].Events;
+        return events.size();
+    };
+}
@@ -0,0 +1,160 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "LootMgr.h"
+#include "SharedDefines.h"
+#include "StartupSnapshot.h"
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+namespace
+{
+struct SnapshotItem
+{
+    uint32 ItemId;
+    uint32 Reference;
+    float Chance;
+    uint16 LootMode;
+    bool NeedsQuest;
+    uint8 GroupId;
+    uint8 MinCount;
+    uint8 MaxCount;
+};
+
+SnapshotItem ReadItem(StartupSnapshot& snapshot)
+{
+    SnapshotItem item;
+    item.ItemId = snapshot.Read<uint32>();
+    item.Reference = snapshot.Read<uint32>();
+    item.Chance = snapshot.Read<float>();
+    item.LootMode = snapshot.Read<uint16>();
+    item.NeedsQuest = snapshot.Read<uint8>() != 0;
+    item.GroupId = snapshot.Read<uint8>();
+    item.MinCount = snapshot.Read<uint8>();
+    item.MaxCount = snapshot.Read<uint8>();
+    return item;
+}
+}
+
+TEST_CASE("Loot template snapshot round trip", "[StartupSnapshot]")
+{
+    boost::filesystem::path file = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("deleteme.snapshot");
+    StartupSnapshot::Digest key = { };
+    key[0] = 1;
+
+    {
+        LootTemplate lootTemplate;
+        lootTemplate.AddEntry(new LootStoreItem(2589, 0, 35.0f, false, LOOT_MODE_DEFAULT, 0, 1, 3));
+        lootTemplate.AddEntry(new LootStoreItem(0, 24024, 100.0f, false, LOOT_MODE_DEFAULT, 0, 1, 1));
+        lootTemplate.AddEntry(new LootStoreItem(6948, 0, 0.0f, true, LOOT_MODE_HARD_MODE_1, 2, 1, 1));
+        lootTemplate.AddEntry(new LootStoreItem(8326, 0, 5.0f, false, LOOT_MODE_DEFAULT, 2, 2, 2));
+
+        StartupSnapshot snapshot("creature_loot_template", file.string(), key);
+        snapshot.Write<uint32>(1);
+        lootTemplate.WriteSnapshot(snapshot);
+        snapshot.WriteString("end");
+        REQUIRE(snapshot.Save());
+    }
+
+    SECTION("Reading it back")
+    {
+        StartupSnapshot snapshot("creature_loot_template", file.string(), key);
+        REQUIRE(snapshot.Open());
+        REQUIRE(snapshot.Read<uint32>() == 1);
+        REQUIRE(snapshot.Read<uint32>() == 4);
+
+        // ungrouped entries and references first, then every group with its explicitly chanced entries before the equal chanced ones
+        SnapshotItem item = ReadItem(snapshot);
+        REQUIRE(item.ItemId == 2589);
+        REQUIRE(item.Chance == 35.0f);
+        REQUIRE(item.MinCount == 1);
+        REQUIRE(item.MaxCount == 3);
+
+        item = ReadItem(snapshot);
+        REQUIRE(item.ItemId == 0);
+        REQUIRE(item.Reference == 24024);
+
+        item = ReadItem(snapshot);
+        REQUIRE(item.ItemId == 8326);
+        REQUIRE(item.GroupId == 2);
+        REQUIRE(item.Chance == 5.0f);
+        REQUIRE(item.MinCount == 2);
+
+        item = ReadItem(snapshot);
+        REQUIRE(item.ItemId == 6948);
+        REQUIRE(item.GroupId == 2);
+        REQUIRE(item.NeedsQuest);
+        REQUIRE(item.LootMode == LOOT_MODE_HARD_MODE_1);
+
+        REQUIRE(snapshot.ReadString() == "end");
+        REQUIRE(snapshot.IsFullyRead());
+        REQUIRE_THROWS_AS(snapshot.Read<uint8>(), ByteBufferException);
+    }
+
+    SECTION("Snapshot of another key is rejected")
+    {
+        StartupSnapshot::Digest otherKey = key;
+        otherKey[1] = 1;
+        StartupSnapshot snapshot("creature_loot_template", file.string(), otherKey);
+        REQUIRE(!snapshot.Open());
+    }
+
+    SECTION("Corrupted snapshot is rejected")
+    {
+        {
+            std::fstream stream(file.string(), std::ios::binary | std::ios::in | std::ios::out);
+            stream.seekg(-5, std::ios::end);
+            char byte = char(stream.get());
+            stream.seekp(-5, std::ios::end);
+            stream.put(char(byte ^ 0x40));
+        }
+
+        StartupSnapshot snapshot("creature_loot_template", file.string(), key);
+        REQUIRE(!snapshot.Open());
+    }
+
+    SECTION("Truncated snapshot is rejected")
+    {
+        boost::filesystem::resize_file(file, boost::filesystem::file_size(file) - 1);
+
+        StartupSnapshot snapshot("creature_loot_template", file.string(), key);
+        REQUIRE(!snapshot.Open());
+    }
+
+    boost::filesystem::remove(file);
+}
+
+TEST_CASE("Empty snapshot round trip", "[StartupSnapshot]")
+{
+    boost::filesystem::path file = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("deleteme.snapshot");
+    StartupSnapshot::Digest key = { };
+
+    {
+        StartupSnapshot snapshot("creature_loot_template", file.string(), key);
+        REQUIRE(snapshot.Save());
+    }
+
+    StartupSnapshot snapshot("creature_loot_template", file.string(), key);
+    REQUIRE(snapshot.Open());
+    REQUIRE(snapshot.IsFullyRead());
+    REQUIRE_THROWS_AS(snapshot.Read<uint8>(), ByteBufferException);
+    snapshot.Close();
+
+    boost::filesystem::remove(file);
+}
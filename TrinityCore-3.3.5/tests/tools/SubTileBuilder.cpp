@@ -0,0 +1,198 @@
+/*
+ * This file is part of the TrinityCore Project. See AUTHORS file for Copyright information
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tc_catch2.h"
+
+#include "SubTileBuilder.h"
+#include "CryptoHash.h"
+#include "Util.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace MMAP;
+
+namespace
+{
+constexpr int TilesPerMap = 4;
+constexpr int TileSize = 40;
+constexpr float CellSize = 0.25f;
+constexpr float MapSize = TilesPerMap * TileSize * CellSize;
+
+// rolling terrain with a raised platform in one corner and a lake in the middle
+struct TestGeometry
+{
+    TestGeometry()
+    {
+        int const gridSize = int(MapSize) + 1;
+        for (int y = 0; y < gridSize; ++y)
+        {
+            for (int x = 0; x < gridSize; ++x)
+            {
+                float height = 2.0f * std::sin(x * 0.35f) * std::cos(y * 0.25f);
+                if (x > 26 && y > 26)
+                    height += 3.0f;
+                SolidVerts.insert(SolidVerts.end(), { float(x), height, float(y) });
+            }
+        }
+
+        for (int y = 0; y + 1 < gridSize; ++y)
+        {
+            for (int x = 0; x + 1 < gridSize; ++x)
+            {
+                int const v = x + y * gridSize;
+                SolidTris.insert(SolidTris.end(), { v, v + gridSize, v + 1, v + 1, v + gridSize, v + gridSize + 1 });
+            }
+        }
+
+        SolidTriAreas.assign(SolidTris.size() / 3, RC_WALKABLE_AREA);
+
+        LiquidVerts = { 12.0f, 1.0f, 12.0f, 12.0f, 1.0f, 24.0f, 24.0f, 1.0f, 12.0f, 24.0f, 1.0f, 24.0f };
+        LiquidTris = { 0, 1, 2, 2, 1, 3 };
+        LiquidTriAreas.assign(2, 8);
+    }
+
+    SubTileInput GetInput() const
+    {
+        SubTileInput input;
+        memset(&input.config, 0, sizeof(input.config));
+        input.config.cs = CellSize;
+        input.config.ch = 0.25f;
+        input.config.bmin[0] = 0.0f;
+        input.config.bmin[1] = -10.0f;
+        input.config.bmin[2] = 0.0f;
+        input.config.bmax[0] = MapSize;
+        input.config.bmax[1] = 10.0f;
+        input.config.bmax[2] = MapSize;
+        input.config.walkableHeight = 12;
+        input.config.walkableRadius = 4;
+        input.config.walkableClimb = 3;
+        input.config.walkableSlopeAngle = 45.0f;
+        input.config.tileSize = TileSize;
+        input.config.borderSize = input.config.walkableRadius + 3;
+        input.config.maxEdgeLen = TileSize + 1;
+        input.config.minRegionArea = rcSqr(8);
+        input.config.mergeRegionArea = rcSqr(20);
+        input.config.maxSimplificationError = 1.8f;
+        input.config.maxVertsPerPoly = 6;
+        input.config.detailSampleDist = CellSize * 16;
+        input.config.detailSampleMaxError = input.config.ch;
+        input.tilesPerMap = TilesPerMap;
+
+        input.solidVerts = SolidVerts.data();
+        input.solidVertCount = int(SolidVerts.size() / 3);
+        input.solidTris = SolidTris.data();
+        input.solidTriCount = int(SolidTris.size() / 3);
+        input.solidTriAreas = SolidTriAreas.data();
+        input.liquidVerts = LiquidVerts.data();
+        input.liquidVertCount = int(LiquidVerts.size() / 3);
+        input.liquidTris = LiquidTris.data();
+        input.liquidTriCount = int(LiquidTris.size() / 3);
+        input.liquidTriAreas = LiquidTriAreas.data();
+        input.tileString = "[Test]";
+        return input;
+    }
+
+    std::vector<float> SolidVerts;
+    std::vector<int> SolidTris;
+    std::vector<unsigned char> SolidTriAreas;
+    std::vector<float> LiquidVerts;
+    std::vector<int> LiquidTris;
+    std::vector<unsigned char> LiquidTriAreas;
+};
+
+template<typename T>
+void HashArray(Trinity::Crypto::SHA1& hash, T const* data, int count)
+{
+    hash.UpdateData(reinterpret_cast<uint8 const*>(data), sizeof(T) * count);
+}
+
+// merges the sub tiles the same way buildMoveMapTile does and hashes the meshes written to the mmtile
+std::string BuildAndHash(SubTileBuilder& builder, SubTileInput const& input, uint32 threads, int* polyCount = nullptr)
+{
+    std::vector<Tile> tiles(TilesPerMap * TilesPerMap);
+    builder.build(input, tiles.data(), threads);
+
+    std::vector<rcPolyMesh*> polyMeshes;
+    std::vector<rcPolyMeshDetail*> detailMeshes;
+    for (Tile const& tile : tiles)
+    {
+        if (!tile.dmesh)
+            continue;
+
+        polyMeshes.push_back(tile.pmesh);
+        detailMeshes.push_back(tile.dmesh);
+    }
+
+    rcContext context(false);
+    rcPolyMesh* polyMesh = rcAllocPolyMesh();
+    rcPolyMeshDetail* detailMesh = rcAllocPolyMeshDetail();
+    REQUIRE(rcMergePolyMeshes(&context, polyMeshes.data(), int(polyMeshes.size()), *polyMesh));
+    REQUIRE(rcMergePolyMeshDetails(&context, detailMeshes.data(), int(detailMeshes.size()), *detailMesh));
+
+    Trinity::Crypto::SHA1 hash;
+    HashArray(hash, polyMesh->verts, polyMesh->nverts * 3);
+    HashArray(hash, polyMesh->polys, polyMesh->npolys * polyMesh->nvp * 2);
+    HashArray(hash, polyMesh->areas, polyMesh->npolys);
+    HashArray(hash, detailMesh->meshes, detailMesh->nmeshes * 4);
+    HashArray(hash, detailMesh->verts, detailMesh->nverts * 3);
+    HashArray(hash, detailMesh->tris, detailMesh->ntris * 4);
+    hash.Finalize();
+
+    if (polyCount)
+        *polyCount = polyMesh->npolys;
+
+    rcFreePolyMesh(polyMesh);
+    rcFreePolyMeshDetail(detailMesh);
+    return ByteArrayToHexStr(hash.GetDigest());
+}
+}
+
+TEST_CASE("Sub tiles built on several threads match a serial build", "[SubTileBuilder]")
+{
+    TestGeometry geometry;
+    SubTileInput input = geometry.GetInput();
+
+    TileBuildContext context;
+    TileScratch scratch;
+    SubTileBuilder builder(&context, &scratch);
+
+    int polyCount = 0;
+    std::string serial = BuildAndHash(builder, input, 1, &polyCount);
+    REQUIRE(polyCount > 0);
+
+    REQUIRE(BuildAndHash(builder, input, 2) == serial);
+    REQUIRE(BuildAndHash(builder, input, 5) == serial);
+    // more threads than sub tiles
+    REQUIRE(BuildAndHash(builder, input, 64) == serial);
+
+    SECTION("Reused heightfields don't leak into the next build")
+    {
+        TileBuildContext freshContext;
+        TileScratch freshScratch;
+        SubTileBuilder freshBuilder(&freshContext, &freshScratch);
+        REQUIRE(BuildAndHash(freshBuilder, input, 1) == serial);
+    }
+
+    SECTION("Helper stage times are added to the builder")
+    {
+        context.resetTimers();
+        BuildAndHash(builder, input, 4);
+        REQUIRE(context.getStageTime(TILE_STAGE_RASTERIZE).count() > 0);
+        REQUIRE(context.getStageTime(TILE_STAGE_DETAIL).count() > 0);
+    }
+}
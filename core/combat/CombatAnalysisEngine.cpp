@@ -0,0 +1,452 @@
+#include "CombatAnalysisEngine.h"
+#include "CombatLogAnalyzer.h"
+#include <algorithm>
+#include <map>
+#include <type_traits>
+
+namespace {
+    bool IsDamageEvent(uint8_t eventType) {
+        return eventType == static_cast<uint8_t>(CombatEventType::SPELL_DAMAGE) ||
+               eventType == static_cast<uint8_t>(CombatEventType::MELEE_DAMAGE);
+    }
+
+    bool IsHealEvent(uint8_t eventType) {
+        return eventType == static_cast<uint8_t>(CombatEventType::SPELL_HEAL);
+    }
+
+    bool HasFlag(uint32_t flags, HitFlags flag) {
+        return (flags & static_cast<uint32_t>(flag)) != 0;
+    }
+
+    bool AllowsEventType(const CombatLogFilter& filter, CombatEventType eventType) {
+        return filter.allowedEventTypes.empty() || filter.allowedEventTypes.contains(eventType);
+    }
+
+    void AddNamed(std::unordered_map<uint32_t, uint64_t>& totals, uint32_t nameId, uint32_t amount) {
+        if (nameId != CombatStringPool::EMPTY) {
+            totals[nameId] += amount;
+        }
+    }
+
+    void ResolveNames(const CombatEventStore& events, const std::unordered_map<uint32_t, uint64_t>& totals, std::map<std::string, uint64_t>& result) {
+        for (const auto& [nameId, total] : totals) {
+            result[events.GetString(nameId)] += total;
+        }
+    }
+
+    template <typename Key>
+    void CopyTotals(const std::unordered_map<Key, uint64_t>& totals, std::map<Key, uint64_t>& result) {
+        for (const auto& [key, total] : totals) {
+            result[key] += total;
+        }
+    }
+
+    void ResolveParticipants(const CombatEventStore& events, const std::unordered_map<uint32_t, uint64_t>& totals, std::map<WGUID, uint64_t>& result) {
+        for (const auto& [participant, total] : totals) {
+            result[events.GetParticipant(participant)] += total;
+        }
+    }
+}
+
+void CombatAnalysisEngine::DamageTotals::Add(const CombatEventStore& events, size_t index) {
+    const uint32_t amount = events.Amounts()[index];
+    const uint32_t flags = events.HitFlagColumn()[index];
+
+    totalHits++;
+    totalDamage += amount;
+    totalOverkill += events.OverAmounts()[index];
+    totalAbsorbed += events.Absorbed()[index];
+    totalResisted += events.Resisted()[index];
+    totalBlocked += events.Blocked()[index];
+    criticalHits += HasFlag(flags, HitFlags::CRITICAL);
+    totalMisses += HasFlag(flags, HitFlags::MISS);
+    totalDodges += HasFlag(flags, HitFlags::DODGE);
+    totalParries += HasFlag(flags, HitFlags::PARRY);
+    totalBlocks += HasFlag(flags, HitFlags::BLOCK);
+
+    const uint32_t spellId = events.SpellIds()[index];
+    if (spellId > 0) {
+        bySpell[spellId] += amount;
+        AddNamed(bySpellName, events.SpellNames()[index], amount);
+    }
+    bySchool[events.SpellSchools()[index]] += amount;
+    AddNamed(byTargetName, events.TargetNames()[index], amount);
+}
+
+DamageBreakdown CombatAnalysisEngine::DamageTotals::ToBreakdown(const CombatEventStore& events) const {
+    DamageBreakdown breakdown;
+    breakdown.totalDamage = totalDamage;
+    breakdown.totalHits = totalHits;
+    breakdown.criticalHits = criticalHits;
+    breakdown.normalHits = totalHits - criticalHits;
+    breakdown.totalMisses = totalMisses;
+    breakdown.totalDodges = totalDodges;
+    breakdown.totalParries = totalParries;
+    breakdown.totalBlocks = totalBlocks;
+    breakdown.totalBlocked = totalBlocked;
+    breakdown.totalAbsorbed = totalAbsorbed;
+    breakdown.totalResisted = totalResisted;
+    breakdown.totalOverkill = totalOverkill;
+
+    CopyTotals(bySpell, breakdown.damageBySpell);
+    ResolveNames(events, bySpellName, breakdown.damageBySpellName);
+    for (const auto& [school, total] : bySchool) {
+        breakdown.damageBySchool[static_cast<CombatSpellSchool>(school)] += total;
+    }
+    ResolveNames(events, byTargetName, breakdown.damageByTarget);
+
+    CombatLogAnalyzer::CalculateDerivedStats(breakdown);
+    return breakdown;
+}
+
+void CombatAnalysisEngine::HealingTotals::Add(const CombatEventStore& events, size_t index) {
+    const uint32_t amount = events.Amounts()[index];
+
+    totalHits++;
+    totalHealing += amount;
+    totalOverheal += events.OverAmounts()[index];
+    criticalHits += HasFlag(events.HitFlagColumn()[index], HitFlags::CRITICAL);
+
+    const uint32_t spellId = events.SpellIds()[index];
+    if (spellId > 0) {
+        bySpell[spellId] += amount;
+        AddNamed(bySpellName, events.SpellNames()[index], amount);
+    }
+    AddNamed(byTargetName, events.TargetNames()[index], amount);
+}
+
+HealingBreakdown CombatAnalysisEngine::HealingTotals::ToBreakdown(const CombatEventStore& events) const {
+    HealingBreakdown breakdown;
+    breakdown.totalHealing = totalHealing;
+    breakdown.totalHits = totalHits;
+    breakdown.criticalHits = criticalHits;
+    breakdown.normalHits = totalHits - criticalHits;
+    breakdown.totalOverheal = totalOverheal;
+
+    CopyTotals(bySpell, breakdown.healingBySpell);
+    ResolveNames(events, bySpellName, breakdown.healingBySpellName);
+    ResolveNames(events, byTargetName, breakdown.healingByTarget);
+
+    CombatLogAnalyzer::CalculateDerivedStats(breakdown);
+    return breakdown;
+}
+
+void CombatAnalysisEngine::SpellTotals::Add(const CombatEventStore& events, size_t index) {
+    if (spellName == CombatStringPool::EMPTY && events.SpellNames()[index] != CombatStringPool::EMPTY) {
+        spellName = events.SpellNames()[index];
+        school = events.SpellSchools()[index];
+    }
+
+    const CombatEventType eventType = static_cast<CombatEventType>(events.EventTypes()[index]);
+    const uint32_t amount = events.Amounts()[index];
+    const uint32_t flags = events.HitFlagColumn()[index];
+    switch (eventType) {
+        case CombatEventType::SPELL_CAST_START:
+            castStarts++;
+            break;
+        case CombatEventType::SPELL_CAST_SUCCESS:
+            castSuccesses++;
+            break;
+        case CombatEventType::SPELL_DAMAGE:
+            totalHits++;
+            totalDamage += amount;
+            totalOverkill += events.OverAmounts()[index];
+            minDamage = std::min<uint64_t>(minDamage, amount);
+            maxDamage = std::max<uint64_t>(maxDamage, amount);
+            totalCrits += HasFlag(flags, HitFlags::CRITICAL);
+            totalMisses += HasFlag(flags, HitFlags::MISS);
+            damageByTarget[events.Targets()[index]] += amount;
+            break;
+        case CombatEventType::SPELL_HEAL:
+            totalHits++;
+            totalHealing += amount;
+            totalOverheal += events.OverAmounts()[index];
+            minHeal = std::min<uint64_t>(minHeal, amount);
+            maxHeal = std::max<uint64_t>(maxHeal, amount);
+            totalCrits += HasFlag(flags, HitFlags::CRITICAL);
+            healingByTarget[events.Targets()[index]] += amount;
+            break;
+        default:
+            break;
+    }
+}
+
+bool CombatAnalysisEngine::SpellTotals::ToAnalysis(const CombatEventStore& events, uint32_t spellId, bool countCastStarts, bool countCastSuccesses, SpellAnalysis& analysis) const {
+    const uint64_t casts = (countCastStarts ? castStarts : 0) + (countCastSuccesses ? castSuccesses : 0);
+    if (casts == 0 && totalHits == 0) {
+        return false;
+    }
+
+    analysis = SpellAnalysis();
+    analysis.spellId = spellId;
+    if (spellName != CombatStringPool::EMPTY) {
+        analysis.spellName = events.GetString(spellName);
+        analysis.school = static_cast<CombatSpellSchool>(school);
+    }
+    analysis.totalCasts = casts;
+    analysis.totalHits = totalHits;
+    analysis.totalCrits = totalCrits;
+    analysis.totalMisses = totalMisses;
+    analysis.totalDamage = totalDamage;
+    analysis.minDamage = minDamage;
+    analysis.maxDamage = maxDamage;
+    analysis.totalOverkill = totalOverkill;
+    analysis.totalHealing = totalHealing;
+    analysis.minHeal = minHeal;
+    analysis.maxHeal = maxHeal;
+    analysis.totalOverheal = totalOverheal;
+    ResolveParticipants(events, damageByTarget, analysis.damageByTarget);
+    ResolveParticipants(events, healingByTarget, analysis.healingByTarget);
+
+    CombatLogAnalyzer::CalculateDerivedStats(analysis);
+    return true;
+}
+
+CombatAnalysisEngine::CombatAnalysisEngine(std::chrono::seconds bucketWidth, size_t bucketCount)
+    : m_bucketTicks(std::max<int64_t>(std::chrono::duration_cast<std::chrono::steady_clock::duration>(bucketWidth).count(), 1)),
+      m_bucketCount(std::max<size_t>(bucketCount, 1)),
+      m_damageRing(m_bucketCount, 0),
+      m_healingRing(m_bucketCount, 0) {
+}
+
+void CombatAnalysisEngine::Add(const CombatEventStore& events, size_t index) {
+    m_eventCount++;
+
+    const uint32_t spellId = events.SpellIds()[index];
+    if (spellId > 0) {
+        m_spells[spellId].Add(events, index);
+    }
+
+    const uint8_t eventType = events.EventTypes()[index];
+    const bool isDamage = IsDamageEvent(eventType);
+    if (!isDamage && !IsHealEvent(eventType)) {
+        return;
+    }
+
+    const uint32_t source = events.Sources()[index];
+    if (source >= m_participants.size()) {
+        m_participants.resize(source + 1);
+    }
+    if (!m_participants[source]) {
+        m_participants[source] = std::make_unique<ParticipantTotals>();
+        m_participants[source]->damageRing.assign(m_bucketCount, 0);
+        m_participants[source]->healingRing.assign(m_bucketCount, 0);
+    }
+    ParticipantTotals& participant = *m_participants[source];
+
+    if (isDamage) {
+        participant.damage.Add(events, index);
+    } else {
+        participant.healing.Add(events, index);
+    }
+
+    // Time buckets, events older than the ring are only counted in the totals
+    const int64_t timestamp = events.Timestamps()[index];
+    if (!m_hasOrigin) {
+        m_hasOrigin = true;
+        m_origin = timestamp;
+    }
+    if (timestamp < m_origin) {
+        return;
+    }
+
+    const int64_t bucket = (timestamp - m_origin) / m_bucketTicks;
+    if (bucket > m_headBucket) {
+        AdvanceTo(bucket);
+    } else if (bucket <= m_headBucket - static_cast<int64_t>(m_bucketCount)) {
+        return;
+    }
+
+    const size_t slot = static_cast<size_t>(bucket % static_cast<int64_t>(m_bucketCount));
+    const uint32_t amount = events.Amounts()[index];
+    if (isDamage) {
+        m_damageRing[slot] += amount;
+        participant.damageRing[slot] += amount;
+    } else {
+        m_healingRing[slot] += amount;
+        participant.healingRing[slot] += amount;
+    }
+}
+
+void CombatAnalysisEngine::AdvanceTo(int64_t bucket) {
+    // Slots of the buckets the head moves past get reused, at most a full turn of the ring has to be cleared
+    const int64_t clearCount = std::min<int64_t>(bucket - m_headBucket, static_cast<int64_t>(m_bucketCount));
+    for (int64_t i = 1; i <= clearCount; ++i) {
+        const size_t slot = static_cast<size_t>((m_headBucket + i) % static_cast<int64_t>(m_bucketCount));
+        m_damageRing[slot] = 0;
+        m_healingRing[slot] = 0;
+        for (const auto& participant : m_participants) {
+            if (participant) {
+                participant->damageRing[slot] = 0;
+                participant->healingRing[slot] = 0;
+            }
+        }
+    }
+    m_headBucket = bucket;
+}
+
+void CombatAnalysisEngine::Clear() {
+    m_hasOrigin = false;
+    m_origin = 0;
+    m_headBucket = 0;
+    std::fill(m_damageRing.begin(), m_damageRing.end(), 0);
+    std::fill(m_healingRing.begin(), m_healingRing.end(), 0);
+    m_participants.clear();
+    m_spells.clear();
+    m_eventCount = 0;
+}
+
+bool CombatAnalysisEngine::SupportsSessionFilter(const CombatEventStore& events, const CombatLogFilter& filter) {
+    return events.BeginRow() == 0 &&
+           !filter.useTimeFilter && filter.minAmount == 0 && filter.maxAmount == UINT32_MAX &&
+           AllowsEventType(filter, CombatEventType::SPELL_DAMAGE) &&
+           AllowsEventType(filter, CombatEventType::MELEE_DAMAGE) &&
+           AllowsEventType(filter, CombatEventType::SPELL_HEAL);
+}
+
+bool CombatAnalysisEngine::SupportsFilter(const CombatEventStore& events, const CombatLogFilter& filter) {
+    return SupportsSessionFilter(events, filter) &&
+           filter.allowedSources.empty() && filter.allowedTargets.empty() && filter.allowedSpells.empty() &&
+           filter.showCrits && filter.showNormalHits && filter.showMisses && filter.showResists;
+}
+
+const CombatAnalysisEngine::ParticipantTotals* CombatAnalysisEngine::FindParticipant(const CombatEventStore& events, const WGUID& guid) const {
+    const uint32_t index = events.FindParticipant(guid);
+    if (index == CombatEventStore::NO_PARTICIPANT || index >= m_participants.size()) {
+        return nullptr;
+    }
+    return m_participants[index].get();
+}
+
+DamageBreakdown CombatAnalysisEngine::GetDamage(const CombatEventStore& events, const WGUID& entityGUID) const {
+    const ParticipantTotals* participant = FindParticipant(events, entityGUID);
+    return participant ? participant->damage.ToBreakdown(events) : DamageBreakdown();
+}
+
+HealingBreakdown CombatAnalysisEngine::GetHealing(const CombatEventStore& events, const WGUID& entityGUID) const {
+    const ParticipantTotals* participant = FindParticipant(events, entityGUID);
+    return participant ? participant->healing.ToBreakdown(events) : HealingBreakdown();
+}
+
+std::vector<SpellAnalysis> CombatAnalysisEngine::GetSpellAnalyses(const CombatEventStore& events, const CombatLogFilter& filter) const {
+    const bool countCastStarts = AllowsEventType(filter, CombatEventType::SPELL_CAST_START);
+    const bool countCastSuccesses = AllowsEventType(filter, CombatEventType::SPELL_CAST_SUCCESS);
+
+    std::vector<SpellAnalysis> results;
+    results.reserve(m_spells.size());
+    for (const auto& [spellId, spell] : m_spells) {
+        SpellAnalysis analysis;
+        if (spell.ToAnalysis(events, spellId, countCastStarts, countCastSuccesses, analysis)) {
+            results.push_back(std::move(analysis));
+        }
+    }
+
+    // Sort by total damage/healing
+    std::sort(results.begin(), results.end(), [](const SpellAnalysis& a, const SpellAnalysis& b) {
+        return (a.totalDamage + a.totalHealing) > (b.totalDamage + b.totalHealing);
+    });
+
+    return results;
+}
+
+CombatAnalysis CombatAnalysisEngine::Analyze(const CombatSession& session) const {
+    CombatAnalysis analysis;
+
+    if (m_eventCount == 0) {
+        return analysis;
+    }
+
+    if (session.isActive) {
+        analysis.duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - session.startTime);
+    } else {
+        analysis.duration = std::chrono::duration<double>(session.endTime - session.startTime);
+    }
+
+    for (const auto& pair : session.participantNames) {
+        analysis.participants.emplace_back(pair.first, pair.second);
+
+        const ParticipantTotals* participant = FindParticipant(session.events, pair.first);
+        if (!participant) continue;
+
+        if (participant->damage.totalDamage > 0) {
+            analysis.damageByParticipant[pair.first] = participant->damage.ToBreakdown(session.events);
+            analysis.totalDamage += participant->damage.totalDamage;
+        }
+        if (participant->healing.totalHealing > 0) {
+            analysis.healingByParticipant[pair.first] = participant->healing.ToBreakdown(session.events);
+            analysis.totalHealing += participant->healing.totalHealing;
+        }
+    }
+
+    if (analysis.duration.count() > 0) {
+        analysis.averageDps = static_cast<double>(analysis.totalDamage) / analysis.duration.count();
+        analysis.averageHps = static_cast<double>(analysis.totalHealing) / analysis.duration.count();
+    }
+
+    analysis.topDamageDealer = CombatLogAnalyzer::RankParticipantsByDps(analysis);
+    analysis.topHealer = CombatLogAnalyzer::RankParticipantsByHps(analysis);
+
+    analysis.timeline.dpsOverTime = GetDpsOverTime();
+    analysis.timeline.hpsOverTime = GetHpsOverTime();
+
+    return analysis;
+}
+
+CombatAnalysisEngine::TimeSeries CombatAnalysisEngine::ToTimeSeries(const std::vector<uint64_t>& ring) const {
+    TimeSeries result;
+    if (!m_hasOrigin) {
+        return result;
+    }
+
+    const double bucketSeconds = std::chrono::duration<double>(std::chrono::steady_clock::duration(m_bucketTicks)).count();
+    const int64_t firstBucket = std::max<int64_t>(0, m_headBucket - static_cast<int64_t>(m_bucketCount) + 1);
+    result.reserve(static_cast<size_t>(m_headBucket - firstBucket + 1));
+    for (int64_t bucket = firstBucket; bucket <= m_headBucket; ++bucket) {
+        const size_t slot = static_cast<size_t>(bucket % static_cast<int64_t>(m_bucketCount));
+        const auto bucketStart = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(m_origin + bucket * m_bucketTicks));
+        result.emplace_back(bucketStart, static_cast<double>(ring[slot]) / bucketSeconds);
+    }
+    return result;
+}
+
+CombatAnalysisEngine::TimeSeries CombatAnalysisEngine::GetDpsOverTime() const {
+    return ToTimeSeries(m_damageRing);
+}
+
+CombatAnalysisEngine::TimeSeries CombatAnalysisEngine::GetHpsOverTime() const {
+    return ToTimeSeries(m_healingRing);
+}
+
+CombatAnalysisEngine::TimeSeries CombatAnalysisEngine::GetDpsOverTime(const CombatEventStore& events, const WGUID& entityGUID) const {
+    const ParticipantTotals* participant = FindParticipant(events, entityGUID);
+    return participant ? ToTimeSeries(participant->damageRing) : TimeSeries();
+}
+
+CombatAnalysisEngine::TimeSeries CombatAnalysisEngine::GetHpsOverTime(const CombatEventStore& events, const WGUID& entityGUID) const {
+    const ParticipantTotals* participant = FindParticipant(events, entityGUID);
+    return participant ? ToTimeSeries(participant->healingRing) : TimeSeries();
+}
+
+size_t CombatAnalysisEngine::GetMemoryUsageBytes() const {
+    // Hash map nodes are estimated as key, value and a next pointer
+    auto mapBytes = [](const auto& map) {
+        return map.size() * (sizeof(typename std::decay_t<decltype(map)>::value_type) + sizeof(void*)) + map.bucket_count() * sizeof(void*);
+    };
+
+    size_t bytes = (m_damageRing.capacity() + m_healingRing.capacity()) * sizeof(uint64_t);
+    bytes += m_participants.capacity() * sizeof(std::unique_ptr<ParticipantTotals>);
+    for (const auto& participant : m_participants) {
+        if (!participant) continue;
+        bytes += sizeof(ParticipantTotals);
+        bytes += (participant->damageRing.capacity() + participant->healingRing.capacity()) * sizeof(uint64_t);
+        bytes += mapBytes(participant->damage.bySpell) + mapBytes(participant->damage.bySpellName) +
+                 mapBytes(participant->damage.bySchool) + mapBytes(participant->damage.byTargetName);
+        bytes += mapBytes(participant->healing.bySpell) + mapBytes(participant->healing.bySpellName) +
+                 mapBytes(participant->healing.byTargetName);
+    }
+    bytes += mapBytes(m_spells);
+    for (const auto& [spellId, spell] : m_spells) {
+        bytes += mapBytes(spell.damageByTarget) + mapBytes(spell.healingByTarget);
+    }
+    return bytes;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "CombatEventStore.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct CombatSession;
+struct CombatLogFilter;
+struct CombatAnalysis;
+struct DamageBreakdown;
+struct HealingBreakdown;
+struct SpellAnalysis;
+
+// Running totals of a session, updated as events are appended so analysis queries cost O(participants + spells)
+// instead of a pass over every event. The totals cover every event of the session, rows trimmed from the store
+// included, so they stop matching a scan of the store once it was trimmed. DPS/HPS over time is kept in fixed
+// width buckets, a ring holds the most recent bucketCount of them.
+class CombatAnalysisEngine {
+public:
+    using TimeSeries = std::vector<std::pair<std::chrono::steady_clock::time_point, double>>;
+
+    static constexpr std::chrono::seconds DEFAULT_BUCKET_WIDTH{5};
+    static constexpr size_t DEFAULT_BUCKET_COUNT = 720;  // one hour of 5 second buckets
+
+    // Totals of one source. Spell names and targets are summed by interned id and only resolved to strings when
+    // the breakdown is built.
+    struct DamageTotals {
+        uint64_t totalDamage = 0;
+        uint64_t totalHits = 0;
+        uint64_t criticalHits = 0;
+        uint64_t totalMisses = 0;
+        uint64_t totalDodges = 0;
+        uint64_t totalParries = 0;
+        uint64_t totalBlocks = 0;
+        uint64_t totalBlocked = 0;
+        uint64_t totalAbsorbed = 0;
+        uint64_t totalResisted = 0;
+        uint64_t totalOverkill = 0;
+        std::unordered_map<uint32_t, uint64_t> bySpell;
+        std::unordered_map<uint32_t, uint64_t> bySpellName;
+        std::unordered_map<uint8_t, uint64_t> bySchool;
+        std::unordered_map<uint32_t, uint64_t> byTargetName;
+
+        void Add(const CombatEventStore& events, size_t index);
+        DamageBreakdown ToBreakdown(const CombatEventStore& events) const;
+    };
+
+    struct HealingTotals {
+        uint64_t totalHealing = 0;
+        uint64_t totalHits = 0;
+        uint64_t criticalHits = 0;
+        uint64_t totalOverheal = 0;
+        std::unordered_map<uint32_t, uint64_t> bySpell;
+        std::unordered_map<uint32_t, uint64_t> bySpellName;
+        std::unordered_map<uint32_t, uint64_t> byTargetName;
+
+        void Add(const CombatEventStore& events, size_t index);
+        HealingBreakdown ToBreakdown(const CombatEventStore& events) const;
+    };
+
+    // Totals of one spell id over every event type, casts are counted per event type so a filter can leave them out
+    struct SpellTotals {
+        uint32_t spellName = CombatStringPool::EMPTY;
+        uint8_t school = 0;
+        uint64_t castStarts = 0;
+        uint64_t castSuccesses = 0;
+        uint64_t totalHits = 0;
+        uint64_t totalCrits = 0;
+        uint64_t totalMisses = 0;
+        uint64_t totalDamage = 0;
+        uint64_t minDamage = UINT64_MAX;
+        uint64_t maxDamage = 0;
+        uint64_t totalOverkill = 0;
+        uint64_t totalHealing = 0;
+        uint64_t minHeal = UINT64_MAX;
+        uint64_t maxHeal = 0;
+        uint64_t totalOverheal = 0;
+        std::unordered_map<uint32_t, uint64_t> damageByTarget;   // by participant index
+        std::unordered_map<uint32_t, uint64_t> healingByTarget;
+
+        void Add(const CombatEventStore& events, size_t index);
+        // Returns false when the spell has neither casts nor hits to report
+        bool ToAnalysis(const CombatEventStore& events, uint32_t spellId, bool countCastStarts, bool countCastSuccesses, SpellAnalysis& analysis) const;
+    };
+
+    explicit CombatAnalysisEngine(std::chrono::seconds bucketWidth = DEFAULT_BUCKET_WIDTH, size_t bucketCount = DEFAULT_BUCKET_COUNT);
+
+    // Folds in the row at index, called right after it was appended to events
+    void Add(const CombatEventStore& events, size_t index);
+    void Clear();
+
+    // Whether the running totals match a scan of the rows of events selected by the filter, never after rows were
+    // trimmed from events. SupportsSessionFilter only checks what CombatLogAnalyzer::AnalyzeSession applies of a filter.
+    static bool SupportsFilter(const CombatEventStore& events, const CombatLogFilter& filter);
+    static bool SupportsSessionFilter(const CombatEventStore& events, const CombatLogFilter& filter);
+
+    DamageBreakdown GetDamage(const CombatEventStore& events, const WGUID& entityGUID) const;
+    HealingBreakdown GetHealing(const CombatEventStore& events, const WGUID& entityGUID) const;
+    std::vector<SpellAnalysis> GetSpellAnalyses(const CombatEventStore& events, const CombatLogFilter& filter) const;
+
+    // Same results as CombatLogAnalyzer::AnalyzeSession, the timeline only has the DPS/HPS buckets and no
+    // per event points
+    CombatAnalysis Analyze(const CombatSession& session) const;
+
+    // Rate per bucket still held by the rings, oldest first
+    TimeSeries GetDpsOverTime() const;
+    TimeSeries GetHpsOverTime() const;
+    TimeSeries GetDpsOverTime(const CombatEventStore& events, const WGUID& entityGUID) const;
+    TimeSeries GetHpsOverTime(const CombatEventStore& events, const WGUID& entityGUID) const;
+
+    uint64_t GetEventCount() const { return m_eventCount; }
+    size_t GetMemoryUsageBytes() const;
+
+private:
+    struct ParticipantTotals {
+        DamageTotals damage;
+        HealingTotals healing;
+        std::vector<uint64_t> damageRing;
+        std::vector<uint64_t> healingRing;
+    };
+
+    const ParticipantTotals* FindParticipant(const CombatEventStore& events, const WGUID& guid) const;
+    void AdvanceTo(int64_t bucket);
+    TimeSeries ToTimeSeries(const std::vector<uint64_t>& ring) const;
+
+    int64_t m_bucketTicks;
+    size_t m_bucketCount;
+
+    // Bucket 0 starts at the first damage or heal event, m_headBucket is the newest bucket in the rings
+    bool m_hasOrigin = false;
+    int64_t m_origin = 0;
+    int64_t m_headBucket = 0;
+    std::vector<uint64_t> m_damageRing;
+    std::vector<uint64_t> m_healingRing;
+
+    // Indexed by the store's participant index, only sources that dealt damage or healed have totals
+    std::vector<std::unique_ptr<ParticipantTotals>> m_participants;
+    std::unordered_map<uint32_t, SpellTotals> m_spells;
+    uint64_t m_eventCount = 0;
+};
@@ -0,0 +1,256 @@
+#include "CombatEventStore.h"
+#include "CombatLogEntry.h"
+#include <algorithm>
+#include <array>
+#include <unordered_set>
+
+namespace {
+    template <typename T>
+    void EraseFrontOf(std::vector<T>& column, size_t count) {
+        column.erase(column.begin(), column.begin() + count);
+    }
+
+    template <typename T>
+    size_t ColumnBytes(const std::vector<T>& column) {
+        return column.capacity() * sizeof(T);
+    }
+}
+
+CombatStringPool::CombatStringPool() {
+    Intern("");
+}
+
+uint32_t CombatStringPool::Intern(std::string_view str) {
+    auto it = m_ids.find(str);
+    if (it != m_ids.end()) {
+        return it->second;
+    }
+
+    uint32_t id = static_cast<uint32_t>(m_strings.size());
+    m_strings.emplace_back(str);
+    m_ids.emplace(m_strings.back(), id);
+    return id;
+}
+
+size_t CombatStringPool::GetMemoryUsageBytes() const {
+    size_t bytes = m_strings.size() * sizeof(std::string) + m_ids.size() * (sizeof(std::string_view) + sizeof(uint32_t) + sizeof(void*));
+    for (const auto& str : m_strings) {
+        bytes += str.capacity() + 1;
+    }
+    return bytes;
+}
+
+void CombatStringPool::Clear() {
+    m_ids.clear();
+    m_strings.clear();
+    Intern("");
+}
+
+void CombatEventStore::Append(const CombatLogEntry& entry) {
+    m_timestamps.push_back(entry.timestamp.time_since_epoch().count());
+    m_serverTimestamps.push_back(entry.serverTimestamp);
+    m_eventTypes.push_back(static_cast<uint8_t>(entry.eventType));
+    m_sources.push_back(InternParticipant(entry.sourceGUID));
+    m_targets.push_back(InternParticipant(entry.targetGUID));
+    m_sourceNames.push_back(m_strings.Intern(entry.sourceName));
+    m_targetNames.push_back(m_strings.Intern(entry.targetName));
+    m_sourceFlags.push_back(entry.sourceFlags);
+    m_targetFlags.push_back(entry.targetFlags);
+    m_spellIds.push_back(entry.spellId);
+    m_spellNames.push_back(m_strings.Intern(entry.spellName));
+    m_spellSchools.push_back(static_cast<uint8_t>(entry.spellSchool));
+    m_schoolMasks.push_back(entry.spellSchoolMask);
+    m_amounts.push_back(entry.amount);
+    m_overAmounts.push_back(entry.overAmount);
+    m_absorbed.push_back(entry.absorbed);
+    m_resisted.push_back(entry.resisted);
+    m_blocked.push_back(entry.blocked);
+    m_hitFlags.push_back(static_cast<uint32_t>(entry.hitFlags));
+    m_damageTypes.push_back(static_cast<uint8_t>(entry.damageType));
+    m_meleeOutcomes.push_back(static_cast<uint8_t>(entry.meleeOutcome));
+}
+
+void CombatEventStore::EraseFront(size_t count) {
+    count = std::min(count, Size());
+    if (count == 0) {
+        return;
+    }
+
+    EraseFrontOf(m_timestamps, count);
+    EraseFrontOf(m_serverTimestamps, count);
+    EraseFrontOf(m_eventTypes, count);
+    EraseFrontOf(m_sources, count);
+    EraseFrontOf(m_targets, count);
+    EraseFrontOf(m_sourceNames, count);
+    EraseFrontOf(m_targetNames, count);
+    EraseFrontOf(m_sourceFlags, count);
+    EraseFrontOf(m_targetFlags, count);
+    EraseFrontOf(m_spellIds, count);
+    EraseFrontOf(m_spellNames, count);
+    EraseFrontOf(m_spellSchools, count);
+    EraseFrontOf(m_schoolMasks, count);
+    EraseFrontOf(m_amounts, count);
+    EraseFrontOf(m_overAmounts, count);
+    EraseFrontOf(m_absorbed, count);
+    EraseFrontOf(m_resisted, count);
+    EraseFrontOf(m_blocked, count);
+    EraseFrontOf(m_hitFlags, count);
+    EraseFrontOf(m_damageTypes, count);
+    EraseFrontOf(m_meleeOutcomes, count);
+
+    // Interned GUIDs and names are kept, the remaining rows still refer to most of them
+    m_firstRow += static_cast<RowId>(count);
+}
+
+void CombatEventStore::Clear() {
+    EraseFront(Size());
+    m_participants.clear();
+    m_participantIndex.clear();
+    m_strings.Clear();
+}
+
+CombatLogEntry CombatEventStore::GetEntry(RowId row) const {
+    CombatLogEntry entry;
+    if (!HasRow(row)) {
+        return entry;
+    }
+
+    size_t i = IndexOf(row);
+    entry.timestamp = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(m_timestamps[i]));
+    entry.serverTimestamp = m_serverTimestamps[i];
+    entry.eventType = static_cast<CombatEventType>(m_eventTypes[i]);
+    entry.sourceGUID = m_participants[m_sources[i]];
+    entry.sourceName = m_strings.Get(m_sourceNames[i]);
+    entry.sourceFlags = m_sourceFlags[i];
+    entry.targetGUID = m_participants[m_targets[i]];
+    entry.targetName = m_strings.Get(m_targetNames[i]);
+    entry.targetFlags = m_targetFlags[i];
+    entry.spellId = m_spellIds[i];
+    entry.spellName = m_strings.Get(m_spellNames[i]);
+    entry.spellSchool = static_cast<CombatSpellSchool>(m_spellSchools[i]);
+    entry.spellSchoolMask = m_schoolMasks[i];
+    entry.amount = m_amounts[i];
+    entry.overAmount = m_overAmounts[i];
+    entry.absorbed = m_absorbed[i];
+    entry.resisted = m_resisted[i];
+    entry.blocked = m_blocked[i];
+    entry.hitFlags = static_cast<HitFlags>(m_hitFlags[i]);
+    entry.damageType = static_cast<DamageEffectType>(m_damageTypes[i]);
+    entry.meleeOutcome = static_cast<MeleeHitOutcome>(m_meleeOutcomes[i]);
+    return entry;
+}
+
+std::vector<CombatEventStore::RowId> CombatEventStore::Select(const CombatLogFilter& filter) const {
+    const size_t count = Size();
+
+    // Each criterion is a separate pass over its column, the simple comparisons vectorize
+    std::vector<uint8_t> keep(count, 1);
+
+    if (!filter.allowedEventTypes.empty()) {
+        std::array<uint8_t, 256> allowed{};
+        for (CombatEventType type : filter.allowedEventTypes) {
+            allowed[static_cast<uint8_t>(type)] = 1;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            keep[i] &= allowed[m_eventTypes[i]];
+        }
+    }
+
+    if (filter.useTimeFilter) {
+        const int64_t start = filter.startTime.time_since_epoch().count();
+        const int64_t end = filter.endTime.time_since_epoch().count();
+        for (size_t i = 0; i < count; ++i) {
+            keep[i] &= static_cast<uint8_t>(m_timestamps[i] >= start && m_timestamps[i] <= end);
+        }
+    }
+
+    if (filter.minAmount > 0 || filter.maxAmount < UINT32_MAX) {
+        const uint32_t minAmount = filter.minAmount;
+        const uint32_t maxAmount = filter.maxAmount;
+        for (size_t i = 0; i < count; ++i) {
+            keep[i] &= static_cast<uint8_t>(m_amounts[i] >= minAmount && m_amounts[i] <= maxAmount);
+        }
+    }
+
+    // GUID sets become a lookup table over the interned participants
+    auto applyParticipantFilter = [&](const std::unordered_set<WGUID, WGUIDHash>& guids, const std::vector<uint32_t>& column) {
+        std::vector<uint8_t> allowed(m_participants.size(), 0);
+        for (const WGUID& guid : guids) {
+            uint32_t index = FindParticipant(guid);
+            if (index != NO_PARTICIPANT) {
+                allowed[index] = 1;
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            keep[i] &= allowed[column[i]];
+        }
+    };
+
+    if (!filter.allowedSources.empty()) {
+        applyParticipantFilter(filter.allowedSources, m_sources);
+    }
+    if (!filter.allowedTargets.empty()) {
+        applyParticipantFilter(filter.allowedTargets, m_targets);
+    }
+
+    // Events without a spell pass the spell filter
+    if (!filter.allowedSpells.empty()) {
+        for (size_t i = 0; i < count; ++i) {
+            if (keep[i] && m_spellIds[i] != 0 && !filter.allowedSpells.contains(m_spellIds[i])) {
+                keep[i] = 0;
+            }
+        }
+    }
+
+    if (!filter.showCrits || !filter.showMisses || !filter.showResists || !filter.showNormalHits) {
+        const uint32_t critMask = static_cast<uint32_t>(HitFlags::CRITICAL);
+        const uint32_t missMask = static_cast<uint32_t>(HitFlags::MISS);
+        const uint32_t resistMask = static_cast<uint32_t>(HitFlags::RESIST);
+        const bool hideCrits = !filter.showCrits;
+        const bool hideMisses = !filter.showMisses;
+        const bool hideResists = !filter.showResists;
+        const bool hideNormalHits = !filter.showNormalHits;
+        for (size_t i = 0; i < count; ++i) {
+            const bool crit = (m_hitFlags[i] & critMask) != 0;
+            const bool miss = (m_hitFlags[i] & missMask) != 0;
+            const bool resist = (m_hitFlags[i] & resistMask) != 0;
+            const bool normal = !crit && !miss && !resist;
+            const bool hidden = (crit && hideCrits) || (miss && hideMisses) || (resist && hideResists) || (normal && hideNormalHits);
+            keep[i] &= static_cast<uint8_t>(!hidden);
+        }
+    }
+
+    std::vector<RowId> rows;
+    for (size_t i = 0; i < count; ++i) {
+        if (keep[i]) {
+            rows.push_back(m_firstRow + static_cast<RowId>(i));
+        }
+    }
+    return rows;
+}
+
+uint32_t CombatEventStore::FindParticipant(const WGUID& guid) const {
+    auto it = m_participantIndex.find(guid);
+    return it != m_participantIndex.end() ? it->second : NO_PARTICIPANT;
+}
+
+uint32_t CombatEventStore::InternParticipant(const WGUID& guid) {
+    auto [it, inserted] = m_participantIndex.try_emplace(guid, static_cast<uint32_t>(m_participants.size()));
+    if (inserted) {
+        m_participants.push_back(guid);
+    }
+    return it->second;
+}
+
+size_t CombatEventStore::GetMemoryUsageBytes() const {
+    size_t bytes = ColumnBytes(m_timestamps) + ColumnBytes(m_serverTimestamps) + ColumnBytes(m_eventTypes) +
+        ColumnBytes(m_sources) + ColumnBytes(m_targets) + ColumnBytes(m_sourceNames) + ColumnBytes(m_targetNames) +
+        ColumnBytes(m_sourceFlags) + ColumnBytes(m_targetFlags) + ColumnBytes(m_spellIds) + ColumnBytes(m_spellNames) +
+        ColumnBytes(m_spellSchools) + ColumnBytes(m_schoolMasks) + ColumnBytes(m_amounts) + ColumnBytes(m_overAmounts) +
+        ColumnBytes(m_absorbed) + ColumnBytes(m_resisted) + ColumnBytes(m_blocked) + ColumnBytes(m_hitFlags) +
+        ColumnBytes(m_damageTypes) + ColumnBytes(m_meleeOutcomes);
+
+    bytes += ColumnBytes(m_participants) + m_participantIndex.size() * (sizeof(WGUID) + sizeof(uint32_t) + sizeof(void*));
+    bytes += m_strings.GetMemoryUsageBytes();
+    return bytes;
+}
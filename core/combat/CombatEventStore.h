@@ -0,0 +1,114 @@
+#pragma once
+
+#include "../types/CommonTypes.h"
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct CombatLogEntry;
+struct CombatLogFilter;
+
+// Interned strings, every distinct name is stored once and referenced by index
+class CombatStringPool {
+public:
+    static constexpr uint32_t EMPTY = 0;
+
+    CombatStringPool();
+
+    uint32_t Intern(std::string_view str);
+    const std::string& Get(uint32_t id) const { return m_strings[id]; }
+    size_t Size() const { return m_strings.size(); }
+    size_t GetMemoryUsageBytes() const;
+    void Clear();
+
+private:
+    std::deque<std::string> m_strings;  // deque keeps the strings in place for the views in m_ids
+    std::unordered_map<std::string_view, uint32_t> m_ids;
+};
+
+// Append-only column store of the events of a session. Every field lives in its own array so filters and
+// aggregations only touch the columns they need, GUIDs and names are interned per session.
+// Rows keep their id when older rows are trimmed from the front.
+class CombatEventStore {
+public:
+    using RowId = uint32_t;
+    static constexpr uint32_t NO_PARTICIPANT = UINT32_MAX;
+
+    void Append(const CombatLogEntry& entry);
+    void EraseFront(size_t count);
+    void Clear();
+
+    size_t Size() const { return m_timestamps.size(); }
+    bool Empty() const { return m_timestamps.empty(); }
+    RowId BeginRow() const { return m_firstRow; }
+    RowId EndRow() const { return m_firstRow + static_cast<RowId>(Size()); }
+    bool HasRow(RowId row) const { return row >= BeginRow() && row < EndRow(); }
+    size_t IndexOf(RowId row) const { return row - m_firstRow; }
+
+    // Rebuilds an entry, only meant for the rows that are displayed or exported
+    CombatLogEntry GetEntry(RowId row) const;
+
+    // Rows matching the filter in insertion order
+    std::vector<RowId> Select(const CombatLogFilter& filter) const;
+
+    // Participants are the interned source and target GUIDs
+    uint32_t FindParticipant(const WGUID& guid) const;
+    const WGUID& GetParticipant(uint32_t index) const { return m_participants[index]; }
+    size_t GetParticipantCount() const { return m_participants.size(); }
+    const std::string& GetString(uint32_t id) const { return m_strings.Get(id); }
+
+    size_t GetMemoryUsageBytes() const;
+
+    // Columns, indexed by IndexOf(row)
+    std::span<const int64_t> Timestamps() const { return m_timestamps; }  // steady_clock ticks
+    std::span<const uint8_t> EventTypes() const { return m_eventTypes; }
+    std::span<const uint32_t> Sources() const { return m_sources; }
+    std::span<const uint32_t> Targets() const { return m_targets; }
+    std::span<const uint32_t> SourceNames() const { return m_sourceNames; }
+    std::span<const uint32_t> TargetNames() const { return m_targetNames; }
+    std::span<const uint32_t> SpellIds() const { return m_spellIds; }
+    std::span<const uint32_t> SpellNames() const { return m_spellNames; }
+    std::span<const uint8_t> SpellSchools() const { return m_spellSchools; }
+    std::span<const uint32_t> SchoolMasks() const { return m_schoolMasks; }
+    std::span<const uint32_t> Amounts() const { return m_amounts; }
+    std::span<const uint32_t> OverAmounts() const { return m_overAmounts; }
+    std::span<const uint32_t> Absorbed() const { return m_absorbed; }
+    std::span<const uint32_t> Resisted() const { return m_resisted; }
+    std::span<const uint32_t> Blocked() const { return m_blocked; }
+    std::span<const uint32_t> HitFlagColumn() const { return m_hitFlags; }
+
+private:
+    uint32_t InternParticipant(const WGUID& guid);
+
+    RowId m_firstRow = 0;
+
+    std::vector<int64_t> m_timestamps;
+    std::vector<uint64_t> m_serverTimestamps;
+    std::vector<uint8_t> m_eventTypes;
+    std::vector<uint32_t> m_sources;
+    std::vector<uint32_t> m_targets;
+    std::vector<uint32_t> m_sourceNames;
+    std::vector<uint32_t> m_targetNames;
+    std::vector<uint32_t> m_sourceFlags;
+    std::vector<uint32_t> m_targetFlags;
+    std::vector<uint32_t> m_spellIds;
+    std::vector<uint32_t> m_spellNames;
+    std::vector<uint8_t> m_spellSchools;
+    std::vector<uint32_t> m_schoolMasks;
+    std::vector<uint32_t> m_amounts;
+    std::vector<uint32_t> m_overAmounts;
+    std::vector<uint32_t> m_absorbed;
+    std::vector<uint32_t> m_resisted;
+    std::vector<uint32_t> m_blocked;
+    std::vector<uint32_t> m_hitFlags;
+    std::vector<uint8_t> m_damageTypes;
+    std::vector<uint8_t> m_meleeOutcomes;
+
+    std::vector<WGUID> m_participants;
+    std::unordered_map<WGUID, uint32_t, WGUIDHash> m_participantIndex;
+    CombatStringPool m_strings;
+};
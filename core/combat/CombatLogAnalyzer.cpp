@@ -1,16 +1,35 @@
 #include "CombatLogAnalyzer.h"
-#include "../logs/Logger.h"
+#include "CombatAnalysisEngine.h"
 #include <algorithm>
 #include <numeric>
 #include <cmath>
 #include <sstream>
 #include <iomanip>
+#include <unordered_map>
 #include <unordered_set>
 
+namespace {
+    using RowId = CombatEventStore::RowId;
+
+    bool IsDamageEvent(uint8_t eventType) {
+        return eventType == static_cast<uint8_t>(CombatEventType::SPELL_DAMAGE) ||
+               eventType == static_cast<uint8_t>(CombatEventType::MELEE_DAMAGE);
+    }
+
+    bool IsHealEvent(uint8_t eventType) {
+        return eventType == static_cast<uint8_t>(CombatEventType::SPELL_HEAL);
+    }
+
+    std::chrono::steady_clock::time_point ToTimePoint(int64_t ticks) {
+        return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(ticks));
+    }
+}
+
 CombatAnalysis CombatLogAnalyzer::AnalyzeSession(const CombatSession& session, const CombatLogFilter& filter) {
     CombatAnalysis analysis;
+    const CombatEventStore& events = session.events;
     
-    if (session.entries.empty()) {
+    if (events.Empty()) {
         return analysis;
     }
     
@@ -26,42 +45,50 @@ CombatAnalysis CombatLogAnalyzer::AnalyzeSession(const CombatSession& session, c
         analysis.participants.emplace_back(pair.first, pair.second);
     }
     
-    // Filter entries based on filter criteria
-    std::vector<std::shared_ptr<CombatLogEntry>> filteredEntries;
-    for (const auto& entry : session.entries) {
-        if (!entry) continue;
-        
-        // Apply filter logic (simplified version of manager's filtering)
-        if (!filter.allowedEventTypes.empty() && 
-            filter.allowedEventTypes.find(entry->eventType) == filter.allowedEventTypes.end()) {
-            continue;
-        }
-        
-        if (filter.useTimeFilter) {
-            if (entry->timestamp < filter.startTime || entry->timestamp > filter.endTime) {
-                continue;
-            }
-        }
-        
-        if (entry->amount < filter.minAmount || entry->amount > filter.maxAmount) {
-            continue;
+    // Simplified version of the manager's filtering, only event types, time and amount apply
+    CombatLogFilter sessionFilter;
+    sessionFilter.allowedEventTypes = filter.allowedEventTypes;
+    sessionFilter.useTimeFilter = filter.useTimeFilter;
+    sessionFilter.startTime = filter.startTime;
+    sessionFilter.endTime = filter.endTime;
+    sessionFilter.minAmount = filter.minAmount;
+    sessionFilter.maxAmount = filter.maxAmount;
+    std::vector<RowId> rows = events.Select(sessionFilter);
+    
+    // A single pass accumulates every source, keyed by interned participant
+    std::unordered_map<uint32_t, CombatAnalysisEngine::DamageTotals> damage;
+    std::unordered_map<uint32_t, CombatAnalysisEngine::HealingTotals> healing;
+    auto eventTypes = events.EventTypes();
+    auto sources = events.Sources();
+    for (RowId row : rows) {
+        size_t i = events.IndexOf(row);
+        if (IsDamageEvent(eventTypes[i])) {
+            damage[sources[i]].Add(events, i);
+        } else if (IsHealEvent(eventTypes[i])) {
+            healing[sources[i]].Add(events, i);
         }
-        
-        filteredEntries.push_back(entry);
     }
     
-    // Analyze damage for each participant
     for (const auto& participant : analysis.participants) {
-        DamageBreakdown damageStats = AnalyzeDamage(filteredEntries, participant.first);
-        if (damageStats.totalDamage > 0) {
-            analysis.damageByParticipant[participant.first] = damageStats;
-            analysis.totalDamage += damageStats.totalDamage;
+        uint32_t index = events.FindParticipant(participant.first);
+        if (index == CombatEventStore::NO_PARTICIPANT) continue;
+        
+        auto damageIt = damage.find(index);
+        if (damageIt != damage.end()) {
+            DamageBreakdown damageStats = damageIt->second.ToBreakdown(events);
+            if (damageStats.totalDamage > 0) {
+                analysis.damageByParticipant[participant.first] = damageStats;
+                analysis.totalDamage += damageStats.totalDamage;
+            }
         }
         
-        HealingBreakdown healingStats = AnalyzeHealing(filteredEntries, participant.first);
-        if (healingStats.totalHealing > 0) {
-            analysis.healingByParticipant[participant.first] = healingStats;
-            analysis.totalHealing += healingStats.totalHealing;
+        auto healingIt = healing.find(index);
+        if (healingIt != healing.end()) {
+            HealingBreakdown healingStats = healingIt->second.ToBreakdown(events);
+            if (healingStats.totalHealing > 0) {
+                analysis.healingByParticipant[participant.first] = healingStats;
+                analysis.totalHealing += healingStats.totalHealing;
+            }
         }
     }
     
@@ -76,7 +103,7 @@ CombatAnalysis CombatLogAnalyzer::AnalyzeSession(const CombatSession& session, c
     analysis.topHealer = RankParticipantsByHps(analysis);
     
     // Generate timeline
-    analysis.timeline = GenerateTimeline(filteredEntries);
+    analysis.timeline = GenerateTimeline(events, rows);
     
     return analysis;
 }
@@ -143,21 +170,30 @@ DamageBreakdown CombatLogAnalyzer::AnalyzeDamage(const std::vector<std::shared_p
     }
     
     // Calculate derived statistics
-    if (breakdown.totalHits > 0) {
-        breakdown.averageDamage = static_cast<double>(breakdown.totalDamage) / breakdown.totalHits;
-        breakdown.critRate = static_cast<double>(breakdown.criticalHits) / breakdown.totalHits;
-        
-        uint64_t totalAttempts = breakdown.totalHits + breakdown.totalMisses + breakdown.totalDodges + breakdown.totalParries;
-        if (totalAttempts > 0) {
-            breakdown.accuracy = static_cast<double>(breakdown.totalHits) / totalAttempts;
-        }
+    CalculateDerivedStats(breakdown);
+    
+    return breakdown;
+}
+
+DamageBreakdown CombatLogAnalyzer::AnalyzeDamage(const CombatEventStore& events, const std::vector<RowId>& rows, const WGUID& entityGUID) {
+    uint32_t participant = events.FindParticipant(entityGUID);
+    if (participant == CombatEventStore::NO_PARTICIPANT) {
+        return DamageBreakdown();
     }
     
-    if (breakdown.totalDamage > 0) {
-        breakdown.overkillPercent = static_cast<double>(breakdown.totalOverkill) / breakdown.totalDamage;
+    CombatAnalysisEngine::DamageTotals totals;
+    auto eventTypes = events.EventTypes();
+    auto sources = events.Sources();
+    for (RowId row : rows) {
+        if (!events.HasRow(row)) continue;
+        
+        size_t i = events.IndexOf(row);
+        if (sources[i] == participant && IsDamageEvent(eventTypes[i])) {
+            totals.Add(events, i);
+        }
     }
     
-    return breakdown;
+    return totals.ToBreakdown(events);
 }
 
 HealingBreakdown CombatLogAnalyzer::AnalyzeHealing(const std::vector<std::shared_ptr<CombatLogEntry>>& entries, const WGUID& entityGUID) {
@@ -196,17 +232,30 @@ HealingBreakdown CombatLogAnalyzer::AnalyzeHealing(const std::vector<std::shared
     }
     
     // Calculate derived statistics
-    if (breakdown.totalHits > 0) {
-        breakdown.averageHeal = static_cast<double>(breakdown.totalHealing) / breakdown.totalHits;
-        breakdown.critRate = static_cast<double>(breakdown.criticalHits) / breakdown.totalHits;
+    CalculateDerivedStats(breakdown);
+    
+    return breakdown;
+}
+
+HealingBreakdown CombatLogAnalyzer::AnalyzeHealing(const CombatEventStore& events, const std::vector<RowId>& rows, const WGUID& entityGUID) {
+    uint32_t participant = events.FindParticipant(entityGUID);
+    if (participant == CombatEventStore::NO_PARTICIPANT) {
+        return HealingBreakdown();
     }
     
-    if (breakdown.totalHealing > 0) {
-        breakdown.overhealPercent = static_cast<double>(breakdown.totalOverheal) / breakdown.totalHealing;
-        breakdown.efficiency = static_cast<double>(breakdown.totalHealing - breakdown.totalOverheal) / breakdown.totalHealing;
+    CombatAnalysisEngine::HealingTotals totals;
+    auto eventTypes = events.EventTypes();
+    auto sources = events.Sources();
+    for (RowId row : rows) {
+        if (!events.HasRow(row)) continue;
+        
+        size_t i = events.IndexOf(row);
+        if (sources[i] == participant && IsHealEvent(eventTypes[i])) {
+            totals.Add(events, i);
+        }
     }
     
-    return breakdown;
+    return totals.ToBreakdown(events);
 }
 
 SpellAnalysis CombatLogAnalyzer::AnalyzeSpell(const std::vector<std::shared_ptr<CombatLogEntry>>& entries, uint32_t spellId) {
@@ -267,20 +316,7 @@ SpellAnalysis CombatLogAnalyzer::AnalyzeSpell(const std::vector<std::shared_ptr<
     }
     
     // Calculate derived statistics
-    if (analysis.totalHits > 0) {
-        if (analysis.totalDamage > 0) {
-            analysis.averageDamage = static_cast<double>(analysis.totalDamage) / analysis.totalHits;
-        }
-        if (analysis.totalHealing > 0) {
-            analysis.averageHeal = static_cast<double>(analysis.totalHealing) / analysis.totalHits;
-        }
-        analysis.critRate = static_cast<double>(analysis.totalCrits) / analysis.totalHits;
-    }
-    
-    uint64_t totalAttempts = analysis.totalHits + analysis.totalMisses;
-    if (totalAttempts > 0) {
-        analysis.hitRate = static_cast<double>(analysis.totalHits) / totalAttempts;
-    }
+    CalculateDerivedStats(analysis);
     
     return analysis;
 }
@@ -311,6 +347,36 @@ std::vector<SpellAnalysis> CombatLogAnalyzer::AnalyzeAllSpells(const std::vector
     return results;
 }
 
+std::vector<SpellAnalysis> CombatLogAnalyzer::AnalyzeAllSpells(const CombatEventStore& events, const std::vector<RowId>& rows) {
+    // Every spell is accumulated in the same pass
+    std::unordered_map<uint32_t, CombatAnalysisEngine::SpellTotals> spells;
+    auto spellIds = events.SpellIds();
+    for (RowId row : rows) {
+        if (!events.HasRow(row)) continue;
+        
+        size_t i = events.IndexOf(row);
+        if (spellIds[i] > 0) {
+            spells[spellIds[i]].Add(events, i);
+        }
+    }
+    
+    std::vector<SpellAnalysis> results;
+    results.reserve(spells.size());
+    for (const auto& [spellId, spell] : spells) {
+        SpellAnalysis analysis;
+        if (spell.ToAnalysis(events, spellId, true, true, analysis)) {
+            results.push_back(std::move(analysis));
+        }
+    }
+    
+    // Sort by total damage/healing
+    std::sort(results.begin(), results.end(), [](const SpellAnalysis& a, const SpellAnalysis& b) {
+        return (a.totalDamage + a.totalHealing) > (b.totalDamage + b.totalHealing);
+    });
+    
+    return results;
+}
+
 TimelineData CombatLogAnalyzer::GenerateTimeline(const std::vector<std::shared_ptr<CombatLogEntry>>& entries, std::chrono::seconds windowSize) {
     TimelineData timeline;
     
@@ -376,6 +442,68 @@ TimelineData CombatLogAnalyzer::GenerateTimeline(const std::vector<std::shared_p
     return timeline;
 }
 
+TimelineData CombatLogAnalyzer::GenerateTimeline(const CombatEventStore& events, const std::vector<RowId>& rows, std::chrono::seconds windowSize) {
+    TimelineData timeline;
+    
+    if (rows.empty() || !events.HasRow(rows.front()) || !events.HasRow(rows.back())) {
+        return timeline;
+    }
+    
+    auto timestamps = events.Timestamps();
+    auto eventTypes = events.EventTypes();
+    auto amounts = events.Amounts();
+    
+    // Find time bounds
+    const int64_t startTime = timestamps[events.IndexOf(rows.front())];
+    const int64_t endTime = timestamps[events.IndexOf(rows.back())];
+    
+    // Windows are bucketed by index so DPS and HPS come out of the same single pass
+    const int64_t windowTicks = std::chrono::duration_cast<std::chrono::steady_clock::duration>(windowSize).count();
+    size_t windowCount = 0;
+    if (windowTicks > 0 && endTime > startTime) {
+        windowCount = static_cast<size_t>((endTime - startTime + windowTicks - 1) / windowTicks);
+    }
+    std::vector<uint64_t> windowDamage(windowCount, 0);
+    std::vector<uint64_t> windowHealing(windowCount, 0);
+    
+    for (RowId row : rows) {
+        if (!events.HasRow(row)) continue;
+        
+        size_t i = events.IndexOf(row);
+        const bool isDamage = IsDamageEvent(eventTypes[i]);
+        const bool isHeal = IsHealEvent(eventTypes[i]);
+        if (!isDamage && !isHeal) continue;
+        
+        // Generate data points for individual events
+        TimelineData::DataPoint point;
+        point.timestamp = ToTimePoint(timestamps[i]);
+        point.eventType = static_cast<CombatEventType>(eventTypes[i]);
+        point.value = static_cast<double>(amounts[i]);
+        
+        std::stringstream desc;
+        desc << events.GetString(events.SourceNames()[i]) << " -> " << events.GetString(events.TargetNames()[i]) << ": " << amounts[i];
+        point.description = desc.str();
+        
+        (isDamage ? timeline.damagePoints : timeline.healingPoints).push_back(std::move(point));
+        
+        if (timestamps[i] < startTime) continue;
+        
+        size_t window = static_cast<size_t>((timestamps[i] - startTime) / std::max<int64_t>(windowTicks, 1));
+        if (window < windowCount) {
+            (isDamage ? windowDamage : windowHealing)[window] += amounts[i];
+        }
+    }
+    
+    // Calculate DPS and HPS over time windows
+    for (size_t window = 0; window < windowCount; ++window) {
+        auto windowStart = ToTimePoint(startTime + static_cast<int64_t>(window) * windowTicks);
+        timeline.dpsOverTime.emplace_back(windowStart, static_cast<double>(windowDamage[window]) / windowSize.count());
+        timeline.hpsOverTime.emplace_back(windowStart, static_cast<double>(windowHealing[window]) / windowSize.count());
+    }
+    
+    return timeline;
+}
+
 std::vector<std::pair<std::chrono::steady_clock::time_point, double>> 
 CombatLogAnalyzer::CalculateDpsOverTime(const std::vector<std::shared_ptr<CombatLogEntry>>& entries, 
                                       const WGUID& entityGUID, 
@@ -496,6 +624,51 @@ std::vector<std::pair<std::string, uint64_t>> CombatLogAnalyzer::RankParticipant
     return rankings;
 }
 
+void CombatLogAnalyzer::CalculateDerivedStats(DamageBreakdown& breakdown) {
+    if (breakdown.totalHits > 0) {
+        breakdown.averageDamage = static_cast<double>(breakdown.totalDamage) / breakdown.totalHits;
+        breakdown.critRate = static_cast<double>(breakdown.criticalHits) / breakdown.totalHits;
+        
+        uint64_t totalAttempts = breakdown.totalHits + breakdown.totalMisses + breakdown.totalDodges + breakdown.totalParries;
+        if (totalAttempts > 0) {
+            breakdown.accuracy = static_cast<double>(breakdown.totalHits) / totalAttempts;
+        }
+    }
+    
+    if (breakdown.totalDamage > 0) {
+        breakdown.overkillPercent = static_cast<double>(breakdown.totalOverkill) / breakdown.totalDamage;
+    }
+}
+
+void CombatLogAnalyzer::CalculateDerivedStats(HealingBreakdown& breakdown) {
+    if (breakdown.totalHits > 0) {
+        breakdown.averageHeal = static_cast<double>(breakdown.totalHealing) / breakdown.totalHits;
+        breakdown.critRate = static_cast<double>(breakdown.criticalHits) / breakdown.totalHits;
+    }
+    
+    if (breakdown.totalHealing > 0) {
+        breakdown.overhealPercent = static_cast<double>(breakdown.totalOverheal) / breakdown.totalHealing;
+        breakdown.efficiency = static_cast<double>(breakdown.totalHealing - breakdown.totalOverheal) / breakdown.totalHealing;
+    }
+}
+
+void CombatLogAnalyzer::CalculateDerivedStats(SpellAnalysis& analysis) {
+    if (analysis.totalHits > 0) {
+        if (analysis.totalDamage > 0) {
+            analysis.averageDamage = static_cast<double>(analysis.totalDamage) / analysis.totalHits;
+        }
+        if (analysis.totalHealing > 0) {
+            analysis.averageHeal = static_cast<double>(analysis.totalHealing) / analysis.totalHits;
+        }
+        analysis.critRate = static_cast<double>(analysis.totalCrits) / analysis.totalHits;
+    }
+    
+    uint64_t totalAttempts = analysis.totalHits + analysis.totalMisses;
+    if (totalAttempts > 0) {
+        analysis.hitRate = static_cast<double>(analysis.totalHits) / totalAttempts;
+    }
+}
+
 double CombatLogAnalyzer::CalculateStandardDeviation(const std::vector<uint64_t>& values) {
     if (values.empty()) return 0.0;
     
@@ -139,14 +139,19 @@ public:
     // Individual participant analysis
     static DamageBreakdown AnalyzeDamage(const std::vector<std::shared_ptr<CombatLogEntry>>& entries, const WGUID& entityGUID);
     static HealingBreakdown AnalyzeHealing(const std::vector<std::shared_ptr<CombatLogEntry>>& entries, const WGUID& entityGUID);
+    static DamageBreakdown AnalyzeDamage(const CombatEventStore& events, const std::vector<CombatEventStore::RowId>& rows, const WGUID& entityGUID);
+    static HealingBreakdown AnalyzeHealing(const CombatEventStore& events, const std::vector<CombatEventStore::RowId>& rows, const WGUID& entityGUID);
     
     // Spell-specific analysis
     static SpellAnalysis AnalyzeSpell(const std::vector<std::shared_ptr<CombatLogEntry>>& entries, uint32_t spellId);
     static std::vector<SpellAnalysis> AnalyzeAllSpells(const std::vector<std::shared_ptr<CombatLogEntry>>& entries);
+    static std::vector<SpellAnalysis> AnalyzeAllSpells(const CombatEventStore& events, const std::vector<CombatEventStore::RowId>& rows);
     
     // Timeline analysis
     static TimelineData GenerateTimeline(const std::vector<std::shared_ptr<CombatLogEntry>>& entries, 
                                         std::chrono::seconds windowSize = std::chrono::seconds(5));
+    static TimelineData GenerateTimeline(const CombatEventStore& events, const std::vector<CombatEventStore::RowId>& rows,
+                                        std::chrono::seconds windowSize = std::chrono::seconds(5));
     
     // Performance over time calculations
     static std::vector<std::pair<std::chrono::steady_clock::time_point, double>> 
@@ -166,6 +171,10 @@ public:
     
     // Statistical calculations
     static double CalculateStandardDeviation(const std::vector<uint64_t>& values);
+    // Averages and rates from the totals of a breakdown
+    static void CalculateDerivedStats(DamageBreakdown& breakdown);
+    static void CalculateDerivedStats(HealingBreakdown& breakdown);
+    static void CalculateDerivedStats(SpellAnalysis& analysis);
     static std::pair<double, double> CalculateConfidenceInterval(const std::vector<double>& values, double confidence = 0.95);
     
     // Utility functions
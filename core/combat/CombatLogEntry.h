@@ -1,6 +1,8 @@
 #pragma once
 
-#include "../types/types.h"
+#include "../types/CommonTypes.h"
+#include "CombatEventStore.h"
+#include "CombatAnalysisEngine.h"
 #include <string>
 #include <vector>
 #include <chrono>
@@ -441,7 +443,8 @@ struct CombatSession {
     std::chrono::steady_clock::time_point endTime;
     bool isActive = false;
     
-    std::vector<std::shared_ptr<CombatLogEntry>> entries;
+    CombatEventStore events;
+    CombatAnalysisEngine aggregates;
     std::unordered_map<WGUID, DamageStatistics, WGUIDHash> damageStats;
     std::unordered_map<WGUID, HealingStatistics, WGUIDHash> healingStats;
     
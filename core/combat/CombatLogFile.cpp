@@ -0,0 +1,561 @@
+#include "CombatLogFile.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace CombatLogFile;
+
+namespace {
+    constexpr size_t MIN_BUFFER_SIZE = 256;
+    constexpr size_t MAX_STRING_SIZE = 1024;
+
+    // Optional event fields, a set bit means the field follows the fixed fields in this order
+    enum EventField : uint32_t {
+        FIELD_OVER_AMOUNT = 1 << 0,
+        FIELD_ABSORBED = 1 << 1,
+        FIELD_RESISTED = 1 << 2,
+        FIELD_BLOCKED = 1 << 3,
+        FIELD_HIT_FLAGS = 1 << 4,
+        FIELD_SOURCE_FLAGS = 1 << 5,
+        FIELD_TARGET_FLAGS = 1 << 6,
+        FIELD_DAMAGE_TYPE = 1 << 7,
+        FIELD_MELEE_OUTCOME = 1 << 8,
+        FIELD_SERVER_TIMESTAMP = 1 << 9
+    };
+
+    void PutVarint(std::vector<uint8_t>& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    void PutZigzag(std::vector<uint8_t>& out, int64_t value) {
+        PutVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+    }
+
+    int64_t ToNanoseconds(std::chrono::steady_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    }
+
+    std::chrono::steady_clock::time_point FromNanoseconds(int64_t ns) {
+        return std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(ns)));
+    }
+
+    // Bounds checked parsing of one record payload, every read past the end clears ok
+    struct PayloadParser {
+        const uint8_t* pos;
+        const uint8_t* end;
+        bool ok = true;
+
+        uint64_t Varint() {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (pos == end) break;
+                const uint8_t byte = *pos++;
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) {
+                    return value;
+                }
+            }
+            ok = false;
+            return 0;
+        }
+
+        uint32_t Varint32() {
+            const uint64_t value = Varint();
+            if (value > UINT32_MAX) {
+                ok = false;
+                return 0;
+            }
+            return static_cast<uint32_t>(value);
+        }
+
+        int64_t Zigzag() {
+            const uint64_t value = Varint();
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+
+        uint8_t Byte() {
+            if (pos == end) {
+                ok = false;
+                return 0;
+            }
+            return *pos++;
+        }
+
+        std::string String(size_t size) {
+            if (static_cast<size_t>(end - pos) < size) {
+                ok = false;
+                return std::string();
+            }
+            std::string result(reinterpret_cast<const char*>(pos), size);
+            pos += size;
+            return result;
+        }
+    };
+}
+
+size_t CombatLogFileWriter::SpellKeyHash::operator()(const SpellKey& key) const {
+    size_t hash = std::hash<uint32_t>()(key.spellId);
+    hash ^= std::hash<uint32_t>()(key.name) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<uint32_t>()(key.school) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    hash ^= std::hash<uint32_t>()(key.schoolMask) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+CombatLogFileWriter::CombatLogFileWriter(std::ostream& out, size_t bufferSize)
+    : m_out(out), m_bufferSize(std::max(bufferSize, MIN_BUFFER_SIZE)) {
+    m_buffer.reserve(m_bufferSize);
+}
+
+CombatLogFileWriter::~CombatLogFileWriter() {
+    Flush();
+}
+
+void CombatLogFileWriter::BeginSession(std::chrono::steady_clock::time_point startTime) {
+    if (m_inSession) {
+        // Close the previous session as still running, it has no end time
+        EndSession(FromNanoseconds(m_lastTimestamp), true);
+    }
+
+    if (!m_headerWritten) {
+        m_buffer.insert(m_buffer.end(), std::begin(MAGIC), std::end(MAGIC));
+        PutVarint(m_buffer, VERSION);
+        m_headerWritten = true;
+    }
+
+    // Index 0 of the string and spell dictionaries is predefined as the empty name and no spell
+    m_guids.clear();
+    m_strings.clear();
+    m_strings.emplace(std::string(), 0);
+    m_spells.clear();
+    m_spells.emplace(SpellKey{ 0, 0, SPELL_SCHOOL_NORMAL, 0 }, 0);
+    m_lastTimestamp = ToNanoseconds(startTime);
+    m_lastServerTimestamp = 0;
+    m_eventCount = 0;
+    m_inSession = true;
+
+    m_payload.clear();
+    PutZigzag(m_payload, m_lastTimestamp);
+    WriteRecord(RECORD_SESSION_BEGIN, m_payload);
+}
+
+void CombatLogFileWriter::WriteEvent(const CombatLogEntry& entry) {
+    if (!m_inSession) {
+        BeginSession(entry.timestamp);
+    }
+
+    // Dictionary records have to come before the event using them
+    const uint32_t source = InternGuid(entry.sourceGUID);
+    const uint32_t target = InternGuid(entry.targetGUID);
+    const uint32_t sourceName = InternString(entry.sourceName);
+    const uint32_t targetName = InternString(entry.targetName);
+    const uint32_t spell = InternSpell(entry);
+
+    const int64_t timestamp = ToNanoseconds(entry.timestamp);
+
+    uint32_t fields = 0;
+    if (entry.overAmount != 0) fields |= FIELD_OVER_AMOUNT;
+    if (entry.absorbed != 0) fields |= FIELD_ABSORBED;
+    if (entry.resisted != 0) fields |= FIELD_RESISTED;
+    if (entry.blocked != 0) fields |= FIELD_BLOCKED;
+    if (entry.hitFlags != HitFlags::NONE) fields |= FIELD_HIT_FLAGS;
+    if (entry.sourceFlags != 0) fields |= FIELD_SOURCE_FLAGS;
+    if (entry.targetFlags != 0) fields |= FIELD_TARGET_FLAGS;
+    if (entry.damageType != DamageEffectType::DIRECT_DAMAGE) fields |= FIELD_DAMAGE_TYPE;
+    if (entry.meleeOutcome != MeleeHitOutcome::MELEE_HIT_NORMAL) fields |= FIELD_MELEE_OUTCOME;
+    if (entry.serverTimestamp != 0) fields |= FIELD_SERVER_TIMESTAMP;
+
+    m_payload.clear();
+    PutVarint(m_payload, static_cast<uint32_t>(entry.eventType));
+    PutZigzag(m_payload, timestamp - m_lastTimestamp);
+    PutVarint(m_payload, source);
+    PutVarint(m_payload, target);
+    PutVarint(m_payload, sourceName);
+    PutVarint(m_payload, targetName);
+    PutVarint(m_payload, spell);
+    PutVarint(m_payload, entry.amount);
+    PutVarint(m_payload, fields);
+
+    if (fields & FIELD_OVER_AMOUNT) PutVarint(m_payload, entry.overAmount);
+    if (fields & FIELD_ABSORBED) PutVarint(m_payload, entry.absorbed);
+    if (fields & FIELD_RESISTED) PutVarint(m_payload, entry.resisted);
+    if (fields & FIELD_BLOCKED) PutVarint(m_payload, entry.blocked);
+    if (fields & FIELD_HIT_FLAGS) PutVarint(m_payload, static_cast<uint32_t>(entry.hitFlags));
+    if (fields & FIELD_SOURCE_FLAGS) PutVarint(m_payload, entry.sourceFlags);
+    if (fields & FIELD_TARGET_FLAGS) PutVarint(m_payload, entry.targetFlags);
+    if (fields & FIELD_DAMAGE_TYPE) PutVarint(m_payload, static_cast<uint32_t>(entry.damageType));
+    if (fields & FIELD_MELEE_OUTCOME) PutVarint(m_payload, static_cast<uint32_t>(entry.meleeOutcome));
+    if (fields & FIELD_SERVER_TIMESTAMP) {
+        PutZigzag(m_payload, static_cast<int64_t>(entry.serverTimestamp - m_lastServerTimestamp));
+        m_lastServerTimestamp = entry.serverTimestamp;
+    }
+
+    WriteRecord(RECORD_EVENT, m_payload);
+    m_lastTimestamp = timestamp;
+    m_eventCount++;
+}
+
+void CombatLogFileWriter::EndSession(std::chrono::steady_clock::time_point endTime, bool isActive) {
+    if (!m_inSession) {
+        return;
+    }
+
+    m_payload.clear();
+    PutZigzag(m_payload, ToNanoseconds(endTime));
+    m_payload.push_back(isActive ? 1 : 0);
+    PutVarint(m_payload, m_eventCount);
+    WriteRecord(RECORD_SESSION_END, m_payload);
+    m_inSession = false;
+}
+
+void CombatLogFileWriter::WriteSession(const CombatSession& session) {
+    const CombatEventStore& events = session.events;
+
+    BeginSession(session.startTime);
+    for (CombatEventStore::RowId row = events.BeginRow(); row != events.EndRow(); ++row) {
+        WriteEvent(events.GetEntry(row));
+    }
+    EndSession(session.endTime, session.isActive);
+}
+
+bool CombatLogFileWriter::Flush() {
+    WriteBuffer();
+    if (m_good) {
+        m_out.flush();
+        m_good = m_out.good();
+    }
+    return m_good;
+}
+
+void CombatLogFileWriter::WriteBuffer() {
+    if (!m_buffer.empty() && m_good) {
+        m_out.write(reinterpret_cast<const char*>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size()));
+        m_bytesWritten += m_buffer.size();
+        m_good = m_out.good();
+    }
+    m_buffer.clear();
+}
+
+uint32_t CombatLogFileWriter::InternGuid(const WGUID& guid) {
+    auto it = m_guids.find(guid);
+    if (it != m_guids.end()) {
+        return it->second;
+    }
+
+    const uint32_t id = static_cast<uint32_t>(m_guids.size());
+    m_guids.emplace(guid, id);
+
+    m_dictionaryPayload.clear();
+    PutVarint(m_dictionaryPayload, guid.ToUint64());
+    WriteRecord(RECORD_GUID, m_dictionaryPayload);
+    return id;
+}
+
+uint32_t CombatLogFileWriter::InternString(const std::string& str) {
+    auto it = m_strings.find(str);
+    if (it != m_strings.end()) {
+        return it->second;
+    }
+
+    const uint32_t id = static_cast<uint32_t>(m_strings.size());
+    m_strings.emplace(str, id);
+
+    // Names come from game memory, anything longer than a sane name is cut so a record stays small
+    const size_t size = std::min(str.size(), MAX_STRING_SIZE);
+    m_dictionaryPayload.clear();
+    PutVarint(m_dictionaryPayload, size);
+    m_dictionaryPayload.insert(m_dictionaryPayload.end(), str.begin(), str.begin() + size);
+    WriteRecord(RECORD_STRING, m_dictionaryPayload);
+    return id;
+}
+
+uint32_t CombatLogFileWriter::InternSpell(const CombatLogEntry& entry) {
+    const SpellKey key{ entry.spellId, InternString(entry.spellName), static_cast<uint32_t>(entry.spellSchool), entry.spellSchoolMask };
+    auto it = m_spells.find(key);
+    if (it != m_spells.end()) {
+        return it->second;
+    }
+
+    const uint32_t id = static_cast<uint32_t>(m_spells.size());
+    m_spells.emplace(key, id);
+
+    m_dictionaryPayload.clear();
+    PutVarint(m_dictionaryPayload, key.spellId);
+    PutVarint(m_dictionaryPayload, key.name);
+    PutVarint(m_dictionaryPayload, key.school);
+    PutVarint(m_dictionaryPayload, key.schoolMask);
+    WriteRecord(RECORD_SPELL, m_dictionaryPayload);
+    return id;
+}
+
+void CombatLogFileWriter::WriteRecord(RecordType type, const std::vector<uint8_t>& payload) {
+    // Type and size take at most 10 bytes, the buffer is written out before a record would overflow it
+    if (m_buffer.size() + payload.size() + 10 > m_bufferSize) {
+        WriteBuffer();
+    }
+
+    PutVarint(m_buffer, type);
+    PutVarint(m_buffer, payload.size());
+    m_buffer.insert(m_buffer.end(), payload.begin(), payload.end());
+}
+
+CombatLogFileReader::CombatLogFileReader(std::istream& in, size_t bufferSize)
+    : m_in(in), m_buffer(std::max(bufferSize, MIN_BUFFER_SIZE)) {
+}
+
+bool CombatLogFileReader::ReadHeader() {
+    uint8_t magic[sizeof(MAGIC)];
+    if (!ReadBytes(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+        return Fail("Not a combat log file");
+    }
+
+    uint64_t version = 0;
+    if (!ReadVarint(version) || version == 0) {
+        return Fail("Invalid file header");
+    }
+    if (version > VERSION) {
+        return Fail("Unsupported file version " + std::to_string(version));
+    }
+
+    m_version = static_cast<uint32_t>(version);
+    return true;
+}
+
+bool CombatLogFileReader::ReadSession(SessionInfo& info, const EventCallback& onEvent) {
+    uint32_t type = 0;
+
+    // Skip to the next session, unknown records may sit between sessions
+    while (true) {
+        if (!ReadRecord(type)) {
+            return false;
+        }
+        if (type == RECORD_SESSION_BEGIN) {
+            break;
+        }
+        if (type >= RECORD_SESSION_END && type <= RECORD_EVENT) {
+            return Fail("Record outside of a session");
+        }
+    }
+
+    PayloadParser begin{ m_payload.data(), m_payload.data() + m_payload.size() };
+    m_lastTimestamp = begin.Zigzag();
+    if (!begin.ok) {
+        return Fail("Invalid session record");
+    }
+
+    info = SessionInfo();
+    info.startTime = FromNanoseconds(m_lastTimestamp);
+    info.endTime = info.startTime;
+    m_lastServerTimestamp = 0;
+    m_guids.clear();
+    m_strings.assign(1, std::string());
+    m_spells.assign(1, Spell());
+
+    uint64_t eventCount = 0;
+    while (true) {
+        if (!ReadRecord(type)) {
+            return m_error.empty() ? Fail("Session is missing its end record") : false;
+        }
+
+        PayloadParser parser{ m_payload.data(), m_payload.data() + m_payload.size() };
+        switch (type) {
+            case RECORD_GUID:
+                m_guids.emplace_back(parser.Varint());
+                break;
+            case RECORD_STRING: {
+                const uint64_t size = parser.Varint();
+                m_strings.push_back(parser.String(static_cast<size_t>(std::min<uint64_t>(size, m_payload.size()))));
+                break;
+            }
+            case RECORD_SPELL: {
+                Spell spell;
+                spell.spellId = parser.Varint32();
+                spell.name = parser.Varint32();
+                spell.school = static_cast<CombatSpellSchool>(parser.Varint32());
+                spell.schoolMask = parser.Varint32();
+                if (spell.name >= m_strings.size()) {
+                    return Fail("Spell references an undefined name");
+                }
+                m_spells.push_back(spell);
+                break;
+            }
+            case RECORD_EVENT: {
+                CombatLogEntry entry;
+                if (!ParseEvent(entry)) {
+                    return false;
+                }
+                // replaced by the end record, a session cut off before it ends with its last event
+                info.endTime = entry.timestamp;
+                onEvent(entry);
+                eventCount++;
+                break;
+            }
+            case RECORD_SESSION_END:
+                info.endTime = FromNanoseconds(parser.Zigzag());
+                info.isActive = parser.Byte() != 0;
+                info.eventCount = parser.Varint();
+                if (!parser.ok) {
+                    return Fail("Invalid session end record");
+                }
+                if (info.eventCount != eventCount) {
+                    return Fail("Session has " + std::to_string(eventCount) + " events, expected " + std::to_string(info.eventCount));
+                }
+                return true;
+            case RECORD_SESSION_BEGIN:
+                return Fail("Session is missing its end record");
+            default:
+                break;
+        }
+
+        if (!parser.ok) {
+            return Fail("Invalid dictionary record");
+        }
+    }
+}
+
+bool CombatLogFileReader::ReadSession(CombatSession& session) {
+    SessionInfo info;
+    const bool result = ReadSession(info, [&session](const CombatLogEntry& entry) {
+        session.events.Append(entry);
+        session.aggregates.Add(session.events, session.events.Size() - 1);
+
+        if (!entry.sourceName.empty()) {
+            session.participantNames[entry.sourceGUID] = entry.sourceName;
+        }
+        if (!entry.targetName.empty()) {
+            session.participantNames[entry.targetGUID] = entry.targetName;
+        }
+    });
+
+    session.startTime = info.startTime;
+    session.endTime = info.endTime;
+    session.isActive = info.isActive;
+    return result;
+}
+
+bool CombatLogFileReader::ParseEvent(CombatLogEntry& entry) {
+    PayloadParser parser{ m_payload.data(), m_payload.data() + m_payload.size() };
+
+    entry.eventType = static_cast<CombatEventType>(parser.Varint32());
+    m_lastTimestamp += parser.Zigzag();
+    entry.timestamp = FromNanoseconds(m_lastTimestamp);
+
+    const uint32_t source = parser.Varint32();
+    const uint32_t target = parser.Varint32();
+    const uint32_t sourceName = parser.Varint32();
+    const uint32_t targetName = parser.Varint32();
+    const uint32_t spell = parser.Varint32();
+    entry.amount = parser.Varint32();
+    const uint32_t fields = parser.Varint32();
+
+    if (!parser.ok) {
+        return Fail("Invalid event record");
+    }
+    if (source >= m_guids.size() || target >= m_guids.size() || sourceName >= m_strings.size() ||
+        targetName >= m_strings.size() || spell >= m_spells.size()) {
+        return Fail("Event references an undefined dictionary entry");
+    }
+
+    entry.sourceGUID = m_guids[source];
+    entry.targetGUID = m_guids[target];
+    entry.sourceName = m_strings[sourceName];
+    entry.targetName = m_strings[targetName];
+    entry.spellId = m_spells[spell].spellId;
+    entry.spellName = m_strings[m_spells[spell].name];
+    entry.spellSchool = m_spells[spell].school;
+    entry.spellSchoolMask = m_spells[spell].schoolMask;
+
+    if (fields & FIELD_OVER_AMOUNT) entry.overAmount = parser.Varint32();
+    if (fields & FIELD_ABSORBED) entry.absorbed = parser.Varint32();
+    if (fields & FIELD_RESISTED) entry.resisted = parser.Varint32();
+    if (fields & FIELD_BLOCKED) entry.blocked = parser.Varint32();
+    if (fields & FIELD_HIT_FLAGS) entry.hitFlags = static_cast<HitFlags>(parser.Varint32());
+    if (fields & FIELD_SOURCE_FLAGS) entry.sourceFlags = parser.Varint32();
+    if (fields & FIELD_TARGET_FLAGS) entry.targetFlags = parser.Varint32();
+    if (fields & FIELD_DAMAGE_TYPE) entry.damageType = static_cast<DamageEffectType>(parser.Varint32());
+    if (fields & FIELD_MELEE_OUTCOME) entry.meleeOutcome = static_cast<MeleeHitOutcome>(parser.Varint32());
+    if (fields & FIELD_SERVER_TIMESTAMP) {
+        m_lastServerTimestamp += static_cast<uint64_t>(parser.Zigzag());
+        entry.serverTimestamp = m_lastServerTimestamp;
+    }
+
+    if (!parser.ok) {
+        return Fail("Invalid event record");
+    }
+    return true;
+}
+
+bool CombatLogFileReader::Refill() {
+    if (m_bufferPos < m_bufferEnd) {
+        return true;
+    }
+
+    m_in.read(reinterpret_cast<char*>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size()));
+    m_bufferPos = 0;
+    m_bufferEnd = static_cast<size_t>(m_in.gcount());
+    return m_bufferEnd > 0;
+}
+
+bool CombatLogFileReader::ReadBytes(uint8_t* data, size_t size) {
+    while (size > 0) {
+        if (!Refill()) {
+            return false;
+        }
+        const size_t count = std::min(size, m_bufferEnd - m_bufferPos);
+        std::memcpy(data, m_buffer.data() + m_bufferPos, count);
+        m_bufferPos += count;
+        data += count;
+        size -= count;
+    }
+    return true;
+}
+
+bool CombatLogFileReader::ReadVarint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (!Refill()) {
+            return false;
+        }
+        const uint8_t byte = m_buffer[m_bufferPos++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CombatLogFileReader::ReadRecord(uint32_t& type) {
+    if (!m_error.empty()) {
+        return false;
+    }
+    if (!Refill()) {
+        return false;  // end of file on a record boundary
+    }
+
+    uint64_t recordType = 0;
+    uint64_t size = 0;
+    if (!ReadVarint(recordType) || !ReadVarint(size)) {
+        return Fail("Truncated record");
+    }
+    if (recordType > UINT32_MAX || size > MAX_RECORD_SIZE) {
+        return Fail("Invalid record");
+    }
+
+    m_payload.resize(static_cast<size_t>(size));
+    if (!ReadBytes(m_payload.data(), m_payload.size())) {
+        return Fail("Truncated record");
+    }
+
+    type = static_cast<uint32_t>(recordType);
+    return true;
+}
+
+bool CombatLogFileReader::Fail(const std::string& error) {
+    if (m_error.empty()) {
+        m_error = error;
+    }
+    return false;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "CombatLogEntry.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Binary combat log files.
+//
+//   header   "WCLB", varint format version
+//   records  varint record type, varint payload size, payload
+//
+// A session is a SESSION_BEGIN record, its events and a SESSION_END record. GUIDs, strings and spells are defined
+// by their own record right before the first event using them and are numbered in the order they are defined.
+// The dictionaries start over with every session, so each session can be read on its own. Integers are LEB128
+// varints, event timestamps are nanosecond deltas to the previous event and fields left at their default are
+// not written. Readers skip record types they don't know, new fields need a new format version.
+namespace CombatLogFile {
+    constexpr char MAGIC[4] = { 'W', 'C', 'L', 'B' };
+    constexpr uint32_t VERSION = 1;
+    constexpr size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+    constexpr size_t MAX_RECORD_SIZE = 64 * 1024;
+
+    enum RecordType : uint32_t {
+        RECORD_SESSION_BEGIN = 1,
+        RECORD_SESSION_END = 2,
+        RECORD_GUID = 3,
+        RECORD_STRING = 4,
+        RECORD_SPELL = 5,
+        RECORD_EVENT = 6
+    };
+
+    struct SessionInfo {
+        std::chrono::steady_clock::time_point startTime;
+        std::chrono::steady_clock::time_point endTime;
+        bool isActive = false;  // the session was still running when it was written
+        uint64_t eventCount = 0;
+    };
+}
+
+// Streams sessions to a file. Output is collected in a buffer of bufferSize bytes that is written out whenever
+// it fills up, so memory use doesn't depend on the size of the log.
+class CombatLogFileWriter {
+public:
+    explicit CombatLogFileWriter(std::ostream& out, size_t bufferSize = CombatLogFile::DEFAULT_BUFFER_SIZE);
+    ~CombatLogFileWriter();
+
+    CombatLogFileWriter(const CombatLogFileWriter&) = delete;
+    CombatLogFileWriter& operator=(const CombatLogFileWriter&) = delete;
+
+    void BeginSession(std::chrono::steady_clock::time_point startTime);
+    void WriteEvent(const CombatLogEntry& entry);
+    void EndSession(std::chrono::steady_clock::time_point endTime, bool isActive);
+
+    // Writes the events still held by the session's store as one session
+    void WriteSession(const CombatSession& session);
+
+    bool Flush();
+    bool Good() const { return m_good; }
+    uint64_t GetBytesWritten() const { return m_bytesWritten + m_buffer.size(); }
+
+private:
+    struct SpellKey {
+        uint32_t spellId;
+        uint32_t name;
+        uint32_t school;
+        uint32_t schoolMask;
+
+        bool operator==(const SpellKey& other) const = default;
+    };
+
+    struct SpellKeyHash {
+        size_t operator()(const SpellKey& key) const;
+    };
+
+    uint32_t InternGuid(const WGUID& guid);
+    uint32_t InternString(const std::string& str);
+    uint32_t InternSpell(const CombatLogEntry& entry);
+    void WriteRecord(CombatLogFile::RecordType type, const std::vector<uint8_t>& payload);
+    void WriteBuffer();
+
+    std::ostream& m_out;
+    size_t m_bufferSize;
+    std::vector<uint8_t> m_buffer;
+    std::vector<uint8_t> m_payload;
+    std::vector<uint8_t> m_dictionaryPayload;
+    bool m_headerWritten = false;
+    bool m_inSession = false;
+    bool m_good = true;
+    uint64_t m_bytesWritten = 0;
+
+    // Per session state
+    int64_t m_lastTimestamp = 0;
+    uint64_t m_lastServerTimestamp = 0;
+    uint64_t m_eventCount = 0;
+    std::unordered_map<WGUID, uint32_t, WGUIDHash> m_guids;
+    std::unordered_map<std::string, uint32_t> m_strings;
+    std::unordered_map<SpellKey, uint32_t, SpellKeyHash> m_spells;
+};
+
+// Reads sessions back one at a time through a buffer of bufferSize bytes
+class CombatLogFileReader {
+public:
+    using EventCallback = std::function<void(const CombatLogEntry&)>;
+
+    explicit CombatLogFileReader(std::istream& in, size_t bufferSize = CombatLogFile::DEFAULT_BUFFER_SIZE);
+
+    // Fails for files that aren't combat logs or were written by a newer format version
+    bool ReadHeader();
+
+    // Calls onEvent for every event of the next session in order. Returns false once there are no more
+    // sessions or the file is damaged, GetError tells the two apart. A session that is cut off by a damaged
+    // file ends with the last event that could be read.
+    bool ReadSession(CombatLogFile::SessionInfo& info, const EventCallback& onEvent);
+
+    // Same as above, rebuilding the session's store, running totals and participant names
+    bool ReadSession(CombatSession& session);
+
+    uint32_t GetVersion() const { return m_version; }
+    const std::string& GetError() const { return m_error; }
+
+private:
+    struct Spell {
+        uint32_t spellId = 0;
+        uint32_t name = 0;
+        CombatSpellSchool school = SPELL_SCHOOL_NORMAL;
+        uint32_t schoolMask = 0;
+    };
+
+    bool Refill();
+    bool ReadBytes(uint8_t* data, size_t size);
+    bool ReadVarint(uint64_t& value);
+    bool ReadRecord(uint32_t& type);
+    bool ParseEvent(CombatLogEntry& entry);
+    bool Fail(const std::string& error);
+
+    std::istream& m_in;
+    std::vector<uint8_t> m_buffer;
+    size_t m_bufferPos = 0;
+    size_t m_bufferEnd = 0;
+    std::vector<uint8_t> m_payload;
+    uint32_t m_version = 0;
+    std::string m_error;
+
+    // Per session state
+    int64_t m_lastTimestamp = 0;
+    uint64_t m_lastServerTimestamp = 0;
+    std::vector<WGUID> m_guids;
+    std::vector<std::string> m_strings;
+    std::vector<Spell> m_spells;
+};
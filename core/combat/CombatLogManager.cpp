@@ -1,5 +1,6 @@
 #include "CombatLogManager.h"
 #include "CombatLogAnalyzer.h"
+#include "CombatLogFile.h"
 #include "../objects/ObjectManager.h"
 #include "../memory/memory.h"
 #include "../logs/Logger.h"
@@ -183,7 +184,8 @@ void CombatLogManager::AddEntry(std::shared_ptr<CombatLogEntry> entry) {
     }
     
     // Add to current session
-    m_currentSession->entries.push_back(entry);
+    m_currentSession->events.Append(*entry);
+    m_currentSession->aggregates.Add(m_currentSession->events, m_currentSession->events.Size() - 1);
     m_totalEntryCount.fetch_add(1);
     
     // Update session metadata
@@ -196,7 +198,7 @@ void CombatLogManager::AddEntry(std::shared_ptr<CombatLogEntry> entry) {
     TriggerEventCallbacks(entry);
     
     // Manage session size
-    if (m_currentSession->entries.size() > m_settings.maxEntriesPerSession) {
+    if (m_currentSession->events.Size() > m_settings.maxEntriesPerSession) {
         TrimOldEntries();
     }
     
@@ -228,6 +230,21 @@ void CombatLogManager::AddHonorEntry(const HonorLogEntry& entry) {
 
 std::vector<std::shared_ptr<CombatLogEntry>> CombatLogManager::GetFilteredEntries(const CombatLogFilter& filter) const {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    return GetEntries(GetFilteredRows(filter));
+}
+
+std::vector<CombatEventStore::RowId> CombatLogManager::GetFilteredRows(const CombatLogFilter& filter) const {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    
+    if (!m_currentSession) {
+        return {};
+    }
+    
+    return m_currentSession->events.Select(filter);
+}
+
+std::vector<std::shared_ptr<CombatLogEntry>> CombatLogManager::GetEntries(const std::vector<CombatEventStore::RowId>& rows) const {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
     
     std::vector<std::shared_ptr<CombatLogEntry>> result;
     
@@ -235,55 +252,11 @@ std::vector<std::shared_ptr<CombatLogEntry>> CombatLogManager::GetFilteredEntrie
         return result;
     }
     
-    for (const auto& entry : m_currentSession->entries) {
-        if (!entry) continue;
-        
-        // Event type filter
-        if (!filter.allowedEventTypes.empty() && 
-            filter.allowedEventTypes.find(entry->eventType) == filter.allowedEventTypes.end()) {
-            continue;
-        }
-        
-        // Time filter
-        if (filter.useTimeFilter) {
-            if (entry->timestamp < filter.startTime || entry->timestamp > filter.endTime) {
-                continue;
-            }
-        }
-        
-        // Amount filter
-        if (entry->amount < filter.minAmount || entry->amount > filter.maxAmount) {
-            continue;
+    result.reserve(rows.size());
+    for (CombatEventStore::RowId row : rows) {
+        if (m_currentSession->events.HasRow(row)) {
+            result.push_back(std::make_shared<CombatLogEntry>(m_currentSession->events.GetEntry(row)));
         }
-        
-        // Source/target filters
-        if (!filter.allowedSources.empty() && 
-            filter.allowedSources.find(entry->sourceGUID) == filter.allowedSources.end()) {
-            continue;
-        }
-        
-        if (!filter.allowedTargets.empty() && 
-            filter.allowedTargets.find(entry->targetGUID) == filter.allowedTargets.end()) {
-            continue;
-        }
-        
-        // Spell filter
-        if (!filter.allowedSpells.empty() && entry->spellId != 0 &&
-            filter.allowedSpells.find(entry->spellId) == filter.allowedSpells.end()) {
-            continue;
-        }
-        
-        // Hit type filters
-        bool hasCrit = static_cast<uint32_t>(entry->hitFlags) & static_cast<uint32_t>(HitFlags::CRITICAL);
-        bool hasMiss = static_cast<uint32_t>(entry->hitFlags) & static_cast<uint32_t>(HitFlags::MISS);
-        bool hasResist = static_cast<uint32_t>(entry->hitFlags) & static_cast<uint32_t>(HitFlags::RESIST);
-        
-        if (hasCrit && !filter.showCrits) continue;
-        if (hasMiss && !filter.showMisses) continue;
-        if (hasResist && !filter.showResists) continue;
-        if (!hasCrit && !hasMiss && !hasResist && !filter.showNormalHits) continue;
-        
-        result.push_back(entry);
     }
     
     return result;
@@ -292,27 +265,43 @@ std::vector<std::shared_ptr<CombatLogEntry>> CombatLogManager::GetFilteredEntrie
 std::vector<std::shared_ptr<CombatLogEntry>> CombatLogManager::GetRecentEntries(size_t count) const {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
     
-    std::vector<std::shared_ptr<CombatLogEntry>> result;
-    
     if (!m_currentSession) {
-        return result;
+        return {};
     }
     
-    size_t startIndex = 0;
-    if (m_currentSession->entries.size() > count) {
-        startIndex = m_currentSession->entries.size() - count;
+    const CombatEventStore& events = m_currentSession->events;
+    std::vector<CombatEventStore::RowId> rows;
+    for (CombatEventStore::RowId row = events.EndRow() - static_cast<CombatEventStore::RowId>(std::min(count, events.Size())); row < events.EndRow(); ++row) {
+        rows.push_back(row);
     }
     
-    for (size_t i = startIndex; i < m_currentSession->entries.size(); ++i) {
-        result.push_back(m_currentSession->entries[i]);
-    }
-    
-    return result;
+    return GetEntries(rows);
+}
+
+std::vector<std::shared_ptr<CombatLogEntry>> CombatLogManager::GetEntriesInTimeRange(
+    std::chrono::steady_clock::time_point start,
+    std::chrono::steady_clock::time_point end) const {
+    CombatLogFilter filter;
+    filter.useTimeFilter = true;
+    filter.startTime = start;
+    filter.endTime = end;
+    return GetFilteredEntries(filter);
 }
 
 DamageStatistics CombatLogManager::CalculateDamageStats(const WGUID& entityGUID, const CombatLogFilter& filter) const {
-    auto entries = GetFilteredEntries(filter);
-    auto breakdown = CombatLogAnalyzer::AnalyzeDamage(entries, entityGUID);
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    
+    if (!m_currentSession) {
+        return DamageStatistics();
+    }
+    
+    // The running totals answer unrestricted queries without touching the events, until old rows are trimmed
+    DamageBreakdown breakdown;
+    if (CombatAnalysisEngine::SupportsFilter(m_currentSession->events, filter)) {
+        breakdown = m_currentSession->aggregates.GetDamage(m_currentSession->events, entityGUID);
+    } else {
+        breakdown = CombatLogAnalyzer::AnalyzeDamage(m_currentSession->events, m_currentSession->events.Select(filter), entityGUID);
+    }
     
     // Convert DamageBreakdown to DamageStatistics
     DamageStatistics stats;
@@ -341,8 +330,18 @@ DamageStatistics CombatLogManager::CalculateDamageStats(const WGUID& entityGUID,
 }
 
 HealingStatistics CombatLogManager::CalculateHealingStats(const WGUID& entityGUID, const CombatLogFilter& filter) const {
-    auto entries = GetFilteredEntries(filter);
-    auto breakdown = CombatLogAnalyzer::AnalyzeHealing(entries, entityGUID);
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    
+    if (!m_currentSession) {
+        return HealingStatistics();
+    }
+    
+    HealingBreakdown breakdown;
+    if (CombatAnalysisEngine::SupportsFilter(m_currentSession->events, filter)) {
+        breakdown = m_currentSession->aggregates.GetHealing(m_currentSession->events, entityGUID);
+    } else {
+        breakdown = CombatLogAnalyzer::AnalyzeHealing(m_currentSession->events, m_currentSession->events.Select(filter), entityGUID);
+    }
     
     // Convert HealingBreakdown to HealingStatistics
     HealingStatistics stats;
@@ -379,7 +378,15 @@ std::vector<std::pair<WGUID, std::string>> CombatLogManager::GetSessionParticipa
 }
 
 bool CombatLogManager::ExportToCSV(const std::string& filename, const CombatLogFilter& filter) const {
-    auto entries = GetFilteredEntries(filter);
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    
+    if (!m_currentSession) {
+        LOG_ERROR("No session to export");
+        return false;
+    }
+    
+    const CombatEventStore& events = m_currentSession->events;
+    auto rows = events.Select(filter);
     
     std::ofstream file(filename);
     if (!file.is_open()) {
@@ -390,18 +397,26 @@ bool CombatLogManager::ExportToCSV(const std::string& filename, const CombatLogF
     // Write header
     file << "Timestamp,EventType,SourceGUID,SourceName,TargetGUID,TargetName,SpellID,SpellName,Amount,OverAmount,Absorbed,Resisted,Blocked,HitFlags\n";
     
-    // Write entries
-    for (const auto& entry : entries) {
-        file << CombatLogAnalyzer::ToCsvRow(*entry) << "\n";
+    // Write entries, rebuilt one at a time
+    for (CombatEventStore::RowId row : rows) {
+        file << CombatLogAnalyzer::ToCsvRow(events.GetEntry(row)) << "\n";
     }
     
     file.close();
-    LOG_INFO("Exported " + std::to_string(entries.size()) + " entries to CSV: " + filename);
+    LOG_INFO("Exported " + std::to_string(rows.size()) + " entries to CSV: " + filename);
     return true;
 }
 
 bool CombatLogManager::ExportToJSON(const std::string& filename, const CombatLogFilter& filter) const {
-    auto entries = GetFilteredEntries(filter);
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    
+    if (!m_currentSession) {
+        LOG_ERROR("No session to export");
+        return false;
+    }
+    
+    const CombatEventStore& events = m_currentSession->events;
+    auto rows = events.Select(filter);
     
     std::ofstream file(filename);
     if (!file.is_open()) {
@@ -411,9 +426,9 @@ bool CombatLogManager::ExportToJSON(const std::string& filename, const CombatLog
     
     // Write JSON array
     file << "[\n";
-    for (size_t i = 0; i < entries.size(); ++i) {
-        file << "  " << CombatLogAnalyzer::ToJsonObject(*entries[i]);
-        if (i < entries.size() - 1) {
+    for (size_t i = 0; i < rows.size(); ++i) {
+        file << "  " << CombatLogAnalyzer::ToJsonObject(events.GetEntry(rows[i]));
+        if (i < rows.size() - 1) {
             file << ",";
         }
         file << "\n";
@@ -421,10 +436,91 @@ bool CombatLogManager::ExportToJSON(const std::string& filename, const CombatLog
     file << "]\n";
     
     file.close();
-    LOG_INFO("Exported " + std::to_string(entries.size()) + " entries to JSON: " + filename);
+    LOG_INFO("Exported " + std::to_string(rows.size()) + " entries to JSON: " + filename);
+    return true;
+}
+
+bool CombatLogManager::ExportSessionsToBinary(const std::string& filename) const {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    
+    if (m_sessions.empty()) {
+        LOG_ERROR("No session to export");
+        return false;
+    }
+    
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR("Failed to open file for binary export: " + filename);
+        return false;
+    }
+    
+    // Sessions are streamed out through the writer's buffer, no copy of the entries is made
+    CombatLogFileWriter writer(file);
+    for (const auto& session : m_sessions) {
+        writer.WriteSession(*session);
+    }
+    
+    if (!writer.Flush()) {
+        LOG_ERROR("Failed to write binary export: " + filename);
+        return false;
+    }
+    
+    LOG_INFO("Exported " + std::to_string(m_sessions.size()) + " sessions (" + std::to_string(writer.GetBytesWritten()) + " bytes) to " + filename);
     return true;
 }
 
+size_t CombatLogManager::ImportSessionsFromBinary(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR("Failed to open combat log file: " + filename);
+        return 0;
+    }
+    
+    CombatLogFileReader reader(file);
+    if (!reader.ReadHeader()) {
+        LOG_ERROR("Failed to import " + filename + ": " + reader.GetError());
+        return 0;
+    }
+    
+    // Sessions are read outside the lock, only adding them to the list needs it
+    std::vector<std::shared_ptr<CombatSession>> sessions;
+    while (true) {
+        auto session = std::make_shared<CombatSession>();
+        const bool complete = reader.ReadSession(*session);
+        if (!complete && session->events.Empty()) {
+            break;
+        }
+        
+        // A session that was still running when it was written ends with its last event, the reader already
+        // does the same for sessions cut off by a damaged file
+        if (session->isActive) {
+            session->isActive = false;
+            session->endTime = session->events.Empty() ? session->startTime :
+                std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(session->events.Timestamps().back()));
+        }
+        sessions.push_back(std::move(session));
+        if (!complete) {
+            break;
+        }
+    }
+    
+    if (!reader.GetError().empty()) {
+        LOG_ERROR("Failed to import " + filename + ": " + reader.GetError());
+    }
+    
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    for (auto& session : sessions) {
+        if (m_sessions.size() >= m_settings.maxSessions) {
+            m_sessions.pop_front(); // Remove oldest session
+        }
+        m_totalEntryCount.fetch_add(session->events.Size());
+        m_sessions.push_back(std::move(session));
+    }
+    
+    LOG_INFO("Imported " + std::to_string(sessions.size()) + " sessions from " + filename);
+    return sessions.size();
+}
+
 void CombatLogManager::ApplySettings(const Settings& settings) {
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
     m_settings = settings;
@@ -443,13 +539,10 @@ void CombatLogManager::UnregisterEventCallback(const std::string& name) {
 void CombatLogManager::TrimOldEntries() {
     if (!m_currentSession) return;
     
-    size_t entriesToRemove = m_currentSession->entries.size() - m_settings.maxEntriesPerSession + 1000; // Keep some buffer
+    size_t entriesToRemove = m_currentSession->events.Size() - m_settings.maxEntriesPerSession + 1000; // Keep some buffer
     
     if (entriesToRemove > 0) {
-        m_currentSession->entries.erase(
-            m_currentSession->entries.begin(),
-            m_currentSession->entries.begin() + entriesToRemove
-        );
+        m_currentSession->events.EraseFront(entriesToRemove);
     }
 }
 
@@ -457,6 +550,16 @@ size_t CombatLogManager::GetTotalEntryCount() const {
     return m_totalEntryCount.load();
 }
 
+size_t CombatLogManager::GetMemoryUsageBytes() const {
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+    
+    size_t bytes = 0;
+    for (const auto& session : m_sessions) {
+        bytes += sizeof(CombatSession) + session->events.GetMemoryUsageBytes() + session->aggregates.GetMemoryUsageBytes();
+    }
+    return bytes;
+}
+
 void CombatLogManager::UpdateCombatState() {
     auto now = std::chrono::steady_clock::now();
     
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "CombatLogEntry.h"
+#include "../types/types.h"
 #include "../logs/Logger.h"
 #include <mutex>
 #include <deque>
@@ -70,6 +71,8 @@ public:
     
     // Data access with filtering
     std::vector<std::shared_ptr<CombatLogEntry>> GetFilteredEntries(const CombatLogFilter& filter) const;
+    std::vector<CombatEventStore::RowId> GetFilteredRows(const CombatLogFilter& filter) const;
+    std::vector<std::shared_ptr<CombatLogEntry>> GetEntries(const std::vector<CombatEventStore::RowId>& rows) const;
     std::vector<std::shared_ptr<CombatLogEntry>> GetRecentEntries(size_t count = 100) const;
     std::vector<std::shared_ptr<CombatLogEntry>> GetEntriesInTimeRange(
         std::chrono::steady_clock::time_point start,
@@ -86,6 +89,11 @@ public:
     bool ExportToCSV(const std::string& filename, const CombatLogFilter& filter = CombatLogFilter()) const;
     bool ExportToJSON(const std::string& filename, const CombatLogFilter& filter = CombatLogFilter()) const;
     
+    // Binary session files (CombatLogFile.h), the export holds every session kept in memory and the import
+    // appends the sessions of a file as ended sessions
+    bool ExportSessionsToBinary(const std::string& filename) const;
+    size_t ImportSessionsFromBinary(const std::string& filename);
+    
     // Settings
     struct Settings {
         size_t maxEntriesPerSession = 10000;
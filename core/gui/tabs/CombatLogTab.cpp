@@ -218,7 +218,8 @@ void CombatLogTab::RenderControlPanel() {
             m_combatLogManager->ClearAllSessions();
             m_sessionCache.Invalidate();
             // Clear the live log display as well
-            m_sessionCache.filteredEntries.clear();
+            m_sessionCache.filteredRows.clear();
+            m_sessionCache.displayedEntries.clear();
             m_sessionCache.currentSession.reset();
             m_sessionCache.needsRefresh = true;
         }
@@ -313,7 +314,7 @@ void CombatLogTab::RenderSessionManagement() {
             
             if (ImGui::IsItemHovered()) {
                 ImGui::BeginTooltip();
-                ImGui::Text("Entries: %zu", session->entries.size());
+                ImGui::Text("Entries: %zu", session->events.Size());
                 ImGui::Text("Duration: %.1fs", session->GetDurationSeconds());
                 ImGui::Text("Participants: %zu", session->participantNames.size());
                 ImGui::EndTooltip();
@@ -408,7 +409,9 @@ void CombatLogTab::RenderLogViewer() {
         
         ImGui::SameLine();
         ImGui::SetNextItemWidth(150);
-        ImGui::SliderInt("Max Entries", &m_uiState.maxDisplayedEntries, 100, 5000);
+        if (ImGui::SliderInt("Max Entries", &m_uiState.maxDisplayedEntries, 100, 5000)) {
+            m_sessionCache.needsRefresh = true;
+        }
     }
     ImGui::EndGroup();
     
@@ -417,18 +420,18 @@ void CombatLogTab::RenderLogViewer() {
     // Log entries
     ImGui::BeginChild("LogEntries", ImVec2(0, 0), true, ImGuiWindowFlags_HorizontalScrollbar);
     
-    if (m_sessionCache.filteredEntries.empty()) {
+    if (m_sessionCache.displayedEntries.empty()) {
         ImGui::TextColored(ImVec4(0.6f, 0.6f, 0.6f, 1.0f), "No entries to display");
     } else {
         
         // Calculate visible range
-        size_t totalEntries = m_sessionCache.filteredEntries.size();
+        size_t totalEntries = m_sessionCache.displayedEntries.size();
         size_t maxDisplay = static_cast<size_t>(m_uiState.maxDisplayedEntries);
         size_t startIndex = totalEntries > maxDisplay ? totalEntries - maxDisplay : 0;
         
         // Render entries
         for (size_t i = startIndex; i < totalEntries; ++i) {
-            const auto& entry = m_sessionCache.filteredEntries[i];
+            const auto& entry = m_sessionCache.displayedEntries[i];
             if (!entry) {
                 LOG_DEBUG("Skipping null entry at index " + std::to_string(i));
                 continue;
@@ -569,7 +572,7 @@ void CombatLogTab::RenderStatistics() {
         // Overall session stats
         ImGui::Text("Session Overview:");
         ImGui::BulletText("Duration: %.1f seconds", session->GetDurationSeconds());
-        ImGui::BulletText("Total Entries: %zu", session->entries.size());
+        ImGui::BulletText("Total Entries: %zu", session->events.Size());
         ImGui::BulletText("Participants: %zu", session->participantNames.size());
         ImGui::BulletText("Status: %s", session->isActive ? "Active" : "Completed");
         
@@ -970,9 +973,19 @@ void CombatLogTab::UpdateAnalysis() {
     
     auto analysisStart = std::chrono::steady_clock::now();
     
-    // Perform analysis
-    m_sessionCache.analysis = CombatLogAnalyzer::AnalyzeSession(*m_sessionCache.currentSession, m_filterState.filter);
-    m_sessionCache.spellAnalyses = CombatLogAnalyzer::AnalyzeAllSpells(m_sessionCache.filteredEntries);
+    // Perform analysis, the session's running totals are used whenever the filter doesn't restrict them and no
+    // rows were trimmed
+    const CombatSession& session = *m_sessionCache.currentSession;
+    if (CombatAnalysisEngine::SupportsSessionFilter(session.events, m_filterState.filter)) {
+        m_sessionCache.analysis = session.aggregates.Analyze(session);
+    } else {
+        m_sessionCache.analysis = CombatLogAnalyzer::AnalyzeSession(session, m_filterState.filter);
+    }
+    if (CombatAnalysisEngine::SupportsFilter(session.events, m_filterState.filter)) {
+        m_sessionCache.spellAnalyses = session.aggregates.GetSpellAnalyses(session.events, m_filterState.filter);
+    } else {
+        m_sessionCache.spellAnalyses = CombatLogAnalyzer::AnalyzeAllSpells(session.events, m_sessionCache.filteredRows);
+    }
     m_sessionCache.isAnalysisValid = true;
     
     auto analysisEnd = std::chrono::steady_clock::now();
@@ -983,18 +996,23 @@ void CombatLogTab::RefreshSessionData() {
     m_sessionCache.currentSession = m_combatLogManager->GetCurrentSession();
     
     if (m_sessionCache.currentSession) {
-        m_sessionCache.filteredEntries = m_combatLogManager->GetFilteredEntries(m_filterState.filter);
-        m_performance.totalEntries = m_sessionCache.currentSession->entries.size();
-        m_performance.filteredEntries = m_sessionCache.filteredEntries.size();
+        m_sessionCache.filteredRows = m_combatLogManager->GetFilteredRows(m_filterState.filter);
+        const auto& rows = m_sessionCache.filteredRows;
+        size_t maxDisplay = static_cast<size_t>(m_uiState.maxDisplayedEntries);
+        size_t startIndex = rows.size() > maxDisplay ? rows.size() - maxDisplay : 0;
+        m_sessionCache.displayedEntries = m_combatLogManager->GetEntries(
+            std::vector<CombatEventStore::RowId>(rows.begin() + startIndex, rows.end()));
+        m_performance.totalEntries = m_sessionCache.currentSession->events.Size();
+        m_performance.filteredEntries = rows.size();
         
-        // Estimate memory usage
-        m_performance.memoryUsageMB = (m_performance.totalEntries * sizeof(CombatLogEntry)) / (1024.0f * 1024.0f);
+        m_performance.memoryUsageMB = m_sessionCache.currentSession->events.GetMemoryUsageBytes() / (1024.0f * 1024.0f);
         
         m_shouldScrollToBottom = true;
     }
     
+    // Invalidate() would request another refresh and redo all of this on the next frame
     m_sessionCache.needsRefresh = false;
-    m_sessionCache.Invalidate(); // Invalidate analysis
+    m_sessionCache.isAnalysisValid = false;
 }
 
 void CombatLogTab::ApplyFilters() {
@@ -152,7 +152,9 @@ private:
     // Session data cache
     struct SessionCache {
         std::shared_ptr<CombatSession> currentSession;
-        std::vector<std::shared_ptr<CombatLogEntry>> filteredEntries;
+        std::vector<CombatEventStore::RowId> filteredRows;
+        // Only the rows shown in the log view are rebuilt as entries
+        std::vector<std::shared_ptr<CombatLogEntry>> displayedEntries;
         CombatAnalysis analysis;
         std::vector<SpellAnalysis> spellAnalyses;
         bool isAnalysisValid = false;
@@ -0,0 +1,246 @@
+// Offline analysis of binary combat log files written by CombatLogManager::ExportSessionsToBinary. Sessions are
+// read and analysed one at a time, so memory use stays at one session no matter how many files are passed.
+//
+// Usage: CombatLogCli info FILE...
+//        CombatLogCli analyze [--top N] FILE...
+//        CombatLogCli summary [--top N] FILE...
+
+#include "CombatLogAnalyzer.h"
+#include "CombatLogFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+    enum class Command {
+        INFO,
+        ANALYZE,
+        SUMMARY
+    };
+
+    struct CliOptions {
+        Command command = Command::INFO;
+        size_t top = 5;
+        std::vector<std::string> files;
+    };
+
+    // Totals of one participant over every session of a summary, participants are matched by name since GUIDs
+    // of players can change between server restarts
+    struct ParticipantSummary {
+        uint64_t damage = 0;
+        uint64_t healing = 0;
+        uint64_t sessions = 0;
+        double seconds = 0.0;
+    };
+
+    struct Summary {
+        uint64_t sessions = 0;
+        uint64_t events = 0;
+        uint64_t damage = 0;
+        uint64_t healing = 0;
+        double seconds = 0.0;
+        std::map<std::string, ParticipantSummary> participants;
+    };
+
+    bool ParseOptions(int argc, char* argv[], CliOptions& options) {
+        if (argc < 3) {
+            return false;
+        }
+
+        if (!strcmp(argv[1], "info")) {
+            options.command = Command::INFO;
+        } else if (!strcmp(argv[1], "analyze")) {
+            options.command = Command::ANALYZE;
+        } else if (!strcmp(argv[1], "summary")) {
+            options.command = Command::SUMMARY;
+        } else {
+            return false;
+        }
+
+        for (int i = 2; i < argc; ++i) {
+            if (!strcmp(argv[i], "--top") && i + 1 < argc) {
+                options.top = static_cast<size_t>(strtoul(argv[++i], nullptr, 10));
+            } else {
+                options.files.push_back(argv[i]);
+            }
+        }
+        return !options.files.empty();
+    }
+
+    std::string GetName(const CombatSession& session, const WGUID& guid) {
+        auto it = session.participantNames.find(guid);
+        return it != session.participantNames.end() ? it->second : "Unknown-" + std::to_string(guid.ToUint64());
+    }
+
+    void PrintRanking(const char* title, const std::vector<std::pair<std::string, double>>& ranking, size_t top) {
+        if (ranking.empty()) return;
+
+        printf("  %s\n", title);
+        for (size_t i = 0; i < std::min(top, ranking.size()); ++i) {
+            printf("    %2zu. %-24s %10s\n", i + 1, ranking[i].first.c_str(), CombatLogAnalyzer::FormatDps(ranking[i].second).c_str());
+        }
+    }
+
+    // Breakdowns don't carry a rate of their own, it's the total over the length of the session
+    template <typename Breakdown>
+    std::vector<std::pair<std::string, double>> RankByRate(const CombatSession& session, const std::map<WGUID, Breakdown>& breakdowns,
+                                                           uint64_t Breakdown::*total, double seconds) {
+        std::vector<std::pair<std::string, double>> ranking;
+        if (seconds <= 0.0) return ranking;
+
+        for (const auto& [guid, breakdown] : breakdowns) {
+            ranking.emplace_back(GetName(session, guid), breakdown.*total / seconds);
+        }
+        std::sort(ranking.begin(), ranking.end(), [](const auto& a, const auto& b) { return a.second > b.second; });
+        return ranking;
+    }
+
+    void PrintSession(size_t index, const CombatSession& session, const CliOptions& options) {
+        const CombatAnalysis analysis = session.aggregates.Analyze(session);
+
+        printf("Session %zu: %s, %s events\n", index, CombatLogAnalyzer::FormatDuration(analysis.duration).c_str(),
+               CombatLogAnalyzer::FormatNumber(session.aggregates.GetEventCount()).c_str());
+        if (options.command == Command::INFO) {
+            return;
+        }
+
+        printf("  Damage  %14s  %10s DPS\n", CombatLogAnalyzer::FormatNumber(analysis.totalDamage).c_str(), CombatLogAnalyzer::FormatDps(analysis.averageDps).c_str());
+        printf("  Healing %14s  %10s HPS\n", CombatLogAnalyzer::FormatNumber(analysis.totalHealing).c_str(), CombatLogAnalyzer::FormatDps(analysis.averageHps).c_str());
+        const double seconds = analysis.duration.count();
+        PrintRanking("Top damage (DPS)", RankByRate(session, analysis.damageByParticipant, &DamageBreakdown::totalDamage, seconds), options.top);
+        PrintRanking("Top healing (HPS)", RankByRate(session, analysis.healingByParticipant, &HealingBreakdown::totalHealing, seconds), options.top);
+
+        const std::vector<SpellAnalysis> spells = session.aggregates.GetSpellAnalyses(session.events, CombatLogFilter());
+        if (!spells.empty()) {
+            printf("  Top spells\n");
+            for (size_t i = 0; i < std::min(options.top, spells.size()); ++i) {
+                const SpellAnalysis& spell = spells[i];
+                printf("    %2zu. %-24s %14s  %6s crit\n", i + 1, spell.spellName.c_str(),
+                       CombatLogAnalyzer::FormatNumber(spell.totalDamage + spell.totalHealing).c_str(),
+                       CombatLogAnalyzer::FormatPercent(spell.critRate).c_str());
+            }
+        }
+    }
+
+    void AddToSummary(const CombatSession& session, Summary& summary) {
+        const CombatAnalysis analysis = session.aggregates.Analyze(session);
+        const double seconds = analysis.duration.count();
+
+        summary.sessions++;
+        summary.events += session.aggregates.GetEventCount();
+        summary.damage += analysis.totalDamage;
+        summary.healing += analysis.totalHealing;
+        summary.seconds += seconds;
+
+        std::map<std::string, ParticipantSummary*> seen;
+        auto participant = [&](const WGUID& guid) -> ParticipantSummary& {
+            const std::string name = GetName(session, guid);
+            auto [it, inserted] = seen.emplace(name, &summary.participants[name]);
+            if (inserted) {
+                it->second->sessions++;
+                it->second->seconds += seconds;
+            }
+            return *it->second;
+        };
+
+        for (const auto& [guid, damage] : analysis.damageByParticipant) {
+            participant(guid).damage += damage.totalDamage;
+        }
+        for (const auto& [guid, healing] : analysis.healingByParticipant) {
+            participant(guid).healing += healing.totalHealing;
+        }
+    }
+
+    void PrintSummary(const Summary& summary, const CliOptions& options) {
+        const std::chrono::duration<double> duration(summary.seconds);
+        printf("%s sessions, %s in combat, %s events\n", CombatLogAnalyzer::FormatNumber(summary.sessions).c_str(),
+               CombatLogAnalyzer::FormatDuration(duration).c_str(), CombatLogAnalyzer::FormatNumber(summary.events).c_str());
+        printf("  Damage  %14s\n", CombatLogAnalyzer::FormatNumber(summary.damage).c_str());
+        printf("  Healing %14s\n", CombatLogAnalyzer::FormatNumber(summary.healing).c_str());
+
+        // Rates are over the combat time of the sessions a participant took part in
+        std::vector<std::pair<std::string, double>> dps, hps;
+        for (const auto& [name, participant] : summary.participants) {
+            if (participant.seconds <= 0.0) continue;
+            if (participant.damage > 0) dps.emplace_back(name, participant.damage / participant.seconds);
+            if (participant.healing > 0) hps.emplace_back(name, participant.healing / participant.seconds);
+        }
+
+        auto byRate = [](const auto& a, const auto& b) { return a.second > b.second; };
+        std::sort(dps.begin(), dps.end(), byRate);
+        std::sort(hps.begin(), hps.end(), byRate);
+        PrintRanking("Top damage (DPS)", dps, options.top);
+        PrintRanking("Top healing (HPS)", hps, options.top);
+    }
+
+    // Calls onSession for every session of the file, returns false if the file couldn't be read to the end
+    bool ReadFile(const std::string& filename, const std::function<void(const CombatSession&)>& onSession) {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            fprintf(stderr, "%s: cannot open file\n", filename.c_str());
+            return false;
+        }
+
+        CombatLogFileReader reader(file);
+        if (!reader.ReadHeader()) {
+            fprintf(stderr, "%s: %s\n", filename.c_str(), reader.GetError().c_str());
+            return false;
+        }
+
+        while (true) {
+            CombatSession session;
+            const bool complete = reader.ReadSession(session);
+            if (!complete && session.events.Empty()) {
+                break;
+            }
+            onSession(session);
+            if (!complete) {
+                break;
+            }
+        }
+
+        if (!reader.GetError().empty()) {
+            fprintf(stderr, "%s: %s\n", filename.c_str(), reader.GetError().c_str());
+            return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    CliOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        printf("Usage: %s info FILE...\n", argv[0]);
+        printf("       %s analyze [--top N] FILE...\n", argv[0]);
+        printf("       %s summary [--top N] FILE...\n", argv[0]);
+        return 1;
+    }
+
+    bool ok = true;
+    Summary summary;
+    for (const std::string& filename : options.files) {
+        if (options.command != Command::SUMMARY) {
+            printf("%s\n", filename.c_str());
+        }
+
+        size_t index = 0;
+        ok &= ReadFile(filename, [&](const CombatSession& session) {
+            if (options.command == Command::SUMMARY) {
+                AddToSummary(session, summary);
+            } else {
+                PrintSession(++index, session, options);
+            }
+        });
+    }
+
+    if (options.command == Command::SUMMARY) {
+        PrintSummary(summary, options);
+    }
+    return ok ? 0 : 1;
+}
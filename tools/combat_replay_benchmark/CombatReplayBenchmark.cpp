@@ -0,0 +1,374 @@
+// Replays a synthetic raid log the way the combat log tab sees it while a fight is running and compares the
+// cost of re-analysing the whole session with a scan against the running totals of CombatAnalysisEngine.
+//
+// Usage: CombatReplayBenchmark [--minutes N] [--players N] [--query-interval SECONDS] [--seed N] [--write FILE]
+//
+// --write saves the session as a binary combat log file (CombatLogFile.h), e.g. as input for CombatLogCli.
+
+#include "CombatAnalysisEngine.h"
+#include "CombatLogAnalyzer.h"
+#include "CombatLogFile.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    struct BenchmarkOptions {
+        int minutes = 30;
+        int players = 25;
+        double queryIntervalSeconds = 10.0;
+        uint32_t seed = 1;
+        std::string writeFile;
+    };
+
+    enum class Role {
+        TANK,
+        HEALER,
+        MELEE,
+        CASTER
+    };
+
+    struct Ability {
+        uint32_t spellId;
+        const char* name;
+        CombatSpellSchool school;
+        uint32_t minAmount;
+        uint32_t maxAmount;
+        bool hasCastTime;
+    };
+
+    const Ability TANK_ABILITIES[] = {
+        { 47488, "Shield Slam", SPELL_SCHOOL_NORMAL, 2500, 3500, false },
+        { 57823, "Revenge", SPELL_SCHOOL_NORMAL, 1800, 2600, false },
+        { 48819, "Consecration", SPELL_SCHOOL_HOLY, 900, 1300, false },
+    };
+    const Ability HEALER_ABILITIES[] = {
+        { 48782, "Holy Light", SPELL_SCHOOL_HOLY, 9000, 16000, true },
+        { 48785, "Flash of Light", SPELL_SCHOOL_HOLY, 2500, 4500, true },
+        { 48441, "Rejuvenation", SPELL_SCHOOL_NATURE, 1200, 2000, false },
+        { 55459, "Chain Heal", SPELL_SCHOOL_NATURE, 4000, 7000, true },
+    };
+    const Ability MELEE_ABILITIES[] = {
+        { 47486, "Mortal Strike", SPELL_SCHOOL_NORMAL, 5000, 8000, false },
+        { 48638, "Sinister Strike", SPELL_SCHOOL_NORMAL, 3000, 5000, false },
+        { 49930, "Blood Strike", SPELL_SCHOOL_NORMAL, 3500, 5500, false },
+        { 55271, "Scourge Strike", SPELL_SCHOOL_SHADOW, 4000, 6500, false },
+    };
+    const Ability CASTER_ABILITIES[] = {
+        { 42842, "Frostbolt", SPELL_SCHOOL_FROST, 6000, 11000, true },
+        { 42833, "Fireball", SPELL_SCHOOL_FIRE, 7000, 12000, true },
+        { 47809, "Shadow Bolt", SPELL_SCHOOL_SHADOW, 7000, 12500, true },
+        { 48461, "Wrath", SPELL_SCHOOL_NATURE, 5000, 9000, true },
+        { 42897, "Arcane Blast", SPELL_SCHOOL_ARCANE, 6500, 10000, true },
+    };
+    const Ability BOSS_MELEE = { 0, "", SPELL_SCHOOL_NORMAL, 12000, 18000, false };
+    const Ability BOSS_RAID_DAMAGE = { 72350, "Fury of Frostmourne", SPELL_SCHOOL_SHADOW, 4000, 6000, false };
+
+    struct Actor {
+        WGUID guid;
+        std::string name;
+        Role role;
+        Clock::duration nextAction;
+        Clock::duration nextSwing;
+    };
+
+    // Events of a boss fight in timestamp order: tanks and melee swing and use abilities, casters cast, healers
+    // heal random raid members and the boss hits the tanks and pulses damage on the whole raid
+    class RaidSimulator {
+    public:
+        RaidSimulator(const BenchmarkOptions& options, Clock::time_point start)
+            : m_rng(options.seed), m_start(start) {
+            m_boss.guid = WGUID(0xF130008EF5000001ull);
+            m_boss.name = "The Lich King";
+
+            for (int i = 0; i < options.players; ++i) {
+                Actor player;
+                player.guid = WGUID(0x0000000000100000ull + static_cast<uint64_t>(i));
+                player.name = "Player" + std::to_string(i + 1);
+                player.role = i < 2 ? Role::TANK : i < 2 + options.players / 5 ? Role::HEALER : (i % 2 ? Role::MELEE : Role::CASTER);
+                player.nextAction = Jitter(std::chrono::milliseconds(1500));
+                player.nextSwing = Jitter(std::chrono::milliseconds(2400));
+                m_players.push_back(player);
+            }
+        }
+
+        void Generate(Clock::duration length, std::vector<CombatLogEntry>& events) {
+            const Clock::duration tick = std::chrono::milliseconds(100);
+            Clock::duration nextBossSwing = std::chrono::milliseconds(1500);
+            Clock::duration nextRaidDamage = std::chrono::seconds(20);
+
+            for (Clock::duration now = Clock::duration::zero(); now < length; now += tick) {
+                for (Actor& player : m_players) {
+                    if (player.role == Role::TANK || player.role == Role::MELEE) {
+                        if (now >= player.nextSwing) {
+                            events.push_back(MakeDamage(now, player, m_boss, BOSS_MELEE, CombatEventType::MELEE_DAMAGE, 3000, 5000));
+                            player.nextSwing = now + Jitter(std::chrono::milliseconds(2400));
+                        }
+                    }
+                    if (now < player.nextAction) continue;
+
+                    switch (player.role) {
+                        case Role::TANK:
+                            Attack(now, player, Pick(TANK_ABILITIES), events);
+                            break;
+                        case Role::MELEE:
+                            Attack(now, player, Pick(MELEE_ABILITIES), events);
+                            break;
+                        case Role::CASTER:
+                            Attack(now, player, Pick(CASTER_ABILITIES), events);
+                            break;
+                        case Role::HEALER:
+                            Heal(now, player, Pick(HEALER_ABILITIES), events);
+                            break;
+                    }
+                    player.nextAction = now + Jitter(std::chrono::milliseconds(1500));
+                }
+
+                if (now >= nextBossSwing) {
+                    Actor& tank = m_players[std::uniform_int_distribution<size_t>(0, std::min<size_t>(m_players.size(), 2) - 1)(m_rng)];
+                    events.push_back(MakeDamage(now, m_boss, tank, BOSS_MELEE, CombatEventType::MELEE_DAMAGE, BOSS_MELEE.minAmount, BOSS_MELEE.maxAmount));
+                    nextBossSwing = now + std::chrono::milliseconds(1500);
+                }
+                if (now >= nextRaidDamage) {
+                    for (Actor& player : m_players) {
+                        events.push_back(MakeDamage(now, m_boss, player, BOSS_RAID_DAMAGE, CombatEventType::SPELL_DAMAGE, BOSS_RAID_DAMAGE.minAmount, BOSS_RAID_DAMAGE.maxAmount));
+                    }
+                    nextRaidDamage = now + std::chrono::seconds(20);
+                }
+            }
+        }
+
+    private:
+        template <size_t N>
+        const Ability& Pick(const Ability (&abilities)[N]) {
+            return abilities[std::uniform_int_distribution<size_t>(0, N - 1)(m_rng)];
+        }
+
+        Clock::duration Jitter(Clock::duration base) {
+            return base + std::chrono::milliseconds(std::uniform_int_distribution<int>(-200, 300)(m_rng));
+        }
+
+        CombatLogEntry MakeEntry(Clock::duration now, CombatEventType eventType, const Actor& source, const Actor& target, const Ability& ability) {
+            CombatLogEntry entry;
+            entry.timestamp = m_start + now;
+            entry.eventType = eventType;
+            entry.sourceGUID = source.guid;
+            entry.sourceName = source.name;
+            entry.targetGUID = target.guid;
+            entry.targetName = target.name;
+            entry.spellId = ability.spellId;
+            entry.spellName = ability.name;
+            entry.spellSchool = ability.school;
+            return entry;
+        }
+
+        CombatLogEntry MakeDamage(Clock::duration now, const Actor& source, const Actor& target, const Ability& ability,
+                                  CombatEventType eventType, uint32_t minAmount, uint32_t maxAmount) {
+            CombatLogEntry entry = MakeEntry(now, eventType, source, target, ability);
+            uint32_t roll = std::uniform_int_distribution<uint32_t>(0, 99)(m_rng);
+            if (roll < 4) {
+                entry.hitFlags = HitFlags::MISS;
+                return entry;
+            }
+
+            entry.amount = std::uniform_int_distribution<uint32_t>(minAmount, maxAmount)(m_rng);
+            if (roll < 30) {
+                entry.hitFlags = HitFlags::CRITICAL;
+                entry.amount *= 2;
+            }
+            if (roll % 10 == 0) {
+                entry.absorbed = entry.amount / 10;
+            }
+            return entry;
+        }
+
+        void Attack(Clock::duration now, const Actor& player, const Ability& ability, std::vector<CombatLogEntry>& events) {
+            if (ability.hasCastTime) {
+                events.push_back(MakeEntry(now, CombatEventType::SPELL_CAST_START, player, m_boss, ability));
+                events.push_back(MakeEntry(now, CombatEventType::SPELL_CAST_SUCCESS, player, m_boss, ability));
+            }
+            events.push_back(MakeDamage(now, player, m_boss, ability, CombatEventType::SPELL_DAMAGE, ability.minAmount, ability.maxAmount));
+        }
+
+        void Heal(Clock::duration now, const Actor& player, const Ability& ability, std::vector<CombatLogEntry>& events) {
+            const Actor& target = m_players[std::uniform_int_distribution<size_t>(0, m_players.size() - 1)(m_rng)];
+            if (ability.hasCastTime) {
+                events.push_back(MakeEntry(now, CombatEventType::SPELL_CAST_START, player, target, ability));
+                events.push_back(MakeEntry(now, CombatEventType::SPELL_CAST_SUCCESS, player, target, ability));
+            }
+
+            CombatLogEntry entry = MakeEntry(now, CombatEventType::SPELL_HEAL, player, target, ability);
+            entry.amount = std::uniform_int_distribution<uint32_t>(ability.minAmount, ability.maxAmount)(m_rng);
+            if (std::uniform_int_distribution<uint32_t>(0, 99)(m_rng) < 20) {
+                entry.hitFlags = HitFlags::CRITICAL;
+                entry.amount = entry.amount * 3 / 2;
+            }
+            entry.overAmount = std::uniform_int_distribution<uint32_t>(0, entry.amount / 2)(m_rng);
+            events.push_back(entry);
+        }
+
+        std::mt19937 m_rng;
+        Clock::time_point m_start;
+        Actor m_boss;
+        std::vector<Actor> m_players;
+    };
+
+    double Milliseconds(Clock::duration duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    bool ParseOptions(int argc, char* argv[], BenchmarkOptions& options) {
+        for (int i = 1; i < argc; ++i) {
+            if (i + 1 >= argc) {
+                return false;
+            }
+            if (!strcmp(argv[i], "--minutes")) {
+                options.minutes = atoi(argv[++i]);
+            } else if (!strcmp(argv[i], "--players")) {
+                options.players = atoi(argv[++i]);
+            } else if (!strcmp(argv[i], "--query-interval")) {
+                options.queryIntervalSeconds = atof(argv[++i]);
+            } else if (!strcmp(argv[i], "--seed")) {
+                options.seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+            } else if (!strcmp(argv[i], "--write")) {
+                options.writeFile = argv[++i];
+            } else {
+                return false;
+            }
+        }
+        return options.minutes > 0 && options.players > 2 && options.queryIntervalSeconds > 0.0;
+    }
+
+    // Both paths have to agree on everything the combat log tab shows
+    bool CompareResults(const CombatAnalysis& scanned, const CombatAnalysis& incremental,
+                        const std::vector<SpellAnalysis>& scannedSpells, const std::vector<SpellAnalysis>& incrementalSpells) {
+        if (scanned.totalDamage != incremental.totalDamage || scanned.totalHealing != incremental.totalHealing ||
+            scanned.damageByParticipant.size() != incremental.damageByParticipant.size() ||
+            scanned.healingByParticipant.size() != incremental.healingByParticipant.size() ||
+            scannedSpells.size() != incrementalSpells.size()) {
+            return false;
+        }
+
+        for (const auto& [guid, damage] : scanned.damageByParticipant) {
+            auto it = incremental.damageByParticipant.find(guid);
+            if (it == incremental.damageByParticipant.end() || it->second.totalDamage != damage.totalDamage ||
+                it->second.criticalHits != damage.criticalHits || it->second.damageBySpellName != damage.damageBySpellName ||
+                it->second.damageByTarget != damage.damageByTarget || it->second.damageBySchool != damage.damageBySchool) {
+                return false;
+            }
+        }
+        for (const auto& [guid, healing] : scanned.healingByParticipant) {
+            auto it = incremental.healingByParticipant.find(guid);
+            if (it == incremental.healingByParticipant.end() || it->second.totalHealing != healing.totalHealing ||
+                it->second.totalOverheal != healing.totalOverheal || it->second.healingByTarget != healing.healingByTarget) {
+                return false;
+            }
+        }
+        for (size_t i = 0; i < scannedSpells.size(); ++i) {
+            if (scannedSpells[i].spellId != incrementalSpells[i].spellId || scannedSpells[i].totalDamage != incrementalSpells[i].totalDamage ||
+                scannedSpells[i].totalHealing != incrementalSpells[i].totalHealing || scannedSpells[i].totalCasts != incrementalSpells[i].totalCasts) {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        printf("Usage: %s [--minutes N] [--players N] [--query-interval SECONDS] [--seed N] [--write FILE]\n", argv[0]);
+        return 1;
+    }
+
+    const Clock::time_point start = Clock::now();
+    std::vector<CombatLogEntry> log;
+    RaidSimulator(options, start).Generate(std::chrono::minutes(options.minutes), log);
+    printf("Synthetic log: %d minutes, %d players, %zu events\n", options.minutes, options.players, log.size());
+
+    CombatSession session;
+    session.startTime = start;
+    session.endTime = start;
+
+    const CombatLogFilter filter;
+    const Clock::duration queryInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.queryIntervalSeconds));
+    Clock::time_point nextQuery = start + queryInterval;
+
+    Clock::duration appendTime{};
+    Clock::duration scanTime{};
+    Clock::duration incrementalTime{};
+    size_t queries = 0;
+    CombatAnalysis scanned, incremental;
+    std::vector<SpellAnalysis> scannedSpells, incrementalSpells;
+
+    auto query = [&]() {
+        Clock::time_point scanStart = Clock::now();
+        scanned = CombatLogAnalyzer::AnalyzeSession(session, filter);
+        scannedSpells = CombatLogAnalyzer::AnalyzeAllSpells(session.events, session.events.Select(filter));
+        Clock::time_point incrementalStart = Clock::now();
+        incremental = session.aggregates.Analyze(session);
+        incrementalSpells = session.aggregates.GetSpellAnalyses(session.events, filter);
+        Clock::time_point queryEnd = Clock::now();
+
+        scanTime += incrementalStart - scanStart;
+        incrementalTime += queryEnd - incrementalStart;
+        queries++;
+    };
+
+    // Same bookkeeping as CombatLogManager::AddEntry, queries run whenever the tab would refresh
+    for (const CombatLogEntry& entry : log) {
+        if (entry.timestamp >= nextQuery) {
+            query();
+            nextQuery += queryInterval;
+        }
+
+        Clock::time_point appendStart = Clock::now();
+        session.events.Append(entry);
+        session.aggregates.Add(session.events, session.events.Size() - 1);
+        appendTime += Clock::now() - appendStart;
+
+        session.participantNames[entry.sourceGUID] = entry.sourceName;
+        session.participantNames[entry.targetGUID] = entry.targetName;
+        session.endTime = entry.timestamp;
+    }
+    query();
+
+    printf("Append:      %10.2f ms total, %8.3f us per event\n", Milliseconds(appendTime), Milliseconds(appendTime) * 1000.0 / log.size());
+    printf("Full scan:   %10.2f ms total, %8.3f ms per query (%zu queries)\n", Milliseconds(scanTime), Milliseconds(scanTime) / queries, queries);
+    printf("Incremental: %10.2f ms total, %8.3f ms per query (%zu queries)\n", Milliseconds(incrementalTime), Milliseconds(incrementalTime) / queries, queries);
+    printf("Memory:      events %.2f MB, aggregates %.2f MB\n",
+           session.events.GetMemoryUsageBytes() / (1024.0 * 1024.0), session.aggregates.GetMemoryUsageBytes() / (1024.0 * 1024.0));
+
+    if (!CompareResults(scanned, incremental, scannedSpells, incrementalSpells)) {
+        printf("Results of the full scan and the incremental totals differ\n");
+        return 1;
+    }
+
+    printf("Results match: %s damage, %s healing\n",
+           CombatLogAnalyzer::FormatNumber(incremental.totalDamage).c_str(), CombatLogAnalyzer::FormatNumber(incremental.totalHealing).c_str());
+
+    if (!options.writeFile.empty()) {
+        std::ofstream file(options.writeFile, std::ios::binary);
+        CombatLogFileWriter writer(file);
+
+        Clock::time_point writeStart = Clock::now();
+        writer.WriteSession(session);
+        const bool written = file.is_open() && writer.Flush();
+        Clock::duration writeTime = Clock::now() - writeStart;
+
+        if (!written) {
+            printf("Failed to write %s\n", options.writeFile.c_str());
+            return 1;
+        }
+        printf("Wrote %s: %s bytes, %.2f bytes per event, %.2f ms\n", options.writeFile.c_str(),
+               CombatLogAnalyzer::FormatNumber(writer.GetBytesWritten()).c_str(), static_cast<double>(writer.GetBytesWritten()) / log.size(), Milliseconds(writeTime));
+    }
+    return 0;
+}